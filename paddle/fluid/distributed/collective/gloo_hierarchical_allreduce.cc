@@ -0,0 +1,354 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/collective/gloo_hierarchical_allreduce.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <gloo/rendezvous/context.h>
+#include <gloo/rendezvous/prefix_store.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+constexpr int kStageNum = 2;
+constexpr size_t kAlignment = 64;
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+void SetString(::gloo::rendezvous::Store& store,  // NOLINT
+               const std::string& key,
+               const std::string& value) {
+  store.set(key, std::vector<char>(value.begin(), value.end()));
+}
+
+std::string GetString(::gloo::rendezvous::Store& store,  // NOLINT
+                      const std::string& key) {
+  store.wait({key});
+  auto value = store.get(key);
+  return std::string(value.begin(), value.end());
+}
+
+// a local rank that died or left the collective would hang the others, so
+// the wait gives up after timeout
+void WaitFor(const std::atomic<uint64_t>& counter,
+             uint64_t target,
+             std::chrono::milliseconds timeout,
+             const char* step) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  for (size_t spin = 0; counter.load(std::memory_order_acquire) < target;
+       ++spin) {
+    if (spin > 1024) {
+      std::this_thread::yield();
+      if (spin % 1024 == 0 && std::chrono::steady_clock::now() > deadline) {
+        PADDLE_THROW(platform::errors::ExecutionTimeout(
+            "Hierarchical all-reduce timed out after %d ms waiting for the "
+            "local ranks to %s, the counter is %d of %d.",
+            timeout.count(),
+            step,
+            counter.load(std::memory_order_acquire),
+            target));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// Counters of a stage, they only grow so a rank waits for the value that
+// the current use of the stage brings them to.
+struct GlooHierarchicalAllReduce::StageHeader {
+  // local ranks that copied their input in
+  alignas(kAlignment) std::atomic<uint64_t> input_ready;
+  // local ranks that reduced their slice
+  alignas(kAlignment) std::atomic<uint64_t> reduced;
+  // the last use whose result is complete
+  alignas(kAlignment) std::atomic<uint64_t> result_ready;
+  // local ranks that copied the result out
+  alignas(kAlignment) std::atomic<uint64_t> consumed;
+};
+
+GlooHierarchicalAllReduce::GlooHierarchicalAllReduce(
+    ::gloo::rendezvous::Store& store,
+    const std::string& prefix,
+    int rank,
+    int size,
+    const std::shared_ptr<::gloo::transport::Device>& device,
+    const std::string& node_key,
+    int64_t chunk_bytes,
+    int64_t small_bytes,
+    std::chrono::milliseconds timeout)
+    : timeout_(timeout),
+      chunk_bytes_(AlignUp(std::max<int64_t>(chunk_bytes, kAlignment))),
+      small_bytes_(std::min<size_t>(std::max<int64_t>(small_bytes, 0),
+                                    chunk_bytes_)) {
+#ifdef _WIN32
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Hierarchical all-reduce of ProcessGroupGloo is not supported on "
+      "Windows."));
+#else
+  std::string key = node_key;
+  if (key.empty()) {
+    char hostname[256] = {0};
+    PADDLE_ENFORCE_EQ(
+        gethostname(hostname, sizeof(hostname) - 1),
+        0,
+        platform::errors::Fatal("Get hostname error for hierarchical "
+                                "all-reduce."));
+    key = hostname;
+  }
+  SetString(store, prefix + "/node/" + std::to_string(rank), key);
+
+  // the first rank of a node leads it, nodes are numbered by their leaders
+  std::vector<std::string> keys(size);
+  std::vector<std::string> leader_keys;
+  int leader = -1;
+  int node_rank = -1;
+  for (int r = 0; r < size; ++r) {
+    keys[r] = GetString(store, prefix + "/node/" + std::to_string(r));
+    bool is_leader = std::find(leader_keys.begin(),
+                               leader_keys.end(),
+                               keys[r]) == leader_keys.end();
+    if (is_leader) {
+      leader_keys.push_back(keys[r]);
+    }
+    if (keys[r] == key) {
+      if (is_leader) {
+        leader = r;
+        node_rank = leader_keys.size() - 1;
+      }
+      if (r < rank) {
+        ++local_rank_;
+      }
+    }
+  }
+  local_size_ = std::count(keys.begin(), keys.end(), key);
+  node_num_ = leader_keys.size();
+
+  if (local_rank_ == 0 && node_num_ > 1) {
+    auto context =
+        std::make_shared<::gloo::rendezvous::Context>(node_rank, node_num_);
+    context->setTimeout(timeout_);
+    ::gloo::rendezvous::PrefixStore leader_store(prefix + "/leaders", store);
+    context->connectFullMesh(leader_store, device);
+    leader_context_ = context;
+  }
+  if (local_size_ > 1) {
+    MapSegment(store, prefix, leader);
+  }
+  VLOG(3) << "Hierarchical all-reduce of rank " << rank << ": local rank "
+          << local_rank_ << " of " << local_size_ << " on node " << node_rank
+          << " of " << node_num_;
+#endif
+}
+
+GlooHierarchicalAllReduce::~GlooHierarchicalAllReduce() {
+#ifndef _WIN32
+  if (segment_ != nullptr) {
+    munmap(segment_, segment_bytes_);
+  }
+#endif
+}
+
+void GlooHierarchicalAllReduce::MapSegment(::gloo::rendezvous::Store& store,
+                                           const std::string& prefix,
+                                           int leader) {
+#ifndef _WIN32
+  segment_bytes_ = AlignUp(kStageNum * sizeof(StageHeader)) +
+                   kStageNum * (local_size_ + 1) * chunk_bytes_;
+  std::string name_key = prefix + "/segment/" + std::to_string(leader);
+  std::string name;
+  int fd = -1;
+  if (local_rank_ == 0) {
+    std::random_device rd;
+    name = "/paddle_gloo_" + std::to_string(getpid()) + "_" +
+           std::to_string(rd());
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    PADDLE_ENFORCE_GE(fd,
+                      0,
+                      platform::errors::Unavailable(
+                          "Failed to create shared memory %s.", name));
+    // the new segment is zero filled, which also resets the counters
+    PADDLE_ENFORCE_EQ(ftruncate(fd, segment_bytes_),
+                      0,
+                      platform::errors::Unavailable(
+                          "Failed to resize shared memory %s to %d bytes.",
+                          name,
+                          segment_bytes_));
+  } else {
+    name = GetString(store, name_key);
+    fd = shm_open(name.c_str(), O_RDWR, 0600);
+    PADDLE_ENFORCE_GE(fd,
+                      0,
+                      platform::errors::Unavailable(
+                          "Failed to open shared memory %s.", name));
+  }
+  void* addr = mmap(
+      nullptr, segment_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(
+      addr,
+      MAP_FAILED,
+      platform::errors::Unavailable("Failed to mmap shared memory %s.", name));
+  segment_ = static_cast<char*>(addr);
+
+  std::string mapped_key = prefix + "/mapped/" + std::to_string(leader) + "/";
+  if (local_rank_ == 0) {
+    SetString(store, name_key, name);
+    std::vector<std::string> mapped_keys;
+    for (int i = 1; i < local_size_; ++i) {
+      mapped_keys.push_back(mapped_key + std::to_string(i));
+    }
+    store.wait(mapped_keys);
+    // the mappings outlive the name, which keeps the segment from leaking
+    shm_unlink(name.c_str());
+  } else {
+    SetString(store, mapped_key + std::to_string(local_rank_), "1");
+  }
+#endif
+}
+
+GlooHierarchicalAllReduce::StageHeader* GlooHierarchicalAllReduce::Header(
+    int stage) const {
+  return reinterpret_cast<StageHeader*>(segment_) + stage;
+}
+
+char* GlooHierarchicalAllReduce::Slot(int stage, int local_rank) const {
+  return segment_ + AlignUp(kStageNum * sizeof(StageHeader)) +
+         (stage * (local_size_ + 1) + local_rank) * chunk_bytes_;
+}
+
+void GlooHierarchicalAllReduce::RunImpl(void* data,
+                                        size_t count,
+                                        size_t elem_size,
+                                        ReduceFunc fn,
+                                        const InterNodeFunc& inter_node) {
+  if (count == 0) {
+    return;
+  }
+  bool small = count * elem_size <= small_bytes_;
+  if (local_size_ == 1) {
+    if (node_num_ > 1) {
+      inter_node(data, count, small);
+    }
+    return;
+  }
+  size_t chunk_count = small ? count : chunk_bytes_ / elem_size;
+  size_t chunk_num = (count + chunk_count - 1) / chunk_count;
+  char* buffer = static_cast<char*>(data);
+  // a rank brings chunk c into its stage before it finishes chunk c - 1,
+  // so the two stages are in flight at the same time
+  for (size_t c = 0; c <= chunk_num; ++c) {
+    if (c < chunk_num) {
+      int stage = c % kStageNum;
+      size_t offset = c * chunk_count;
+      size_t n = std::min(chunk_count, count - offset);
+      uint64_t use = ++uses_[stage];
+      CopyIn(stage, use, buffer + offset * elem_size, n * elem_size);
+      if (local_rank_ > 0) {
+        Reduce(stage, use, n, elem_size, fn);
+      }
+    }
+    if (c > 0) {
+      int stage = (c - 1) % kStageNum;
+      size_t offset = (c - 1) * chunk_count;
+      size_t n = std::min(chunk_count, count - offset);
+      uint64_t use = uses_[stage];
+      if (local_rank_ == 0) {
+        InterNode(stage, use, n, small, inter_node);
+      }
+      CopyOut(stage, use, buffer + offset * elem_size, n * elem_size);
+    }
+  }
+}
+
+void GlooHierarchicalAllReduce::CopyIn(int stage,
+                                       uint64_t use,
+                                       const char* src,
+                                       size_t bytes) {
+  StageHeader* header = Header(stage);
+  // the stage is free once every local rank read the previous result
+  WaitFor(header->consumed,
+          (use - 1) * local_size_,
+          timeout_,
+          "read the previous result");
+  std::memcpy(Slot(stage, local_rank_), src, bytes);
+  header->input_ready.fetch_add(1, std::memory_order_release);
+}
+
+void GlooHierarchicalAllReduce::Reduce(
+    int stage, uint64_t use, size_t count, size_t elem_size, ReduceFunc fn) {
+  StageHeader* header = Header(stage);
+  WaitFor(header->input_ready, use * local_size_, timeout_, "copy in");
+  // the leader is busy across nodes, the other local ranks split the chunk
+  size_t reducers = local_size_ - 1;
+  size_t index = local_rank_ - 1;
+  size_t begin = count * index / reducers;
+  size_t end = count * (index + 1) / reducers;
+  if (end > begin) {
+    size_t offset = begin * elem_size;
+    char* result = Result(stage) + offset;
+    fn(result,
+       Slot(stage, 0) + offset,
+       Slot(stage, 1) + offset,
+       end - begin);
+    for (int i = 2; i < local_size_; ++i) {
+      fn(result, result, Slot(stage, i) + offset, end - begin);
+    }
+  }
+  header->reduced.fetch_add(1, std::memory_order_release);
+}
+
+void GlooHierarchicalAllReduce::InterNode(int stage,
+                                          uint64_t use,
+                                          size_t count,
+                                          bool small,
+                                          const InterNodeFunc& inter_node) {
+  StageHeader* header = Header(stage);
+  WaitFor(header->reduced, use * (local_size_ - 1), timeout_, "reduce");
+  if (node_num_ > 1) {
+    inter_node(Result(stage), count, small);
+  }
+  header->result_ready.store(use, std::memory_order_release);
+}
+
+void GlooHierarchicalAllReduce::CopyOut(int stage,
+                                        uint64_t use,
+                                        char* dst,
+                                        size_t bytes) {
+  StageHeader* header = Header(stage);
+  WaitFor(header->result_ready, use, timeout_, "finish the result");
+  std::memcpy(dst, Result(stage), bytes);
+  header->consumed.fetch_add(1, std::memory_order_release);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,140 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gloo/allreduce.h>
+#include <gloo/rendezvous/store.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace paddle {
+namespace distributed {
+
+// Two level all-reduce for groups with several ranks per node. The ranks
+// of a node reduce through a shared memory segment, then the first rank
+// of every node all-reduces the partial result with the other node
+// leaders and the local ranks read the result back from the segment.
+//
+// Buffers are cut into chunk_bytes chunks that alternate between two
+// stages of the segment, so the leader all-reduces a chunk across nodes
+// while the other local ranks reduce the next one. Buffers up to
+// small_bytes are reduced as a single chunk and use the bcube algorithm
+// among leaders, which takes log(nodes) steps instead of the
+// 2 * (nodes - 1) steps of the ring.
+class GlooHierarchicalAllReduce {
+ public:
+  using ReduceFunc = void (*)(void*, const void*, const void*, size_t);
+
+  static constexpr int64_t kDefaultChunkBytes = 1 << 20;
+  static constexpr int64_t kDefaultSmallBytes = 64 << 10;
+
+  // Collective over all ranks of the group. Ranks with the same node_key
+  // share a node, the hostname is used when node_key is empty. A rank that
+  // waits longer than timeout for the others throws.
+  GlooHierarchicalAllReduce(
+      ::gloo::rendezvous::Store& store,  // NOLINT
+      const std::string& prefix,
+      int rank,
+      int size,
+      const std::shared_ptr<::gloo::transport::Device>& device,
+      const std::string& node_key,
+      int64_t chunk_bytes,
+      int64_t small_bytes,
+      std::chrono::milliseconds timeout);
+
+  ~GlooHierarchicalAllReduce();
+
+  // In place, every rank of the group calls it with the same count.
+  template <typename T>
+  void Run(T* data, size_t count, ReduceFunc fn) {
+    RunImpl(data,
+            count,
+            sizeof(T),
+            fn,
+            [this, fn](void* chunk, size_t chunk_count, bool small) {
+              ::gloo::AllreduceOptions opts(leader_context_);
+              opts.setOutput(static_cast<T*>(chunk), chunk_count);
+              opts.setReduceFunction(fn);
+              opts.setAlgorithm(
+                  small ? ::gloo::AllreduceOptions::Algorithm::BCUBE
+                        : ::gloo::AllreduceOptions::Algorithm::RING);
+              opts.setTag(leader_tag_++);
+              ::gloo::allreduce(opts);
+            });
+  }
+
+  int local_rank() const { return local_rank_; }
+  int local_size() const { return local_size_; }
+  int node_num() const { return node_num_; }
+
+ private:
+  GlooHierarchicalAllReduce(const GlooHierarchicalAllReduce&) = delete;
+  GlooHierarchicalAllReduce& operator=(const GlooHierarchicalAllReduce&) =
+      delete;
+
+  using InterNodeFunc = std::function<void(void*, size_t, bool)>;
+
+  struct StageHeader;
+
+  void MapSegment(::gloo::rendezvous::Store& store,  // NOLINT
+                  const std::string& prefix,
+                  int leader);
+  void RunImpl(void* data,
+               size_t count,
+               size_t elem_size,
+               ReduceFunc fn,
+               const InterNodeFunc& inter_node);
+
+  StageHeader* Header(int stage) const;
+  char* Slot(int stage, int local_rank) const;
+  char* Result(int stage) const { return Slot(stage, local_size_); }
+
+  // the steps of a chunk, in the order a rank takes them
+  void CopyIn(int stage, uint64_t use, const char* src, size_t bytes);
+  void Reduce(int stage,
+              uint64_t use,
+              size_t count,
+              size_t elem_size,
+              ReduceFunc fn);
+  void InterNode(int stage,
+                 uint64_t use,
+                 size_t count,
+                 bool small,
+                 const InterNodeFunc& inter_node);
+  void CopyOut(int stage, uint64_t use, char* dst, size_t bytes);
+
+  std::chrono::milliseconds timeout_;
+  int local_rank_ = 0;
+  int local_size_ = 1;
+  int node_num_ = 1;
+  size_t chunk_bytes_;
+  size_t small_bytes_;
+
+  std::shared_ptr<::gloo::Context> leader_context_;
+  uint32_t leader_tag_ = 0;
+
+  char* segment_ = nullptr;
+  size_t segment_bytes_ = 0;
+  // the times each stage has been used, the same on all local ranks
+  uint64_t uses_[2] = {0, 0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <iostream>
 
 #ifdef _WIN32
@@ -176,6 +177,32 @@ ProcessGroupGloo::GlooTask::GlooTask(
     int rank, const std::vector<phi::DenseTensor>& inputs, CommType comm_type)
     : ProcessGroup::Task(rank, inputs, comm_type) {}
 
+bool ProcessGroupGloo::GlooTask::Wait(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (timeout == kWaitTimeout) {
+    cv_.wait(lock, [&] { return is_completed_; });
+  } else {
+    cv_.wait_for(lock, timeout, [&] { return is_completed_; });
+    PADDLE_ENFORCE_EQ(
+        is_completed_,
+        true,
+        platform::errors::Unavailable("Gloo operation timeout! "));
+  }
+  if (exception_) {
+    std::rethrow_exception(exception_);
+  }
+  return true;
+}
+
+void ProcessGroupGloo::GlooTask::Finish(std::exception_ptr exception) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_completed_ = true;
+    exception_ = exception;
+  }
+  cv_.notify_all();
+}
+
 ProcessGroupGloo::ProcessGroupGloo(
     const std::shared_ptr<phi::distributed::Store>& store,
     int rank,
@@ -184,11 +211,85 @@ ProcessGroupGloo::ProcessGroupGloo(
     const std::shared_ptr<GlooOptions> options)
     : ProcessGroupWithoutStream(rank, world_size, gid),
       _tag(0),
-      _store(new GlooStore(store)) {
+      _store(new GlooStore(store)),
+      _device(options->device) {
   _context = std::make_shared<gloo::rendezvous::Context>(rank, world_size);
   auto prefix_store =
       ::gloo::rendezvous::PrefixStore(std::to_string(gid), *_store);
   _context->connectFullMesh(prefix_store, options->device);
+  worker_thread = std::thread(&ProcessGroupGloo::workLoop, this);
+}
+
+ProcessGroupGloo::~ProcessGroupGloo() {
+  std::unique_lock<std::mutex> lock(pg_mutex);
+  queue_consume.wait(lock, [&] { return queue_.empty(); });
+  stop_ = true;
+  lock.unlock();
+  queue_produce.notify_all();
+
+  worker_thread.join();
+}
+
+void ProcessGroupGloo::workLoop() {
+  std::unique_lock<std::mutex> lock(pg_mutex);
+
+  while (!stop_) {
+    if (queue_.empty()) {
+      queue_produce.wait(lock);
+      continue;
+    }
+
+    auto task = std::move(queue_.front());
+    queue_.pop_front();
+
+    lock.unlock();
+    queue_consume.notify_one();
+
+    try {
+      task->Run();
+      task->Finish();
+    } catch (...) {
+      task->Finish(std::current_exception());
+    }
+
+    lock.lock();
+  }
+}
+
+std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Enqueue(
+    std::shared_ptr<GlooTask> task, bool sync_op) {
+  std::unique_lock<std::mutex> lock(pg_mutex);
+  queue_.push_back(task);
+  lock.unlock();
+  queue_produce.notify_one();
+  if (sync_op) {
+    task->Wait();
+  }
+  return task;
+}
+
+void ProcessGroupGloo::SetHierarchicalAllReduce(bool enable,
+                                                const std::string& node_key,
+                                                int64_t chunk_bytes,
+                                                int64_t small_bytes) {
+  if (!enable) {
+    // tasks in flight hold their own reference
+    _hierarchical.reset();
+    return;
+  }
+  // every setup rendezvous under its own keys
+  std::string prefix = std::to_string(gid_) + "/hierarchical/" +
+                       std::to_string(_hierarchical_setups++);
+  _hierarchical =
+      std::make_shared<GlooHierarchicalAllReduce>(*_store,
+                                                  prefix,
+                                                  rank_,
+                                                  size_,
+                                                  _device,
+                                                  node_key,
+                                                  chunk_bytes,
+                                                  small_bytes,
+                                                  _context->getTimeout());
 }
 
 class BroadcastGlooTask : public ProcessGroupGloo::GlooTask {
@@ -252,13 +353,12 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Broadcast(
     const BroadcastOptions& opts,
     bool sync_op) {
   auto root = opts.source_rank;
-  std::unique_ptr<BroadcastGlooTask> task;
+  std::shared_ptr<BroadcastGlooTask> task;
   auto tag = next_tag();
   auto context = get_context();
-  task = std::make_unique<BroadcastGlooTask>(
+  task = std::make_shared<BroadcastGlooTask>(
       context, inputs, outputs, rank_, root, tag);
-  task->Run();
-  return task;
+  return Enqueue(task, true);
 }
 
 class AllreduceGlooTask : public ProcessGroupGloo::GlooTask {
@@ -268,15 +368,23 @@ class AllreduceGlooTask : public ProcessGroupGloo::GlooTask {
                     std::vector<phi::DenseTensor>& inputs,   // NOLINT
                     std::vector<phi::DenseTensor>& outputs,  // NOLINT
                     ReduceOp reduce_op,
-                    uint32_t tag)
+                    uint32_t tag,
+                    std::shared_ptr<GlooHierarchicalAllReduce> hierarchical)
       : ProcessGroupGloo::GlooTask(rank, inputs, CommType::ALLREDUCE),
         _context(context),
         _inputs(inputs),
         _outputs(outputs),
         _reduce_op(reduce_op),
-        _tag(tag) {}
-
-  void Run() override { _do_allreduce(_inputs, _outputs); }
+        _tag(tag),
+        _hierarchical(hierarchical) {}
+
+  void Run() override {
+    if (_hierarchical && _inputs.size() == 1 && _outputs.size() == 1) {
+      _do_hierarchical_allreduce(_inputs[0], _outputs[0]);
+    } else {
+      _do_allreduce(_inputs, _outputs);
+    }
+  }
 
  private:
   std::shared_ptr<gloo::Context> _context;
@@ -284,6 +392,7 @@ class AllreduceGlooTask : public ProcessGroupGloo::GlooTask {
   std::vector<phi::DenseTensor> _outputs;
   const ReduceOp _reduce_op;
   uint32_t _tag;
+  std::shared_ptr<GlooHierarchicalAllReduce> _hierarchical;
 
   gloo::AllreduceOptions::Func _get_function(const experimental::DataType type,
                                              const ReduceOp op) {
@@ -308,6 +417,21 @@ class AllreduceGlooTask : public ProcessGroupGloo::GlooTask {
     opts.setTag(_tag);
     gloo::allreduce(opts);
   }
+
+  template <typename T>
+  void _run_hierarchical(phi::DenseTensor& tensor) {  // NOLINT
+    _hierarchical->Run(
+        get_data<T>(tensor), tensor.numel(), get_function<T>(_reduce_op));
+  }
+
+  void _do_hierarchical_allreduce(phi::DenseTensor& in,    // NOLINT
+                                  phi::DenseTensor& out) {  // NOLINT
+    const auto& dtype = in.dtype();
+    if (in.data() != out.data()) {
+      std::memcpy(out.data(), in.data(), in.numel() * phi::SizeOf(dtype));
+    }
+    GENERATE_FUNC(dtype, _run_hierarchical, out);
+  }
 };
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
@@ -317,14 +441,16 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
     bool sync_op) {
   std::vector<phi::DenseTensor> in_wrapper{in_tensor};
   std::vector<phi::DenseTensor> out_wrapper{*out_tensor};
-  return AllReduce(in_wrapper, out_wrapper, opts, true);
+  return AllReduce(in_wrapper, out_wrapper, opts, sync_op);
 }
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
     std::vector<phi::DenseTensor>& inputs,
     std::vector<phi::DenseTensor>& outputs,
     const AllreduceOptions& opts) {
-  return AllReduce(inputs, outputs, opts, true);
+  // callers wait for the returned task, which lets the reducer overlap the
+  // all-reduce of gradient groups with the rest of backward
+  return AllReduce(inputs, outputs, opts, /*sync_op*/ false);
 }
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
@@ -336,9 +462,8 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
   std::shared_ptr<GlooTask> task;
   auto context = get_context();
   task = std::make_shared<AllreduceGlooTask>(
-      rank_, context, inputs, outputs, opts.reduce_op, tag);
-  task->Run();
-  return task;
+      rank_, context, inputs, outputs, opts.reduce_op, tag, _hierarchical);
+  return Enqueue(task, sync_op);
 }
 
 class BarrierGlooTask : public ProcessGroupGloo::GlooTask {
@@ -364,8 +489,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Barrier(
   std::shared_ptr<BarrierGlooTask> task;
   auto context = get_context();
   task = std::make_shared<BarrierGlooTask>(rank_, context);
-  task->Run();
-  return task;
+  return Enqueue(task, true);
 }
 
 class AllgatherGlooTask : public ProcessGroupGloo::GlooTask {
@@ -426,8 +550,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllGather(
   auto context = get_context();
   task = std::make_shared<AllgatherGlooTask>(
       rank_, context, in_tensors, out_tensors, tag);
-  task->Run();
-  return task;
+  return Enqueue(task, true);
 }
 
 class ReduceGlooTask : public ProcessGroupGloo::GlooTask {
@@ -502,8 +625,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Reduce(
                                           opts.reduce_op,
                                           opts.root_rank,
                                           tag);
-  task->Run();
-  return task;
+  return Enqueue(task, true);
 }
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Reduce(
@@ -567,8 +689,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Scatter(
   std::vector<phi::DenseTensor> out_wrapper{*out_tensor};
   task = std::make_shared<ScatterGlooTask>(
       rank_, context, in_wrapper, out_wrapper, opts.root_rank, size_, tag);
-  task->Run();
-  return task;
+  return Enqueue(task, true);
 }
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Scatter(
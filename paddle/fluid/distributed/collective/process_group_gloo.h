@@ -14,10 +14,15 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <future>
 #include <memory>
 #include <mutex>
+#include <thread>
 
+#include "paddle/fluid/distributed/collective/gloo_hierarchical_allreduce.h"
 #include "paddle/fluid/distributed/collective/process_group.h"
 #include "paddle/fluid/distributed/collective/process_group_without_stream.h"
 #include "paddle/phi/core/distributed/store/store.h"
@@ -42,12 +47,17 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
     ~GlooTask() = default;
 
     virtual void Run() = 0;
-    bool Wait(std::chrono::milliseconds timeout) override { return true; }
-    bool IsCompleted() override { return true; }
-    void Synchronize() override {}
+    bool Wait(std::chrono::milliseconds timeout = kWaitTimeout) override;
+    void Synchronize() override { Wait(); }
 
    protected:
     friend class ProcessGroupGloo;
+
+   private:
+    void Finish(std::exception_ptr exception = nullptr);
+
+    std::condition_variable cv_;
+    std::exception_ptr exception_;
   };
 
   class GlooStore : public ::gloo::rendezvous::Store {
@@ -111,7 +121,7 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
       int world_size,
       int gid);
 
-  ~ProcessGroupGloo() = default;
+  ~ProcessGroupGloo();
 
   std::shared_ptr<ProcessGroup::Task> AllGather(
       phi::DenseTensor* out_tensor,
@@ -187,6 +197,16 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
       std::vector<phi::DenseTensor>& out_tensors,
       const ScatterOptions&) override;
 
+  // Switches all-reduce between the flat gloo algorithm and a two level one
+  // that reduces through shared memory within a node, see
+  // GlooHierarchicalAllReduce. Enabling is collective over the group. Ranks
+  // with the same node_key, the hostname by default, share a node.
+  void SetHierarchicalAllReduce(
+      bool enable,
+      const std::string& node_key = "",
+      int64_t chunk_bytes = GlooHierarchicalAllReduce::kDefaultChunkBytes,
+      int64_t small_bytes = GlooHierarchicalAllReduce::kDefaultSmallBytes);
+
   std::shared_ptr<::gloo::Context> get_context() { return _context; }
   uint64_t next_tag() { return _tag++; }
 
@@ -203,10 +223,29 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
       const std::string& ifname);
   static std::shared_ptr<::gloo::transport::Device> createDefaultDevice();
 
+ protected:
+  void workLoop();
+
+  // Tasks run on the communication thread in the order they are enqueued,
+  // which is the same on every rank, so async tasks may overlap with the
+  // compute of the caller. A sync_op task is waited for before returning.
+  std::shared_ptr<ProcessGroup::Task> Enqueue(std::shared_ptr<GlooTask> task,
+                                              bool sync_op);
+
  private:
   uint32_t _tag;
   std::shared_ptr<gloo::rendezvous::Context> _context;
   std::shared_ptr<::gloo::rendezvous::Store> _store;
+  std::shared_ptr<::gloo::transport::Device> _device;
+  std::shared_ptr<GlooHierarchicalAllReduce> _hierarchical;
+  int _hierarchical_setups{0};
+
+  bool stop_{false};
+  std::mutex pg_mutex;
+  std::thread worker_thread;
+  std::deque<std::shared_ptr<GlooTask>> queue_;
+  std::condition_variable queue_produce;
+  std::condition_variable queue_consume;
 };
 
 }  // namespace distributed
@@ -1011,13 +1011,20 @@ void EagerReducer::ProcessUnusedDenseVars() {
   }
 }
 
+bool EagerReducer::SplitAfterWait() const {
+  // The all-reduce of a CPU group runs on the communication thread of the
+  // process group and has no stream to chain the split to, so the fused
+  // buffer is split only after the task is waited for in FinalizeBackward.
+  return !IsStreamSafeAllocator() || platform::is_cpu_place(inner_place_);
+}
+
 void EagerReducer::FinalizeBackward() {
   groups_need_finalize_ = false;
   grad_need_hooks_ = false;
   for (auto &group : groups_) {
     if (!group.is_sparse_) {
       group.task->Synchronize();
-      if (!IsStreamSafeAllocator()) {
+      if (SplitAfterWait()) {
         auto *default_ctx =
             platform::DeviceContextPool::Instance().Get(inner_place_);
         group.SplitTensors(*default_ctx);
@@ -1060,7 +1067,7 @@ void EagerReducer::FusedAllReduceSchedule(EagerGroup *group,
 
   auto *context = process_group_->GetDeviceContext(inner_place_);
 
-  if (IsStreamSafeAllocator()) {
+  if (!SplitAfterWait()) {
     // NOTE(shenliang03): The best_fit allocator strategy is multi-stream
     // insecure. In the Split operator, additional memory will be applied for
     // calculation, and if it is asynchronous, an illegal memory access may be
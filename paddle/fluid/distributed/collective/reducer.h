@@ -114,6 +114,8 @@ class EagerReducer {
   bool HasGrad(size_t var_index);
 
  private:
+  bool SplitAfterWait() const;
+
   std::vector<Tensor> tensors_;
   std::vector<std::vector<size_t>> group_indices_;
   std::vector<bool> is_sparse_gradient_;
@@ -19,10 +19,13 @@
 #include <set>
 #include <thread>
 
+#include "gflags/gflags.h"
 #include "paddle/fluid/distributed/fleet_executor/carrier.h"
 #include "paddle/fluid/distributed/fleet_executor/global.h"
 #include "paddle/fluid/platform/gen_comm_id_helper.h"
 
+DECLARE_bool(fleet_executor_shm_transport);
+
 namespace paddle {
 namespace distributed {
 
@@ -66,6 +69,11 @@ void MessageBus::Init(
   }
 #endif
 
+#if defined(PADDLE_WITH_DISTRIBUTE) && !defined(PADDLE_WITH_PSLIB)
+  // before the brpc server starts, so a rank that can reach this one can
+  // also open its queue
+  InitShmTransport();
+#endif
   ListenPort();
 }
 
@@ -74,6 +82,10 @@ bool MessageBus::IsInit() const { return is_init_; }
 MessageBus::~MessageBus() {
   VLOG(3) << "Message bus releases resource.";
 #if defined(PADDLE_WITH_DISTRIBUTE) && !defined(PADDLE_WITH_PSLIB)
+  if (shm_receive_thread_.joinable()) {
+    shm_stop_ = true;
+    shm_receive_thread_.join();
+  }
   server_.Stop(1000);
   server_.Join();
 #endif
@@ -98,7 +110,10 @@ bool MessageBus::Send(int64_t dst_rank,
   int retry_time = 0;  // message bus will retry sending for 10 times
   while (retry_time < 10) {
     ++retry_time;
-    if (SendInterRank(dst_rank, interceptor_message)) {
+    bool sent = IsSameHost(dst_rank)
+                    ? SendSameHost(dst_rank, interceptor_message)
+                    : SendInterRank(dst_rank, interceptor_message);
+    if (sent) {
       VLOG(3) << "Message bus sends inter rank successfully with " << retry_time
               << " times retries.";
       return true;
@@ -250,6 +265,104 @@ bool MessageBus::SendInterRank(int64_t dst_rank,
   }
 }
 
+void MessageBus::InitShmTransport() {
+  if (addr_ == "" || !FLAGS_fleet_executor_shm_transport) {
+    return;
+  }
+  bool has_same_host_rank = false;
+  for (const auto& pair : rank_to_addr_) {
+    has_same_host_rank |= pair.first != rank_ &&
+                          pair.second.substr(0, pair.second.rfind(':')) ==
+                              addr_.substr(0, addr_.rfind(':'));
+  }
+  if (!has_same_host_rank) {
+    return;
+  }
+  shm_inbox_ = ShmMessageQueue::Create(ShmQueueName(rank_), 4096);
+  shm_receive_thread_ = std::thread([this] { ReceiveSameHost(); });
+  LOG(INFO) << "Message bus receives messages from ranks on the same host "
+               "through shared memory queue "
+            << ShmQueueName(rank_);
+}
+
+bool MessageBus::IsSameHost(int64_t rank) const {
+  if (shm_inbox_ == nullptr || rank == rank_) {
+    return false;
+  }
+  const auto& addr = GetAddr(rank);
+  return addr.substr(0, addr.rfind(':')) == addr_.substr(0, addr_.rfind(':'));
+}
+
+std::string MessageBus::ShmQueueName(int64_t rank) const {
+  // a port is listened by one process of the host at a time
+  const auto& addr = GetAddr(rank);
+  return "/paddle_fleet_executor_" + addr.substr(addr.rfind(':') + 1) + "_" +
+         std::to_string(rank);
+}
+
+bool MessageBus::SendSameHost(int64_t dst_rank,
+                              const InterceptorMessage& interceptor_message) {
+  std::string buffer;
+  interceptor_message.SerializeToString(&buffer);
+  ShmMessageQueue* outbox = nullptr;
+  if (buffer.size() <= ShmMessageQueue::kMaxMessageBytes) {
+    std::lock_guard<std::mutex> lock(shm_mutex_);
+    auto& queue = shm_outboxes_[dst_rank];
+    if (queue == nullptr) {
+      queue = ShmMessageQueue::Open(ShmQueueName(dst_rank));
+    }
+    outbox = queue.get();
+  }
+  if (outbox == nullptr) {
+    // the dst rank does not receive through shared memory
+    VLOG(3) << "Message bus sends to rank " << dst_rank << " through brpc.";
+    return SendInterRank(dst_rank, interceptor_message);
+  }
+  auto start = std::chrono::steady_clock::now();
+  while (!outbox->Push(buffer.data(), buffer.size())) {
+    // the queue is full, wait for the receiver to drain it
+    if (std::chrono::steady_clock::now() - start > std::chrono::seconds(1)) {
+      VLOG(4) << "Message bus: shared memory queue of rank " << dst_rank
+              << " stays full.";
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  VLOG(3) << "Message bus: shared memory sends success.";
+  return true;
+}
+
+void MessageBus::ReceiveSameHost() {
+  std::string buffer;
+  size_t idle = 0;
+  while (!shm_stop_) {
+    if (!shm_inbox_->Pop(&buffer)) {
+      // spin for a while since messages come in bursts, then back off
+      ++idle;
+      if (idle > 4096) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      } else if (idle > 1024) {
+        std::this_thread::yield();
+      }
+      continue;
+    }
+    idle = 0;
+    InterceptorMessage interceptor_message;
+    PADDLE_ENFORCE_EQ(
+        interceptor_message.ParseFromString(buffer),
+        true,
+        platform::errors::InvalidArgument(
+            "Message bus: failed to parse a shared memory message."));
+    if (interceptor_message.ctrl_message()) {
+      IncreaseBarrierCount();
+    } else if (!DispatchMsgToCarrier(interceptor_message)) {
+      VLOG(4) << "Message bus: failed to dispatch a message from interceptor "
+              << interceptor_message.src_id() << " to interceptor "
+              << interceptor_message.dst_id();
+    }
+  }
+}
+
 #endif
 
 }  // namespace distributed
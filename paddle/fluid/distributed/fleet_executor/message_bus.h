@@ -14,7 +14,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -24,6 +26,7 @@
 #include "brpc/channel.h"
 #include "brpc/server.h"
 #include "paddle/fluid/distributed/fleet_executor/message_service.h"
+#include "paddle/fluid/distributed/fleet_executor/shm_message_queue.h"
 #endif
 
 #include "paddle/fluid/distributed/fleet_executor/interceptor_message.pb.h"
@@ -67,6 +70,15 @@ class MessageBus final {
   // send the message inter rank (dst is different rank with src)
   bool SendInterRank(int64_t dst_rank,
                      const InterceptorMessage& interceptor_message);
+
+  // ranks whose addrs have the same ip as this rank exchange messages
+  // through shared memory queues, each rank owns the queue it receives from
+  void InitShmTransport();
+  bool IsSameHost(int64_t rank) const;
+  std::string ShmQueueName(int64_t rank) const;
+  bool SendSameHost(int64_t dst_rank,
+                    const InterceptorMessage& interceptor_message);
+  void ReceiveSameHost();
 #endif
 
   bool is_init_{false};
@@ -83,6 +95,14 @@ class MessageBus final {
   MessageServiceImpl message_service_;
   // brpc server
   brpc::Server server_;
+
+  // the queue other ranks on this host send to
+  std::unique_ptr<ShmMessageQueue> shm_inbox_;
+  std::thread shm_receive_thread_;
+  std::atomic<bool> shm_stop_{false};
+  // the queues of the other ranks on this host, opened on first send
+  std::mutex shm_mutex_;
+  std::unordered_map<int64_t, std::unique_ptr<ShmMessageQueue>> shm_outboxes_;
 #endif
 
   // for barrier
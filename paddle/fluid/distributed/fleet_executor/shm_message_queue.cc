@@ -0,0 +1,210 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _WIN32
+
+#include "paddle/fluid/distributed/fleet_executor/shm_message_queue.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+constexpr uint64_t kShmQueueMagic = 0x3130514D48534650ULL;  // "PFSHMQ01"
+
+}  // namespace
+
+struct ShmMessageQueue::Header {
+  uint64_t magic;
+  uint64_t capacity;
+  // set by the owner once the slots are initialized
+  std::atomic<uint32_t> ready;
+  alignas(64) std::atomic<uint64_t> enqueue_pos;
+  alignas(64) std::atomic<uint64_t> dequeue_pos;
+};
+
+struct alignas(64) ShmMessageQueue::Slot {
+  // pos when free for the push at pos, pos + 1 when filled by it
+  std::atomic<uint64_t> sequence;
+  uint32_t size;
+  char data[kMaxMessageBytes];
+};
+
+std::unique_ptr<ShmMessageQueue> ShmMessageQueue::Create(
+    const std::string& name, size_t capacity) {
+  size_t slot_num = 1;
+  while (slot_num < capacity) {
+    slot_num <<= 1;
+  }
+  size_t segment_bytes = sizeof(Slot) + slot_num * sizeof(Slot);
+  // a segment left by a crashed run of the same rank is dropped
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  PADDLE_ENFORCE_GE(fd,
+                    0,
+                    platform::errors::Unavailable(
+                        "Failed to create shared memory queue %s.", name));
+  if (ftruncate(fd, segment_bytes) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Failed to resize shared memory queue %s to %d bytes.",
+        name,
+        segment_bytes));
+  }
+  void* addr = mmap(
+      nullptr, segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Failed to mmap shared memory queue %s.", name));
+  }
+  std::unique_ptr<ShmMessageQueue> queue(new ShmMessageQueue(
+      name, static_cast<char*>(addr), segment_bytes, true));
+  Header* header = queue->header_;
+  header->magic = kShmQueueMagic;
+  header->capacity = slot_num;
+  header->enqueue_pos.store(0, std::memory_order_relaxed);
+  header->dequeue_pos.store(0, std::memory_order_relaxed);
+  for (size_t i = 0; i < slot_num; ++i) {
+    queue->slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  header->ready.store(1, std::memory_order_release);
+  return queue;
+}
+
+std::unique_ptr<ShmMessageQueue> ShmMessageQueue::Open(
+    const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      static_cast<size_t>(file_stat.st_size) < 2 * sizeof(Slot)) {
+    close(fd);
+    return nullptr;
+  }
+  size_t segment_bytes = file_stat.st_size;
+  void* addr = mmap(
+      nullptr, segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  std::unique_ptr<ShmMessageQueue> queue(new ShmMessageQueue(
+      name, static_cast<char*>(addr), segment_bytes, false));
+  Header* header = queue->header_;
+  if (header->ready.load(std::memory_order_acquire) == 0 ||
+      header->magic != kShmQueueMagic ||
+      sizeof(Slot) + header->capacity * sizeof(Slot) != segment_bytes) {
+    return nullptr;
+  }
+  return queue;
+}
+
+ShmMessageQueue::ShmMessageQueue(const std::string& name,
+                                 char* segment,
+                                 size_t segment_bytes,
+                                 bool owner)
+    : name_(name),
+      segment_(segment),
+      segment_bytes_(segment_bytes),
+      owner_(owner),
+      header_(reinterpret_cast<Header*>(segment)),
+      // the header takes the first slot
+      slots_(reinterpret_cast<Slot*>(segment) + 1) {
+  static_assert(sizeof(Slot) == kSlotBytes,
+                "the slot of ShmMessageQueue should be kSlotBytes");
+  static_assert(sizeof(Header) <= sizeof(Slot),
+                "the header of ShmMessageQueue should fit in a slot");
+}
+
+ShmMessageQueue::~ShmMessageQueue() {
+  munmap(segment_, segment_bytes_);
+  if (owner_) {
+    shm_unlink(name_.c_str());
+  }
+}
+
+size_t ShmMessageQueue::Capacity() const { return header_->capacity; }
+
+bool ShmMessageQueue::Push(const void* data, size_t size) {
+  if (size > kMaxMessageBytes) {
+    return false;
+  }
+  uint64_t mask = header_->capacity - 1;
+  uint64_t pos = header_->enqueue_pos.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots_[pos & mask];
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    int64_t diff = static_cast<int64_t>(sequence - pos);
+    if (diff == 0) {
+      if (header_->enqueue_pos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // the slot still holds the message of the previous round
+      return false;
+    } else {
+      pos = header_->enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+  slot->size = size;
+  std::memcpy(slot->data, data, size);
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool ShmMessageQueue::Pop(std::string* data) {
+  uint64_t mask = header_->capacity - 1;
+  uint64_t pos = header_->dequeue_pos.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots_[pos & mask];
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    int64_t diff = static_cast<int64_t>(sequence - (pos + 1));
+    if (diff == 0) {
+      if (header_->dequeue_pos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = header_->dequeue_pos.load(std::memory_order_relaxed);
+    }
+  }
+  data->assign(slot->data, slot->size);
+  slot->sequence.store(pos + mask + 1, std::memory_order_release);
+  return true;
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+#endif
@@ -0,0 +1,75 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace distributed {
+
+// A bounded queue of small messages in a named POSIX shared memory segment,
+// used by the MessageBus to pass messages between ranks on the same host.
+// The receiving rank creates and owns the segment, the other processes of
+// the host open it by name and push into it. Push and Pop do not lock: every
+// slot carries a sequence number that tells the position it is free or
+// filled for, so producers claim slots with a CAS on the enqueue position
+// and a message becomes visible when its sequence is published.
+class ShmMessageQueue final {
+ public:
+  static constexpr size_t kSlotBytes = 256;
+  static constexpr size_t kMaxMessageBytes = kSlotBytes - 16;
+
+  // capacity is rounded up to a power of 2, an existing segment with the
+  // same name is replaced
+  static std::unique_ptr<ShmMessageQueue> Create(const std::string& name,
+                                                 size_t capacity);
+  // returns nullptr if the segment is not created yet
+  static std::unique_ptr<ShmMessageQueue> Open(const std::string& name);
+
+  ~ShmMessageQueue();
+
+  // returns false if the queue is full or the message is too large
+  bool Push(const void* data, size_t size);
+  // returns false if the queue is empty
+  bool Pop(std::string* data);
+
+  size_t Capacity() const;
+
+ private:
+  struct Header;
+  struct Slot;
+
+  ShmMessageQueue(const std::string& name,
+                  char* segment,
+                  size_t segment_bytes,
+                  bool owner);
+
+  DISABLE_COPY_AND_ASSIGN(ShmMessageQueue);
+
+  std::string name_;
+  char* segment_;
+  size_t segment_bytes_;
+  bool owner_;
+  Header* header_;
+  Slot* slots_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -18,12 +18,15 @@ limitations under the License. */
 #include <iostream>
 #include <unordered_map>
 
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/fleet_executor/carrier.h"
 #include "paddle/fluid/distributed/fleet_executor/global.h"
 #include "paddle/fluid/distributed/fleet_executor/interceptor.h"
 #include "paddle/fluid/distributed/fleet_executor/message_bus.h"
 
+DECLARE_bool(fleet_executor_shm_transport);
+
 namespace paddle {
 namespace distributed {
 
@@ -63,6 +66,8 @@ REGISTER_INTERCEPTOR(PingPong, PingPongInterceptor);
 
 TEST(InterceptorTest, PingPong) {
   std::cout << "Ping pong test through brpc" << std::endl;
+  // both ranks are on localhost, which would use shared memory
+  FLAGS_fleet_executor_shm_transport = false;
   unsigned int seed = time(0);
   // random generated two ports in from 6000 to 9000
   int port0 = 6000 + rand_r(&seed) % 3000;
@@ -0,0 +1,234 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/fleet_executor/carrier.h"
+#include "paddle/fluid/distributed/fleet_executor/global.h"
+#include "paddle/fluid/distributed/fleet_executor/interceptor.h"
+#include "paddle/fluid/distributed/fleet_executor/message_bus.h"
+#include "paddle/fluid/distributed/fleet_executor/shm_message_queue.h"
+
+namespace paddle {
+namespace distributed {
+
+constexpr int kRoundTrips = 10000;
+
+TEST(ShmMessageQueueTest, PushPop) {
+  std::string name = "/paddle_shm_queue_test_" + std::to_string(getpid());
+  auto queue = ShmMessageQueue::Create(name, 3);
+  EXPECT_EQ(queue->Capacity(), 4UL);
+  auto peer = ShmMessageQueue::Open(name);
+  ASSERT_NE(peer, nullptr);
+
+  std::string msg;
+  EXPECT_FALSE(queue->Pop(&msg));
+  for (int i = 0; i < 4; ++i) {
+    std::string data = "msg" + std::to_string(i);
+    EXPECT_TRUE(peer->Push(data.data(), data.size()));
+  }
+  EXPECT_FALSE(peer->Push("full", 4));
+  std::string large(ShmMessageQueue::kMaxMessageBytes + 1, 'x');
+  EXPECT_FALSE(peer->Push(large.data(), large.size()));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue->Pop(&msg));
+    EXPECT_EQ(msg, "msg" + std::to_string(i));
+  }
+  EXPECT_FALSE(queue->Pop(&msg));
+
+  queue.reset();
+  EXPECT_EQ(ShmMessageQueue::Open(name), nullptr);
+}
+
+TEST(ShmMessageQueueTest, PingPongAcrossProcesses) {
+  std::string name = "/paddle_shm_queue_test_" + std::to_string(getpid());
+  auto ping = ShmMessageQueue::Create(name + "_ping", 1024);
+  auto pong = ShmMessageQueue::Create(name + "_pong", 1024);
+  // a message of the size of a serialized InterceptorMessage
+  std::string msg(32, 'x');
+
+  int pid = fork();
+  if (pid == 0) {
+    auto in = ShmMessageQueue::Open(name + "_ping");
+    auto out = ShmMessageQueue::Open(name + "_pong");
+    std::string buffer;
+    for (int i = 0; i < kRoundTrips + 1; ++i) {
+      while (!in->Pop(&buffer)) {
+        std::this_thread::yield();
+      }
+      while (!out->Push(buffer.data(), buffer.size())) {
+        std::this_thread::yield();
+      }
+    }
+    // for stream messages, the peer pushes without waiting for replies
+    for (int i = 0; i < kRoundTrips; ++i) {
+      while (!in->Pop(&buffer)) {
+        std::this_thread::yield();
+      }
+    }
+    _exit(0);
+  }
+
+  std::string buffer;
+  auto round_trip = [&] {
+    while (!ping->Push(msg.data(), msg.size())) {
+      std::this_thread::yield();
+    }
+    while (!pong->Pop(&buffer)) {
+      std::this_thread::yield();
+    }
+  };
+  // warm up
+  round_trip();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRoundTrips; ++i) {
+    round_trip();
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(buffer, msg);
+  double us = std::chrono::duration<double, std::micro>(end - start).count();
+  std::cout << "Shared memory queue round trip latency: " << us / kRoundTrips
+            << " us" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRoundTrips; ++i) {
+    while (!ping->Push(msg.data(), msg.size())) {
+      std::this_thread::yield();
+    }
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  end = std::chrono::steady_clock::now();
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  us = std::chrono::duration<double, std::micro>(end - start).count();
+  std::cout << "Shared memory queue throughput: " << kRoundTrips / us
+            << " M msg/s" << std::endl;
+}
+
+class ShmPingPongInterceptor : public Interceptor {
+ public:
+  ShmPingPongInterceptor(int64_t interceptor_id, TaskNode* node)
+      : Interceptor(interceptor_id, node) {
+    RegisterMsgHandle([this](const InterceptorMessage& msg) { PingPong(msg); });
+  }
+
+  void PingPong(const InterceptorMessage& msg) {
+    if (msg.message_type() == STOP) {
+      StopCarrier();
+      return;
+    }
+    if (count_ == 0) {
+      start_ = std::chrono::steady_clock::now();
+    }
+    ++count_;
+    if (count_ == kRoundTrips && GetInterceptorId() == 0) {
+      double us = std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - start_)
+                      .count();
+      std::cout << "Interceptor round trip latency through message bus: "
+                << us / kRoundTrips << " us" << std::endl;
+      InterceptorMessage stop;
+      stop.set_message_type(STOP);
+      Send(0, stop);
+      Send(1, stop);
+      return;
+    }
+
+    InterceptorMessage resp;
+    int64_t dst = GetInterceptorId() == 0 ? 1 : 0;
+    Send(dst, resp);
+  }
+
+ private:
+  int count_{0};
+  std::chrono::steady_clock::time_point start_;
+};
+
+REGISTER_INTERCEPTOR(ShmPingPong, ShmPingPongInterceptor);
+
+int FindFreePort(int port) {
+  int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+  int opt = 1;
+  linger ling;
+  ling.l_onoff = 1;
+  ling.l_linger = 0;
+  setsockopt(server_fd, SOL_SOCKET, SO_LINGER, &ling, sizeof(ling));
+  setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+  struct sockaddr_in address;
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = INADDR_ANY;
+  address.sin_port = htons(port);
+  while (bind(server_fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+    port++;
+    address.sin_port = htons(port);
+  }
+  close(server_fd);
+  return port;
+}
+
+TEST(InterceptorTest, PingPongWithShm) {
+  std::cout << "Ping pong test through shared memory" << std::endl;
+  unsigned int seed = time(0);
+  // random generated two ports in from 6000 to 9000
+  int port0 = FindFreePort(6000 + rand_r(&seed) % 3000);
+  int port1 = FindFreePort(port0 + 1);
+
+  std::string ip0 = "127.0.0.1:" + std::to_string(port0);
+  std::string ip1 = "127.0.0.1:" + std::to_string(port1);
+  std::cout << "ip0: " << ip0 << std::endl;
+  std::cout << "ip1: " << ip1 << std::endl;
+  std::unordered_map<int64_t, int64_t> interceptor_id_to_rank = {{0, 0},
+                                                                 {1, 1}};
+  std::string carrier_id = "0";
+
+  int pid = fork();
+  if (pid == 0) {
+    Carrier* carrier =
+        GlobalMap<std::string, Carrier>::Create(carrier_id, carrier_id);
+    GlobalVal<std::string>::Set(new std::string(carrier_id));
+    MessageBus* msg_bus = GlobalVal<MessageBus>::Create();
+    msg_bus->Init(0, {{0, ip0}, {1, ip1}}, ip0);
+    carrier->Init(0, interceptor_id_to_rank);
+    Interceptor* a = carrier->SetInterceptor(
+        0, InterceptorFactory::Create("ShmPingPong", 0, nullptr));
+    msg_bus->Barrier();
+    InterceptorMessage msg;
+    a->Send(1, msg);
+    carrier->Wait();
+  } else {
+    Carrier* carrier =
+        GlobalMap<std::string, Carrier>::Create(carrier_id, carrier_id);
+    GlobalVal<std::string>::Set(new std::string(carrier_id));
+    MessageBus* msg_bus = GlobalVal<MessageBus>::Create();
+    msg_bus->Init(1, {{0, ip0}, {1, ip1}}, ip1);
+    carrier->Init(1, interceptor_id_to_rank);
+    carrier->SetInterceptor(
+        1, InterceptorFactory::Create("ShmPingPong", 1, nullptr));
+    msg_bus->Barrier();
+    carrier->Wait();
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -17,6 +17,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 #include "paddle/fluid/distributed/ps/service/coordinator_client.h"
 #include "paddle/fluid/framework/archive.h"
@@ -87,6 +88,132 @@ inline size_t get_sparse_shard(uint32_t shard_num,
   return (key % shard_num) / local_shard_num;
 }
 
+// keys of one table to pull, deduplicated and grouped by server. the unique
+// keys are ordered by a one pass radix (counting) sort on the server index,
+// so the keys of server i are keys[server_offset[i], server_offset[i + 1]).
+struct SparsePullPlan {
+  size_t value_size = 0;
+  SparsePullCache *pull_cache = nullptr;
+  // returned by the Lookup of pull_cache
+  uint64_t cache_generation = 0;
+  // output buffer of every requested key
+  std::vector<float *> select_values;
+  // unique slot of every requested key
+  std::vector<uint32_t> inverse;
+  std::vector<uint64_t> keys;
+  std::vector<uint32_t> counts;
+  // requested index of the first occurrence of every unique key
+  std::vector<uint32_t> first_index;
+  std::vector<size_t> server_offset;
+
+  size_t ServerKeyNum(size_t server_id) const {
+    return server_offset[server_id + 1] - server_offset[server_id];
+  }
+};
+
+void BuildSparsePullPlan(float **select_values,
+                         const uint64_t *keys,
+                         size_t num,
+                         uint32_t shard_num,
+                         size_t server_num,
+                         SparsePullPlan *plan) {
+  plan->select_values.assign(select_values, select_values + num);
+  plan->inverse.resize(num);
+
+  std::unordered_map<uint64_t, uint32_t> key_slots;
+  key_slots.reserve(num);
+  std::vector<uint32_t> unique_index;
+  unique_index.reserve(num);
+  for (size_t i = 0; i < num; ++i) {
+    auto ret = key_slots.emplace(keys[i], unique_index.size());
+    if (ret.second) {
+      unique_index.push_back(i);
+    }
+    plan->inverse[i] = ret.first->second;
+  }
+
+  size_t unique_num = unique_index.size();
+  std::vector<uint32_t> server_ids(unique_num);
+  plan->server_offset.assign(server_num + 1, 0);
+  for (size_t u = 0; u < unique_num; ++u) {
+    server_ids[u] =
+        get_sparse_shard(shard_num, server_num, keys[unique_index[u]]);
+    ++plan->server_offset[server_ids[u] + 1];
+  }
+  for (size_t i = 0; i < server_num; ++i) {
+    plan->server_offset[i + 1] += plan->server_offset[i];
+  }
+
+  std::vector<size_t> cursor(plan->server_offset.begin(),
+                             plan->server_offset.end() - 1);
+  std::vector<uint32_t> sorted_slots(unique_num);
+  plan->keys.resize(unique_num);
+  plan->counts.assign(unique_num, 0);
+  plan->first_index.resize(unique_num);
+  for (size_t u = 0; u < unique_num; ++u) {
+    size_t slot = cursor[server_ids[u]]++;
+    sorted_slots[u] = slot;
+    plan->keys[slot] = keys[unique_index[u]];
+    plan->first_index[slot] = unique_index[u];
+  }
+  for (size_t i = 0; i < num; ++i) {
+    plan->inverse[i] = sorted_slots[plan->inverse[i]];
+    ++plan->counts[plan->inverse[i]];
+  }
+}
+
+// |key_num 4B|keys 8B*n|frequencies 4B*n| of the keys on server_id
+void AppendSparsePullKeys(const SparsePullPlan &plan,
+                          size_t server_id,
+                          butil::IOBuf *request_buffer) {
+  size_t begin = plan.server_offset[server_id];
+  uint32_t key_num = plan.ServerKeyNum(server_id);
+  request_buffer->append(reinterpret_cast<const void *>(&key_num),
+                         sizeof(uint32_t));
+  request_buffer->append(
+      reinterpret_cast<const void *>(plan.keys.data() + begin),
+      sizeof(uint64_t) * key_num);
+  request_buffer->append(
+      reinterpret_cast<const void *>(plan.counts.data() + begin),
+      sizeof(uint32_t) * key_num);
+}
+
+// copy the values of the keys on server_id from the response straight into
+// the caller buffers, only the first occurrence of a key is written here
+int ScatterSparsePullValues(const SparsePullPlan &plan,
+                            size_t server_id,
+                            butil::IOBufBytesIterator *io_buffer_itr) {
+  for (size_t slot = plan.server_offset[server_id];
+       slot < plan.server_offset[server_id + 1];
+       ++slot) {
+    void *dst = plan.select_values[plan.first_index[slot]];
+    if (plan.value_size !=
+        io_buffer_itr->copy_and_forward(dst, plan.value_size)) {
+      LOG(WARNING) << "res data is lack or not in format";
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// fill duplicated keys and the hot key cache once every server responded
+void FinishSparsePull(const SparsePullPlan &plan) {
+  for (size_t i = 0; i < plan.inverse.size(); ++i) {
+    uint32_t first = plan.first_index[plan.inverse[i]];
+    if (first != i) {
+      memcpy(plan.select_values[i], plan.select_values[first], plan.value_size);
+    }
+  }
+  if (plan.pull_cache != nullptr) {
+    for (size_t slot = 0; slot < plan.keys.size(); ++slot) {
+      plan.pull_cache->Update(&plan.keys[slot],
+                              &plan.select_values[plan.first_index[slot]],
+                              1,
+                              plan.cache_generation);
+    }
+  }
+}
+
 void DownpourPsClientService::service(
     ::google::protobuf::RpcController *controller,
     const PsRequestMessage *request,
@@ -343,6 +470,16 @@ int32_t BrpcPsClient::Initialize() {
           paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
     }
+    const auto &compress_param =
+        worker_param.downpour_table_param(i).grad_compress_param();
+    // slot/show/click of sparse pushes are sent as they are by default
+    auto compressor = CreateGradCompressor(
+        compress_param, GetTableAccessor(table_id)->GetPushPrefixDim());
+    if (compressor != nullptr) {
+      VLOG(0) << "BrpcPsClient table " << table_id << " push with "
+              << compress_param.compress_type() << " grad compress";
+      _table_grad_compressors[table_id] = compressor;
+    }
   }
 
   auto &profiler = CostProfiler::instance();
@@ -440,6 +577,14 @@ int FlClientBrpcClosure::check_response(size_t request_idx, int cmd_id) {
 }
 
 std::future<int32_t> BrpcPsClient::PrintTableStat(uint32_t table_id) {
+  auto *pull_cache = GetSparsePullCache(table_id);
+  if (pull_cache != nullptr) {
+    auto stat = pull_cache->GetStat();
+    std::cout << "table id: " << table_id
+              << ", pull cache hit rate: " << stat.HitRate()
+              << ", cached keys: " << stat.cached_num
+              << ", rpc bytes saved: " << stat.saved_bytes << std::endl;
+  }
   size_t request_call_num = _server_channels.size();
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
       request_call_num, [request_call_num, table_id](void *done) {
@@ -556,6 +701,10 @@ std::future<int32_t> BrpcPsClient::SendSaveCmd(
 
 std::future<int32_t> BrpcPsClient::Shrink(uint32_t table_id,
                                           const std::string threshold) {
+  auto *compressor = GetGradCompressor(table_id);
+  if (compressor != nullptr) {
+    compressor->ShrinkResiduals();
+  }
   return SendCmd(table_id, PS_SHRINK_TABLE, {threshold});
 }
 
@@ -1007,6 +1156,11 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     size_t num,
     void *done) {
   auto *accessor = GetTableAccessor(table_id);
+  auto *compressor = GetGradCompressor(table_id);
+  auto *pull_cache = GetSparsePullCache(table_id);
+  if (pull_cache != nullptr) {
+    pull_cache->Invalidate(keys, num);
+  }
   // 发送RPC请求
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -1049,14 +1203,33 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     push_request->set_client_id(_client_id);
     push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
     auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (size_t i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], value_size);
-      push_data_ptr += value_size;
+    if (compressor != nullptr) {
+      /*
+      Push Content:
+      |---keysData---|---compressedValues---|
+      |---8*{num}B---|---see grad_compressor.h---|
+      */
+      uint32_t compress_type = compressor->Type();
+      push_request->add_params((char *)&compress_type,  // NOLINT
+                               sizeof(uint32_t));
+      uint32_t value_dim = value_size / sizeof(float);
+      push_data->resize(kv_size * sizeof(uint64_t) +
+                        compressor->EncodedSize(kv_size, value_dim));
+      char *push_data_ptr = const_cast<char *>(push_data->data());
+      memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
+      push_data_ptr += kv_size * sizeof(uint64_t);
+      compressor->Encode(
+          kvs.data(), value_ptr.data(), kv_size, value_dim, push_data_ptr);
+    } else {
+      push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
+      char *push_data_ptr = const_cast<char *>(push_data->data());
+      memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
+      push_data_ptr += kv_size * sizeof(uint64_t);
+
+      for (size_t i = 0; i < kv_size; ++i) {
+        memcpy(push_data_ptr, value_ptr[i], value_size);
+        push_data_ptr += value_size;
+      }
     }
     PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
     closure->cntl(shard_idx)->set_request_compress_type(
@@ -1080,6 +1253,7 @@ std::future<int32_t> BrpcPsClient::PushDenseRawGradient(
   closure->add_promise(promise);
   std::future<int> fut = promise->get_future();
   auto *accessor = GetTableAccessor(table_id);
+  auto *compressor = GetGradCompressor(table_id);
   uint32_t num_per_shard =
       DenseDimPerShard(accessor->GetAccessorInfo().fea_dim, request_call_num);
   for (size_t i = 0; i < request_call_num; ++i) {
@@ -1088,12 +1262,30 @@ std::future<int32_t> BrpcPsClient::PushDenseRawGradient(
     closure->request(i)->set_client_id(_client_id);
     auto *push_data = closure->request(i)->mutable_data();
     push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard,
-           num_per_shard * sizeof(float));
+    const float *shard_data = total_send_data + i * num_per_shard;
+    if (compressor != nullptr) {
+      // the whole shard is one row, residual keyed by shard index
+      uint32_t compress_type = compressor->Type();
+      closure->request(i)->add_params((char *)&compress_type,  // NOLINT
+                                      sizeof(uint32_t));
+      uint64_t shard_key = i;
+      push_data->resize(sizeof(uint32_t) +
+                        compressor->EncodedSize(1, num_per_shard));
+      char *push_data_ptr = const_cast<char *>(push_data->data());
+      memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
+      compressor->Encode(&shard_key,
+                         &shard_data,
+                         1,
+                         num_per_shard,
+                         push_data_ptr + sizeof(uint32_t));
+    } else {
+      push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
+      char *push_data_ptr = const_cast<char *>(push_data->data());
+      memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
+      memcpy(push_data_ptr + sizeof(uint32_t),
+             shard_data,
+             num_per_shard * sizeof(float));
+    }
     // closure->cntl(i)->set_request_compress_type(
     //     (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(GetDenseChannel(i));
@@ -1132,6 +1324,17 @@ std::future<int32_t> BrpcPsClient::PushGlobalStep(int table_id,
   return fut;
 }
 
+uint32_t BrpcPsClient::GetSparseShardNum(size_t table_id) {
+  const auto &server_param = _config.server_param().downpour_server_param();
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (table_param.table_id() == table_id) {
+      return table_param.shard_num();
+    }
+  }
+  return FLAGS_pserver_sparse_table_shard_num;
+}
+
 std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
                                               size_t table_id,
                                               const uint64_t *keys,
@@ -1142,64 +1345,50 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       std::make_shared<CostTimer>("pserver_client_pull_sparse_local");
   size_t request_call_num = _server_channels.size();
 
-  auto shard_sorted_kvs = std::make_shared<
-      std::vector<std::vector<std::pair<uint64_t, float *>>>>();
-  shard_sorted_kvs->resize(request_call_num);
-
-  const auto &server_param = _config.server_param().downpour_server_param();
-  uint64_t shard_num = FLAGS_pserver_sparse_table_shard_num;
-  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
-    const auto &table_param = server_param.downpour_table_param(i);
-    if (table_param.table_id() == table_id) {
-      shard_num = table_param.shard_num();
-      break;
-    }
+  // only keys missed by the hot key cache go over the wire
+  auto *pull_cache = GetSparsePullCache(table_id);
+  std::vector<uint64_t> miss_keys;
+  std::vector<float *> miss_values;
+  uint64_t cache_generation = 0;
+  if (pull_cache != nullptr) {
+    cache_generation = pull_cache->Lookup(
+        keys, select_values, num, &miss_keys, &miss_values);
+    keys = miss_keys.data();
+    select_values = miss_values.data();
+    num = miss_keys.size();
   }
 
-  for (size_t i = 0; i < num; ++i) {
-    size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
-    shard_sorted_kvs->at(shard_id).push_back({keys[i], select_values[i]});
-  }
-
-  auto *accessor = GetTableAccessor(table_id);
-
-  size_t value_size = accessor->GetAccessorInfo().select_size;
+  auto plan = std::make_shared<SparsePullPlan>();
+  plan->value_size =
+      GetTableAccessor(table_id)->GetAccessorInfo().select_size;
+  plan->pull_cache = pull_cache;
+  plan->cache_generation = cache_generation;
+  BuildSparsePullPlan(select_values,
+                      keys,
+                      num,
+                      GetSparseShardNum(table_id),
+                      request_call_num,
+                      plan.get());
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num, [plan, request_call_num](void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
-        for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
+        for (size_t i = 0; i < request_call_num; ++i) {
           if (closure->check_response(i, PS_PULL_SPARSE_TABLE) != 0) {
             ret = -1;
             break;
           }
-
-          auto &request_kvs = shard_sorted_kvs->at(i);
-          auto &res_io_buffer = closure->cntl(i)->response_attachment();
-          butil::IOBufBytesIterator io_buffer_itr(res_io_buffer);
-          uint64_t last_key = UINT64_MAX;
-          float *last_value_data = NULL;
-
-          for (size_t kv_idx = 0; kv_idx < request_kvs.size(); ++kv_idx) {
-            auto *kv_pair = &(request_kvs[kv_idx]);
-            if (kv_pair->first == last_key) {
-              memcpy(reinterpret_cast<void *>(kv_pair->second),
-                     reinterpret_cast<void *>(last_value_data),
-                     value_size);
-            } else {
-              last_key = kv_pair->first;
-              last_value_data = kv_pair->second;
-              if (value_size !=
-                  io_buffer_itr.copy_and_forward(
-                      reinterpret_cast<void *>(last_value_data), value_size)) {
-                LOG(WARNING) << "res data is lack or not in format";
-                ret = -1;
-                break;
-              }
-            }
+          butil::IOBufBytesIterator io_buffer_itr(
+              closure->cntl(i)->response_attachment());
+          if (ScatterSparsePullValues(*plan, i, &io_buffer_itr) != 0) {
+            ret = -1;
+            break;
           }
         }
+        if (ret == 0) {
+          FinishSparsePull(*plan);
+        }
         closure->set_promise_value(ret);
       });
   closure->add_timer(timer);
@@ -1208,53 +1397,139 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   std::future<int> fut = promise->get_future();
 
   for (size_t i = 0; i < request_call_num; ++i) {
-    auto &sorted_kvs = shard_sorted_kvs->at(i);
-    std::sort(sorted_kvs.begin(),
-              sorted_kvs.end(),
-              [](const std::pair<uint64_t, float *> &k1,
-                 const std::pair<uint64_t, float *> &k2) {
-                return k1.first < k2.first;
-              });
-
-    uint64_t last_key = UINT64_MAX;
-    uint32_t kv_request_count = 0;
-    size_t sorted_kv_size = sorted_kvs.size();
+    uint32_t kv_request_count = plan->ServerKeyNum(i);
+    if (kv_request_count == 0) {
+      closure->Run();
+      continue;
+    }
+    size_t begin = plan->server_offset[i];
     auto &request_buffer = closure->cntl(i)->request_attachment();
-
     request_buffer.append(reinterpret_cast<void *>(&is_training), sizeof(bool));
-    std::vector<uint32_t> keys_counter;
-    keys_counter.reserve(sorted_kv_size);
+    request_buffer.append(
+        reinterpret_cast<const void *>(plan->keys.data() + begin),
+        sizeof(uint64_t) * kv_request_count);
+    request_buffer.append(
+        reinterpret_cast<const void *>(plan->counts.data() + begin),
+        sizeof(uint32_t) * kv_request_count);
+
+    closure->request(i)->set_cmd_id(PS_PULL_SPARSE_TABLE);
+    closure->request(i)->set_table_id(table_id);
+    closure->request(i)->set_client_id(_client_id);
+    closure->request(i)->add_params((char *)&kv_request_count,  // NOLINT
+                                    sizeof(uint32_t));
+    PsService_Stub rpc_stub(GetCmdChannel(i));
+    closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
+    rpc_stub.service(
+        closure->cntl(i), closure->request(i), closure->response(i), closure);
+  }
+  return fut;
+}
 
-    for (size_t kv_idx = 0; kv_idx < sorted_kv_size; ++kv_idx) {
-      ++kv_request_count;
-      uint32_t keys = 1;
-      last_key = sorted_kvs[kv_idx].first;
-      request_buffer.append(reinterpret_cast<void *>(&last_key),
-                            sizeof(uint64_t));
-      while (kv_idx < sorted_kv_size - 1 &&
-             last_key == sorted_kvs[kv_idx + 1].first) {
-        ++kv_idx;
-        ++keys;
-      }
-      keys_counter.push_back(keys);
+std::future<int32_t> BrpcPsClient::PullSparseMultiTable(
+    const std::vector<PullSparseRequest> &requests, bool is_training) {
+  auto timer = std::make_shared<CostTimer>("pserver_client_pull_sparse");
+  size_t request_call_num = _server_channels.size();
+  if (requests.empty()) {
+    std::promise<int32_t> promise;
+    std::future<int> fut = promise.get_future();
+    promise.set_value(0);
+    return fut;
+  }
+
+  auto plans = std::make_shared<std::vector<SparsePullPlan>>(requests.size());
+  std::vector<uint64_t> miss_keys;
+  std::vector<float *> miss_values;
+  for (size_t t = 0; t < requests.size(); ++t) {
+    const auto &request = requests[t];
+    auto &plan = plans->at(t);
+    plan.value_size =
+        GetTableAccessor(request.table_id)->GetAccessorInfo().select_size;
+    plan.pull_cache = GetSparsePullCache(request.table_id);
+    float **select_values = request.select_values;
+    const uint64_t *keys = request.keys;
+    size_t num = request.num;
+    if (plan.pull_cache != nullptr) {
+      plan.cache_generation = plan.pull_cache->Lookup(
+          keys, select_values, num, &miss_keys, &miss_values);
+      keys = miss_keys.data();
+      select_values = miss_values.data();
+      num = miss_keys.size();
     }
+    BuildSparsePullPlan(select_values,
+                        keys,
+                        num,
+                        GetSparseShardNum(request.table_id),
+                        request_call_num,
+                        &plan);
+  }
 
-    request_buffer.append(reinterpret_cast<void *>(keys_counter.data()),
-                          sizeof(uint32_t) * keys_counter.size());
+  // the response of a server holds the values of every table back to back
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [plans, request_call_num](void *done) {
+        int ret = 0;
+        auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        for (size_t i = 0; i < request_call_num && ret == 0; ++i) {
+          if (closure->check_response(i, PS_PULL_SPARSE_MULTI_TABLE) != 0) {
+            ret = -1;
+            break;
+          }
+          butil::IOBufBytesIterator io_buffer_itr(
+              closure->cntl(i)->response_attachment());
+          for (auto &plan : *plans) {
+            if (ScatterSparsePullValues(plan, i, &io_buffer_itr) != 0) {
+              ret = -1;
+              break;
+            }
+          }
+        }
+        if (ret == 0) {
+          for (auto &plan : *plans) {
+            FinishSparsePull(plan);
+          }
+        }
+        closure->set_promise_value(ret);
+      });
+  closure->add_timer(timer);
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
 
-    if (kv_request_count == 0) {
+  uint32_t table_num = requests.size();
+  for (size_t i = 0; i < request_call_num; ++i) {
+    size_t server_key_num = 0;
+    for (auto &plan : *plans) {
+      server_key_num += plan.ServerKeyNum(i);
+    }
+    if (server_key_num == 0) {
       closure->Run();
-    } else {
-      closure->request(i)->set_cmd_id(PS_PULL_SPARSE_TABLE);
-      closure->request(i)->set_table_id(table_id);
-      closure->request(i)->set_client_id(_client_id);
-      closure->request(i)->add_params((char *)&kv_request_count,  // NOLINT
-                                      sizeof(uint32_t));
-      PsService_Stub rpc_stub(GetCmdChannel(i));
-      closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
-      rpc_stub.service(
-          closure->cntl(i), closure->request(i), closure->response(i), closure);
+      continue;
+    }
+    /*
+    |---isTraining--------------|
+    |---per table:
+    |------4B(table_id)---------|
+    |------4B(num)--------------|
+    |------8*{num}B(keysData)---|
+    |------4*{num}B(Frequencies)|
+    */
+    auto &request_buffer = closure->cntl(i)->request_attachment();
+    request_buffer.append(reinterpret_cast<void *>(&is_training), sizeof(bool));
+    for (size_t t = 0; t < requests.size(); ++t) {
+      uint32_t table_id = requests[t].table_id;
+      request_buffer.append(reinterpret_cast<void *>(&table_id),
+                            sizeof(uint32_t));
+      AppendSparsePullKeys(plans->at(t), i, &request_buffer);
     }
+
+    closure->request(i)->set_cmd_id(PS_PULL_SPARSE_MULTI_TABLE);
+    closure->request(i)->set_table_id(requests[0].table_id);
+    closure->request(i)->set_client_id(_client_id);
+    closure->request(i)->add_params((char *)&table_num,  // NOLINT
+                                    sizeof(uint32_t));
+    PsService_Stub rpc_stub(GetCmdChannel(i));
+    closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
+    rpc_stub.service(
+        closure->cntl(i), closure->request(i), closure->response(i), closure);
   }
   return fut;
 }
@@ -1410,6 +1685,10 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradientPartial(
     int pserver_idx) {
   auto *accessor = GetTableAccessor(table_id);
   size_t value_size = accessor->GetAccessorInfo().update_size;
+  auto *pull_cache = GetSparsePullCache(table_id);
+  if (pull_cache != nullptr) {
+    pull_cache->Invalidate(keys, num);
+  }
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
   closure->add_promise(promise);
@@ -1530,6 +1809,10 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
                                               size_t num) {
   auto push_timer = std::make_shared<CostTimer>("pserver_client_push_sparse");
   CostTimer parse_timer("pserver_client_push_sparse_parse");
+  auto *pull_cache = GetSparsePullCache(table_id);
+  if (pull_cache != nullptr) {
+    pull_cache->Invalidate(keys, num);
+  }
   int push_sparse_async_num = _push_sparse_task_queue_map[table_id]->Size();
   while (push_sparse_async_num > FLAGS_pserver_max_async_call_num) {
     //    LOG(INFO) << "PushSparse Waiting for async_call_num comsume,
@@ -24,6 +24,7 @@
 #include "brpc/controller.h"
 #include "brpc/server.h"
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
+#include "paddle/fluid/distributed/ps/service/grad_compressor.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
 #include "paddle/fluid/framework/channel.h"
@@ -261,6 +262,9 @@ class BrpcPsClient : public PSClient {
                                           const uint64_t *keys,
                                           size_t num,
                                           bool is_training);
+  std::future<int32_t> PullSparseMultiTable(
+      const std::vector<PullSparseRequest> &requests,
+      bool is_training) override;
   virtual std::future<int32_t> PullSparseParam(float **select_values,
                                                size_t table_id,
                                                const uint64_t *keys,
@@ -310,6 +314,15 @@ class BrpcPsClient : public PSClient {
   void PrintQueueSize();
   void PrintQueueSizeThread();
 
+  // nullptr if pushes of table_id are not compressed
+  GradCompressor *GetGradCompressor(size_t table_id) {
+    auto itr = _table_grad_compressors.find(table_id);
+    if (itr == _table_grad_compressors.end()) {
+      return nullptr;
+    }
+    return itr->second.get();
+  }
+
  protected:
   virtual size_t GetServerNums() { return _server_channels.size(); }
   inline brpc::Channel *GetSparseChannel(size_t server_id) {
@@ -337,6 +350,9 @@ class BrpcPsClient : public PSClient {
     return dense_dim_total / shard_num + 1;
   }
 
+  // shard_num of a sparse table in the server param
+  uint32_t GetSparseShardNum(size_t table_id);
+
   std::future<int32_t> SendCmd(uint32_t table_id,
                                int cmd_id,
                                const std::vector<std::string> &param);
@@ -360,6 +376,9 @@ class BrpcPsClient : public PSClient {
   std::unordered_map<uint32_t, paddle::framework::Channel<SparseAsyncTask *>>
       _push_sparse_task_queue_map;
   std::unordered_map<uint32_t, uint32_t> _push_sparse_merge_count_map;
+  // gradient compressor of push raw gradient, keyed by table_id
+  std::unordered_map<uint32_t, std::shared_ptr<GradCompressor>>
+      _table_grad_compressors;
 
   std::thread _print_thread;
 
@@ -18,6 +18,7 @@
 
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/grad_compressor.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -192,6 +193,8 @@ int32_t BrpcPsService::Initialize() {
   _service_handler_map[PS_PULL_DENSE_TABLE] = &BrpcPsService::PullDense;
   _service_handler_map[PS_PUSH_DENSE_TABLE] = &BrpcPsService::PushDense;
   _service_handler_map[PS_PULL_SPARSE_TABLE] = &BrpcPsService::PullSparse;
+  _service_handler_map[PS_PULL_SPARSE_MULTI_TABLE] =
+      &BrpcPsService::PullSparseMultiTable;
   _service_handler_map[PS_PUSH_SPARSE_TABLE] = &BrpcPsService::PushSparse;
   _service_handler_map[PS_SAVE_ONE_TABLE] = &BrpcPsService::SaveOneTable;
   _service_handler_map[PS_SAVE_ALL_TABLE] = &BrpcPsService::SaveAllTable;
@@ -389,12 +392,31 @@ int32_t BrpcPsService::PushDense(Table *table,
   table_context.push_context.values =
       (const float *)(request.data().data() + sizeof(uint32_t));
   table_context.num = num;
+  // compressed by GradCompressor, params(0) holds the compress type
+  std::vector<float> *decode_data = nullptr;
+  if (request.params_size() > 0) {
+    decode_data = butil::get_object<std::vector<float>>();
+    decode_data->resize(num);
+    if (GradCompressor::Decode(request.data().data() + sizeof(uint32_t),
+                               req_buffer_size - sizeof(uint32_t),
+                               1,
+                               num,
+                               decode_data->data()) != 0) {
+      butil::return_object(decode_data);
+      set_response_code(response, -1, "PushDense decode grad failed");
+      return 0;
+    }
+    table_context.push_context.values = decode_data->data();
+  }
   // const float *values = (const float *)(request.data().data() +
   // sizeof(uint32_t));
   if (table->Push(table_context) != 0) {
     // if (table->PushDense(values, num) != 0) {
     set_response_code(response, -1, "PushDense failed");
   }
+  if (decode_data != nullptr) {
+    butil::return_object(decode_data);
+  }
 
   return 0;
 }
@@ -549,6 +571,88 @@ int32_t BrpcPsService::PullSparse(Table *table,
   return 0;
 }
 
+int32_t BrpcPsService::PullSparseMultiTable(Table *table,
+                                            const PsRequestMessage &request,
+                                            PsResponseMessage &response,
+                                            brpc::Controller *cntl) {
+  platform::RecordEvent record_event("PsService->PullSparseMultiTable",
+                                     platform::TracerEventType::Communication,
+                                     1);
+  CHECK_TABLE_EXIST(table, request, response)
+
+  auto &req_io_buffer = cntl->request_attachment();
+  auto req_buffer_size = req_io_buffer.size();
+  if (req_buffer_size < 1) {
+    set_response_code(response, -1, "req attachment is empty");
+    return 0;
+  }
+  if (request.params_size() < 1) {
+    set_response_code(response,
+                      -1,
+                      "PsRequestMessage.params is requeired at "
+                      "least 1 for num of tables");
+    return 0;
+  }
+
+  CostTimer timer("pserver_server_pull_sparse");
+  const uint32_t table_num =
+      *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
+
+  thread_local std::string req_buffer;
+  req_buffer.resize(req_buffer_size);
+  const char *data = reinterpret_cast<const char *>(
+      req_io_buffer.fetch(const_cast<char *>(req_buffer.data()),
+                          req_buffer_size));
+  const char *data_end = data + req_buffer_size;
+  bool is_training = *reinterpret_cast<const bool *>(data);
+  data += sizeof(bool);
+
+  auto res_data = butil::get_object<std::vector<float>>();
+  for (uint32_t t = 0; t < table_num; ++t) {
+    uint32_t table_id = 0;
+    uint32_t num = 0;
+    if (data + 2 * sizeof(uint32_t) > data_end) {
+      set_response_code(response, -1, "req attachment is not in format");
+      break;
+    }
+    memcpy(&table_id, data, sizeof(uint32_t));
+    memcpy(&num, data + sizeof(uint32_t), sizeof(uint32_t));
+    data += 2 * sizeof(uint32_t);
+    if (data + num * (sizeof(uint64_t) + sizeof(uint32_t)) > data_end) {
+      set_response_code(response, -1, "req attachment is not in format");
+      break;
+    }
+    auto *sub_table = _server->GetTable(table_id);
+    if (sub_table == NULL) {
+      std::string err_msg("table not found with table_id:");
+      err_msg.append(std::to_string(table_id));
+      set_response_code(response, -1, err_msg.c_str());
+      break;
+    }
+
+    auto dim = sub_table->ValueAccesor()->GetAccessorInfo().select_dim;
+    auto value = PullSparseValue(num, dim);
+    value.is_training_ = is_training;
+    value.feasigns_ =
+        reinterpret_cast<uint64_t *>(const_cast<char *>(data));
+    value.frequencies_ = reinterpret_cast<uint32_t *>(
+        const_cast<char *>(data + sizeof(uint64_t) * num));
+    data += num * (sizeof(uint64_t) + sizeof(uint32_t));
+
+    res_data->resize(num * dim);
+    TableContext table_context;
+    table_context.value_type = Sparse;
+    table_context.pull_context.pull_value = value;
+    table_context.pull_context.values = res_data->data();
+    sub_table->Pull(table_context);
+    cntl->response_attachment().append(
+        reinterpret_cast<char *>(res_data->data()),
+        res_data->size() * sizeof(float));
+  }
+  butil::return_object(res_data);
+  return 0;
+}
+
 int32_t BrpcPsService::PushSparse(Table *table,
                                   const PsRequestMessage &request,
                                   PsResponseMessage &response,
@@ -582,6 +686,23 @@ int32_t BrpcPsService::PushSparse(Table *table,
   table_context.push_context.values =
       (const float *)(push_data.data() + sizeof(uint64_t) * num);
   table_context.num = num;
+  // compressed by GradCompressor, params(1) holds the compress type
+  std::vector<float> *decode_data = nullptr;
+  if (request.params_size() > 1) {
+    auto dim = table->ValueAccesor()->GetAccessorInfo().update_dim;
+    decode_data = butil::get_object<std::vector<float>>();
+    decode_data->resize(num * dim);
+    if (GradCompressor::Decode(push_data.data() + sizeof(uint64_t) * num,
+                               push_data.size() - sizeof(uint64_t) * num,
+                               num,
+                               dim,
+                               decode_data->data()) != 0) {
+      butil::return_object(decode_data);
+      set_response_code(response, -1, "PushSparse decode grad failed");
+      return 0;
+    }
+    table_context.push_context.values = decode_data->data();
+  }
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
   // num);
@@ -589,6 +710,9 @@ int32_t BrpcPsService::PushSparse(Table *table,
     // if (table->PushSparse(keys, values, num) != 0) {
     set_response_code(response, -1, "PushSparse error");
   }
+  if (decode_data != nullptr) {
+    butil::return_object(decode_data);
+  }
   return 0;
 }
 
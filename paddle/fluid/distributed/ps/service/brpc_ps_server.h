@@ -109,6 +109,10 @@ class BrpcPsService : public PsBaseService {
                      const PsRequestMessage &request,
                      PsResponseMessage &response,  // NOLINT
                      brpc::Controller *cntl);
+  int32_t PullSparseMultiTable(Table *table,
+                               const PsRequestMessage &request,
+                               PsResponseMessage &response,  // NOLINT
+                               brpc::Controller *cntl);
   int32_t PullGeoParam(Table *table,
                        const PsRequestMessage &request,
                        PsResponseMessage &response,  // NOLINT
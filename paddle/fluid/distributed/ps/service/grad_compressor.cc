@@ -0,0 +1,326 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/grad_compressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "glog/logging.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+// codec bytes of one row without the raw prefix
+size_t CodecRowSize(uint32_t type, size_t dim, uint32_t k) {
+  switch (type) {
+    case GRAD_COMPRESS_FP16:
+      return dim * sizeof(uint16_t);
+    case GRAD_COMPRESS_TOPK:
+      return k * (sizeof(uint32_t) + sizeof(float));
+    case GRAD_COMPRESS_SIGN:
+      return sizeof(float) + (dim + 7) / 8;
+    default:
+      return dim * sizeof(float);
+  }
+}
+
+}  // namespace
+
+int32_t GradCompressor::Initialize(const GradCompressParameter &param) {
+  _prefix_dim = param.raw_prefix_dim();
+  _max_residual_keys = param.max_residual_keys();
+  return 0;
+}
+
+size_t GradCompressor::EncodedSize(size_t num, size_t dim) const {
+  size_t prefix_dim = std::min<size_t>(_prefix_dim, dim);
+  size_t codec_dim = dim - prefix_dim;
+  size_t row_size = prefix_dim * sizeof(float) +
+                    CodecRowSize(Type(), codec_dim, RowParam(codec_dim));
+  return sizeof(GradCompressHeader) + num * row_size;
+}
+
+float *GradCompressor::Residual(uint64_t key, size_t dim) {
+  auto &residual = _residuals[key];
+  if (residual.value.size() != dim) {
+    residual.value.assign(dim, 0.0);
+  }
+  residual.step = _encode_step;
+  return residual.value.data();
+}
+
+void GradCompressor::EvictResiduals() {
+  if (_max_residual_keys == 0 || _residuals.size() <= _max_residual_keys) {
+    return;
+  }
+  std::vector<uint64_t> steps;
+  steps.reserve(_residuals.size());
+  for (auto &residual : _residuals) {
+    steps.push_back(residual.second.step);
+  }
+  auto mid = steps.begin() + steps.size() / 2;
+  std::nth_element(steps.begin(), mid, steps.end());
+  uint64_t min_step = *mid;
+  for (auto it = _residuals.begin(); it != _residuals.end();) {
+    if (it->second.step < min_step) {
+      it = _residuals.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  // the keys of a single push are more than the limit
+  for (auto it = _residuals.begin(); _residuals.size() > _max_residual_keys;) {
+    it = _residuals.erase(it);
+  }
+}
+
+void GradCompressor::ShrinkResiduals() {
+  std::lock_guard<std::mutex> lock(_residual_mutex);
+  for (auto it = _residuals.begin(); it != _residuals.end();) {
+    if (it->second.step < _shrink_step) {
+      it = _residuals.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  _shrink_step = _encode_step;
+}
+
+size_t GradCompressor::ResidualSize() {
+  std::lock_guard<std::mutex> lock(_residual_mutex);
+  return _residuals.size();
+}
+
+void GradCompressor::Encode(const uint64_t *keys,
+                            const float *const *rows,
+                            size_t num,
+                            size_t dim,
+                            char *out) {
+  size_t prefix_dim = std::min<size_t>(_prefix_dim, dim);
+  size_t codec_dim = dim - prefix_dim;
+  GradCompressHeader header;
+  header.type = Type();
+  header.prefix_dim = prefix_dim;
+  header.k = RowParam(codec_dim);
+  memcpy(out, &header, sizeof(GradCompressHeader));
+  char *out_ptr = out + sizeof(GradCompressHeader);
+
+  size_t prefix_size = prefix_dim * sizeof(float);
+  size_t codec_size = CodecRowSize(header.type, codec_dim, header.k);
+  {
+    std::lock_guard<std::mutex> lock(_residual_mutex);
+    ++_encode_step;
+    for (size_t i = 0; i < num; ++i) {
+      memcpy(out_ptr, rows[i], prefix_size);
+      out_ptr += prefix_size;
+      EncodeRow(keys[i], rows[i] + prefix_dim, codec_dim, out_ptr);
+      out_ptr += codec_size;
+    }
+    EvictResiduals();
+  }
+  _raw_bytes += num * dim * sizeof(float);
+  _encoded_bytes += out_ptr - out;
+}
+
+int32_t GradCompressor::Decode(
+    const char *data, size_t size, size_t num, size_t dim, float *out) {
+  if (size < sizeof(GradCompressHeader)) {
+    LOG(ERROR) << "compressed grad buffer is too small, size: " << size;
+    return -1;
+  }
+  GradCompressHeader header;
+  memcpy(&header, data, sizeof(GradCompressHeader));
+  if (header.prefix_dim > dim) {
+    LOG(ERROR) << "invalid compressed grad prefix dim " << header.prefix_dim
+               << " for row dim " << dim;
+    return -1;
+  }
+  size_t prefix_dim = header.prefix_dim;
+  size_t codec_dim = dim - prefix_dim;
+  size_t codec_size = CodecRowSize(header.type, codec_dim, header.k);
+  size_t expect_size = sizeof(GradCompressHeader) +
+                       num * (prefix_dim * sizeof(float) + codec_size);
+  if (size != expect_size || header.k > codec_dim) {
+    LOG(ERROR) << "compressed grad size mismatch, type: " << header.type
+               << " size: " << size << " expect: " << expect_size;
+    return -1;
+  }
+
+  const char *in_ptr = data + sizeof(GradCompressHeader);
+  for (size_t i = 0; i < num; ++i) {
+    float *row = out + i * dim;
+    memcpy(row, in_ptr, prefix_dim * sizeof(float));
+    in_ptr += prefix_dim * sizeof(float);
+    float *codec_row = row + prefix_dim;
+    switch (header.type) {
+      case GRAD_COMPRESS_FP16: {
+        const uint16_t *half = reinterpret_cast<const uint16_t *>(in_ptr);
+        for (size_t j = 0; j < codec_dim; ++j) {
+          codec_row[j] =
+              static_cast<float>(phi::dtype::raw_uint16_to_float16(half[j]));
+        }
+        break;
+      }
+      case GRAD_COMPRESS_TOPK: {
+        std::fill(codec_row, codec_row + codec_dim, 0.0);
+        const char *ptr = in_ptr;
+        for (uint32_t j = 0; j < header.k; ++j) {
+          uint32_t idx;
+          float value;
+          memcpy(&idx, ptr, sizeof(uint32_t));
+          memcpy(&value, ptr + sizeof(uint32_t), sizeof(float));
+          ptr += sizeof(uint32_t) + sizeof(float);
+          if (idx >= codec_dim) {
+            LOG(ERROR) << "topk index " << idx << " out of range " << codec_dim;
+            return -1;
+          }
+          codec_row[idx] = value;
+        }
+        break;
+      }
+      case GRAD_COMPRESS_SIGN: {
+        float scale;
+        memcpy(&scale, in_ptr, sizeof(float));
+        const uint8_t *bits =
+            reinterpret_cast<const uint8_t *>(in_ptr + sizeof(float));
+        for (size_t j = 0; j < codec_dim; ++j) {
+          codec_row[j] = (bits[j >> 3] >> (j & 7)) & 1 ? -scale : scale;
+        }
+        break;
+      }
+      default:
+        LOG(ERROR) << "unknown grad compress type: " << header.type;
+        return -1;
+    }
+    in_ptr += codec_size;
+  }
+  return 0;
+}
+
+void Fp16GradCompressor::EncodeRow(uint64_t key,
+                                   const float *row,
+                                   size_t dim,
+                                   char *out) {
+  uint16_t *half = reinterpret_cast<uint16_t *>(out);
+  for (size_t j = 0; j < dim; ++j) {
+    half[j] = phi::dtype::float16(row[j]).x;
+  }
+}
+
+int32_t TopkGradCompressor::Initialize(const GradCompressParameter &param) {
+  GradCompressor::Initialize(param);
+  _ratio = param.topk_ratio();
+  if (_ratio <= 0 || _ratio > 1) {
+    LOG(ERROR) << "topk_ratio should be in (0, 1], but got " << _ratio;
+    return -1;
+  }
+  return 0;
+}
+
+uint32_t TopkGradCompressor::RowParam(size_t dim) const {
+  if (dim == 0) {
+    return 0;
+  }
+  size_t k = static_cast<size_t>(std::ceil(_ratio * dim));
+  return static_cast<uint32_t>(std::min(std::max<size_t>(k, 1), dim));
+}
+
+void TopkGradCompressor::EncodeRow(uint64_t key,
+                                   const float *row,
+                                   size_t dim,
+                                   char *out) {
+  uint32_t k = RowParam(dim);
+  float *residual = Residual(key, dim);
+  for (size_t j = 0; j < dim; ++j) {
+    residual[j] += row[j];
+  }
+  thread_local std::vector<uint32_t> index;
+  index.resize(dim);
+  std::iota(index.begin(), index.end(), 0);
+  std::nth_element(index.begin(),
+                   index.begin() + (k > 0 ? k - 1 : 0),
+                   index.end(),
+                   [residual](uint32_t a, uint32_t b) {
+                     return std::fabs(residual[a]) > std::fabs(residual[b]);
+                   });
+  char *ptr = out;
+  for (uint32_t j = 0; j < k; ++j) {
+    uint32_t idx = index[j];
+    memcpy(ptr, &idx, sizeof(uint32_t));
+    memcpy(ptr + sizeof(uint32_t), residual + idx, sizeof(float));
+    ptr += sizeof(uint32_t) + sizeof(float);
+    // sent part leaves the residual
+    residual[idx] = 0.0;
+  }
+}
+
+void SignGradCompressor::EncodeRow(uint64_t key,
+                                   const float *row,
+                                   size_t dim,
+                                   char *out) {
+  float *residual = Residual(key, dim);
+  float scale = 0.0;
+  for (size_t j = 0; j < dim; ++j) {
+    residual[j] += row[j];
+    scale += std::fabs(residual[j]);
+  }
+  scale = dim > 0 ? scale / dim : 0.0;
+  memcpy(out, &scale, sizeof(float));
+  uint8_t *bits = reinterpret_cast<uint8_t *>(out + sizeof(float));
+  memset(bits, 0, (dim + 7) / 8);
+  for (size_t j = 0; j < dim; ++j) {
+    if (residual[j] < 0) {
+      bits[j >> 3] |= static_cast<uint8_t>(1 << (j & 7));
+      residual[j] += scale;
+    } else {
+      residual[j] -= scale;
+    }
+  }
+}
+
+std::shared_ptr<GradCompressor> CreateGradCompressor(
+    const GradCompressParameter &param, uint32_t default_prefix_dim) {
+  std::shared_ptr<GradCompressor> compressor;
+  const auto &type = param.compress_type();
+  if (type == "fp16") {
+    compressor = std::make_shared<Fp16GradCompressor>();
+  } else if (type == "topk") {
+    compressor = std::make_shared<TopkGradCompressor>();
+  } else if (type == "sign") {
+    compressor = std::make_shared<SignGradCompressor>();
+  } else {
+    if (type != "none") {
+      LOG(WARNING) << "unknown grad compress type: " << type
+                   << ", push uncompressed";
+    }
+    return nullptr;
+  }
+  GradCompressParameter config = param;
+  if (!config.has_raw_prefix_dim()) {
+    config.set_raw_prefix_dim(default_prefix_dim);
+  }
+  if (compressor->Initialize(config) != 0) {
+    return nullptr;
+  }
+  return compressor;
+}
+
+}  // namespace distributed
+}  // namespace paddle
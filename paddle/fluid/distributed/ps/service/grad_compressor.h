@@ -0,0 +1,171 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+enum GradCompressType : uint32_t {
+  GRAD_COMPRESS_NONE = 0,
+  GRAD_COMPRESS_FP16 = 1,
+  GRAD_COMPRESS_TOPK = 2,
+  GRAD_COMPRESS_SIGN = 3,
+};
+
+/*
+ Encoded buffer of `num` rows with `dim` floats each:
+ |--type--|--prefix_dim--|--k--|---row_0---|...|---row_{num-1}---|
+ |---4B---|------4B------|-4B--|-----------|...|-----------------|
+ every row starts with `prefix_dim` raw floats, the rest is codec specific:
+   fp16: (dim - prefix_dim) x 2B half
+   topk: k x (4B index + 4B value)
+   sign: 4B scale + ceil((dim - prefix_dim) / 8)B sign bits
+*/
+struct GradCompressHeader {
+  uint32_t type;
+  uint32_t prefix_dim;
+  uint32_t k;
+};
+
+// Gradient codec configured per table by GradCompressParameter. The client
+// side instance is stateful: topk and sign keep the per-key residual of what
+// was not sent (error feedback) and add it to the next gradient of that key.
+// At most max_residual_keys residuals are kept, the ones of the keys pushed
+// least recently are dropped first.
+// Decoding is stateless and done by the server before the accessor update.
+class GradCompressor {
+ public:
+  GradCompressor() {}
+  virtual ~GradCompressor() {}
+
+  virtual int32_t Initialize(const GradCompressParameter &param);
+
+  virtual GradCompressType Type() const = 0;
+
+  // bytes needed by Encode for num rows of dim floats, header included
+  size_t EncodedSize(size_t num, size_t dim) const;
+
+  // encode num rows into out, which holds at least EncodedSize(num, dim)
+  // bytes. keys identify the rows in the residual store, dense tables pass
+  // the shard index as key.
+  void Encode(const uint64_t *keys,
+              const float *const *rows,
+              size_t num,
+              size_t dim,
+              char *out);
+
+  // decode a buffer produced by Encode into num * dim floats
+  static int32_t Decode(const char *data,
+                        size_t size,
+                        size_t num,
+                        size_t dim,
+                        float *out);
+
+  // drop the residuals of the keys not pushed since the previous call, called
+  // when the table is shrunk so the residuals of evicted keys go with them
+  void ShrinkResiduals();
+
+  size_t ResidualSize();
+
+  uint64_t RawBytes() const { return _raw_bytes; }
+  uint64_t EncodedBytes() const { return _encoded_bytes; }
+
+ protected:
+  // k stored in the header, only meaningful for topk
+  virtual uint32_t RowParam(size_t dim) const { return 0; }
+  virtual void EncodeRow(uint64_t key,
+                         const float *row,
+                         size_t dim,
+                         char *out) = 0;
+
+  // residual of key, created with zeros on first use
+  float *Residual(uint64_t key, size_t dim);
+
+  struct ResidualEntry {
+    std::vector<float> value;
+    // _encode_step of the last push of the key
+    uint64_t step = 0;
+  };
+
+  // drop the older half of the residuals once there are too many
+  void EvictResiduals();
+
+  uint32_t _prefix_dim = 0;
+  size_t _max_residual_keys = 0;
+  std::mutex _residual_mutex;
+  std::unordered_map<uint64_t, ResidualEntry> _residuals;
+  uint64_t _encode_step = 0;
+  uint64_t _shrink_step = 0;
+  std::atomic<uint64_t> _raw_bytes{0};
+  std::atomic<uint64_t> _encoded_bytes{0};
+};
+
+class Fp16GradCompressor : public GradCompressor {
+ public:
+  GradCompressType Type() const override { return GRAD_COMPRESS_FP16; }
+
+ protected:
+  void EncodeRow(uint64_t key,
+                 const float *row,
+                 size_t dim,
+                 char *out) override;
+};
+
+class TopkGradCompressor : public GradCompressor {
+ public:
+  int32_t Initialize(const GradCompressParameter &param) override;
+  GradCompressType Type() const override { return GRAD_COMPRESS_TOPK; }
+
+ protected:
+  uint32_t RowParam(size_t dim) const override;
+  void EncodeRow(uint64_t key,
+                 const float *row,
+                 size_t dim,
+                 char *out) override;
+
+ private:
+  float _ratio = 0.01;
+};
+
+class SignGradCompressor : public GradCompressor {
+ public:
+  GradCompressType Type() const override { return GRAD_COMPRESS_SIGN; }
+
+ protected:
+  void EncodeRow(uint64_t key,
+                 const float *row,
+                 size_t dim,
+                 char *out) override;
+};
+
+// returns nullptr when compress_type is "none". default_prefix_dim is used
+// when param has no raw_prefix_dim, e.g. the non gradient dims of the push
+// value of the table accessor.
+std::shared_ptr<GradCompressor> CreateGradCompressor(
+    const GradCompressParameter &param, uint32_t default_prefix_dim = 0);
+
+}  // namespace distributed
+}  // namespace paddle
@@ -560,6 +560,64 @@ std::future<int32_t> GraphBrpcClient::random_sample_nodes(
   return fut;
 }
 
+std::future<int32_t> GraphBrpcClient::sample_subgraph(
+    uint32_t table_id,
+    const GraphSubgraphParam &param,
+    const std::vector<uint64_t> &seeds,
+    std::unique_ptr<char[]> *buffer,
+    int64_t *actual_size,
+    int server_index) {
+  if (server_index < 0) {
+    if (seeds.empty()) {
+      buffer->reset();
+      *actual_size = 0;
+      std::promise<int32_t> promise;
+      promise.set_value(-1);
+      return promise.get_future();
+    }
+    server_index = get_server_index_by_id(seeds[0]);
+  }
+  DownpourBrpcClosure *closure =
+      new DownpourBrpcClosure(1, [buffer, actual_size](void *done) {
+        int ret = 0;
+        auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        if (closure->check_response(0, PS_GRAPH_SAMPLE_SUBGRAPH) != 0) {
+          ret = -1;
+        } else {
+          auto &res_io_buffer = closure->cntl(0)->response_attachment();
+          *actual_size = res_io_buffer.size();
+          buffer->reset(new char[*actual_size]);
+          res_io_buffer.copy_to(buffer->get(), *actual_size);
+        }
+        closure->set_promise_value(ret);
+      });
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+
+  std::string joint_feature_name =
+      paddle::string::join_strings(param.feature_names, '\t');
+  closure->request(0)->set_cmd_id(PS_GRAPH_SAMPLE_SUBGRAPH);
+  closure->request(0)->set_table_id(table_id);
+  closure->request(0)->set_client_id(_client_id);
+  closure->request(0)->add_params(
+      reinterpret_cast<const char *>(param.edge_idx.data()),
+      sizeof(int) * param.edge_idx.size());
+  closure->request(0)->add_params(
+      reinterpret_cast<const char *>(param.fanouts.data()),
+      sizeof(int) * param.fanouts.size());
+  closure->request(0)->add_params(reinterpret_cast<const char *>(seeds.data()),
+                                  sizeof(uint64_t) * seeds.size());
+  closure->request(0)->add_params(joint_feature_name.c_str(),
+                                  joint_feature_name.size());
+
+  GraphPsService_Stub rpc_stub = getServiceStub(GetCmdChannel(server_index));
+  closure->cntl(0)->set_log_id(butil::gettimeofday_ms());
+  rpc_stub.service(
+      closure->cntl(0), closure->request(0), closure->response(0), closure);
+  return fut;
+}
+
 std::future<int32_t> GraphBrpcClient::pull_graph_list(
     uint32_t table_id,
     int type_id,
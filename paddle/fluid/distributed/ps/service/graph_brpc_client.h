@@ -106,6 +106,17 @@ class GraphBrpcClient : public BrpcPsClient {
       const std::vector<std::string>& feature_names,
       const std::vector<std::vector<std::string>>& features);
 
+  // samples the subgraph of seeds on server_index, or on the server of the
+  // first seed, which reaches the other servers for the nodes it does not
+  // own. buffer is laid out as described in GraphSubgraphHeader.
+  virtual std::future<int32_t> sample_subgraph(
+      uint32_t table_id,
+      const GraphSubgraphParam& param,
+      const std::vector<uint64_t>& seeds,
+      std::unique_ptr<char[]>* buffer,
+      int64_t* actual_size,
+      int server_index = -1);
+
   virtual std::future<int32_t> clear_nodes(uint32_t table_id,
                                            int type_id,
                                            int idx);
@@ -219,6 +219,10 @@ int32_t GraphBrpcService::Initialize() {
       &GraphBrpcService::graph_set_node_feat;
   _service_handler_map[PS_GRAPH_SAMPLE_NODES_FROM_ONE_SERVER] =
       &GraphBrpcService::sample_neighbors_across_multi_servers;
+  _service_handler_map[PS_GRAPH_SAMPLE_SUBGRAPH] =
+      &GraphBrpcService::graph_sample_subgraph;
+  _service_handler_map[PS_GRAPH_GET_NODE_FEAT_BATCH] =
+      &GraphBrpcService::graph_get_node_feat_batch;
   InitializeShardInfo();
 
   return 0;
@@ -415,11 +419,54 @@ int32_t GraphBrpcService::graph_random_sample_neighbors(
       *reinterpret_cast<const int *>(request.params(2).c_str());
   const bool need_weight =
       *reinterpret_cast<const bool *>(request.params(3).c_str());
+  GraphTable *graph_table = reinterpret_cast<GraphTable *>(table);
+  bool use_batch = !graph_table->use_cache;
+#ifdef PADDLE_WITH_HETERPS
+  use_batch = use_batch && graph_table->search_level != 2;
+#endif
+  if (use_batch) {
+    std::vector<uint64_t> neighbor_ids, offsets;
+    std::vector<float> weights;
+    graph_table->random_sample_neighbors_batch(idx_,
+                                               node_data,
+                                               node_num,
+                                               sample_size,
+                                               need_weight,
+                                               &neighbor_ids,
+                                               &weights,
+                                               &offsets);
+    int entry_size =
+        need_weight ? Node::id_size + Node::weight_size : Node::id_size;
+    std::vector<int> actual_sizes(node_num);
+    for (size_t idx = 0; idx < node_num; ++idx) {
+      actual_sizes[idx] = (offsets[idx + 1] - offsets[idx]) * entry_size;
+    }
+    // same layout as the per-node buffers, built in one allocation
+    std::string data;
+    if (need_weight) {
+      data.resize(neighbor_ids.size() * entry_size);
+      char *pos = &data[0];
+      for (size_t i = 0; i < neighbor_ids.size(); ++i) {
+        memcpy(pos, &neighbor_ids[i], Node::id_size);
+        memcpy(pos + Node::id_size, &weights[i], Node::weight_size);
+        pos += entry_size;
+      }
+    }
+    cntl->response_attachment().append(&node_num, sizeof(size_t));
+    cntl->response_attachment().append(actual_sizes.data(),
+                                       sizeof(int) * node_num);
+    if (need_weight) {
+      cntl->response_attachment().append(data.data(), data.size());
+    } else {
+      cntl->response_attachment().append(neighbor_ids.data(),
+                                         neighbor_ids.size() * Node::id_size);
+    }
+    return 0;
+  }
   std::vector<std::shared_ptr<char>> buffers(node_num);
   std::vector<int> actual_sizes(node_num, 0);
-  (reinterpret_cast<GraphTable *>(table))
-      ->random_sample_neighbors(
-          idx_, node_data, sample_size, buffers, actual_sizes, need_weight);
+  graph_table->random_sample_neighbors(
+      idx_, node_data, sample_size, buffers, actual_sizes, need_weight);
 
   cntl->response_attachment().append(&node_num, sizeof(size_t));
   cntl->response_attachment().append(actual_sizes.data(),
@@ -659,6 +706,339 @@ int32_t GraphBrpcService::sample_neighbors_across_multi_servers(
   fut.get();
   return 0;
 }
+int32_t GraphBrpcService::call_servers(
+    uint32_t table_id,
+    int32_t cmd_id,
+    const std::vector<int> &servers,
+    const std::vector<std::vector<std::string>> &params,
+    std::vector<butil::IOBuf> *responses) {
+  size_t request_call_num = servers.size();
+  responses->clear();
+  responses->resize(request_call_num);
+  if (request_call_num == 0) {
+    return 0;
+  }
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+      request_call_num, [&, request_call_num, cmd_id](void *done) {
+        int ret = 0;
+        auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        for (size_t request_idx = 0; request_idx < request_call_num;
+             ++request_idx) {
+          if (closure->check_response(request_idx, cmd_id) != 0) {
+            ret = -1;
+            continue;
+          }
+          (*responses)[request_idx].swap(
+              closure->cntl(request_idx)->response_attachment());
+        }
+        closure->set_promise_value(ret);
+      });
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+  for (size_t request_idx = 0; request_idx < request_call_num; ++request_idx) {
+    closure->request(request_idx)->set_cmd_id(cmd_id);
+    closure->request(request_idx)->set_table_id(table_id);
+    closure->request(request_idx)->set_client_id(GetRank());
+    for (auto &param : params[request_idx]) {
+      closure->request(request_idx)->add_params(param);
+    }
+    PsService_Stub rpc_stub((reinterpret_cast<GraphBrpcServer *>(GetServer())
+                                 ->GetCmdChannel(servers[request_idx])));
+    closure->cntl(request_idx)->set_log_id(butil::gettimeofday_ms());
+    rpc_stub.service(closure->cntl(request_idx),
+                     closure->request(request_idx),
+                     closure->response(request_idx),
+                     closure);
+  }
+  return fut.get();
+}
+
+int32_t GraphBrpcService::sample_neighbors_on_servers(
+    GraphTable *table,
+    uint32_t table_id,
+    int idx,
+    const uint64_t *node_ids,
+    size_t node_num,
+    int sample_size,
+    std::vector<uint64_t> *neighbor_ids,
+    std::vector<uint64_t> *offsets) {
+  int rank = static_cast<int>(GetRank());
+  std::vector<int> servers;
+  std::vector<int> server2request(server_size, -1);
+  std::vector<std::vector<uint64_t>> id_buckets;
+  std::vector<std::pair<int, size_t>> seq(node_num);
+  for (size_t i = 0; i < node_num; ++i) {
+    int server_index = table->get_server_index_by_id(node_ids[i]);
+    if (server2request[server_index] == -1) {
+      server2request[server_index] = servers.size();
+      servers.push_back(server_index);
+      id_buckets.emplace_back();
+    }
+    int request_idx = server2request[server_index];
+    seq[i] = std::make_pair(request_idx, id_buckets[request_idx].size());
+    id_buckets[request_idx].push_back(node_ids[i]);
+  }
+  // neighbors of every bucket, the local bucket is sampled in place
+  std::vector<std::vector<uint64_t>> bucket_ids(servers.size());
+  std::vector<std::vector<uint64_t>> bucket_offsets(servers.size());
+  std::vector<int> remote_servers;
+  std::vector<int> remote_requests;
+  std::vector<std::vector<std::string>> params;
+  bool need_weight = false;
+  for (size_t request_idx = 0; request_idx < servers.size(); ++request_idx) {
+    auto &ids = id_buckets[request_idx];
+    if (servers[request_idx] == rank) {
+      std::vector<float> weights;
+      table->random_sample_neighbors_batch(idx,
+                                           ids.data(),
+                                           ids.size(),
+                                           sample_size,
+                                           false,
+                                           &bucket_ids[request_idx],
+                                           &weights,
+                                           &bucket_offsets[request_idx]);
+      continue;
+    }
+    remote_servers.push_back(servers[request_idx]);
+    remote_requests.push_back(request_idx);
+    // graph_random_sample_neighbors parses the edge type with std::stoi
+    params.push_back(
+        {std::to_string(idx),
+         std::string(reinterpret_cast<char *>(ids.data()),
+                     sizeof(uint64_t) * ids.size()),
+         std::string(reinterpret_cast<char *>(&sample_size), sizeof(int)),
+         std::string(reinterpret_cast<char *>(&need_weight), sizeof(bool))});
+  }
+  std::vector<butil::IOBuf> responses;
+  if (call_servers(table_id,
+                   PS_GRAPH_SAMPLE_NEIGHBORS,
+                   remote_servers,
+                   params,
+                   &responses) != 0) {
+    return -1;
+  }
+  for (size_t i = 0; i < remote_requests.size(); ++i) {
+    int request_idx = remote_requests[i];
+    size_t bucket_size = id_buckets[request_idx].size();
+    butil::IOBufBytesIterator io_buffer_itr(responses[i]);
+    size_t num = 0;
+    io_buffer_itr.copy_and_forward(&num, sizeof(size_t));
+    if (num != bucket_size) {
+      return -1;
+    }
+    std::vector<int> actual_sizes(num);
+    io_buffer_itr.copy_and_forward(actual_sizes.data(), sizeof(int) * num);
+    auto &offset = bucket_offsets[request_idx];
+    offset.assign(1, 0);
+    for (size_t j = 0; j < num; ++j) {
+      offset.push_back(offset.back() + actual_sizes[j] / Node::id_size);
+    }
+    bucket_ids[request_idx].resize(offset.back());
+    size_t bytes = sizeof(uint64_t) * offset.back();
+    if (io_buffer_itr.copy_and_forward(bucket_ids[request_idx].data(),
+                                       bytes) != bytes) {
+      return -1;
+    }
+  }
+  // back to the order of node_ids
+  offsets->assign(1, 0);
+  offsets->reserve(node_num + 1);
+  neighbor_ids->clear();
+  for (size_t i = 0; i < node_num; ++i) {
+    auto &ids = bucket_ids[seq[i].first];
+    auto &offset = bucket_offsets[seq[i].first];
+    neighbor_ids->insert(neighbor_ids->end(),
+                         ids.begin() + offset[seq[i].second],
+                         ids.begin() + offset[seq[i].second + 1]);
+    offsets->push_back(neighbor_ids->size());
+  }
+  return 0;
+}
+
+int32_t GraphBrpcService::get_node_feat_on_servers(
+    GraphTable *table,
+    uint32_t table_id,
+    const uint64_t *node_ids,
+    size_t node_num,
+    const std::vector<std::string> &feature_names,
+    std::vector<std::vector<std::string>> *res) {
+  int rank = static_cast<int>(GetRank());
+  std::vector<int> servers;
+  std::vector<int> server2request(server_size, -1);
+  std::vector<std::vector<uint64_t>> id_buckets;
+  std::vector<std::vector<size_t>> query_idx_buckets;
+  for (size_t i = 0; i < node_num; ++i) {
+    int server_index = table->get_server_index_by_id(node_ids[i]);
+    if (server2request[server_index] == -1) {
+      server2request[server_index] = servers.size();
+      servers.push_back(server_index);
+      id_buckets.emplace_back();
+      query_idx_buckets.emplace_back();
+    }
+    id_buckets[server2request[server_index]].push_back(node_ids[i]);
+    query_idx_buckets[server2request[server_index]].push_back(i);
+  }
+  res->assign(feature_names.size(), std::vector<std::string>(node_num));
+  std::string joint_feature_name =
+      paddle::string::join_strings(feature_names, '\t');
+  std::vector<int> remote_servers;
+  std::vector<int> remote_requests;
+  std::vector<std::vector<std::string>> params;
+  for (size_t request_idx = 0; request_idx < servers.size(); ++request_idx) {
+    auto &ids = id_buckets[request_idx];
+    if (servers[request_idx] == rank) {
+      std::vector<std::vector<std::string>> local_res;
+      table->get_node_feat_batch(
+          ids.data(), ids.size(), feature_names, &local_res);
+      for (size_t feat_idx = 0; feat_idx < feature_names.size(); ++feat_idx) {
+        for (size_t j = 0; j < ids.size(); ++j) {
+          (*res)[feat_idx][query_idx_buckets[request_idx][j]] =
+              std::move(local_res[feat_idx][j]);
+        }
+      }
+      continue;
+    }
+    remote_servers.push_back(servers[request_idx]);
+    remote_requests.push_back(request_idx);
+    params.push_back({std::string(reinterpret_cast<char *>(ids.data()),
+                                  sizeof(uint64_t) * ids.size()),
+                      joint_feature_name});
+  }
+  std::vector<butil::IOBuf> responses;
+  if (call_servers(table_id,
+                   PS_GRAPH_GET_NODE_FEAT_BATCH,
+                   remote_servers,
+                   params,
+                   &responses) != 0) {
+    return -1;
+  }
+  for (size_t i = 0; i < remote_requests.size(); ++i) {
+    int request_idx = remote_requests[i];
+    butil::IOBufBytesIterator io_buffer_itr(responses[i]);
+    for (size_t feat_idx = 0; feat_idx < feature_names.size(); ++feat_idx) {
+      for (size_t query_idx : query_idx_buckets[request_idx]) {
+        size_t feat_len = 0;
+        if (io_buffer_itr.copy_and_forward(&feat_len, sizeof(size_t)) !=
+                sizeof(size_t) ||
+            feat_len > io_buffer_itr.bytes_left()) {
+          return -1;
+        }
+        std::string &feat = (*res)[feat_idx][query_idx];
+        feat.resize(feat_len);
+        io_buffer_itr.copy_and_forward(&feat[0], feat_len);
+      }
+    }
+  }
+  return 0;
+}
+
+int32_t GraphBrpcService::graph_sample_subgraph(
+    Table *table,
+    const PsRequestMessage &request,
+    PsResponseMessage &response,
+    brpc::Controller *cntl) {
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.params_size() < 4) {
+    set_response_code(
+        response,
+        -1,
+        "graph_sample_subgraph request requires at least 4 arguments");
+    return 0;
+  }
+  GraphSubgraphParam param;
+  const int *edge_idx =
+      reinterpret_cast<const int *>(request.params(0).c_str());
+  param.edge_idx.assign(edge_idx,
+                        edge_idx + request.params(0).size() / sizeof(int));
+  const int *fanouts = reinterpret_cast<const int *>(request.params(1).c_str());
+  param.fanouts.assign(fanouts,
+                       fanouts + request.params(1).size() / sizeof(int));
+  size_t seed_num = request.params(2).size() / sizeof(uint64_t);
+  const uint64_t *seeds =
+      reinterpret_cast<const uint64_t *>(request.params(2).c_str());
+  if (!request.params(3).empty()) {
+    param.feature_names =
+        paddle::string::split_string<std::string>(request.params(3), "\t");
+  }
+  for (int idx : param.edge_idx) {
+    if (idx < 0) {
+      set_response_code(
+          response, -1, "graph_sample_subgraph got a negative edge type");
+      return 0;
+    }
+  }
+
+  GraphTable *graph_table = reinterpret_cast<GraphTable *>(table);
+  uint32_t table_id = request.table_id();
+  GraphNeighborSampleFunc sample_func = [&](int idx,
+                                            const uint64_t *node_ids,
+                                            size_t node_num,
+                                            int sample_size,
+                                            std::vector<uint64_t> *neighbors,
+                                            std::vector<uint64_t> *offsets) {
+    return sample_neighbors_on_servers(graph_table,
+                                       table_id,
+                                       idx,
+                                       node_ids,
+                                       node_num,
+                                       sample_size,
+                                       neighbors,
+                                       offsets);
+  };
+  GraphNodeFeatFunc feat_func =
+      [&](const uint64_t *node_ids,
+          size_t node_num,
+          const std::vector<std::string> &feature_names,
+          std::vector<std::vector<std::string>> *res) {
+        return get_node_feat_on_servers(
+            graph_table, table_id, node_ids, node_num, feature_names, res);
+      };
+  std::unique_ptr<char[]> buffer;
+  int64_t actual_size = 0;
+  try {
+    graph_table->sample_subgraph(
+        param, seeds, seed_num, buffer, actual_size, sample_func, feat_func);
+  } catch (const std::exception &e) {
+    set_response_code(response, -1, e.what());
+    return 0;
+  }
+  cntl->response_attachment().append(buffer.get(), actual_size);
+  return 0;
+}
+
+int32_t GraphBrpcService::graph_get_node_feat_batch(
+    Table *table,
+    const PsRequestMessage &request,
+    PsResponseMessage &response,
+    brpc::Controller *cntl) {
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.params_size() < 2) {
+    set_response_code(
+        response,
+        -1,
+        "graph_get_node_feat_batch request requires at least 2 arguments");
+    return 0;
+  }
+  size_t node_num = request.params(0).size() / sizeof(uint64_t);
+  const uint64_t *node_data =
+      reinterpret_cast<const uint64_t *>(request.params(0).c_str());
+  std::vector<std::string> feature_names =
+      paddle::string::split_string<std::string>(request.params(1), "\t");
+  std::vector<std::vector<std::string>> feature;
+  (reinterpret_cast<GraphTable *>(table))
+      ->get_node_feat_batch(node_data, node_num, feature_names, &feature);
+
+  for (size_t feat_idx = 0; feat_idx < feature_names.size(); ++feat_idx) {
+    for (size_t node_idx = 0; node_idx < node_num; ++node_idx) {
+      size_t feat_len = feature[feat_idx][node_idx].size();
+      cntl->response_attachment().append(&feat_len, sizeof(size_t));
+      cntl->response_attachment().append(feature[feat_idx][node_idx].data(),
+                                         feat_len);
+    }
+  }
+  return 0;
+}
 int32_t GraphBrpcService::graph_set_node_feat(Table *table,
                                               const PsRequestMessage &request,
                                               PsResponseMessage &response,
@@ -147,6 +147,20 @@ class GraphBrpcService : public PsBaseService {
       PsResponseMessage &response,  // NOLINT
       brpc::Controller *cntl);
 
+  // samples the k-hop subgraph of the seeds of the request, reaching the
+  // nodes of other servers through PS_GRAPH_SAMPLE_NEIGHBORS and
+  // PS_GRAPH_GET_NODE_FEAT_BATCH, see GraphTable::sample_subgraph
+  int32_t graph_sample_subgraph(Table *table,
+                                const PsRequestMessage &request,
+                                PsResponseMessage &response,  // NOLINT
+                                brpc::Controller *cntl);
+
+  // features of local nodes in any node type
+  int32_t graph_get_node_feat_batch(Table *table,
+                                    const PsRequestMessage &request,
+                                    PsResponseMessage &response,  // NOLINT
+                                    brpc::Controller *cntl);
+
   int32_t use_neighbors_sample_cache(Table *table,
                                      const PsRequestMessage &request,
                                      PsResponseMessage &response,  // NOLINT
@@ -158,6 +172,30 @@ class GraphBrpcService : public PsBaseService {
                                   brpc::Controller *cntl);
 
  private:
+  // sends cmd_id with params[i] to servers[i] and waits for all of them,
+  // (*responses)[i] is the response attachment of servers[i]. returns -1 if
+  // any request failed.
+  int32_t call_servers(uint32_t table_id,
+                       int32_t cmd_id,
+                       const std::vector<int> &servers,
+                       const std::vector<std::vector<std::string>> &params,
+                       std::vector<butil::IOBuf> *responses);
+  int32_t sample_neighbors_on_servers(GraphTable *table,
+                                      uint32_t table_id,
+                                      int idx,
+                                      const uint64_t *node_ids,
+                                      size_t node_num,
+                                      int sample_size,
+                                      std::vector<uint64_t> *neighbor_ids,
+                                      std::vector<uint64_t> *offsets);
+  int32_t get_node_feat_on_servers(
+      GraphTable *table,
+      uint32_t table_id,
+      const uint64_t *node_ids,
+      size_t node_num,
+      const std::vector<std::string> &feature_names,
+      std::vector<std::vector<std::string>> *res);
+
   bool _is_initialize_shard_info;
   std::mutex _initialize_shard_mutex;
   std::unordered_map<int32_t, serviceHandlerFunc> _msg_handler_map;
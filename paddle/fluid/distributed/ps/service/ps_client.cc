@@ -61,6 +61,14 @@ int32_t PSClient::Configure(  // called in FleetWrapper::InitWorker
     accessor->Initialize();
     _table_accessors[work_param.downpour_table_param(i).table_id()].reset(
         accessor);
+    const auto &cache_param =
+        work_param.downpour_table_param(i).pull_cache_param();
+    if (work_param.downpour_table_param(i).type() == PS_SPARSE_TABLE &&
+        cache_param.capacity() > 0) {
+      _table_pull_caches[work_param.downpour_table_param(i).table_id()] =
+          std::make_shared<SparsePullCache>(
+              cache_param, accessor->GetAccessorInfo().select_size);
+    }
   }
   return Initialize();
 }
@@ -24,6 +24,7 @@
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/ps/service/env.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
 #include "paddle/fluid/distributed/ps/service/sparse_shard_value.h"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
@@ -36,6 +37,15 @@ namespace distributed {
 using paddle::distributed::PsRequestMessage;
 using paddle::distributed::PsResponseMessage;
 
+// keys of one table in a coalesced PullSparseMultiTable call, every value
+// takes select_size of the table accessor
+struct PullSparseRequest {
+  size_t table_id;
+  float **select_values;
+  const uint64_t *keys;
+  size_t num;
+};
+
 typedef std::function<void(void *)> PSClientCallBack;
 class PSClientClosure : public google::protobuf::Closure {
  public:
@@ -137,6 +147,17 @@ class PSClient {
                                           size_t num,
                                           bool is_training) = 0;
 
+  // pull sparse of several tables with at most one request per server,
+  // future结束前keys和values缓冲区不能再次使用
+  virtual std::future<int32_t> PullSparseMultiTable(
+      const std::vector<PullSparseRequest> &requests, bool is_training) {
+    VLOG(0) << "Did not implement";
+    std::promise<int32_t> promise;
+    std::future<int> fut = promise.get_future();
+    promise.set_value(-1);
+    return fut;
+  }
+
   virtual std::future<int32_t> PullSparseParam(float **select_values,
                                                size_t table_id,
                                                const uint64_t *keys,
@@ -239,6 +260,15 @@ class PSClient {
     return itr->second.get();
   }
 
+  // nullptr if pull sparse of table_id is not cached
+  virtual SparsePullCache *GetSparsePullCache(size_t table_id) {
+    auto itr = _table_pull_caches.find(table_id);
+    if (itr == _table_pull_caches.end()) {
+      return NULL;
+    }
+    return itr->second.get();
+  }
+
   virtual size_t GetServerNums() = 0;
 
   virtual std::future<int32_t> PushDenseRawGradient(int table_id,
@@ -344,6 +374,8 @@ class PSClient {
   std::map<uint64_t, std::vector<paddle::distributed::Region>>
       _dense_pull_regions;
   std::unordered_map<uint32_t, std::shared_ptr<ValueAccessor>> _table_accessors;
+  std::unordered_map<uint32_t, std::shared_ptr<SparsePullCache>>
+      _table_pull_caches;
   std::unordered_map<int32_t, MsgHandlerFunc>
       _msg_handler_map;  // 处理client2client消息
 
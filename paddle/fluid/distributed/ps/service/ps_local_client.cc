@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "paddle/fluid/distributed/ps/service/ps_local_client.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 
 namespace paddle {
@@ -253,11 +254,68 @@ int32_t PsLocalClient::Initialize() {
   return done();
 }
 
+::std::future<int32_t> PsLocalClient::PullSparse(float** select_values,
+                                                 size_t table_id,
+                                                 const uint64_t* keys,
+                                                 size_t num,
+                                                 bool is_training) {
+  auto* pull_cache = GetSparsePullCache(table_id);
+  std::vector<uint64_t> miss_keys;
+  std::vector<float*> miss_values;
+  uint64_t cache_generation = 0;
+  if (pull_cache != nullptr) {
+    cache_generation = pull_cache->Lookup(
+        keys, select_values, num, &miss_keys, &miss_values);
+  } else {
+    miss_keys.assign(keys, keys + num);
+    miss_values.assign(select_values, select_values + num);
+  }
+  if (miss_keys.empty()) {
+    return done();
+  }
+
+  auto* table_ptr = GetTable(table_id);
+  size_t select_dim =
+      table_ptr->ValueAccesor()->GetAccessorInfo().select_size / sizeof(float);
+  std::vector<uint32_t> frequencies(miss_keys.size(), 1);
+  std::vector<float> pull_values(miss_keys.size() * select_dim);
+  PullSparseValue pull_value(miss_keys, frequencies, select_dim);
+  pull_value.is_training_ = is_training;
+
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = pull_value;
+  table_context.pull_context.values = pull_values.data();
+  table_context.num = miss_keys.size();
+  table_ptr->Pull(table_context);
+
+  for (size_t i = 0; i < miss_keys.size(); ++i) {
+    memcpy(miss_values[i],
+           pull_values.data() + i * select_dim,
+           select_dim * sizeof(float));
+  }
+  if (pull_cache != nullptr) {
+    pull_cache->Update(miss_keys.data(),
+                       miss_values.data(),
+                       miss_keys.size(),
+                       cache_generation);
+  }
+  return done();
+}
+
 ::std::future<int32_t> PsLocalClient::PrintTableStat(uint32_t table_id) {
   auto* table_ptr = GetTable(table_id);
   std::pair<int64_t, int64_t> ret = table_ptr->PrintTableStat();
   VLOG(0) << "table id: " << table_id << ", feasign size: " << ret.first
           << ", mf size: " << ret.second;
+  auto* pull_cache = GetSparsePullCache(table_id);
+  if (pull_cache != nullptr) {
+    auto stat = pull_cache->GetStat();
+    VLOG(0) << "table id: " << table_id
+            << ", pull cache hit rate: " << stat.HitRate()
+            << ", cached keys: " << stat.cached_num
+            << ", rpc bytes saved: " << stat.saved_bytes;
+  }
   return done();
 }
 
@@ -283,6 +341,10 @@ int32_t PsLocalClient::Initialize() {
     void* callback) {
   PSClientClosure* closure = reinterpret_cast<PSClientClosure*>(callback);
   auto* table_ptr = GetTable(table_id);
+  auto* pull_cache = GetSparsePullCache(table_id);
+  if (pull_cache != nullptr) {
+    pull_cache->Invalidate(keys, num);
+  }
 
   TableContext table_context;
   table_context.value_type = Sparse;
@@ -302,6 +364,10 @@ int32_t PsLocalClient::Initialize() {
                                                  const float** update_values,
                                                  size_t num) {
   auto* table_ptr = GetTable(table_id);
+  auto* pull_cache = GetSparsePullCache(table_id);
+  if (pull_cache != nullptr) {
+    pull_cache->Invalidate(keys, num);
+  }
 
   TableContext table_context;
   table_context.value_type = Sparse;
@@ -314,5 +380,25 @@ int32_t PsLocalClient::Initialize() {
   table_ptr->Push(table_context);
   return done();
 }
+::std::future<int32_t> PsLocalClient::SampleSubgraph(
+    size_t table_id,
+    const GraphSubgraphParam& param,
+    const uint64_t* seeds,
+    size_t seed_num,
+    std::unique_ptr<char[]>* buffer,
+    int64_t* actual_size) {
+  auto* graph_table = dynamic_cast<GraphTable*>(GetTable(table_id));
+  std::promise<int32_t> prom;
+  std::future<int32_t> fut = prom.get_future();
+  if (graph_table == nullptr) {
+    LOG(ERROR) << "table " << table_id << " is not a graph table";
+    prom.set_value(-1);
+    return fut;
+  }
+  prom.set_value(graph_table->sample_subgraph(
+      param, seeds, seed_num, *buffer, *actual_size));
+  return fut;
+}
+
 }  // namespace distributed
 }  // namespace paddle
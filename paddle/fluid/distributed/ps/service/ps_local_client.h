@@ -21,6 +21,7 @@ namespace paddle {
 namespace distributed {
 
 class Table;
+struct GraphSubgraphParam;
 
 class PsLocalClient : public PSClient {
  public:
@@ -68,13 +69,7 @@ class PsLocalClient : public PSClient {
                                             size_t table_id,
                                             const uint64_t* keys,
                                             size_t num,
-                                            bool is_training) {
-    std::promise<int32_t> prom;
-    std::future<int32_t> fut = prom.get_future();
-    prom.set_value(0);
-
-    return fut;
-  }
+                                            bool is_training);
 
   virtual ::std::future<int32_t> PullSparsePtr(const int shard_id,
                                                char** select_values,
@@ -159,6 +154,16 @@ class PsLocalClient : public PSClient {
   }
   virtual size_t GetServerNums() { return 1; }
 
+  // k-hop subgraph of seeds sampled by the GraphTable table_id, see
+  // GraphTable::sample_subgraph for the layout of buffer
+  virtual std::future<int32_t> SampleSubgraph(
+      size_t table_id,
+      const GraphSubgraphParam& param,
+      const uint64_t* seeds,
+      size_t seed_num,
+      std::unique_ptr<char[]>* buffer,
+      int64_t* actual_size);
+
   virtual std::future<int32_t> PushDenseRawGradient(int table_id,
                                                     float* total_send_data,
                                                     size_t total_send_data_size,
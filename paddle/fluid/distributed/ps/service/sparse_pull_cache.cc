@@ -0,0 +1,177 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+inline int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+SparsePullCache::SparsePullCache(const SparsePullCacheParameter &param,
+                                 size_t value_size)
+    : _param(param), _value_size(value_size) {
+  _shard_capacity = (param.capacity() + kShardNum - 1) / kShardNum;
+  _shard_max_entries = std::max<size_t>(4 * _shard_capacity, 1024);
+}
+
+uint64_t SparsePullCache::Lookup(const uint64_t *keys,
+                                 float **values,
+                                 size_t num,
+                                 std::vector<uint64_t> *miss_keys,
+                                 std::vector<float *> *miss_values) {
+  uint64_t generation = _generation;
+  uint64_t step = ++_step;
+  int64_t now_ms = NowMs();
+  miss_keys->clear();
+  miss_values->clear();
+  miss_keys->reserve(num);
+  miss_values->reserve(num);
+  uint64_t hit_num = 0;
+  for (size_t i = 0; i < num; ++i) {
+    auto &shard = GetShard(keys[i]);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto itr = shard.entries.find(keys[i]);
+    if (itr != shard.entries.end() && itr->second.valid) {
+      auto &entry = itr->second;
+      if (!IsExpired(entry, step, now_ms)) {
+        memcpy(values[i], entry.value.data(), _value_size);
+        ++hit_num;
+        continue;
+      }
+      entry.valid = false;
+      --shard.cached_num;
+    }
+    miss_keys->push_back(keys[i]);
+    miss_values->push_back(values[i]);
+  }
+  _hit_num += hit_num;
+  _miss_num += num - hit_num;
+  return generation;
+}
+
+void SparsePullCache::Update(const uint64_t *keys,
+                             float *const *values,
+                             size_t num,
+                             uint64_t generation) {
+  uint64_t step = _step;
+  int64_t now_ms = NowMs();
+  for (size_t i = 0; i < num; ++i) {
+    auto &shard = GetShard(keys[i]);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto itr = shard.entries.find(keys[i]);
+    if (itr == shard.entries.end()) {
+      // pushed while pulled, the value may be older than the push
+      if (shard.invalidate_generation > generation) {
+        continue;
+      }
+      if (shard.entries.size() >= _shard_max_entries) {
+        ShrinkShard(&shard);
+      }
+      itr = shard.entries.emplace(keys[i], CacheEntry()).first;
+    }
+    auto &entry = itr->second;
+    if (entry.invalidate_generation > generation) {
+      continue;
+    }
+    if (!entry.valid && ++entry.miss_count < _param.admit_threshold()) {
+      continue;
+    }
+    if (!entry.valid) {
+      if (shard.cached_num >= _shard_capacity) {
+        continue;
+      }
+      entry.valid = true;
+      ++shard.cached_num;
+    }
+    entry.value.resize(_value_size);
+    memcpy(entry.value.data(), values[i], _value_size);
+    entry.step = step;
+    entry.time_ms = now_ms;
+  }
+}
+
+void SparsePullCache::Invalidate(const uint64_t *keys, size_t num) {
+  if (!_param.invalidate_on_push()) {
+    return;
+  }
+  uint64_t generation = ++_generation;
+  for (size_t i = 0; i < num; ++i) {
+    auto &shard = GetShard(keys[i]);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto itr = shard.entries.find(keys[i]);
+    if (itr == shard.entries.end()) {
+      shard.invalidate_generation = generation;
+      continue;
+    }
+    itr->second.invalidate_generation = generation;
+    if (itr->second.valid) {
+      itr->second.valid = false;
+      --shard.cached_num;
+    }
+  }
+}
+
+void SparsePullCache::ShrinkShard(CacheShard *shard) {
+  for (auto itr = shard->entries.begin(); itr != shard->entries.end();) {
+    if (!itr->second.valid) {
+      // the shard keeps the invalidation of the dropped keys
+      shard->invalidate_generation = std::max(
+          shard->invalidate_generation, itr->second.invalidate_generation);
+      itr = shard->entries.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+}
+
+void SparsePullCache::Clear() {
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto &entry : shard.entries) {
+      shard.invalidate_generation = std::max(
+          shard.invalidate_generation, entry.second.invalidate_generation);
+    }
+    shard.entries.clear();
+    shard.cached_num = 0;
+  }
+}
+
+SparsePullCacheStat SparsePullCache::GetStat() const {
+  SparsePullCacheStat stat;
+  stat.hit_num = _hit_num;
+  stat.miss_num = _miss_num;
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    stat.cached_num += shard.cached_num;
+  }
+  stat.saved_bytes =
+      stat.hit_num * (sizeof(uint64_t) + sizeof(uint32_t) + _value_size);
+  return stat;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,124 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+struct SparsePullCacheStat {
+  uint64_t hit_num = 0;
+  uint64_t miss_num = 0;
+  uint64_t cached_num = 0;
+  // request keys + frequencies + response values not sent over rpc
+  uint64_t saved_bytes = 0;
+
+  double HitRate() const {
+    uint64_t total = hit_num + miss_num;
+    return total == 0 ? 0.0 : static_cast<double>(hit_num) / total;
+  }
+};
+
+// Client side cache of pull sparse values of hot keys. A key is admitted
+// after admit_threshold missed pulls, and its value is served locally until
+// it is older than max_staleness_steps pulls of the table or
+// max_staleness_ms, or until the client pushes the key.
+// Every Invalidate starts a new generation, and an Update of a pull that was
+// looked up before the last invalidation of a key is dropped for that key,
+// so a pull in flight does not cache a value older than a push.
+class SparsePullCache {
+ public:
+  SparsePullCache(const SparsePullCacheParameter &param, size_t value_size);
+
+  // copy cached values of hit keys to values, and collect missed keys with
+  // their output pointers. every Lookup counts as one step of the table.
+  // returns the generation to pass to the Update of the pulled values.
+  uint64_t Lookup(const uint64_t *keys,
+                  float **values,
+                  size_t num,
+                  std::vector<uint64_t> *miss_keys,
+                  std::vector<float *> *miss_values);
+
+  // count the misses of keys and fill the cache from their pulled values,
+  // only hot keys not invalidated since generation are stored
+  void Update(const uint64_t *keys,
+              float *const *values,
+              size_t num,
+              uint64_t generation);
+
+  // called on push of keys
+  void Invalidate(const uint64_t *keys, size_t num);
+
+  void Clear();
+
+  SparsePullCacheStat GetStat() const;
+
+  size_t ValueSize() const { return _value_size; }
+
+ private:
+  struct CacheEntry {
+    uint32_t miss_count = 0;
+    bool valid = false;
+    uint64_t step = 0;
+    int64_t time_ms = 0;
+    // generation of the last Invalidate of the key
+    uint64_t invalidate_generation = 0;
+    std::vector<char> value;
+  };
+
+  struct CacheShard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, CacheEntry> entries;
+    size_t cached_num = 0;
+    // generation of the last Invalidate of a key without entry
+    uint64_t invalidate_generation = 0;
+  };
+
+  static constexpr size_t kShardNum = 64;
+
+  inline CacheShard &GetShard(uint64_t key) {
+    return _shards[key % kShardNum];
+  }
+  inline bool IsExpired(const CacheEntry &entry,
+                        uint64_t step,
+                        int64_t now_ms) const {
+    return step - entry.step > _param.max_staleness_steps() ||
+           now_ms - entry.time_ms > _param.max_staleness_ms();
+  }
+  // drop miss counters of uncached keys when the shard grows too large
+  void ShrinkShard(CacheShard *shard);
+
+  SparsePullCacheParameter _param;
+  size_t _value_size;
+  size_t _shard_capacity;
+  size_t _shard_max_entries;
+  mutable CacheShard _shards[kShardNum];
+  std::atomic<uint64_t> _step{0};
+  std::atomic<uint64_t> _generation{0};
+  std::atomic<uint64_t> _hit_num{0};
+  std::atomic<uint64_t> _miss_num{0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
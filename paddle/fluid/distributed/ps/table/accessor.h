@@ -90,6 +90,8 @@ class ValueAccessor {
   virtual int Initialize() = 0;
 
   virtual AccessorInfo GetAccessorInfo() { return _accessor_info; }
+  // push value中梯度之前的维度, 如slot/show/click, push时不能有损压缩
+  virtual size_t GetPushPrefixDim() { return 0; }
 
   virtual bool NeedExtendMF(float* value) { return false; }
   virtual bool HasMF(size_t size) { return false; }
@@ -508,6 +508,7 @@ void GraphTable::clear_graph(int idx) {
   for (size_t i = 0; i < shard_num_per_server; i++) {
     edge_shards[idx].push_back(new GraphShard());
   }
+  invalidate_sample_cache();
 }
 
 #ifdef PADDLE_WITH_HETERPS
@@ -1087,6 +1088,7 @@ int32_t GraphTable::add_comm_edge(int idx, uint64_t src_id, uint64_t dst_id) {
   size_t index = src_shard_id - shard_start;
   edge_shards[idx][index]->add_graph_node(src_id)->build_edges(false);
   edge_shards[idx][index]->add_neighbor(src_id, dst_id, 1.0);
+  invalidate_sample_cache();
   return 0;
 }
 int32_t GraphTable::add_graph_node(int idx,
@@ -1116,6 +1118,7 @@ int32_t GraphTable::add_graph_node(int idx,
         }));
   }
   for (size_t i = 0; i < tasks.size(); i++) tasks[i].get();
+  invalidate_sample_cache();
   return 0;
 }
 
@@ -1141,6 +1144,7 @@ int32_t GraphTable::remove_graph_node(int idx, std::vector<uint64_t> &id_list) {
         }));
   }
   for (size_t i = 0; i < tasks.size(); i++) tasks[i].get();
+  invalidate_sample_cache();
   return 0;
 }
 
@@ -1712,9 +1716,134 @@ int32_t GraphTable::build_sampler(int idx, std::string sample_type) {
       bucket[i]->build_sampler(sample_type);
     }
   }
+  invalidate_sample_cache();
   return 0;
 }
 
+int32_t GraphTable::build_csr_shards(GraphTableType table_type,
+                                     int idx,
+                                     bool release_nodes) {
+  auto &shards = table_type == GraphTableType::EDGE_TABLE ? edge_shards
+                                                          : feature_shards;
+  auto &csr_shards = table_type == GraphTableType::EDGE_TABLE
+                         ? edge_csr_shards
+                         : feature_csr_shards;
+  if (idx < 0 || idx >= static_cast<int>(shards.size())) {
+    VLOG(0) << "build_csr_shards: invalid idx " << idx;
+    return -1;
+  }
+  if (csr_shards.size() < shards.size()) {
+    csr_shards.resize(shards.size());
+  }
+  csr_shards[idx].resize(shards[idx].size());
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < shards[idx].size(); ++i) {
+    tasks.push_back(load_node_edge_task_pool->enqueue(
+        [&shards, &csr_shards, idx, i, release_nodes]() -> int {
+          auto csr_shard = std::make_shared<CsrGraphShard>();
+          csr_shard->build(shards[idx][i]->get_bucket());
+          if (release_nodes) {
+            shards[idx][i]->clear();
+          }
+          csr_shards[idx][i] = csr_shard;
+          return 0;
+        }));
+  }
+  for (auto &task : tasks) {
+    task.get();
+  }
+  size_t node_num = 0, edge_num = 0, memory_size = 0;
+  for (auto &csr_shard : csr_shards[idx]) {
+    node_num += csr_shard->get_node_num();
+    edge_num += csr_shard->get_edge_num();
+    memory_size += csr_shard->memory_size();
+  }
+  VLOG(0) << "build csr shards of idx " << idx << ": " << node_num
+          << " nodes, " << edge_num << " edges, " << memory_size << " bytes";
+  return 0;
+}
+
+int32_t GraphTable::save_csr_shards(GraphTableType table_type,
+                                    int idx,
+                                    const std::string &path) {
+  auto &csr_shards = table_type == GraphTableType::EDGE_TABLE
+                         ? edge_csr_shards
+                         : feature_csr_shards;
+  if (idx < 0 || idx >= static_cast<int>(csr_shards.size()) ||
+      csr_shards[idx].empty()) {
+    VLOG(0) << "save_csr_shards: csr shards of idx " << idx << " not built";
+    return -1;
+  }
+  const char *prefix =
+      table_type == GraphTableType::EDGE_TABLE ? "edge" : "node";
+  for (size_t i = 0; i < csr_shards[idx].size(); ++i) {
+    std::string file = paddle::string::format_string(
+        "%s/%s_%d.csr-%05d",
+        path.c_str(),
+        prefix,
+        idx,
+        static_cast<int>(shard_start + i));
+    if (csr_shards[idx][i]->save(file) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int32_t GraphTable::load_csr_shards(GraphTableType table_type,
+                                    int idx,
+                                    const std::string &path,
+                                    bool use_mmap) {
+  auto &shards = table_type == GraphTableType::EDGE_TABLE ? edge_shards
+                                                          : feature_shards;
+  auto &csr_shards = table_type == GraphTableType::EDGE_TABLE
+                         ? edge_csr_shards
+                         : feature_csr_shards;
+  if (idx < 0 || idx >= static_cast<int>(shards.size())) {
+    VLOG(0) << "load_csr_shards: invalid idx " << idx;
+    return -1;
+  }
+  if (csr_shards.size() < shards.size()) {
+    csr_shards.resize(shards.size());
+  }
+  const char *prefix =
+      table_type == GraphTableType::EDGE_TABLE ? "edge" : "node";
+  std::vector<std::shared_ptr<CsrGraphShard>> loaded(shard_num_per_server);
+  for (size_t i = 0; i < shard_num_per_server; ++i) {
+    std::string file = paddle::string::format_string(
+        "%s/%s_%d.csr-%05d",
+        path.c_str(),
+        prefix,
+        idx,
+        static_cast<int>(shard_start + i));
+    loaded[i] = std::make_shared<CsrGraphShard>();
+    if (loaded[i]->load(file, use_mmap) != 0) {
+      return -1;
+    }
+  }
+  csr_shards[idx].swap(loaded);
+  if (table_type == GraphTableType::EDGE_TABLE) {
+    invalidate_sample_cache();
+  }
+  return 0;
+}
+
+const CsrGraphShard *GraphTable::find_csr_shard(GraphTableType table_type,
+                                                int idx,
+                                                uint64_t id) {
+  auto &csr_shards = table_type == GraphTableType::EDGE_TABLE
+                         ? edge_csr_shards
+                         : feature_csr_shards;
+  if (idx >= static_cast<int>(csr_shards.size()) || csr_shards[idx].empty()) {
+    return nullptr;
+  }
+  size_t shard_id = id % shard_num;
+  if (shard_id >= shard_end || shard_id < shard_start) {
+    return nullptr;
+  }
+  return csr_shards[idx][shard_id - shard_start].get();
+}
+
 std::pair<uint64_t, uint64_t> GraphTable::parse_edge_file(
     const std::string &path, int idx, bool reverse) {
   std::string sample_type = "random";
@@ -1841,15 +1970,24 @@ int32_t GraphTable::load_edges(const std::string &path,
     // this optimization is only performed in load_edges function.
     VLOG(0) << "run in gpugraph mode!";
   } else {
-    std::string sample_type = "random";
+    // weighted nodes get an alias table, O(n) to build and O(1) per draw
     VLOG(0) << "build sampler ... ";
+    std::vector<std::future<int>> tasks;
     for (auto &shard : edge_shards[idx]) {
-      auto bucket = shard->get_bucket();
-      for (size_t i = 0; i < bucket.size(); i++) {
-        bucket[i]->build_sampler(sample_type);
-      }
+      tasks.push_back(load_node_edge_task_pool->enqueue([&shard]() -> int {
+        auto &bucket = shard->get_bucket();
+        for (size_t i = 0; i < bucket.size(); i++) {
+          bucket[i]->build_sampler(bucket[i]->get_is_weighted() ? "alias"
+                                                                : "random");
+        }
+        return 0;
+      }));
+    }
+    for (auto &task : tasks) {
+      task.get();
     }
   }
+  invalidate_sample_cache();
 
   return 0;
 }
@@ -1906,6 +2044,9 @@ int32_t GraphTable::clear_nodes(GraphTableType table_type, int idx) {
   for (size_t i = 0; i < search_shards.size(); i++) {
     search_shards[i]->clear();
   }
+  if (table_type == GraphTableType::EDGE_TABLE) {
+    invalidate_sample_cache();
+  }
   return 0;
 }
 
@@ -2002,76 +2143,408 @@ int32_t GraphTable::random_sample_neighbors(
     if (seq_id[i].size() == 0) continue;
     tasks.push_back(_shards_task_pool[i]->enqueue([&, i, this]() -> int {
       uint64_t node_id;
-      std::vector<std::pair<SampleKey, SampleResult>> r;
-      LRUResponse response = LRUResponse::blocked;
-      if (use_cache) {
-        response =
-            scaled_lru->query(i, id_list[i].data(), id_list[i].size(), r);
-      }
-      size_t index = 0;
-      std::vector<SampleResult> sample_res;
-      std::vector<SampleKey> sample_keys;
       auto &rng = _shards_task_rng_pool[i];
       for (size_t k = 0; k < id_list[i].size(); k++) {
-        if (index < r.size() &&
-            r[index].first.node_key == id_list[i][k].node_key) {
-          int idy = seq_id[i][k];
-          actual_sizes[idy] = r[index].second.actual_size;
-          buffers[idy] = r[index].second.buffer;
-          index++;
-        } else {
-          node_id = id_list[i][k].node_key;
-          Node *node = find_node(GraphTableType::EDGE_TABLE, idx, node_id);
-          int idy = seq_id[i][k];
-          int &actual_size = actual_sizes[idy];
-          if (node == nullptr) {
+        if (use_cache && sample_cache->Query(id_list[i][k],
+                                             &buffers[seq_id[i][k]],
+                                             &actual_sizes[seq_id[i][k]])) {
+          continue;
+        }
+        node_id = id_list[i][k].node_key;
+        const CsrGraphShard *csr_shard =
+            find_csr_shard(GraphTableType::EDGE_TABLE, idx, node_id);
+        int64_t csr_pos = csr_shard == nullptr ? -1 : csr_shard->find(node_id);
+        Node *node = csr_pos >= 0
+                         ? nullptr
+                         : find_node(GraphTableType::EDGE_TABLE, idx, node_id);
+        int idy = seq_id[i][k];
+        int &actual_size = actual_sizes[idy];
+        if (node == nullptr && csr_pos < 0) {
 #ifdef PADDLE_WITH_HETERPS
-            if (search_level == 2) {
-              VLOG(2) << "enter sample from ssd for node_id " << node_id;
-              char *buffer_addr = random_sample_neighbor_from_ssd(
-                  idx, node_id, sample_size, rng, actual_size);
-              if (actual_size != 0) {
-                std::shared_ptr<char> &buffer = buffers[idy];
-                buffer.reset(buffer_addr, char_del);
-              }
-              VLOG(2) << "actual sampled size from ssd = " << actual_sizes[idy];
-              continue;
+          if (search_level == 2) {
+            VLOG(2) << "enter sample from ssd for node_id " << node_id;
+            char *buffer_addr = random_sample_neighbor_from_ssd(
+                idx, node_id, sample_size, rng, actual_size);
+            if (actual_size != 0) {
+              std::shared_ptr<char> &buffer = buffers[idy];
+              buffer.reset(buffer_addr, char_del);
             }
-#endif
-            actual_size = 0;
+            VLOG(2) << "actual sampled size from ssd = " << actual_sizes[idy];
             continue;
           }
-          std::shared_ptr<char> &buffer = buffers[idy];
-          std::vector<int> res = node->sample_k(sample_size, rng);
-          actual_size =
-              res.size() * (need_weight ? (Node::id_size + Node::weight_size)
-                                        : Node::id_size);
-          int offset = 0;
-          uint64_t id;
-          float weight;
-          char *buffer_addr = new char[actual_size];
-          if (response == LRUResponse::ok) {
-            sample_keys.emplace_back(idx, node_id, sample_size, need_weight);
-            sample_res.emplace_back(actual_size, buffer_addr);
-            buffer = sample_res.back().buffer;
-          } else {
-            buffer.reset(buffer_addr, char_del);
+#endif
+          actual_size = 0;
+          continue;
+        }
+        std::shared_ptr<char> &buffer = buffers[idy];
+        std::vector<int> res =
+            csr_pos >= 0 ? csr_shard->sample_k(csr_pos, sample_size, rng)
+                         : node->sample_k(sample_size, rng);
+        actual_size =
+            res.size() * (need_weight ? (Node::id_size + Node::weight_size)
+                                      : Node::id_size);
+        int offset = 0;
+        uint64_t id;
+        float weight;
+        char *buffer_addr = new char[actual_size];
+        buffer.reset(buffer_addr, char_del);
+        for (int &x : res) {
+          id = csr_pos >= 0 ? csr_shard->get_neighbor_id(csr_pos, x)
+                            : node->get_neighbor_id(x);
+          memcpy(buffer_addr + offset, &id, Node::id_size);
+          offset += Node::id_size;
+          if (need_weight) {
+            weight = csr_pos >= 0 ? csr_shard->get_neighbor_weight(csr_pos, x)
+                                  : node->get_neighbor_weight(x);
+            memcpy(buffer_addr + offset, &weight, Node::weight_size);
+            offset += Node::weight_size;
+          }
+        }
+        if (use_cache) {
+          sample_cache->Insert(id_list[i][k], buffer_addr, actual_size);
+        }
+      }
+      return 0;
+    }));
+  }
+  for (auto &t : tasks) {
+    t.get();
+  }
+  return 0;
+}
+
+int32_t GraphTable::random_sample_neighbors_batch(
+    int idx,
+    const uint64_t *node_ids,
+    size_t node_num,
+    int sample_size,
+    bool need_weight,
+    std::vector<uint64_t> *neighbor_ids,
+    std::vector<float> *weights,
+    std::vector<uint64_t> *offsets) {
+  std::vector<std::vector<uint32_t>> seq_id(task_pool_size_);
+  for (size_t idy = 0; idy < node_num; ++idy) {
+    seq_id[get_thread_pool_index(node_ids[idy])].push_back(idy);
+  }
+  // sample sizes are written per node, the neighbors per task
+  std::vector<uint64_t> sizes(node_num + 1, 0);
+  std::vector<std::vector<uint64_t>> task_ids(task_pool_size_);
+  std::vector<std::vector<float>> task_weights(task_pool_size_);
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < seq_id.size(); i++) {
+    if (seq_id[i].size() == 0) continue;
+    tasks.push_back(_shards_task_pool[i]->enqueue([&, i, this]() -> int {
+      auto &rng = _shards_task_rng_pool[i];
+      auto &ids = task_ids[i];
+      auto &ws = task_weights[i];
+      ids.reserve(seq_id[i].size() * sample_size);
+      for (uint32_t idy : seq_id[i]) {
+        uint64_t node_id = node_ids[idy];
+        size_t before = ids.size();
+        const CsrGraphShard *csr_shard =
+            find_csr_shard(GraphTableType::EDGE_TABLE, idx, node_id);
+        int64_t csr_pos = csr_shard == nullptr ? -1 : csr_shard->find(node_id);
+        if (csr_pos >= 0) {
+          for (int x : csr_shard->sample_k(csr_pos, sample_size, rng)) {
+            ids.push_back(csr_shard->get_neighbor_id(csr_pos, x));
+            if (need_weight) {
+              ws.push_back(csr_shard->get_neighbor_weight(csr_pos, x));
+            }
           }
-          for (int &x : res) {
-            id = node->get_neighbor_id(x);
-            memcpy(buffer_addr + offset, &id, Node::id_size);
-            offset += Node::id_size;
+        } else {
+          Node *node = find_node(GraphTableType::EDGE_TABLE, idx, node_id);
+          if (node == nullptr) continue;
+          for (int x : node->sample_k(sample_size, rng)) {
+            ids.push_back(node->get_neighbor_id(x));
             if (need_weight) {
-              weight = node->get_neighbor_weight(x);
-              memcpy(buffer_addr + offset, &weight, Node::weight_size);
-              offset += Node::weight_size;
+              ws.push_back(node->get_neighbor_weight(x));
             }
           }
         }
+        sizes[idy + 1] = ids.size() - before;
+      }
+      return 0;
+    }));
+  }
+  for (auto &t : tasks) {
+    t.get();
+  }
+
+  for (size_t idy = 0; idy < node_num; ++idy) {
+    sizes[idy + 1] += sizes[idy];
+  }
+  offsets->assign(sizes.begin(), sizes.end());
+  neighbor_ids->resize(sizes[node_num]);
+  if (need_weight) {
+    weights->resize(sizes[node_num]);
+  }
+  // the samples of a task are in the order of its nodes
+  for (size_t i = 0; i < seq_id.size(); i++) {
+    size_t pos = 0;
+    for (uint32_t idy : seq_id[i]) {
+      uint64_t begin = sizes[idy], size = sizes[idy + 1] - sizes[idy];
+      std::copy(task_ids[i].begin() + pos,
+                task_ids[i].begin() + pos + size,
+                neighbor_ids->begin() + begin);
+      if (need_weight) {
+        std::copy(task_weights[i].begin() + pos,
+                  task_weights[i].begin() + pos + size,
+                  weights->begin() + begin);
+      }
+      pos += size;
+    }
+  }
+  return 0;
+}
+
+int GraphSubgraphView::parse(const char *buffer, int64_t size) {
+  if (size < static_cast<int64_t>(sizeof(GraphSubgraphHeader))) {
+    return -1;
+  }
+  memcpy(&header, buffer, sizeof(GraphSubgraphHeader));
+  // bounds the counts so the array sizes below do not overflow
+  int64_t max_num = size / static_cast<int64_t>(sizeof(int64_t));
+  for (int64_t num : {header.node_num,
+                      header.edge_num,
+                      header.hop_num,
+                      header.feature_num}) {
+    if (num < 0 || num > max_num) {
+      return -1;
+    }
+  }
+  if (header.feature_num > 0 &&
+      header.node_num + 1 > max_num / header.feature_num) {
+    return -1;
+  }
+  const int64_t *arrays =
+      reinterpret_cast<const int64_t *>(buffer + sizeof(GraphSubgraphHeader));
+  int64_t array_num = header.node_num + header.hop_num + 2 +
+                      header.edge_num * 2 + header.hop_num + 1 +
+                      header.feature_num * (header.node_num + 1);
+  int64_t array_end = sizeof(GraphSubgraphHeader) + array_num * sizeof(int64_t);
+  if (size < array_end) {
+    return -1;
+  }
+  node_ids = reinterpret_cast<const uint64_t *>(arrays);
+  hop_node_offsets = arrays + header.node_num;
+  edge_src = hop_node_offsets + header.hop_num + 2;
+  edge_dst = edge_src + header.edge_num;
+  hop_edge_offsets = edge_dst + header.edge_num;
+  feature_offsets = hop_edge_offsets + header.hop_num + 1;
+  feature_data = reinterpret_cast<const char *>(arrays + array_num);
+  // the features of every node are within the feature bytes
+  int64_t feature_bytes = size - array_end;
+  for (int64_t f = 0; f < header.feature_num; ++f) {
+    const int64_t *offsets = feature_offsets + f * (header.node_num + 1);
+    if (offsets[0] < 0) {
+      return -1;
+    }
+    for (int64_t i = 0; i < header.node_num; ++i) {
+      if (offsets[i + 1] < offsets[i]) {
+        return -1;
+      }
+    }
+    if (offsets[header.node_num] > feature_bytes) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+std::string GraphSubgraphView::get_feature(int64_t feature_idx,
+                                           int64_t node_idx) const {
+  const int64_t *offsets =
+      feature_offsets + feature_idx * (header.node_num + 1);
+  return std::string(feature_data + offsets[node_idx],
+                     offsets[node_idx + 1] - offsets[node_idx]);
+}
+
+int32_t GraphTable::sample_subgraph(const GraphSubgraphParam &param,
+                                    const uint64_t *seeds,
+                                    size_t seed_num,
+                                    std::unique_ptr<char[]> &buffer,
+                                    int64_t &actual_size,
+                                    const GraphNeighborSampleFunc &sample_func,
+                                    const GraphNodeFeatFunc &feat_func) {
+  size_t hop_num = param.fanouts.size();
+  PADDLE_ENFORCE_EQ(
+      param.edge_idx.size() == 1 || param.edge_idx.size() == hop_num,
+      true,
+      paddle::platform::errors::InvalidArgument(
+          "The number of edge types should be 1 or the number of hops %d, "
+          "but got %d.",
+          hop_num,
+          param.edge_idx.size()));
+
+  std::vector<uint64_t> node_ids;
+  std::unordered_map<uint64_t, int64_t> node_index;
+  std::vector<int64_t> edge_src, edge_dst;
+  std::vector<int64_t> hop_node_offsets(1, 0), hop_edge_offsets(1, 0);
+  node_index.reserve(seed_num);
+  for (size_t i = 0; i < seed_num; ++i) {
+    if (node_index.emplace(seeds[i], node_ids.size()).second) {
+      node_ids.push_back(seeds[i]);
+    }
+  }
+  hop_node_offsets.push_back(node_ids.size());
+
+  std::vector<uint64_t> neighbor_ids, offsets;
+  std::vector<float> weights;
+  for (size_t h = 0; h < hop_num; ++h) {
+    int edge_idx = param.edge_idx.size() == 1 ? param.edge_idx[0]
+                                              : param.edge_idx[h];
+    PADDLE_ENFORCE_EQ(
+        edge_idx >= 0 && edge_idx < static_cast<int>(edge_shards.size()),
+        true,
+        paddle::platform::errors::InvalidArgument(
+            "Edge type %d of hop %d is not defined.", edge_idx, h));
+    PADDLE_ENFORCE_GT(param.fanouts[h],
+                      0,
+                      paddle::platform::errors::InvalidArgument(
+                          "Fanout of hop %d should be positive.", h));
+    // the frontier is the nodes reached by the last hop
+    int64_t frontier_begin = hop_node_offsets[h];
+    int64_t frontier_size = hop_node_offsets[h + 1] - frontier_begin;
+    if (sample_func != nullptr) {
+      PADDLE_ENFORCE_EQ(
+          sample_func(edge_idx,
+                      node_ids.data() + frontier_begin,
+                      frontier_size,
+                      param.fanouts[h],
+                      &neighbor_ids,
+                      &offsets),
+          0,
+          paddle::platform::errors::Unavailable(
+              "Failed to sample the neighbors of hop %d.", h));
+    } else {
+      random_sample_neighbors_batch(edge_idx,
+                                    node_ids.data() + frontier_begin,
+                                    frontier_size,
+                                    param.fanouts[h],
+                                    false,
+                                    &neighbor_ids,
+                                    &weights,
+                                    &offsets);
+    }
+    node_index.reserve(node_ids.size() + neighbor_ids.size());
+    edge_src.reserve(edge_src.size() + neighbor_ids.size());
+    edge_dst.reserve(edge_dst.size() + neighbor_ids.size());
+    for (int64_t i = 0; i < frontier_size; ++i) {
+      for (uint64_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+        auto iter = node_index.emplace(neighbor_ids[j], node_ids.size());
+        if (iter.second) {
+          node_ids.push_back(neighbor_ids[j]);
+        }
+        edge_src.push_back(iter.first->second);
+        edge_dst.push_back(frontier_begin + i);
       }
-      if (sample_res.size()) {
-        scaled_lru->insert(
-            i, sample_keys.data(), sample_res.data(), sample_keys.size());
+    }
+    hop_node_offsets.push_back(node_ids.size());
+    hop_edge_offsets.push_back(edge_src.size());
+  }
+
+  GraphSubgraphHeader header;
+  header.node_num = node_ids.size();
+  header.edge_num = edge_src.size();
+  header.hop_num = hop_num;
+  header.feature_num = param.feature_names.size();
+  std::vector<std::vector<std::string>> features;
+  std::vector<int64_t> feature_offsets;
+  if (header.feature_num > 0) {
+    if (feat_func != nullptr) {
+      PADDLE_ENFORCE_EQ(
+          feat_func(
+              node_ids.data(), node_ids.size(), param.feature_names, &features),
+          0,
+          paddle::platform::errors::Unavailable(
+              "Failed to get the features of the subgraph nodes."));
+    } else {
+      get_node_feat_batch(
+          node_ids.data(), node_ids.size(), param.feature_names, &features);
+    }
+    feature_offsets.reserve(header.feature_num * (header.node_num + 1));
+  }
+  int64_t feature_bytes = 0;
+  for (auto &feature : features) {
+    for (auto &value : feature) {
+      feature_offsets.push_back(feature_bytes);
+      feature_bytes += value.size();
+    }
+    feature_offsets.push_back(feature_bytes);
+  }
+
+  actual_size = sizeof(GraphSubgraphHeader) +
+                (node_ids.size() + hop_node_offsets.size() + edge_src.size() +
+                 edge_dst.size() + hop_edge_offsets.size() +
+                 feature_offsets.size()) *
+                    sizeof(int64_t) +
+                feature_bytes;
+  buffer.reset(new char[actual_size]);
+  char *pos = buffer.get();
+  auto append = [&pos](const void *data, size_t size) {
+    if (size > 0) {
+      memcpy(pos, data, size);
+      pos += size;
+    }
+  };
+  append(&header, sizeof(header));
+  append(node_ids.data(), node_ids.size() * sizeof(uint64_t));
+  for (auto *array : {&hop_node_offsets,
+                      &edge_src,
+                      &edge_dst,
+                      &hop_edge_offsets,
+                      &feature_offsets}) {
+    append(array->data(), array->size() * sizeof(int64_t));
+  }
+  for (auto &feature : features) {
+    for (auto &value : feature) {
+      append(value.data(), value.size());
+    }
+  }
+  return 0;
+}
+
+int32_t GraphTable::get_node_feat_batch(
+    const uint64_t *node_ids,
+    size_t node_num,
+    const std::vector<std::string> &feature_names,
+    std::vector<std::vector<std::string>> *res) {
+  res->assign(feature_names.size(), std::vector<std::string>(node_num));
+  std::vector<std::vector<uint32_t>> seq_id(task_pool_size_);
+  for (size_t idy = 0; idy < node_num; ++idy) {
+    seq_id[get_thread_pool_index(node_ids[idy])].push_back(idy);
+  }
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < seq_id.size(); i++) {
+    if (seq_id[i].size() == 0) continue;
+    tasks.push_back(_shards_task_pool[i]->enqueue([&, i, this]() -> int {
+      for (uint32_t idy : seq_id[i]) {
+        uint64_t node_id = node_ids[idy];
+        for (int type = 0; type < static_cast<int>(feature_shards.size());
+             ++type) {
+          const CsrGraphShard *csr_shard =
+              find_csr_shard(GraphTableType::FEATURE_TABLE, type, node_id);
+          int64_t csr_pos =
+              csr_shard == nullptr ? -1 : csr_shard->find(node_id);
+          Node *node =
+              csr_pos >= 0
+                  ? nullptr
+                  : find_node(GraphTableType::FEATURE_TABLE, type, node_id);
+          if (node == nullptr && csr_pos < 0) {
+            continue;
+          }
+          for (size_t feat_idx = 0; feat_idx < feature_names.size();
+               ++feat_idx) {
+            auto iter = feat_id_map[type].find(feature_names[feat_idx]);
+            if (iter == feat_id_map[type].end() ||
+                !(*res)[feat_idx][idy].empty()) {
+              continue;
+            }
+            (*res)[feat_idx][idy] =
+                csr_pos >= 0 ? csr_shard->get_feature(csr_pos, iter->second)
+                             : node->get_feature(iter->second);
+          }
+        }
       }
       return 0;
     }));
@@ -2082,6 +2555,22 @@ int32_t GraphTable::random_sample_neighbors(
   return 0;
 }
 
+std::pair<int64_t, int64_t> GraphTable::PrintTableStat() {
+  if (sample_cache == nullptr) {
+    return {0, 0};
+  }
+  auto stat = sample_cache->GetStat();
+  LOG(INFO) << "graph table " << table_name
+            << " neighbor sample cache: capacity " << sample_cache->Capacity()
+            << ", hit rate " << stat.HitRate() << ", hit " << stat.hit_num
+            << ", miss " << stat.miss_num << ", insert " << stat.insert_num
+            << ", evict " << stat.evict_num << ", oversize "
+            << stat.oversize_num << ", query latency " << stat.query_ns
+            << " ns";
+  return {static_cast<int64_t>(stat.hit_num),
+          static_cast<int64_t>(stat.miss_num)};
+}
+
 int32_t GraphTable::get_node_feat(int idx,
                                   const std::vector<uint64_t> &node_ids,
                                   const std::vector<std::string> &feature_names,
@@ -2092,9 +2581,16 @@ int32_t GraphTable::get_node_feat(int idx,
     uint64_t node_id = node_ids[idy];
     tasks.push_back(_shards_task_pool[get_thread_pool_index(node_id)]->enqueue(
         [&, idx, idy, node_id]() -> int {
-          Node *node = find_node(GraphTableType::FEATURE_TABLE, idx, node_id);
-
-          if (node == nullptr) {
+          const CsrGraphShard *csr_shard =
+              find_csr_shard(GraphTableType::FEATURE_TABLE, idx, node_id);
+          int64_t csr_pos =
+              csr_shard == nullptr ? -1 : csr_shard->find(node_id);
+          Node *node =
+              csr_pos >= 0
+                  ? nullptr
+                  : find_node(GraphTableType::FEATURE_TABLE, idx, node_id);
+
+          if (node == nullptr && csr_pos < 0) {
             return 0;
           }
           for (size_t feat_idx = 0; feat_idx < feature_names.size();
@@ -2103,8 +2599,10 @@ int32_t GraphTable::get_node_feat(int idx,
             if (feat_id_map[idx].find(feature_name) != feat_id_map[idx].end()) {
               // res[feat_idx][idx] =
               // node->get_feature(feat_id_map[feature_name]);
-              auto feat = node->get_feature(feat_id_map[idx][feature_name]);
-              res[feat_idx][idy] = feat;
+              int slot_idx = feat_id_map[idx][feature_name];
+              res[feat_idx][idy] =
+                  csr_pos >= 0 ? csr_shard->get_feature(csr_pos, slot_idx)
+                               : node->get_feature(slot_idx);
             }
           }
           return 0;
@@ -2569,7 +3067,8 @@ int32_t GraphTable::Initialize(const GraphParameter &graph) {
   if (use_cache) {
     cache_size_limit = graph.cache_size_limit();
     cache_ttl = graph.cache_ttl();
-    make_neighbor_sample_cache(cache_size_limit, cache_ttl);
+    cache_sample_size = graph.cache_sample_size();
+    make_neighbor_sample_cache(cache_size_limit, cache_ttl, cache_sample_size);
   }
   _shards_task_pool.resize(task_pool_size_);
   for (size_t i = 0; i < _shards_task_pool.size(); ++i) {
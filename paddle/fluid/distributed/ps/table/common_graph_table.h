@@ -41,7 +41,9 @@
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/graph/class_macro.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_sample_cache.h"
 #include "paddle/fluid/string/string_helper.h"
 #include "paddle/phi/core/utils/rw_lock.h"
 
@@ -157,287 +159,6 @@ class GraphShard {
   std::vector<Node *> bucket;
 };
 
-enum LRUResponse { ok = 0, blocked = 1, err = 2 };
-
-struct SampleKey {
-  int idx;
-  uint64_t node_key;
-  size_t sample_size;
-  bool is_weighted;
-  SampleKey(int _idx,
-            uint64_t _node_key,
-            size_t _sample_size,
-            bool _is_weighted) {
-    idx = _idx;
-    node_key = _node_key;
-    sample_size = _sample_size;
-    is_weighted = _is_weighted;
-  }
-  bool operator==(const SampleKey &s) const {
-    return idx == s.idx && node_key == s.node_key &&
-           sample_size == s.sample_size && is_weighted == s.is_weighted;
-  }
-};
-
-class SampleResult {
- public:
-  size_t actual_size;
-  std::shared_ptr<char> buffer;
-  SampleResult(size_t _actual_size, std::shared_ptr<char> &_buffer)  // NOLINT
-      : actual_size(_actual_size), buffer(_buffer) {}
-  SampleResult(size_t _actual_size, char *_buffer)
-      : actual_size(_actual_size),
-        buffer(_buffer, [](char *p) { delete[] p; }) {}
-  ~SampleResult() {}
-};
-
-template <typename K, typename V>
-class LRUNode {
- public:
-  LRUNode(K _key, V _data, size_t _ttl) : key(_key), data(_data), ttl(_ttl) {
-    next = pre = NULL;
-  }
-  K key;
-  V data;
-  size_t ttl;
-  // time to live
-  LRUNode<K, V> *pre, *next;
-};
-template <typename K, typename V>
-class ScaledLRU;
-
-template <typename K, typename V>
-class RandomSampleLRU {
- public:
-  explicit RandomSampleLRU(ScaledLRU<K, V> *_father) {
-    father = _father;
-    remove_count = 0;
-    node_size = 0;
-    node_head = node_end = NULL;
-    global_ttl = father->ttl;
-    total_diff = 0;
-  }
-
-  ~RandomSampleLRU() {
-    LRUNode<K, V> *p;
-    while (node_head != NULL) {
-      p = node_head->next;
-      delete node_head;
-      node_head = p;
-    }
-  }
-  LRUResponse query(K *keys,
-                    size_t length,
-                    std::vector<std::pair<K, V>> &res) {  // NOLINT
-    if (pthread_rwlock_tryrdlock(&father->rwlock) != 0)
-      return LRUResponse::blocked;
-    // pthread_rwlock_rdlock(&father->rwlock);
-    int init_size = node_size - remove_count;
-    process_redundant(length * 3);
-
-    for (size_t i = 0; i < length; i++) {
-      auto iter = key_map.find(keys[i]);
-      if (iter != key_map.end()) {
-        res.emplace_back(keys[i], iter->second->data);
-        iter->second->ttl--;
-        if (iter->second->ttl == 0) {
-          remove(iter->second);
-          if (remove_count != 0) remove_count--;
-        } else {
-          move_to_tail(iter->second);
-        }
-      }
-    }
-    total_diff += node_size - remove_count - init_size;
-    if (total_diff >= 500 || total_diff < -500) {
-      father->handle_size_diff(total_diff);
-      total_diff = 0;
-    }
-    pthread_rwlock_unlock(&father->rwlock);
-    return LRUResponse::ok;
-  }
-  LRUResponse insert(K *keys, V *data, size_t length) {
-    if (pthread_rwlock_tryrdlock(&father->rwlock) != 0)
-      return LRUResponse::blocked;
-    // pthread_rwlock_rdlock(&father->rwlock);
-    int init_size = node_size - remove_count;
-    process_redundant(length * 3);
-    for (size_t i = 0; i < length; i++) {
-      auto iter = key_map.find(keys[i]);
-      if (iter != key_map.end()) {
-        move_to_tail(iter->second);
-        iter->second->ttl = global_ttl;
-        iter->second->data = data[i];
-      } else {
-        LRUNode<K, V> *temp = new LRUNode<K, V>(keys[i], data[i], global_ttl);
-        add_new(temp);
-      }
-    }
-    total_diff += node_size - remove_count - init_size;
-    if (total_diff >= 500 || total_diff < -500) {
-      father->handle_size_diff(total_diff);
-      total_diff = 0;
-    }
-
-    pthread_rwlock_unlock(&father->rwlock);
-    return LRUResponse::ok;
-  }
-  void remove(LRUNode<K, V> *node) {
-    fetch(node);
-    node_size--;
-    key_map.erase(node->key);
-    delete node;
-  }
-
-  void process_redundant(int process_size) {
-    int length = std::min(remove_count, process_size);
-    while (length--) {
-      remove(node_head);
-      remove_count--;
-    }
-  }
-
-  void move_to_tail(LRUNode<K, V> *node) {
-    fetch(node);
-    place_at_tail(node);
-  }
-
-  void add_new(LRUNode<K, V> *node) {
-    node->ttl = global_ttl;
-    place_at_tail(node);
-    node_size++;
-    key_map[node->key] = node;
-  }
-  void place_at_tail(LRUNode<K, V> *node) {
-    if (node_end == NULL) {
-      node_head = node_end = node;
-      node->next = node->pre = NULL;
-    } else {
-      node_end->next = node;
-      node->pre = node_end;
-      node->next = NULL;
-      node_end = node;
-    }
-  }
-
-  void fetch(LRUNode<K, V> *node) {
-    if (node->pre) {
-      node->pre->next = node->next;
-    } else {
-      node_head = node->next;
-    }
-    if (node->next) {
-      node->next->pre = node->pre;
-    } else {
-      node_end = node->pre;
-    }
-  }
-
- private:
-  std::unordered_map<K, LRUNode<K, V> *> key_map;
-  ScaledLRU<K, V> *father;
-  size_t global_ttl, size_limit;
-  int node_size, total_diff;
-  LRUNode<K, V> *node_head, *node_end;
-  friend class ScaledLRU<K, V>;
-  int remove_count;
-};
-
-template <typename K, typename V>
-class ScaledLRU {
- public:
-  ScaledLRU(size_t _shard_num, size_t size_limit, size_t _ttl)
-      : size_limit(size_limit), ttl(_ttl) {
-    shard_num = _shard_num;
-    pthread_rwlock_init(&rwlock, NULL);
-    stop = false;
-    thread_pool.reset(new ::ThreadPool(1));
-    global_count = 0;
-    lru_pool = std::vector<RandomSampleLRU<K, V>>(shard_num,
-                                                  RandomSampleLRU<K, V>(this));
-    shrink_job = std::thread([this]() -> void {
-      while (true) {
-        {
-          std::unique_lock<std::mutex> lock(mutex_);
-          cv_.wait_for(lock, std::chrono::milliseconds(20000));
-          if (stop) {
-            return;
-          }
-        }
-        auto status =
-            thread_pool->enqueue([this]() -> int { return Shrink(); });
-        status.wait();
-      }
-    });
-    shrink_job.detach();
-  }
-  ~ScaledLRU() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    stop = true;
-    cv_.notify_one();
-  }
-  LRUResponse query(size_t index,
-                    K *keys,
-                    size_t length,
-                    std::vector<std::pair<K, V>> &res) {  // NOLINT
-    return lru_pool[index].query(keys, length, res);
-  }
-  LRUResponse insert(size_t index, K *keys, V *data, size_t length) {
-    return lru_pool[index].insert(keys, data, length);
-  }
-  int Shrink() {
-    size_t node_size = 0;
-    for (size_t i = 0; i < lru_pool.size(); i++) {
-      node_size += lru_pool[i].node_size - lru_pool[i].remove_count;
-    }
-
-    if (node_size <= static_cast<size_t>(1.1 * size_limit) + 1) return 0;
-    if (pthread_rwlock_wrlock(&rwlock) == 0) {
-      global_count = 0;
-      for (size_t i = 0; i < lru_pool.size(); i++) {
-        global_count += lru_pool[i].node_size - lru_pool[i].remove_count;
-      }
-      if (static_cast<size_t>(global_count) > size_limit) {
-        size_t remove = global_count - size_limit;
-        for (size_t i = 0; i < lru_pool.size(); i++) {
-          lru_pool[i].total_diff = 0;
-          lru_pool[i].remove_count +=
-              1.0 * (lru_pool[i].node_size - lru_pool[i].remove_count) /
-              global_count * remove;
-        }
-      }
-      pthread_rwlock_unlock(&rwlock);
-      return 0;
-    }
-    return 0;
-  }
-
-  void handle_size_diff(int diff) {
-    if (diff != 0) {
-      __sync_fetch_and_add(&global_count, diff);
-      if (global_count > static_cast<int>(1.25 * size_limit)) {
-        thread_pool->enqueue([this]() -> int { return Shrink(); });
-      }
-    }
-  }
-
-  size_t get_ttl() { return ttl; }
-
- private:
-  pthread_rwlock_t rwlock;
-  size_t shard_num;
-  int global_count;
-  size_t size_limit, total, hit;
-  size_t ttl;
-  bool stop;
-  std::thread shrink_job;
-  std::vector<RandomSampleLRU<K, V>> lru_pool;
-  mutable std::mutex mutex_;
-  std::condition_variable cv_;
-  std::shared_ptr<::ThreadPool> thread_pool;
-  friend class RandomSampleLRU<K, V>;
-};
-
 /*
 #ifdef PADDLE_WITH_HETERPS
 enum GraphSamplerStatus { waiting = 0, running = 1, terminating = 2 };
@@ -498,6 +219,67 @@ class GraphSampler {
 
 enum GraphTableType { EDGE_TABLE, FEATURE_TABLE };
 
+// Options of GraphTable::sample_subgraph.
+struct GraphSubgraphParam {
+  // edge type of every hop, a single edge type is used for all hops
+  std::vector<int> edge_idx;
+  // number of neighbors sampled for every node of the frontier, per hop
+  std::vector<int> fanouts;
+  // features gathered for every node of the subgraph, a node gets the
+  // feature from the first node type that has it
+  std::vector<std::string> feature_names;
+};
+
+// Header of the buffer of GraphTable::sample_subgraph. It is followed by
+// int64 arrays
+//   node_ids[node_num] | hop_node_offsets[hop_num + 2] |
+//   edge_src[edge_num] | edge_dst[edge_num] | hop_edge_offsets[hop_num + 1] |
+//   feature_offsets[feature_num * (node_num + 1)]
+// and the feature bytes. Nodes are reindexed in the order they are reached:
+// the deduplicated seeds are [hop_node_offsets[0], hop_node_offsets[1]), the
+// nodes first reached at hop h are [hop_node_offsets[h + 1],
+// hop_node_offsets[h + 2]). Edge e goes from the sampled neighbor
+// edge_src[e] to the frontier node edge_dst[e], both local indexes.
+struct GraphSubgraphHeader {
+  int64_t node_num;
+  int64_t edge_num;
+  int64_t hop_num;
+  int64_t feature_num;
+};
+
+// Samples sample_size neighbors of every node of node_ids of edge type idx
+// into flat arrays, laid out as by GraphTable::random_sample_neighbors_batch.
+using GraphNeighborSampleFunc =
+    std::function<int32_t(int idx,
+                          const uint64_t *node_ids,
+                          size_t node_num,
+                          int sample_size,
+                          std::vector<uint64_t> *neighbor_ids,
+                          std::vector<uint64_t> *offsets)>;
+// Gets the features of node_ids as GraphTable::get_node_feat_batch does.
+using GraphNodeFeatFunc =
+    std::function<int32_t(const uint64_t *node_ids,
+                          size_t node_num,
+                          const std::vector<std::string> &feature_names,
+                          std::vector<std::vector<std::string>> *res)>;
+
+// Read-only view of a subgraph buffer, the buffer must outlive the view.
+struct GraphSubgraphView {
+  // returns -1 if the buffer is truncated or its counts and feature offsets
+  // are out of range
+  int parse(const char *buffer, int64_t size);
+  std::string get_feature(int64_t feature_idx, int64_t node_idx) const;
+
+  GraphSubgraphHeader header;
+  const uint64_t *node_ids = nullptr;
+  const int64_t *hop_node_offsets = nullptr;
+  const int64_t *edge_src = nullptr;
+  const int64_t *edge_dst = nullptr;
+  const int64_t *hop_edge_offsets = nullptr;
+  const int64_t *feature_offsets = nullptr;
+  const char *feature_data = nullptr;
+};
+
 class GraphTable : public Table {
  public:
   GraphTable() {
@@ -545,6 +327,40 @@ class GraphTable : public Table {
       std::vector<int> &actual_sizes,               // NOLINT
       bool need_weight);
 
+  // Samples the neighbors of node_ids into flat arrays, the neighbors of
+  // node_ids[i] are (*neighbor_ids)[(*offsets)[i], (*offsets)[i + 1]).
+  // Nodes are grouped by shard task pool and sampled in parallel, without
+  // the per-node buffers and the cache of random_sample_neighbors.
+  int32_t random_sample_neighbors_batch(int idx,
+                                        const uint64_t *node_ids,
+                                        size_t node_num,
+                                        int sample_size,
+                                        bool need_weight,
+                                        std::vector<uint64_t> *neighbor_ids,
+                                        std::vector<float> *weights,
+                                        std::vector<uint64_t> *offsets);
+
+  // Samples the k-hop subgraph of seeds on the server, hop h samples
+  // fanouts[h] neighbors of every node first reached at hop h - 1. Nodes are
+  // deduplicated and reindexed as they are reached and the requested
+  // features are gathered, the result is one buffer laid out as described
+  // in GraphSubgraphHeader. Neighbors and features are read from this table
+  // unless sample_func and feat_func are given, e.g. by the graph service to
+  // reach the nodes of other servers.
+  int32_t sample_subgraph(const GraphSubgraphParam &param,
+                          const uint64_t *seeds,
+                          size_t seed_num,
+                          std::unique_ptr<char[]> &buffer,  // NOLINT
+                          int64_t &actual_size,             // NOLINT
+                          const GraphNeighborSampleFunc &sample_func = nullptr,
+                          const GraphNodeFeatFunc &feat_func = nullptr);
+
+  // features of node_ids in any node type, grouped by shard task pool
+  int32_t get_node_feat_batch(const uint64_t *node_ids,
+                              size_t node_num,
+                              const std::vector<std::string> &feature_names,
+                              std::vector<std::vector<std::string>> *res);
+
   int32_t random_sample_nodes(GraphTableType table_type,
                               int idx,
                               int sample_size,
@@ -676,17 +492,30 @@ class GraphTable : public Table {
   void release_graph();
   void release_graph_edge();
   void release_graph_node();
-  virtual int32_t make_neighbor_sample_cache(size_t size_limit, size_t ttl) {
+  // samples of up to max_sample_size weighted neighbors fit a cache slot
+  virtual int32_t make_neighbor_sample_cache(size_t size_limit,
+                                             size_t ttl,
+                                             size_t max_sample_size = 32) {
     {
       std::unique_lock<std::mutex> lock(mutex_);
       if (use_cache == false) {
-        scaled_lru.reset(new ScaledLRU<SampleKey, SampleResult>(
-            task_pool_size_, size_limit, ttl));
+        size_t slot_bytes =
+            max_sample_size * (Node::id_size + Node::weight_size);
+        sample_cache.reset(new GraphSampleCache(size_limit, ttl, slot_bytes));
         use_cache = true;
       }
     }
     return 0;
   }
+  // cached samples are dropped whenever the edges change
+  void invalidate_sample_cache() {
+    if (sample_cache != nullptr) {
+      sample_cache->Invalidate();
+    }
+  }
+  // logs the hit rate and latency of the neighbor sample cache, returns
+  // {hit_num, miss_num}
+  virtual std::pair<int64_t, int64_t> PrintTableStat();
   virtual void load_node_weight(int type_id, int idx, std::string path);
 #ifdef PADDLE_WITH_HETERPS
   // virtual int32_t start_graph_sampling() {
@@ -741,6 +570,24 @@ class GraphTable : public Table {
 #endif
   virtual int32_t add_comm_edge(int idx, uint64_t src_id, uint64_t dst_id);
   virtual int32_t build_sampler(int idx, std::string sample_type = "random");
+  // Freezes the shards of edge type (or node type) idx into the immutable
+  // CSR layout, which is used by random_sample_neighbors and get_node_feat
+  // from then on. release_nodes frees the node objects, after which the
+  // node based interfaces (pull_graph_list, get_all_id, ...) see no nodes.
+  int32_t build_csr_shards(GraphTableType table_type,
+                           int idx,
+                           bool release_nodes);
+  // one file per shard under path
+  int32_t save_csr_shards(GraphTableType table_type,
+                          int idx,
+                          const std::string &path);
+  int32_t load_csr_shards(GraphTableType table_type,
+                          int idx,
+                          const std::string &path,
+                          bool use_mmap);
+  const CsrGraphShard *find_csr_shard(GraphTableType table_type,
+                                      int idx,
+                                      uint64_t id);
   void set_slot_feature_separator(const std::string &ch);
   void set_feature_separator(const std::string &ch);
 
@@ -752,6 +599,8 @@ class GraphTable : public Table {
   std::unordered_map<int, int> type_to_index_;
 
   std::vector<std::vector<GraphShard *>> edge_shards, feature_shards;
+  std::vector<std::vector<std::shared_ptr<CsrGraphShard>>> edge_csr_shards,
+      feature_csr_shards;
   size_t shard_start, shard_end, server_num, shard_num_per_server, shard_num;
   int task_pool_size_ = 64;
   int load_thread_num = 160;
@@ -773,12 +622,13 @@ class GraphTable : public Table {
   std::vector<std::shared_ptr<::ThreadPool>> _cpu_worker_pool;
   std::vector<std::shared_ptr<std::mt19937_64>> _shards_task_rng_pool;
   std::shared_ptr<::ThreadPool> load_node_edge_task_pool;
-  std::shared_ptr<ScaledLRU<SampleKey, SampleResult>> scaled_lru;
+  std::shared_ptr<GraphSampleCache> sample_cache;
   std::unordered_set<uint64_t> extra_nodes;
   std::unordered_map<uint64_t, size_t> extra_nodes_to_thread_index;
   bool use_cache, use_duplicate_nodes;
   int cache_size_limit;
   int cache_ttl;
+  int cache_sample_size;
   mutable std::mutex mutex_;
   bool build_sampler_on_cpu;
   bool is_load_reverse_edge = false;
@@ -138,6 +138,10 @@ class CtrCommonAccessor : public ValueAccessor {
   virtual int Initialize();
   // 初始化AccessorInfo
   virtual void InitAccessorInfo();
+  // push value中梯度之前的维度
+  virtual size_t GetPushPrefixDim() {
+    return CtrCommonPushValue::EmbedGIndex();
+  }
   // 判断该value是否进行shrink
   virtual bool Shrink(float* value);
   // 判断该value是否保存到ssd
@@ -162,6 +162,10 @@ class CtrDoubleAccessor : public ValueAccessor {
   virtual int Initialize();
   // 初始化AccessorInfo
   virtual void InitAccessorInfo();
+  // push value中梯度之前的维度
+  virtual size_t GetPushPrefixDim() {
+    return CtrDoublePushValue::EmbedGIndex();
+  }
   // 判断该value是否进行shrink
   virtual bool Shrink(float* value);
   virtual bool NeedExtendMF(float* value);
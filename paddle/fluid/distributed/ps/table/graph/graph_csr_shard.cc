@@ -0,0 +1,317 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+const uint64_t kCsrShardMagic = 0x31305253434450ULL;  // "PDCSR01"
+
+struct CsrShardHeader {
+  uint64_t magic;
+  uint64_t node_num;
+  uint64_t edge_num;
+  uint64_t slot_num;
+  uint64_t feature_bytes;
+  uint64_t is_weighted;
+};
+
+inline size_t align8(size_t size) { return (size + 7) & ~size_t(7); }
+
+// byte offsets of the sections in the buffer
+struct CsrShardSections {
+  explicit CsrShardSections(const CsrShardHeader &header) {
+    ids = align8(sizeof(CsrShardHeader));
+    edge_offsets = ids + header.node_num * sizeof(uint64_t);
+    neighbors = edge_offsets + (header.node_num + 1) * sizeof(uint64_t);
+    weights = neighbors + header.edge_num * sizeof(uint64_t);
+    feature_offsets =
+        weights + align8(header.is_weighted ? header.edge_num * sizeof(float)
+                                            : 0);
+    feature_data = feature_offsets + (header.node_num * header.slot_num + 1) *
+                                         sizeof(uint64_t);
+    total = align8(feature_data + header.feature_bytes);
+  }
+  size_t ids;
+  size_t edge_offsets;
+  size_t neighbors;
+  size_t weights;
+  size_t feature_offsets;
+  size_t feature_data;
+  size_t total;
+};
+
+}  // namespace
+
+CsrGraphShard::~CsrGraphShard() { release(); }
+
+void CsrGraphShard::release() {
+  if (data_ != nullptr) {
+    if (mmaped_) {
+      munmap(data_, size_);
+    } else {
+      delete[] data_;
+    }
+  }
+  data_ = nullptr;
+  size_ = 0;
+  mmaped_ = false;
+  node_num_ = edge_num_ = slot_num_ = 0;
+  ids_ = edge_offsets_ = neighbors_ = feature_offsets_ = nullptr;
+  weights_ = nullptr;
+  feature_data_ = nullptr;
+}
+
+void CsrGraphShard::reset_views() {
+  PADDLE_ENFORCE_GE(size_,
+                    sizeof(CsrShardHeader),
+                    paddle::platform::errors::InvalidArgument(
+                        "CSR graph shard is truncated, size %d.", size_));
+  const CsrShardHeader *header =
+      reinterpret_cast<const CsrShardHeader *>(data_);
+  PADDLE_ENFORCE_EQ(header->magic,
+                    kCsrShardMagic,
+                    paddle::platform::errors::InvalidArgument(
+                        "Bad magic number of CSR graph shard."));
+  CsrShardSections sections(*header);
+  PADDLE_ENFORCE_EQ(
+      size_,
+      sections.total,
+      paddle::platform::errors::InvalidArgument(
+          "CSR graph shard size should be %d, but got %d.",
+          sections.total,
+          size_));
+  node_num_ = header->node_num;
+  edge_num_ = header->edge_num;
+  slot_num_ = header->slot_num;
+  ids_ = reinterpret_cast<const uint64_t *>(data_ + sections.ids);
+  edge_offsets_ =
+      reinterpret_cast<const uint64_t *>(data_ + sections.edge_offsets);
+  neighbors_ = reinterpret_cast<const uint64_t *>(data_ + sections.neighbors);
+  weights_ = header->is_weighted
+                 ? reinterpret_cast<const float *>(data_ + sections.weights)
+                 : nullptr;
+  feature_offsets_ =
+      reinterpret_cast<const uint64_t *>(data_ + sections.feature_offsets);
+  feature_data_ = data_ + sections.feature_data;
+}
+
+void CsrGraphShard::build(const std::vector<Node *> &bucket) {
+  std::vector<Node *> nodes(bucket.begin(), bucket.end());
+  std::sort(nodes.begin(), nodes.end(), [](Node *a, Node *b) {
+    return a->get_id() < b->get_id();
+  });
+
+  CsrShardHeader header;
+  header.magic = kCsrShardMagic;
+  header.node_num = nodes.size();
+  header.edge_num = 0;
+  header.slot_num = 0;
+  header.feature_bytes = 0;
+  header.is_weighted = 0;
+  for (auto *node : nodes) {
+    size_t neighbor_size = node->get_neighbor_size();
+    header.edge_num += neighbor_size;
+    for (size_t j = 0; j < neighbor_size && !header.is_weighted; ++j) {
+      header.is_weighted = node->get_neighbor_weight(j) != 1.;
+    }
+    size_t feature_size = node->get_feature_size();
+    header.slot_num = std::max<uint64_t>(header.slot_num, feature_size);
+    for (size_t s = 0; s < feature_size; ++s) {
+      header.feature_bytes += node->get_feature(s).size();
+    }
+  }
+
+  release();
+  CsrShardSections sections(header);
+  size_ = sections.total;
+  data_ = new char[size_];
+  memset(data_, 0, size_);
+  memcpy(data_, &header, sizeof(header));
+
+  uint64_t *ids = reinterpret_cast<uint64_t *>(data_ + sections.ids);
+  uint64_t *edge_offsets =
+      reinterpret_cast<uint64_t *>(data_ + sections.edge_offsets);
+  uint64_t *neighbors =
+      reinterpret_cast<uint64_t *>(data_ + sections.neighbors);
+  float *weights = reinterpret_cast<float *>(data_ + sections.weights);
+  uint64_t *feature_offsets =
+      reinterpret_cast<uint64_t *>(data_ + sections.feature_offsets);
+  char *feature_data = data_ + sections.feature_data;
+
+  uint64_t edge_pos = 0;
+  uint64_t feature_pos = 0;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    Node *node = nodes[i];
+    ids[i] = node->get_id();
+    edge_offsets[i] = edge_pos;
+    size_t neighbor_size = node->get_neighbor_size();
+    for (size_t j = 0; j < neighbor_size; ++j) {
+      neighbors[edge_pos] = node->get_neighbor_id(j);
+      if (header.is_weighted) {
+        weights[edge_pos] = node->get_neighbor_weight(j);
+      }
+      ++edge_pos;
+    }
+    int feature_size = node->get_feature_size();
+    for (size_t s = 0; s < header.slot_num; ++s) {
+      feature_offsets[i * header.slot_num + s] = feature_pos;
+      if (static_cast<int>(s) < feature_size) {
+        std::string feature = node->get_feature(s);
+        memcpy(feature_data + feature_pos, feature.data(), feature.size());
+        feature_pos += feature.size();
+      }
+    }
+  }
+  edge_offsets[nodes.size()] = edge_pos;
+  feature_offsets[nodes.size() * header.slot_num] = feature_pos;
+  reset_views();
+}
+
+int CsrGraphShard::save(const std::string &path) const {
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (fp == nullptr) {
+    LOG(WARNING) << "can not open " << path << " to save csr graph shard";
+    return -1;
+  }
+  size_t written = size_ == 0 ? 0 : fwrite(data_, 1, size_, fp);
+  int ret = fclose(fp);
+  if (written != size_ || ret != 0) {
+    LOG(WARNING) << "failed to write csr graph shard to " << path;
+    return -1;
+  }
+  return 0;
+}
+
+int CsrGraphShard::load(const std::string &path, bool use_mmap) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(WARNING) << "can not open csr graph shard " << path;
+    return -1;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return -1;
+  }
+  release();
+  size_ = file_stat.st_size;
+  if (use_mmap && size_ > 0) {
+    void *addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    PADDLE_ENFORCE_NE(addr,
+                      MAP_FAILED,
+                      paddle::platform::errors::Unavailable(
+                          "Failed to mmap csr graph shard %s.", path));
+    // sampling touches the neighbors of random nodes
+    madvise(addr, size_, MADV_RANDOM);
+    data_ = static_cast<char *>(addr);
+    mmaped_ = true;
+  } else {
+    data_ = new char[size_];
+    size_t read_size = 0;
+    while (read_size < size_) {
+      ssize_t ret = read(fd, data_ + read_size, size_ - read_size);
+      if (ret <= 0) {
+        break;
+      }
+      read_size += ret;
+    }
+    close(fd);
+    PADDLE_ENFORCE_EQ(read_size,
+                      size_,
+                      paddle::platform::errors::Unavailable(
+                          "Failed to read csr graph shard %s.", path));
+  }
+  reset_views();
+  return 0;
+}
+
+int64_t CsrGraphShard::find(uint64_t id) const {
+  const uint64_t *end = ids_ + node_num_;
+  const uint64_t *iter = std::lower_bound(ids_, end, id);
+  if (iter == end || *iter != id) {
+    return -1;
+  }
+  return iter - ids_;
+}
+
+std::string CsrGraphShard::get_feature(int64_t pos, int slot_idx) const {
+  if (slot_idx < 0 || static_cast<size_t>(slot_idx) >= slot_num_) {
+    return std::string("");
+  }
+  size_t index = pos * slot_num_ + slot_idx;
+  return std::string(feature_data_ + feature_offsets_[index],
+                     feature_offsets_[index + 1] - feature_offsets_[index]);
+}
+
+std::vector<int> CsrGraphShard::sample_k(
+    int64_t pos, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  if (weights_ != nullptr) {
+    return weighted_sample_k(pos, k, rng.get());
+  }
+  return random_sample_k(pos, k, rng.get());
+}
+
+std::vector<int> CsrGraphShard::random_sample_k(int64_t pos,
+                                                int k,
+                                                std::mt19937_64 *rng) const {
+  int n = get_neighbor_size(pos);
+  std::vector<int> sample_result;
+  if (k >= n) {
+    sample_result.resize(n);
+    for (int i = 0; i < n; i++) {
+      sample_result[i] = i;
+    }
+    return sample_result;
+  }
+  sample_result.reserve(k);
+  // partial Fisher-Yates shuffle, only the swapped slots are remembered
+  std::unordered_map<int, int> replace_map;
+  while (k--) {
+    std::uniform_int_distribution<int> distrib(0, n - 1);
+    int rand_int = distrib(*rng);
+    auto iter = replace_map.find(rand_int);
+    sample_result.push_back(iter == replace_map.end() ? rand_int
+                                                      : iter->second);
+    iter = replace_map.find(n - 1);
+    replace_map[rand_int] = iter == replace_map.end() ? n - 1 : iter->second;
+    --n;
+  }
+  return sample_result;
+}
+
+std::vector<int> CsrGraphShard::weighted_sample_k(int64_t pos,
+                                                  int k,
+                                                  std::mt19937_64 *rng) const {
+  return weighted_reservoir_sample_k(
+      weights_ + edge_offsets_[pos], get_neighbor_size(pos), k, rng);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,108 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+namespace paddle {
+namespace distributed {
+
+// Immutable compressed sparse row layout of one graph shard. All nodes of the
+// shard live in a single buffer:
+//   header | ids | edge_offsets | neighbors | weights | feature_offsets |
+//   feature_data
+// ids are sorted for lookup, the neighbors of the i-th node are
+// neighbors[edge_offsets[i], edge_offsets[i + 1]), weights only exist for
+// weighted graphs, and the bytes of slot s of node i are
+// feature_data[feature_offsets[i * slot_num + s], ...[i * slot_num + s + 1]).
+// The buffer is written to disk as is, so a saved shard can be mmaped.
+class CsrGraphShard {
+ public:
+  CsrGraphShard() {}
+  ~CsrGraphShard();
+
+  // builds from the nodes of a GraphShard, the nodes are not modified
+  void build(const std::vector<Node *> &bucket);
+
+  int save(const std::string &path) const;
+  // returns -1 if path can not be opened, the file is mmaped read-only if
+  // use_mmap, otherwise read into memory
+  int load(const std::string &path, bool use_mmap);
+
+  // position of id in the shard, -1 if not found
+  int64_t find(uint64_t id) const;
+
+  size_t get_node_num() const { return node_num_; }
+  size_t get_edge_num() const { return edge_num_; }
+  size_t get_slot_num() const { return slot_num_; }
+  bool is_weighted() const { return weights_ != nullptr; }
+  bool is_mmaped() const { return mmaped_; }
+  // bytes of the buffer, including the header
+  size_t memory_size() const { return size_; }
+
+  uint64_t get_id(int64_t pos) const { return ids_[pos]; }
+  size_t get_neighbor_size(int64_t pos) const {
+    return edge_offsets_[pos + 1] - edge_offsets_[pos];
+  }
+  uint64_t get_neighbor_id(int64_t pos, int idx) const {
+    return neighbors_[edge_offsets_[pos] + idx];
+  }
+  float get_neighbor_weight(int64_t pos, int idx) const {
+    return weights_ == nullptr ? 1. : weights_[edge_offsets_[pos] + idx];
+  }
+  std::string get_feature(int64_t pos, int slot_idx) const;
+
+  // samples k neighbors of the node at pos without replacement and returns
+  // their indexes, weighted by edge weight for weighted graphs
+  std::vector<int> sample_k(int64_t pos,
+                            int k,
+                            const std::shared_ptr<std::mt19937_64> rng) const;
+
+ private:
+  CsrGraphShard(const CsrGraphShard &) = delete;
+  CsrGraphShard &operator=(const CsrGraphShard &) = delete;
+
+  void release();
+  void reset_views();
+
+  std::vector<int> random_sample_k(int64_t pos,
+                                   int k,
+                                   std::mt19937_64 *rng) const;
+  std::vector<int> weighted_sample_k(int64_t pos,
+                                     int k,
+                                     std::mt19937_64 *rng) const;
+
+  char *data_ = nullptr;
+  size_t size_ = 0;
+  bool mmaped_ = false;
+
+  size_t node_num_ = 0;
+  size_t edge_num_ = 0;
+  size_t slot_num_ = 0;
+  const uint64_t *ids_ = nullptr;
+  const uint64_t *edge_offsets_ = nullptr;
+  const uint64_t *neighbors_ = nullptr;
+  const float *weights_ = nullptr;
+  const uint64_t *feature_offsets_ = nullptr;
+  const char *feature_data_ = nullptr;
+};
+
+}  // namespace distributed
+}  // namespace paddle
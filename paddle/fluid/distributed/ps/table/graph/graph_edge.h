@@ -39,6 +39,7 @@ class WeightedGraphEdgeBlob : public GraphEdgeBlob {
   virtual ~WeightedGraphEdgeBlob() {}
   virtual void add_edge(int64_t id, float weight);
   virtual float get_weight(int idx) { return weight_arr[idx]; }
+  std::vector<float>& export_weight_array() { return weight_arr; }
 
  protected:
   std::vector<float> weight_arr;
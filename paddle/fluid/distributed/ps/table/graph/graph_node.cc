@@ -58,6 +58,7 @@ int FeatureNode::get_size(bool need_feature) {
 
 void GraphNode::build_edges(bool is_weighted) {
   if (edges == nullptr) {
+    this->is_weighted = is_weighted;
     if (is_weighted == true) {
       edges = new WeightedGraphEdgeBlob();
     } else {
@@ -67,14 +68,18 @@ void GraphNode::build_edges(bool is_weighted) {
 }
 void GraphNode::build_sampler(std::string sample_type) {
   if (sampler != nullptr) {
-    return;
+    delete sampler;
+    sampler = nullptr;
   }
   if (sample_type == "random") {
     sampler = new RandomSampler();
   } else if (sample_type == "weighted") {
     sampler = new WeightedSampler();
+  } else if (sample_type == "alias") {
+    sampler = new AliasSampler();
   }
   sampler->build(edges);
+  sampler_stale = false;
 }
 void FeatureNode::to_buffer(char* buffer, bool need_feature) {
   memcpy(buffer, &id, id_size);
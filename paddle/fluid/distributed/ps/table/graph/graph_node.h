@@ -30,13 +30,14 @@ namespace distributed {
 
 class Node {
  public:
-  Node() {}
-  explicit Node(uint64_t id) : id(id) {}
+  Node() : is_weighted(false) {}
+  explicit Node(uint64_t id) : id(id), is_weighted(false) {}
   virtual ~Node() {}
   static int id_size, int_size, weight_size;
   uint64_t get_id() { return id; }
   int64_t get_py_id() { return (int64_t)id; }
   void set_id(uint64_t id) { this->id = id; }
+  bool get_is_weighted() { return is_weighted; }
 
   virtual void build_edges(bool is_weighted) {}
   virtual void build_sampler(std::string sample_type) {}
@@ -74,17 +75,28 @@ class Node {
 
 class GraphNode : public Node {
  public:
-  GraphNode() : Node(), sampler(nullptr), edges(nullptr) {}
+  GraphNode()
+      : Node(), sampler(nullptr), edges(nullptr), sampler_stale(false) {}
   explicit GraphNode(uint64_t id)
-      : Node(id), sampler(nullptr), edges(nullptr) {}
+      : Node(id), sampler(nullptr), edges(nullptr), sampler_stale(false) {}
   virtual ~GraphNode();
   virtual void build_edges(bool is_weighted);
+  // "random", "weighted" or "alias", replaces the sampler built before
   virtual void build_sampler(std::string sample_type);
   virtual void add_edge(uint64_t id, float weight) {
     edges->add_edge(id, weight);
+    // the alias and weighted samplers keep tables built from the edges, they
+    // are rebuilt once by the next sample_k instead of on every added edge
+    sampler_stale = sampler != nullptr;
   }
+  // The nodes of a shard are only sampled by the task pool thread of the
+  // shard, so the stale sampler is rebuilt without a lock.
   virtual std::vector<int> sample_k(
       int k, const std::shared_ptr<std::mt19937_64> rng) {
+    if (sampler_stale) {
+      sampler->build(edges);
+      sampler_stale = false;
+    }
     return sampler->sample_k(k, rng);
   }
   virtual uint64_t get_neighbor_id(int idx) { return edges->get_id(idx); }
@@ -94,6 +106,8 @@ class GraphNode : public Node {
  protected:
   Sampler *sampler;
   GraphEdgeBlob *edges;
+  // edges were added since the sampler was built
+  bool sampler_stale;
 };
 
 class FeatureNode : public Node {
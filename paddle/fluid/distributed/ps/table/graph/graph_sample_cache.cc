@@ -0,0 +1,219 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_sample_cache.h"
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <functional>
+#include <thread>  // NOLINT
+
+#include "glog/logging.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+inline uint64_t mix64(uint64_t x) {
+  // splitmix64 finalizer, node ids are often sequential
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// one of every kTimedQueryPeriod queries of a thread is timed
+const uint32_t kTimedQueryPeriod = 64;
+
+}  // namespace
+
+GraphSampleCache::GraphSampleCache(size_t capacity,
+                                   size_t ttl,
+                                   size_t slot_bytes)
+    : ttl_(ttl), slot_bytes_(slot_bytes) {
+  set_num_ = 1;
+  while (set_num_ * kWays < capacity) {
+    set_num_ <<= 1;
+  }
+  size_t slot_num = set_num_ * kWays;
+  slots_.reset(new Slot[slot_num]);
+  slab_.reset(new char[slot_num * slot_bytes_]);
+  set_locks_.reset(new SetLock[set_num_]);
+}
+
+GraphSampleCache::~GraphSampleCache() {}
+
+size_t GraphSampleCache::SetIndex(const SampleKey &key) const {
+  uint64_t h = mix64(key.node_key ^ (static_cast<uint64_t>(key.idx) << 48) ^
+                     (static_cast<uint64_t>(key.sample_size) << 32) ^
+                     (static_cast<uint64_t>(key.is_weighted) << 63));
+  return h & (set_num_ - 1);
+}
+
+bool GraphSampleCache::Match(const Slot &slot,
+                             const SampleKey &key,
+                             uint64_t epoch) const {
+  return slot.node_key.load(std::memory_order_relaxed) == key.node_key &&
+         slot.idx.load(std::memory_order_relaxed) == key.idx &&
+         slot.sample_size.load(std::memory_order_relaxed) ==
+             key.sample_size &&
+         slot.is_weighted.load(std::memory_order_relaxed) ==
+             static_cast<uint8_t>(key.is_weighted) &&
+         slot.epoch.load(std::memory_order_relaxed) == epoch;
+}
+
+GraphSampleCache::Counters &GraphSampleCache::LocalCounters() {
+  static thread_local size_t stripe =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) %
+      kCounterStripes;
+  return counters_[stripe];
+}
+
+bool GraphSampleCache::Query(const SampleKey &key,
+                             std::shared_ptr<char> *buffer,
+                             int *size) {
+  static thread_local uint32_t query_count = 0;
+  Counters &counters = LocalCounters();
+  if (++query_count < kTimedQueryPeriod) {
+    return QueryImpl(key, buffer, size);
+  }
+  query_count = 0;
+  auto start = std::chrono::steady_clock::now();
+  bool hit = QueryImpl(key, buffer, size);
+  auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  counters.timed_query.fetch_add(1, std::memory_order_relaxed);
+  counters.timed_ns.fetch_add(cost.count(), std::memory_order_relaxed);
+  return hit;
+}
+
+bool GraphSampleCache::QueryImpl(const SampleKey &key,
+                                 std::shared_ptr<char> *buffer,
+                                 int *size) {
+  Counters &counters = LocalCounters();
+  uint64_t epoch = epoch_.load(std::memory_order_acquire);
+  size_t begin = SetIndex(key) * kWays;
+  for (size_t pos = begin; pos < begin + kWays; ++pos) {
+    Slot &slot = slots_[pos];
+    uint64_t version = slot.version.load(std::memory_order_acquire);
+    if ((version & 1) || !Match(slot, key, epoch)) {
+      continue;
+    }
+    int result_size = slot.size.load(std::memory_order_relaxed);
+    char *data = new char[result_size];
+    memcpy(data, slab_.get() + pos * slot_bytes_, result_size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // overwritten while copying, or used up
+    if (slot.version.load(std::memory_order_relaxed) != version ||
+        slot.uses_left.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+      delete[] data;
+      break;
+    }
+    slot.referenced.store(1, std::memory_order_relaxed);
+    buffer->reset(data, [](char *p) { delete[] p; });
+    *size = result_size;
+    counters.hit.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  counters.miss.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void GraphSampleCache::Insert(const SampleKey &key,
+                              const char *buffer,
+                              int size) {
+  Counters &counters = LocalCounters();
+  if (size < 0 || static_cast<size_t>(size) > slot_bytes_) {
+    if (counters.oversize.fetch_add(1, std::memory_order_relaxed) == 0) {
+      LOG(WARNING) << "neighbor sample of " << size
+                   << " bytes does not fit the cache slot of " << slot_bytes_
+                   << " bytes and is not cached, raise cache_sample_size";
+    }
+    return;
+  }
+  size_t set = SetIndex(key);
+  SetLock &lock = set_locks_[set];
+  while (lock.flag.test_and_set(std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+  uint64_t epoch = epoch_.load(std::memory_order_acquire);
+  size_t begin = set * kWays;
+  size_t victim = begin + kWays;
+  // the same key, then a stale or used up slot
+  for (size_t pos = begin; pos < begin + kWays; ++pos) {
+    if (Match(slots_[pos], key, epoch)) {
+      victim = pos;
+      break;
+    }
+    if (victim == begin + kWays &&
+        (slots_[pos].epoch.load(std::memory_order_relaxed) != epoch ||
+         slots_[pos].uses_left.load(std::memory_order_relaxed) <= 0)) {
+      victim = pos;
+    }
+  }
+  if (victim == begin + kWays) {
+    // CLOCK: the hand skips and clears referenced slots
+    while (true) {
+      Slot &slot = slots_[begin + lock.hand];
+      size_t pos = begin + lock.hand;
+      lock.hand = (lock.hand + 1) % kWays;
+      if (slot.referenced.exchange(0, std::memory_order_relaxed) == 0) {
+        victim = pos;
+        break;
+      }
+    }
+    counters.evict.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Slot &slot = slots_[victim];
+  uint64_t version = slot.version.load(std::memory_order_relaxed);
+  slot.version.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.node_key.store(key.node_key, std::memory_order_relaxed);
+  slot.idx.store(key.idx, std::memory_order_relaxed);
+  slot.sample_size.store(key.sample_size, std::memory_order_relaxed);
+  slot.is_weighted.store(key.is_weighted, std::memory_order_relaxed);
+  slot.epoch.store(epoch, std::memory_order_relaxed);
+  slot.size.store(size, std::memory_order_relaxed);
+  slot.uses_left.store(ttl_, std::memory_order_relaxed);
+  slot.referenced.store(0, std::memory_order_relaxed);
+  memcpy(slab_.get() + victim * slot_bytes_, buffer, size);
+  slot.version.store(version + 2, std::memory_order_release);
+  counters.insert.fetch_add(1, std::memory_order_relaxed);
+
+  lock.flag.clear(std::memory_order_release);
+}
+
+GraphSampleCacheStat GraphSampleCache::GetStat() const {
+  GraphSampleCacheStat stat;
+  uint64_t timed_query = 0, timed_ns = 0;
+  for (auto &counters : counters_) {
+    stat.hit_num += counters.hit.load(std::memory_order_relaxed);
+    stat.miss_num += counters.miss.load(std::memory_order_relaxed);
+    stat.insert_num += counters.insert.load(std::memory_order_relaxed);
+    stat.evict_num += counters.evict.load(std::memory_order_relaxed);
+    stat.oversize_num += counters.oversize.load(std::memory_order_relaxed);
+    timed_query += counters.timed_query.load(std::memory_order_relaxed);
+    timed_ns += counters.timed_ns.load(std::memory_order_relaxed);
+  }
+  stat.query_ns =
+      timed_query == 0 ? 0 : static_cast<double>(timed_ns) / timed_query;
+  return stat;
+}
+
+}  // namespace distributed
+}  // namespace paddle
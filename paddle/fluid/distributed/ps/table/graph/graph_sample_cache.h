@@ -0,0 +1,155 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+struct SampleKey {
+  int idx;
+  uint64_t node_key;
+  size_t sample_size;
+  bool is_weighted;
+  SampleKey(int _idx,
+            uint64_t _node_key,
+            size_t _sample_size,
+            bool _is_weighted) {
+    idx = _idx;
+    node_key = _node_key;
+    sample_size = _sample_size;
+    is_weighted = _is_weighted;
+  }
+  bool operator==(const SampleKey &s) const {
+    return idx == s.idx && node_key == s.node_key &&
+           sample_size == s.sample_size && is_weighted == s.is_weighted;
+  }
+};
+
+class SampleResult {
+ public:
+  size_t actual_size;
+  std::shared_ptr<char> buffer;
+  SampleResult(size_t _actual_size, std::shared_ptr<char> &_buffer)  // NOLINT
+      : actual_size(_actual_size), buffer(_buffer) {}
+  SampleResult(size_t _actual_size, char *_buffer)
+      : actual_size(_actual_size),
+        buffer(_buffer, [](char *p) { delete[] p; }) {}
+  ~SampleResult() {}
+};
+
+struct GraphSampleCacheStat {
+  uint64_t hit_num = 0;
+  uint64_t miss_num = 0;
+  uint64_t insert_num = 0;
+  uint64_t evict_num = 0;
+  // results larger than a slot
+  uint64_t oversize_num = 0;
+  // mean latency of sampled queries
+  double query_ns = 0;
+
+  double HitRate() const {
+    uint64_t total = hit_num + miss_num;
+    return total == 0 ? 0.0 : static_cast<double>(hit_num) / total;
+  }
+};
+
+// Cache of neighbor sample results with a fixed memory footprint. Entries
+// live in a preallocated slab of slot_bytes sized slots grouped into sets of
+// kWays, a key can only be cached in the slots of its set and is evicted by
+// a CLOCK hand per set. Queries do not lock: a slot carries a version that
+// is odd while being written, and a reader that sees the version change
+// during its copy counts a miss. Writers of a set serialize on a spin lock.
+//
+// An entry serves ttl queries, after which the sample is drawn again, and
+// Invalidate drops all entries at once when the graph changes.
+class GraphSampleCache {
+ public:
+  static constexpr size_t kWays = 8;
+
+  GraphSampleCache(size_t capacity, size_t ttl, size_t slot_bytes = 256);
+  ~GraphSampleCache();
+
+  // returns false on miss, otherwise the result is copied out of the slot
+  bool Query(const SampleKey &key, std::shared_ptr<char> *buffer, int *size);
+
+  // results larger than slot_bytes are not cached and are logged
+  // once per counter stripe
+  void Insert(const SampleKey &key, const char *buffer, int size);
+
+  void Invalidate() { epoch_.fetch_add(1, std::memory_order_release); }
+
+  GraphSampleCacheStat GetStat() const;
+
+  size_t Capacity() const { return set_num_ * kWays; }
+
+ private:
+  GraphSampleCache(const GraphSampleCache &) = delete;
+  GraphSampleCache &operator=(const GraphSampleCache &) = delete;
+
+  struct Slot {
+    // even when stable, odd while a writer fills the slot
+    std::atomic<uint64_t> version{0};
+    std::atomic<uint64_t> node_key{0};
+    std::atomic<uint64_t> sample_size{0};
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<int32_t> idx{-1};
+    std::atomic<int32_t> size{0};
+    std::atomic<int32_t> uses_left{0};
+    std::atomic<uint8_t> is_weighted{0};
+    // the CLOCK reference bit
+    std::atomic<uint8_t> referenced{0};
+  };
+
+  struct alignas(64) SetLock {
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+    uint32_t hand = 0;
+  };
+
+  // counters are striped over threads to keep hits from sharing a line
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> hit{0};
+    std::atomic<uint64_t> miss{0};
+    std::atomic<uint64_t> insert{0};
+    std::atomic<uint64_t> evict{0};
+    std::atomic<uint64_t> oversize{0};
+    std::atomic<uint64_t> timed_query{0};
+    std::atomic<uint64_t> timed_ns{0};
+  };
+  static constexpr size_t kCounterStripes = 32;
+
+  size_t SetIndex(const SampleKey &key) const;
+  bool Match(const Slot &slot, const SampleKey &key, uint64_t epoch) const;
+  Counters &LocalCounters();
+  bool QueryImpl(const SampleKey &key,
+                 std::shared_ptr<char> *buffer,
+                 int *size);
+
+  size_t set_num_;
+  size_t ttl_;
+  size_t slot_bytes_;
+  std::unique_ptr<Slot[]> slots_;
+  std::unique_ptr<char[]> slab_;
+  std::unique_ptr<SetLock[]> set_locks_;
+  std::atomic<uint64_t> epoch_{1};
+  Counters counters_[kCounterStripes];
+};
+
+}  // namespace distributed
+}  // namespace paddle
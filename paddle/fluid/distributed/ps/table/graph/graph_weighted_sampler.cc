@@ -14,10 +14,15 @@
 
 #include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
+#include "glog/logging.h"
 #include "paddle/phi/core/generator.h"
 namespace paddle {
 namespace distributed {
@@ -58,6 +63,163 @@ std::vector<int> RandomSampler::sample_k(
   return sample_result;
 }
 
+void build_alias_table(const float *weights, int n, float *prob, int *alias) {
+  double sum = 0;
+  for (int i = 0; i < n; ++i) {
+    sum += std::max(weights[i], 0.f);
+  }
+  if (sum <= 0) {
+    for (int i = 0; i < n; ++i) {
+      prob[i] = 0;
+      alias[i] = i;
+    }
+    return;
+  }
+  // scaled[i] is the weight of column i relative to the average column
+  std::vector<double> scaled(n);
+  std::vector<int> small, large;
+  for (int i = 0; i < n; ++i) {
+    scaled[i] = std::max(weights[i], 0.f) * n / sum;
+    if (scaled[i] < 1.) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    int s = small.back(), l = large.back();
+    small.pop_back();
+    prob[s] = scaled[s];
+    alias[s] = l;
+    scaled[l] -= 1. - scaled[s];
+    if (scaled[l] < 1.) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // leftovers are full columns up to rounding error
+  for (int l : large) {
+    prob[l] = 1.;
+    alias[l] = l;
+  }
+  for (int s : small) {
+    prob[s] = scaled[s] > 0 ? 1. : 0.;
+    alias[s] = s;
+  }
+}
+
+std::vector<int> weighted_reservoir_sample_k(const float *weights,
+                                             int n,
+                                             int k,
+                                             std::mt19937_64 *rng) {
+  std::uniform_real_distribution<double> distrib(0., 1.);
+  std::vector<std::pair<double, int>> keys;
+  keys.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    if (weights[i] <= 0) {
+      continue;
+    }
+    keys.emplace_back(std::log(1. - distrib(*rng)) / weights[i], i);
+  }
+  if (k < static_cast<int>(keys.size())) {
+    std::nth_element(
+        keys.begin(),
+        keys.begin() + k,
+        keys.end(),
+        [](const std::pair<double, int> &a, const std::pair<double, int> &b) {
+          return a.first > b.first;
+        });
+    keys.resize(k);
+  }
+  std::vector<int> sample_result(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    sample_result[i] = keys[i].second;
+  }
+  return sample_result;
+}
+
+std::vector<int> alias_sample_k(const float *weights,
+                                const float *prob,
+                                const int *alias,
+                                int n,
+                                int k,
+                                std::mt19937_64 *rng) {
+  std::vector<int> sample_result;
+  if (k <= 0 || n <= 0) {
+    return sample_result;
+  }
+  // rejection gets slow once most of the weight is taken, leave large k to
+  // the reservoir
+  if (k * 4 > n) {
+    return weighted_reservoir_sample_k(weights, n, k, rng);
+  }
+  sample_result.reserve(k);
+  std::unordered_set<int> sampled;
+  std::uniform_int_distribution<int> column_distrib(0, n - 1);
+  std::uniform_real_distribution<float> prob_distrib(0, 1.0);
+  int max_tries = 4 * k + 32;
+  while (static_cast<int>(sample_result.size()) < k && max_tries-- > 0) {
+    int column = column_distrib(*rng);
+    int idx = prob_distrib(*rng) < prob[column] ? column : alias[column];
+    if (weights[idx] <= 0) {
+      continue;
+    }
+    if (sample_result.size() < 16) {
+      // a linear scan beats hashing for the usual fanouts
+      if (std::find(sample_result.begin(), sample_result.end(), idx) !=
+          sample_result.end()) {
+        continue;
+      }
+      if (sample_result.size() == 15) {
+        sampled.insert(sample_result.begin(), sample_result.end());
+        sampled.insert(idx);
+      }
+    } else if (!sampled.insert(idx).second) {
+      continue;
+    }
+    sample_result.push_back(idx);
+  }
+  if (static_cast<int>(sample_result.size()) < k) {
+    // too many duplicates, e.g. few heavy edges among many weightless ones
+    return weighted_reservoir_sample_k(weights, n, k, rng);
+  }
+  return sample_result;
+}
+
+void AliasSampler::build(GraphEdgeBlob *edges) {
+  this->edges = edges;
+  auto *weighted_edges = dynamic_cast<WeightedGraphEdgeBlob *>(edges);
+  if (weighted_edges == nullptr) {
+    prob.clear();
+    alias.clear();
+    return;
+  }
+  auto &weight_arr = weighted_edges->export_weight_array();
+  int n = weight_arr.size();
+  prob.resize(n);
+  alias.resize(n);
+  build_alias_table(weight_arr.data(), n, prob.data(), alias.data());
+}
+
+std::vector<int> AliasSampler::sample_k(
+    int k, const std::shared_ptr<std::mt19937_64> rng) {
+  int n = edges->size();
+  auto *weighted_edges = dynamic_cast<WeightedGraphEdgeBlob *>(edges);
+  if (weighted_edges == nullptr) {
+    RandomSampler random_sampler;
+    random_sampler.build(edges);
+    return random_sampler.sample_k(k, rng);
+  }
+  // the weight array may have grown or moved since build
+  const float *weights = weighted_edges->export_weight_array().data();
+  if (static_cast<int>(prob.size()) != n) {
+    VLOG(2) << "alias table of " << prob.size() << " edges is stale, "
+            << n << " edges now";
+    return weighted_reservoir_sample_k(weights, n, k, rng.get());
+  }
+  return alias_sample_k(weights, prob.data(), alias.data(), n, k, rng.get());
+}
+
 WeightedSampler::WeightedSampler() {
   left = nullptr;
   right = nullptr;
@@ -40,6 +40,46 @@ class RandomSampler : public Sampler {
   GraphEdgeBlob *edges;
 };
 
+// Vose's alias method over weights[0, n): after the O(n) build, an index is
+// drawn in O(1) by picking a column i and returning i with probability
+// prob[i], otherwise alias[i].
+void build_alias_table(const float *weights, int n, float *prob, int *alias);
+
+// Samples k distinct indexes of weights[0, n) with probability proportional
+// to the weight, like drawing them one by one without replacement. Indexes
+// of non-positive weight are never sampled. Draws from the alias table and
+// rejects duplicates while k is small relative to n, otherwise falls back
+// to weighted_reservoir_sample_k.
+std::vector<int> alias_sample_k(const float *weights,
+                                const float *prob,
+                                const int *alias,
+                                int n,
+                                int k,
+                                std::mt19937_64 *rng);
+
+// Efraimidis-Spirakis reservoir sampling: keeps the k indexes with the
+// largest log(u) / weight, O(n) per call and no precomputed state.
+std::vector<int> weighted_reservoir_sample_k(const float *weights,
+                                             int n,
+                                             int k,
+                                             std::mt19937_64 *rng);
+
+// O(1) per draw weighted sampler, 8 extra bytes per edge. Used for the
+// "alias" sample type, edges without weights are sampled uniformly. The
+// table must be rebuilt when edges change; until then sample_k falls back
+// to weighted_reservoir_sample_k over the current weights.
+class AliasSampler : public Sampler {
+ public:
+  AliasSampler() : edges(nullptr) {}
+  virtual ~AliasSampler() {}
+  virtual void build(GraphEdgeBlob *edges);
+  virtual std::vector<int> sample_k(int k,
+                                    const std::shared_ptr<std::mt19937_64> rng);
+  GraphEdgeBlob *edges;
+  std::vector<float> prob;
+  std::vector<int> alias;
+};
+
 class WeightedSampler : public Sampler {
  public:
   WeightedSampler();
@@ -125,6 +125,10 @@ class SparseAccessor : public ValueAccessor {
   virtual int Initialize();
   // 初始化AccessorInfo
   virtual void InitAccessorInfo();
+  // push value中梯度之前的维度
+  virtual size_t GetPushPrefixDim() {
+    return SparsePushValue::EmbedGIndex();
+  }
   // 判断该value是否进行shrink
   virtual bool Shrink(float* value);
   // 判断该value是否保存到ssd
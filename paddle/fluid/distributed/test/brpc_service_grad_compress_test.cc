@@ -0,0 +1,236 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_server.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace framework = paddle::framework;
+namespace distributed = paddle::distributed;
+
+// one sparse table per compress type, all with the same accessor
+const std::vector<std::string> kCompressTypes = {  // NOLINT
+    "none",
+    "fp16",
+    "topk",
+    "sign"};
+const int kEmbedxDim = 8;
+// slot, show, click, embed_g, embedx_g
+const int kUpdateDim = 4 + kEmbedxDim;
+
+void GetSparseTableProto(distributed::TableParameter* sparse_table_proto,
+                         int table_id) {
+  sparse_table_proto->set_table_id(table_id);
+  sparse_table_proto->set_table_class("MemorySparseTable");
+  sparse_table_proto->set_shard_num(10);
+  sparse_table_proto->set_type(distributed::PS_SPARSE_TABLE);
+  auto* compress_param = sparse_table_proto->mutable_grad_compress_param();
+  compress_param->set_compress_type(kCompressTypes[table_id]);
+  compress_param->set_topk_ratio(0.25);
+  // slot/show/click are not gradients
+  compress_param->set_raw_prefix_dim(3);
+
+  auto* accessor_config = sparse_table_proto->mutable_accessor();
+  accessor_config->set_accessor_class("SparseAccessor");
+  accessor_config->set_fea_dim(kEmbedxDim + 1);
+  accessor_config->set_embedx_dim(kEmbedxDim);
+  accessor_config->set_embedx_threshold(0);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  for (auto* sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto* naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(1.0);
+    naive_param->set_initial_range(0.0);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+}
+
+void SetServiceProto(distributed::DownpourServerParameter* downpour_server) {
+  auto* server_service_proto = downpour_server->mutable_service_param();
+  server_service_proto->set_service_class("BrpcPsService");
+  server_service_proto->set_server_class("BrpcPsServer");
+  server_service_proto->set_client_class("BrpcPsClient");
+  server_service_proto->set_start_server_port(0);
+  server_service_proto->set_server_thread_num(12);
+  for (size_t i = 0; i < kCompressTypes.size(); ++i) {
+    GetSparseTableProto(downpour_server->add_downpour_table_param(), i);
+  }
+}
+
+distributed::PSParameter GetServerProto() {
+  distributed::PSParameter server_fleet_desc;
+  SetServiceProto(server_fleet_desc.mutable_server_param()
+                      ->mutable_downpour_server_param());
+  return server_fleet_desc;
+}
+
+distributed::PSParameter GetWorkerProto() {
+  distributed::PSParameter worker_fleet_desc;
+  auto* downpour_worker_proto = worker_fleet_desc.mutable_worker_param()
+                                    ->mutable_downpour_worker_param();
+  for (size_t i = 0; i < kCompressTypes.size(); ++i) {
+    GetSparseTableProto(downpour_worker_proto->add_downpour_table_param(), i);
+  }
+  SetServiceProto(worker_fleet_desc.mutable_server_param()
+                      ->mutable_downpour_server_param());
+  return worker_fleet_desc;
+}
+
+/*-------------------------------------------------------------------------*/
+
+std::string ip_ = "127.0.0.1";  // NOLINT
+uint32_t port_ = 4212;
+
+std::vector<std::string> host_sign_list_;
+
+std::shared_ptr<distributed::PSServer> pserver_ptr_;
+
+std::shared_ptr<distributed::PSClient> worker_ptr_;
+
+void RunServer() {
+  distributed::PSParameter server_proto = GetServerProto();
+  auto _ps_env = distributed::PaddlePSEnvironment();
+  _ps_env.SetPsServers(&host_sign_list_, 1);
+  pserver_ptr_ = std::shared_ptr<distributed::PSServer>(
+      distributed::PSServerFactory::Create(server_proto));
+  std::vector<framework::ProgramDesc> empty_vec;
+  framework::ProgramDesc empty_prog;
+  empty_vec.push_back(empty_prog);
+  pserver_ptr_->Configure(server_proto, _ps_env, 0, empty_vec);
+  pserver_ptr_->Start(ip_, port_);
+}
+
+void RunClient(std::map<uint64_t, std::vector<distributed::Region>>&
+                   dense_regions) {
+  distributed::PSParameter worker_proto = GetWorkerProto();
+  distributed::PaddlePSEnvironment _ps_env;
+  _ps_env.SetPsServers(&host_sign_list_, host_sign_list_.size());
+  worker_ptr_ = std::shared_ptr<distributed::PSClient>(
+      distributed::PSClientFactory::Create(worker_proto));
+  worker_ptr_->Configure(worker_proto, dense_regions, _ps_env, 0);
+}
+
+int PushOnce(int table_id,
+             const std::vector<uint64_t>& keys,
+             const std::vector<const float*>& grads) {
+  auto* closure = new distributed::DownpourBrpcClosure(1, [](void* done) {
+    auto* closure = reinterpret_cast<distributed::DownpourBrpcClosure*>(done);
+    closure->set_promise_value(
+        closure->check_response(0, distributed::PS_PUSH_SPARSE_TABLE));
+  });
+  auto status = worker_ptr_->PushSparseRawGradient(
+      table_id,
+      keys.data(),
+      const_cast<const float**>(grads.data()),
+      keys.size(),
+      closure);
+  status.wait();
+  return status.get();
+}
+
+void RunBrpcPushCompressedSparse() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  auto ph_host = distributed::PSHost(ip_, port_, 0);
+  host_sign_list_.push_back(ph_host.SerializeToString());
+
+  std::thread server_thread(RunServer);
+  sleep(1);
+
+  std::map<uint64_t, std::vector<distributed::Region>> dense_regions;
+  RunClient(dense_regions);
+  auto* brpc_client =
+      dynamic_cast<distributed::BrpcPsClient*>(worker_ptr_.get());
+  ASSERT_NE(brpc_client, nullptr);
+
+  const size_t key_num = 10000;
+  const int push_times = 20;
+  std::vector<uint64_t> keys(key_num);
+  std::vector<float> grads(key_num * kUpdateDim);
+  std::vector<const float*> grad_ptrs(key_num);
+  for (size_t i = 0; i < key_num; ++i) {
+    keys[i] = i * 7919;
+    float* g = grads.data() + i * kUpdateDim;
+    g[0] = 1;  // slot
+    g[1] = 1;  // show
+    g[2] = 0;  // click
+    for (int j = 3; j < kUpdateDim; ++j) {
+      g[j] = 0.001 * static_cast<float>((i + j) % 17) - 0.008;
+    }
+    grad_ptrs[i] = g;
+  }
+
+  size_t select_dim =
+      worker_ptr_->GetTableAccessor(0)->GetAccessorInfo().select_dim;
+  std::vector<std::vector<float>> pulled(kCompressTypes.size());
+  for (size_t table_id = 0; table_id < kCompressTypes.size(); ++table_id) {
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < push_times; ++t) {
+      ASSERT_EQ(PushOnce(table_id, keys, grad_ptrs), 0);
+    }
+    double cost = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    size_t key_bytes = push_times * key_num * sizeof(uint64_t);
+    size_t value_bytes = push_times * key_num * kUpdateDim * sizeof(float);
+    auto* compressor = brpc_client->GetGradCompressor(table_id);
+    if (compressor != nullptr) {
+      ASSERT_EQ(compressor->RawBytes(), value_bytes);
+      value_bytes = compressor->EncodedBytes();
+    }
+    LOG(INFO) << "grad compress: " << kCompressTypes[table_id]
+              << " bytes on wire per push: "
+              << (key_bytes + value_bytes) / push_times
+              << " push qps: " << push_times / cost
+              << " keys/s: " << push_times * key_num / cost;
+
+    pulled[table_id].resize(key_num * select_dim);
+    std::vector<float*> value_ptrs(key_num);
+    for (size_t i = 0; i < key_num; ++i) {
+      value_ptrs[i] = pulled[table_id].data() + i * select_dim;
+    }
+    auto pull_status = worker_ptr_->PullSparse(
+        value_ptrs.data(), table_id, keys.data(), key_num, true);
+    pull_status.wait();
+  }
+
+  // fp16 keeps the update close to the uncompressed table
+  for (size_t i = 0; i < pulled[0].size(); ++i) {
+    ASSERT_NEAR(pulled[1][i], pulled[0][i], 1e-2);
+  }
+
+  worker_ptr_->StopServer();
+  worker_ptr_->FinalizeWorker();
+  server_thread.join();
+}
+
+TEST(RunBrpcPushCompressedSparse, Run) { RunBrpcPushCompressedSparse(); }
@@ -0,0 +1,213 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_server.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace framework = paddle::framework;
+namespace distributed = paddle::distributed;
+
+const int kTableNum = 2;
+const int kEmbedxDim = 8;
+
+void GetSparseTableProto(distributed::TableParameter* sparse_table_proto,
+                         int table_id) {
+  sparse_table_proto->set_table_id(table_id);
+  sparse_table_proto->set_table_class("MemorySparseTable");
+  sparse_table_proto->set_shard_num(10);
+  sparse_table_proto->set_type(distributed::PS_SPARSE_TABLE);
+
+  auto* accessor_config = sparse_table_proto->mutable_accessor();
+  accessor_config->set_accessor_class("SparseAccessor");
+  accessor_config->set_fea_dim(kEmbedxDim + 1);
+  accessor_config->set_embedx_dim(kEmbedxDim);
+  accessor_config->set_embedx_threshold(0);
+  for (auto* sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto* naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+}
+
+void SetServiceProto(distributed::DownpourServerParameter* downpour_server) {
+  auto* server_service_proto = downpour_server->mutable_service_param();
+  server_service_proto->set_service_class("BrpcPsService");
+  server_service_proto->set_server_class("BrpcPsServer");
+  server_service_proto->set_client_class("BrpcPsClient");
+  server_service_proto->set_start_server_port(0);
+  server_service_proto->set_server_thread_num(12);
+  for (int i = 0; i < kTableNum; ++i) {
+    GetSparseTableProto(downpour_server->add_downpour_table_param(), i);
+  }
+}
+
+distributed::PSParameter GetServerProto() {
+  distributed::PSParameter server_fleet_desc;
+  SetServiceProto(server_fleet_desc.mutable_server_param()
+                      ->mutable_downpour_server_param());
+  return server_fleet_desc;
+}
+
+distributed::PSParameter GetWorkerProto() {
+  distributed::PSParameter worker_fleet_desc;
+  auto* downpour_worker_proto = worker_fleet_desc.mutable_worker_param()
+                                    ->mutable_downpour_worker_param();
+  for (int i = 0; i < kTableNum; ++i) {
+    GetSparseTableProto(downpour_worker_proto->add_downpour_table_param(), i);
+  }
+  SetServiceProto(worker_fleet_desc.mutable_server_param()
+                      ->mutable_downpour_server_param());
+  return worker_fleet_desc;
+}
+
+/*-------------------------------------------------------------------------*/
+
+std::string ip_ = "127.0.0.1";  // NOLINT
+uint32_t port_ = 4213;
+
+std::vector<std::string> host_sign_list_;
+
+std::shared_ptr<distributed::PSServer> pserver_ptr_;
+
+std::shared_ptr<distributed::PSClient> worker_ptr_;
+
+void RunServer() {
+  distributed::PSParameter server_proto = GetServerProto();
+  auto _ps_env = distributed::PaddlePSEnvironment();
+  _ps_env.SetPsServers(&host_sign_list_, 1);
+  pserver_ptr_ = std::shared_ptr<distributed::PSServer>(
+      distributed::PSServerFactory::Create(server_proto));
+  std::vector<framework::ProgramDesc> empty_vec;
+  framework::ProgramDesc empty_prog;
+  empty_vec.push_back(empty_prog);
+  pserver_ptr_->Configure(server_proto, _ps_env, 0, empty_vec);
+  pserver_ptr_->Start(ip_, port_);
+}
+
+void RunClient(std::map<uint64_t, std::vector<distributed::Region>>&
+                   dense_regions) {
+  distributed::PSParameter worker_proto = GetWorkerProto();
+  distributed::PaddlePSEnvironment _ps_env;
+  _ps_env.SetPsServers(&host_sign_list_, host_sign_list_.size());
+  worker_ptr_ = std::shared_ptr<distributed::PSClient>(
+      distributed::PSClientFactory::Create(worker_proto));
+  worker_ptr_->Configure(worker_proto, dense_regions, _ps_env, 0);
+}
+
+void RunBrpcPullSparseMultiTable() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  auto ph_host = distributed::PSHost(ip_, port_, 0);
+  host_sign_list_.push_back(ph_host.SerializeToString());
+
+  std::thread server_thread(RunServer);
+  sleep(1);
+
+  std::map<uint64_t, std::vector<distributed::Region>> dense_regions;
+  RunClient(dense_regions);
+
+  // a batch of a ctr model has many repeated keys
+  const size_t key_num = 20000;
+  const size_t unique_num = 2000;
+  const int pull_times = 20;
+  size_t select_dim =
+      worker_ptr_->GetTableAccessor(0)->GetAccessorInfo().select_dim;
+
+  std::vector<std::vector<uint64_t>> keys(kTableNum);
+  std::vector<std::vector<float>> values(kTableNum);
+  std::vector<std::vector<float>> expect_values(kTableNum);
+  std::vector<std::vector<float*>> value_ptrs(kTableNum);
+  std::vector<std::vector<float*>> expect_ptrs(kTableNum);
+  std::vector<distributed::PullSparseRequest> requests(kTableNum);
+  for (int t = 0; t < kTableNum; ++t) {
+    keys[t].resize(key_num);
+    values[t].resize(key_num * select_dim);
+    expect_values[t].resize(key_num * select_dim);
+    value_ptrs[t].resize(key_num);
+    expect_ptrs[t].resize(key_num);
+    for (size_t i = 0; i < key_num; ++i) {
+      keys[t][i] = (i * 7919 + t) % unique_num * 104729;
+      value_ptrs[t][i] = values[t].data() + i * select_dim;
+      expect_ptrs[t][i] = expect_values[t].data() + i * select_dim;
+    }
+    requests[t].table_id = t;
+    requests[t].select_values = value_ptrs[t].data();
+    requests[t].keys = keys[t].data();
+    requests[t].num = key_num;
+
+    // creates the features, later pulls are served from the table
+    auto status = worker_ptr_->PullSparse(
+        expect_ptrs[t].data(), t, keys[t].data(), key_num, true);
+    status.wait();
+    ASSERT_EQ(status.get(), 0);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < pull_times; ++n) {
+    for (int t = 0; t < kTableNum; ++t) {
+      worker_ptr_
+          ->PullSparse(expect_ptrs[t].data(), t, keys[t].data(), key_num, true)
+          .wait();
+    }
+  }
+  double single_cost =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  start = std::chrono::steady_clock::now();
+  for (int n = 0; n < pull_times; ++n) {
+    auto status = worker_ptr_->PullSparseMultiTable(requests, true);
+    status.wait();
+    ASSERT_EQ(status.get(), 0);
+  }
+  double multi_cost =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  for (int t = 0; t < kTableNum; ++t) {
+    for (size_t i = 0; i < values[t].size(); ++i) {
+      ASSERT_FLOAT_EQ(values[t][i], expect_values[t][i]);
+    }
+  }
+
+  // keys and frequencies of the unique keys plus their values
+  double bytes_per_key =
+      static_cast<double>(unique_num) *
+      (sizeof(uint64_t) + sizeof(uint32_t) + select_dim * sizeof(float)) /
+      key_num;
+  double total_keys = static_cast<double>(pull_times) * kTableNum * key_num;
+  LOG(INFO) << "pull sparse per table keys/s: " << total_keys / single_cost
+            << " multi table keys/s: " << total_keys / multi_cost
+            << " bytes on wire per key: " << bytes_per_key;
+
+  worker_ptr_->StopServer();
+  worker_ptr_->FinalizeWorker();
+  server_thread.join();
+}
+
+TEST(RunBrpcPullSparseMultiTable, Run) { RunBrpcPullSparseMultiTable(); }
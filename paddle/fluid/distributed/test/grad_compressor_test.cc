@@ -0,0 +1,193 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/grad_compressor.h"
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+std::shared_ptr<GradCompressor> MakeCompressor(const std::string& type,
+                                               uint32_t prefix_dim = 0,
+                                               float topk_ratio = 0.25) {
+  GradCompressParameter param;
+  param.set_compress_type(type);
+  param.set_raw_prefix_dim(prefix_dim);
+  param.set_topk_ratio(topk_ratio);
+  return CreateGradCompressor(param);
+}
+
+std::vector<float> RoundTrip(GradCompressor* compressor,
+                             const std::vector<uint64_t>& keys,
+                             const std::vector<float>& values,
+                             size_t dim) {
+  size_t num = keys.size();
+  std::vector<const float*> rows(num);
+  for (size_t i = 0; i < num; ++i) {
+    rows[i] = values.data() + i * dim;
+  }
+  std::vector<char> buffer(compressor->EncodedSize(num, dim));
+  compressor->Encode(keys.data(), rows.data(), num, dim, buffer.data());
+  std::vector<float> decoded(num * dim);
+  EXPECT_EQ(GradCompressor::Decode(
+                buffer.data(), buffer.size(), num, dim, decoded.data()),
+            0);
+  return decoded;
+}
+
+}  // namespace
+
+TEST(GradCompressor, none) {
+  ASSERT_EQ(MakeCompressor("none"), nullptr);
+}
+
+TEST(GradCompressor, fp16) {
+  auto compressor = MakeCompressor("fp16", 3);
+  ASSERT_NE(compressor, nullptr);
+  const size_t dim = 11;
+  std::vector<uint64_t> keys = {1, 7, 42};
+  std::vector<float> values(keys.size() * dim);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = 0.001 * i - 0.01 + 100000.0 * (i % dim == 0);
+  }
+  auto decoded = RoundTrip(compressor.get(), keys, values, dim);
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (i % dim < 3) {
+      // raw prefix such as slot/show/click is exact
+      ASSERT_FLOAT_EQ(decoded[i], values[i]);
+    } else {
+      ASSERT_NEAR(decoded[i], values[i], 1e-3);
+    }
+  }
+  ASSERT_LT(compressor->EncodedBytes(), compressor->RawBytes());
+}
+
+TEST(GradCompressor, topk_error_feedback) {
+  auto compressor = MakeCompressor("topk", 0, 0.25);
+  ASSERT_NE(compressor, nullptr);
+  const size_t dim = 8;
+  std::vector<uint64_t> keys = {5};
+  std::vector<float> values = {0.1, -4.0, 0.2, 3.0, 0.0, -0.3, 0.05, 0.4};
+  auto decoded = RoundTrip(compressor.get(), keys, values, dim);
+  std::vector<float> expect = {0, -4.0, 0, 3.0, 0, 0, 0, 0};
+  for (size_t j = 0; j < dim; ++j) {
+    ASSERT_FLOAT_EQ(decoded[j], expect[j]);
+  }
+  // the unsent part is accumulated and shows up in later pushes
+  std::vector<float> sent(dim, 0.0);
+  std::vector<float> zeros(dim, 0.0);
+  for (int step = 0; step < 4; ++step) {
+    auto part = RoundTrip(compressor.get(), keys, zeros, dim);
+    for (size_t j = 0; j < dim; ++j) sent[j] += part[j];
+  }
+  for (size_t j = 0; j < dim; ++j) {
+    ASSERT_FLOAT_EQ(sent[j] + expect[j], values[j]);
+  }
+}
+
+TEST(GradCompressor, sign_error_feedback) {
+  auto compressor = MakeCompressor("sign");
+  ASSERT_NE(compressor, nullptr);
+  const size_t dim = 13;
+  std::vector<uint64_t> keys = {3, 9};
+  std::vector<float> values(keys.size() * dim);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = (i % 3 == 0 ? -1.0 : 1.0) * (0.1 + 0.01 * i);
+  }
+  // sum of decoded pushes plus the residual always equals the sum of grads
+  std::vector<float> sent(values.size(), 0.0);
+  const int steps = 50;
+  for (int step = 0; step < steps; ++step) {
+    auto part = RoundTrip(compressor.get(), keys, values, dim);
+    for (size_t i = 0; i < values.size(); ++i) sent[i] += part[i];
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    ASSERT_NEAR(sent[i] / steps, values[i], 0.05);
+  }
+  size_t encoded = compressor->EncodedSize(keys.size(), dim);
+  ASSERT_EQ(encoded,
+            sizeof(GradCompressHeader) + keys.size() * (sizeof(float) + 2));
+}
+
+TEST(GradCompressor, default_prefix_dim) {
+  GradCompressParameter param;
+  param.set_compress_type("fp16");
+  // slot ids above 2048 are not exact in fp16
+  auto compressor = CreateGradCompressor(param, 3);
+  const size_t dim = 5;
+  std::vector<uint64_t> keys = {1};
+  std::vector<float> values = {4097, 12345, 3, 0.5, -0.25};
+  auto decoded = RoundTrip(compressor.get(), keys, values, dim);
+  for (size_t j = 0; j < dim; ++j) {
+    ASSERT_FLOAT_EQ(decoded[j], values[j]);
+  }
+  // an explicit raw_prefix_dim wins
+  param.set_raw_prefix_dim(0);
+  compressor = CreateGradCompressor(param, 3);
+  decoded = RoundTrip(compressor.get(), keys, values, dim);
+  ASSERT_NE(decoded[0], values[0]);
+}
+
+TEST(GradCompressor, bounded_residuals) {
+  GradCompressParameter param;
+  param.set_compress_type("sign");
+  param.set_max_residual_keys(100);
+  auto compressor = CreateGradCompressor(param);
+  const size_t dim = 4;
+  std::vector<float> values(10 * dim, 1.0);
+  for (uint64_t step = 0; step < 50; ++step) {
+    std::vector<uint64_t> keys(10);
+    for (uint64_t i = 0; i < keys.size(); ++i) {
+      keys[i] = step * keys.size() + i;
+    }
+    RoundTrip(compressor.get(), keys, values, dim);
+    ASSERT_LE(compressor->ResidualSize(), 100UL);
+  }
+  // the keys of the last push are kept
+  ASSERT_GE(compressor->ResidualSize(), 10UL);
+
+  // keys not pushed since the previous shrink are dropped
+  compressor->ShrinkResiduals();
+  std::vector<uint64_t> keys = {7, 8};
+  RoundTrip(compressor.get(), keys, std::vector<float>(2 * dim, 1.0), dim);
+  compressor->ShrinkResiduals();
+  ASSERT_EQ(compressor->ResidualSize(), 2UL);
+}
+
+TEST(GradCompressor, decode_invalid) {
+  auto compressor = MakeCompressor("topk", 0, 0.5);
+  const size_t dim = 4;
+  std::vector<uint64_t> keys = {1};
+  std::vector<float> values = {1, 2, 3, 4};
+  const float* row = values.data();
+  std::vector<char> buffer(compressor->EncodedSize(1, dim));
+  compressor->Encode(keys.data(), &row, 1, dim, buffer.data());
+  std::vector<float> decoded(dim);
+  ASSERT_NE(GradCompressor::Decode(
+                buffer.data(), buffer.size() - 1, 1, dim, decoded.data()),
+            0);
+  ASSERT_NE(GradCompressor::Decode(
+                buffer.data(), buffer.size(), 2, dim, decoded.data()),
+            0);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,250 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
+
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+
+namespace distributed = paddle::distributed;
+
+namespace {
+
+// nodes with ids 0, 2, 4, ..., odd ids are missing
+std::vector<distributed::Node *> MakeGraphNodes(size_t node_num,
+                                                int max_degree,
+                                                bool is_weighted) {
+  std::mt19937_64 rng(2023);
+  std::uniform_int_distribution<int> degree_dist(0, max_degree);
+  std::uniform_int_distribution<uint64_t> id_dist(0, node_num * 2);
+  std::uniform_real_distribution<float> weight_dist(0.1, 2.0);
+  std::vector<distributed::Node *> nodes;
+  for (size_t i = 0; i < node_num; ++i) {
+    auto *node = new distributed::GraphNode(i * 2);
+    node->build_edges(is_weighted);
+    int degree = degree_dist(rng);
+    for (int j = 0; j < degree; ++j) {
+      node->add_edge(id_dist(rng), is_weighted ? weight_dist(rng) : 1.);
+    }
+    // WeightedSampler can not be built on an empty edge list
+    if (!is_weighted || degree > 0) {
+      node->build_sampler(is_weighted ? "weighted" : "random");
+    }
+    nodes.push_back(node);
+  }
+  // the bucket of a GraphShard is not sorted
+  std::shuffle(nodes.begin(), nodes.end(), rng);
+  return nodes;
+}
+
+void DeleteNodes(std::vector<distributed::Node *> *nodes) {
+  for (auto *node : *nodes) {
+    delete node;
+  }
+  nodes->clear();
+}
+
+void ExpectSameShard(const std::vector<distributed::Node *> &nodes,
+                     const distributed::CsrGraphShard &csr_shard) {
+  ASSERT_EQ(csr_shard.get_node_num(), nodes.size());
+  for (auto *node : nodes) {
+    int64_t pos = csr_shard.find(node->get_id());
+    ASSERT_GE(pos, 0);
+    EXPECT_EQ(csr_shard.get_id(pos), node->get_id());
+    ASSERT_EQ(csr_shard.get_neighbor_size(pos), node->get_neighbor_size());
+    for (size_t j = 0; j < node->get_neighbor_size(); ++j) {
+      EXPECT_EQ(csr_shard.get_neighbor_id(pos, j), node->get_neighbor_id(j));
+      EXPECT_EQ(csr_shard.get_neighbor_weight(pos, j),
+                node->get_neighbor_weight(j));
+    }
+    for (int s = 0; s < node->get_feature_size(); ++s) {
+      EXPECT_EQ(csr_shard.get_feature(pos, s), node->get_feature(s));
+    }
+  }
+}
+
+// rough heap size of the node objects held by a GraphShard
+size_t NodeObjectBytes(const std::vector<distributed::Node *> &nodes) {
+  // node, edge blob and sampler objects, each with about 16 bytes of
+  // allocator overhead, plus the bucket pointer and the node_location entry
+  const size_t per_node = sizeof(distributed::GraphNode) +
+                          sizeof(distributed::WeightedGraphEdgeBlob) +
+                          sizeof(distributed::WeightedSampler) + 3 * 16 +
+                          sizeof(void *) + 48;
+  size_t bytes = 0;
+  for (auto *node : nodes) {
+    bytes += per_node + node->get_neighbor_size() * sizeof(int64_t);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TEST(CsrGraphShard, Build) {
+  for (bool is_weighted : {false, true}) {
+    auto nodes = MakeGraphNodes(1000, 20, is_weighted);
+    distributed::CsrGraphShard csr_shard;
+    csr_shard.build(nodes);
+    EXPECT_EQ(csr_shard.is_weighted(), is_weighted);
+    ExpectSameShard(nodes, csr_shard);
+    EXPECT_EQ(csr_shard.find(1), -1);
+    EXPECT_EQ(csr_shard.find(1000000), -1);
+    DeleteNodes(&nodes);
+  }
+
+  std::vector<distributed::Node *> feature_nodes;
+  for (uint64_t id = 0; id < 100; ++id) {
+    auto *node = new distributed::FeatureNode(id);
+    node->set_feature_size(id % 3 + 1);
+    node->set_feature(0, std::to_string(id));
+    if (id % 3 == 2) {
+      node->set_feature(2, std::string(id, 'a'));
+    }
+    feature_nodes.push_back(node);
+  }
+  distributed::CsrGraphShard feature_shard;
+  feature_shard.build(feature_nodes);
+  EXPECT_EQ(feature_shard.get_slot_num(), 3u);
+  EXPECT_EQ(feature_shard.get_edge_num(), 0u);
+  ExpectSameShard(feature_nodes, feature_shard);
+  EXPECT_EQ(feature_shard.get_feature(feature_shard.find(0), 2), "");
+  DeleteNodes(&feature_nodes);
+}
+
+TEST(CsrGraphShard, SaveAndLoad) {
+  auto nodes = MakeGraphNodes(1000, 20, true);
+  distributed::CsrGraphShard csr_shard;
+  csr_shard.build(nodes);
+  std::string path = "./csr_graph_shard_test.csr";
+  ASSERT_EQ(csr_shard.save(path), 0);
+  for (bool use_mmap : {false, true}) {
+    distributed::CsrGraphShard loaded;
+    ASSERT_EQ(loaded.load(path, use_mmap), 0);
+    EXPECT_EQ(loaded.is_mmaped(), use_mmap);
+    EXPECT_EQ(loaded.memory_size(), csr_shard.memory_size());
+    ExpectSameShard(nodes, loaded);
+  }
+  distributed::CsrGraphShard missing;
+  EXPECT_EQ(missing.load("./not_exist.csr", true), -1);
+  unlink(path.c_str());
+  DeleteNodes(&nodes);
+}
+
+TEST(CsrGraphShard, Sample) {
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  auto nodes = MakeGraphNodes(200, 50, false);
+  distributed::CsrGraphShard csr_shard;
+  csr_shard.build(nodes);
+  for (size_t pos = 0; pos < csr_shard.get_node_num(); ++pos) {
+    int neighbor_size = csr_shard.get_neighbor_size(pos);
+    for (int k : {1, 5, 100}) {
+      auto res = csr_shard.sample_k(pos, k, rng);
+      EXPECT_EQ(static_cast<int>(res.size()), std::min(k, neighbor_size));
+      std::unordered_set<int> unique(res.begin(), res.end());
+      EXPECT_EQ(unique.size(), res.size());
+      for (int x : res) {
+        EXPECT_GE(x, 0);
+        EXPECT_LT(x, neighbor_size);
+      }
+    }
+  }
+  DeleteNodes(&nodes);
+
+  // a heavy edge is picked far more often than a light one
+  auto *node = new distributed::GraphNode(7);
+  node->build_edges(true);
+  node->add_edge(1, 100.);
+  node->add_edge(2, 0.);
+  for (int i = 0; i < 8; ++i) {
+    node->add_edge(10 + i, 1.);
+  }
+  std::vector<distributed::Node *> weighted_nodes = {node};
+  distributed::CsrGraphShard weighted_shard;
+  weighted_shard.build(weighted_nodes);
+  int heavy_count = 0;
+  for (int i = 0; i < 1000; ++i) {
+    for (int x : weighted_shard.sample_k(0, 1, rng)) {
+      EXPECT_NE(x, 1);  // zero weight
+      heavy_count += x == 0;
+    }
+  }
+  EXPECT_GT(heavy_count, 800);
+  EXPECT_EQ(weighted_shard.sample_k(0, 20, rng).size(), 9u);
+  DeleteNodes(&weighted_nodes);
+}
+
+TEST(CsrGraphShard, Benchmark) {
+  const size_t node_num = 200000;
+  const int sample_size = 10;
+  const int query_num = 1000000;
+  auto nodes = MakeGraphNodes(node_num, 32, false);
+  std::unordered_map<uint64_t, distributed::Node *> node_location;
+  for (auto *node : nodes) {
+    node_location[node->get_id()] = node;
+  }
+  distributed::CsrGraphShard csr_shard;
+  csr_shard.build(nodes);
+
+  std::mt19937_64 query_rng(1);
+  std::uniform_int_distribution<uint64_t> query_dist(0, node_num - 1);
+  std::vector<uint64_t> queries(query_num);
+  for (auto &id : queries) {
+    id = query_dist(query_rng) * 2;
+  }
+
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  uint64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t id : queries) {
+    distributed::Node *node = node_location[id];
+    for (int x : node->sample_k(sample_size, rng)) {
+      checksum += node->get_neighbor_id(x);
+    }
+  }
+  std::chrono::duration<double> node_cost =
+      std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (uint64_t id : queries) {
+    int64_t pos = csr_shard.find(id);
+    for (int x : csr_shard.sample_k(pos, sample_size, rng)) {
+      checksum += csr_shard.get_neighbor_id(pos, x);
+    }
+  }
+  std::chrono::duration<double> csr_cost =
+      std::chrono::steady_clock::now() - start;
+
+  size_t node_bytes = NodeObjectBytes(nodes);
+  LOG(INFO) << node_num << " nodes, " << csr_shard.get_edge_num()
+            << " edges, checksum " << checksum;
+  LOG(INFO) << "memory: node objects ~" << node_bytes << " bytes, csr "
+            << csr_shard.memory_size() << " bytes ("
+            << static_cast<double>(node_bytes) / csr_shard.memory_size()
+            << "x)";
+  LOG(INFO) << "samples/sec: node objects " << query_num / node_cost.count()
+            << ", csr " << query_num / csr_cost.count();
+  EXPECT_LT(csr_shard.memory_size(), node_bytes);
+  DeleteNodes(&nodes);
+}
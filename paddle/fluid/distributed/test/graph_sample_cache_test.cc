@@ -0,0 +1,171 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_sample_cache.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace distributed = paddle::distributed;
+
+namespace {
+
+// the sample of a node is its id repeated, so a torn read is detectable
+std::vector<uint64_t> MakeSample(uint64_t node_id, size_t sample_size) {
+  return std::vector<uint64_t>(sample_size, node_id);
+}
+
+bool CheckSample(const char *buffer, int size, uint64_t node_id) {
+  const uint64_t *ids = reinterpret_cast<const uint64_t *>(buffer);
+  for (size_t i = 0; i < size / sizeof(uint64_t); ++i) {
+    if (ids[i] != node_id) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(GraphSampleCache, QueryInsert) {
+  distributed::GraphSampleCache cache(1024, 3);
+  EXPECT_EQ(cache.Capacity(), 1024u);
+  distributed::SampleKey key(0, 42, 4, false);
+  std::shared_ptr<char> buffer;
+  int size = 0;
+  EXPECT_FALSE(cache.Query(key, &buffer, &size));
+
+  auto sample = MakeSample(42, 4);
+  cache.Insert(key,
+               reinterpret_cast<const char *>(sample.data()),
+               sample.size() * sizeof(uint64_t));
+  // another sample size or edge type is another key
+  EXPECT_FALSE(
+      cache.Query(distributed::SampleKey(0, 42, 5, false), &buffer, &size));
+  EXPECT_FALSE(
+      cache.Query(distributed::SampleKey(1, 42, 4, false), &buffer, &size));
+  // an entry serves ttl queries
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(cache.Query(key, &buffer, &size));
+    EXPECT_EQ(size, 32);
+    EXPECT_TRUE(CheckSample(buffer.get(), size, 42));
+  }
+  EXPECT_FALSE(cache.Query(key, &buffer, &size));
+
+  cache.Insert(key,
+               reinterpret_cast<const char *>(sample.data()),
+               sample.size() * sizeof(uint64_t));
+  cache.Invalidate();
+  EXPECT_FALSE(cache.Query(key, &buffer, &size));
+
+  std::vector<uint64_t> large(100, 42);
+  cache.Insert(key,
+               reinterpret_cast<const char *>(large.data()),
+               large.size() * sizeof(uint64_t));
+  EXPECT_FALSE(cache.Query(key, &buffer, &size));
+
+  auto stat = cache.GetStat();
+  EXPECT_EQ(stat.hit_num, 3u);
+  EXPECT_EQ(stat.miss_num, 6u);
+  EXPECT_EQ(stat.insert_num, 2u);
+  EXPECT_EQ(stat.oversize_num, 1u);
+}
+
+TEST(GraphSampleCache, ClockEviction) {
+  // a single set
+  distributed::GraphSampleCache cache(distributed::GraphSampleCache::kWays,
+                                      1000);
+  std::shared_ptr<char> buffer;
+  int size = 0;
+  auto insert = [&cache](uint64_t node_id) {
+    auto sample = MakeSample(node_id, 2);
+    cache.Insert(distributed::SampleKey(0, node_id, 2, false),
+                 reinterpret_cast<const char *>(sample.data()),
+                 sample.size() * sizeof(uint64_t));
+  };
+  for (uint64_t id = 0; id < distributed::GraphSampleCache::kWays; ++id) {
+    insert(id);
+  }
+  // node 0 is referenced, so node 1 is the first victim
+  ASSERT_TRUE(
+      cache.Query(distributed::SampleKey(0, 0, 2, false), &buffer, &size));
+  insert(100);
+  EXPECT_TRUE(
+      cache.Query(distributed::SampleKey(0, 0, 2, false), &buffer, &size));
+  EXPECT_FALSE(
+      cache.Query(distributed::SampleKey(0, 1, 2, false), &buffer, &size));
+  EXPECT_TRUE(
+      cache.Query(distributed::SampleKey(0, 100, 2, false), &buffer, &size));
+  EXPECT_EQ(cache.GetStat().evict_num, 1u);
+}
+
+TEST(GraphSampleCache, Concurrent) {
+  const size_t sample_size = 10;
+  const uint64_t node_num = 200000;
+  const int thread_num = 8;
+  const int query_num = 500000;
+  distributed::GraphSampleCache cache(65536, 5);
+  std::atomic<int> torn_reads{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      std::mt19937_64 rng(t);
+      // skewed node ids, like the frontier of a power-law graph
+      std::uniform_real_distribution<double> dist(0, 1);
+      std::shared_ptr<char> buffer;
+      int size = 0;
+      for (int i = 0; i < query_num; ++i) {
+        uint64_t node_id =
+            static_cast<uint64_t>(node_num * std::pow(dist(rng), 4));
+        distributed::SampleKey key(0, node_id, sample_size, false);
+        if (cache.Query(key, &buffer, &size)) {
+          if (size != static_cast<int>(sample_size * sizeof(uint64_t)) ||
+              !CheckSample(buffer.get(), size, node_id)) {
+            ++torn_reads;
+          }
+        } else {
+          auto sample = MakeSample(node_id, sample_size);
+          cache.Insert(key,
+                       reinterpret_cast<const char *>(sample.data()),
+                       sample.size() * sizeof(uint64_t));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> cost =
+      std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(torn_reads.load(), 0);
+  auto stat = cache.GetStat();
+  EXPECT_EQ(stat.hit_num + stat.miss_num,
+            static_cast<uint64_t>(thread_num) * query_num);
+  EXPECT_GT(stat.HitRate(), 0.3);
+  LOG(INFO) << thread_num << " threads: "
+            << thread_num * query_num / cost.count()
+            << " queries/sec, hit rate " << stat.HitRate()
+            << ", query latency " << stat.query_ns << " ns, evict "
+            << stat.evict_num;
+}
@@ -0,0 +1,352 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/ps/service/ps_local_client.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+void PrepareFile(const std::string& file_name,
+                 const std::vector<std::string>& lines) {
+  std::ofstream ofile(file_name);
+  for (auto& line : lines) {
+    ofile << line << std::endl;
+  }
+}
+
+PSParameter GetGraphPsProto(const std::vector<std::string>& edge_types,
+                            const std::vector<std::string>& node_types) {
+  PSParameter ps_param;
+  auto* server_param =
+      ps_param.mutable_server_param()->mutable_downpour_server_param();
+  server_param->mutable_service_param()->set_client_class("PsLocalClient");
+  server_param->mutable_service_param()->set_server_class("PsLocalServer");
+  auto* table_proto = server_param->add_downpour_table_param();
+  table_proto->set_table_id(0);
+  table_proto->set_table_class("GraphTable");
+  table_proto->set_shard_num(24);
+  table_proto->set_type(PS_SPARSE_TABLE);
+  table_proto->mutable_accessor()->set_accessor_class("CommMergeAccessor");
+  auto* graph_proto = table_proto->mutable_graph_parameter();
+  graph_proto->set_task_pool_size(8);
+  for (auto& edge_type : edge_types) {
+    graph_proto->add_edge_types(edge_type);
+  }
+  for (auto& node_type : node_types) {
+    graph_proto->add_node_types(node_type);
+    auto* feature = graph_proto->add_graph_feature();
+    feature->add_name("a");
+    feature->add_dtype("string");
+    feature->add_shape(1);
+  }
+  return ps_param;
+}
+
+std::unique_ptr<PSClient> CreateClient(const PSParameter& ps_param) {
+  PaddlePSEnvironment env;
+  std::map<uint64_t, std::vector<Region>> dense_regions;
+  std::unique_ptr<PSClient> client(PSClientFactory::Create(ps_param));
+  client->Configure(ps_param, dense_regions, env, 0);
+  return client;
+}
+
+}  // namespace
+
+TEST(GraphSubgraphSample, metapath_reindex_feature) {
+  // users 1-4, items 101-104
+  std::vector<std::string> edges_u2i = {
+      "1\t101", "1\t102", "1\t103", "2\t101", "3\t104", "4\t102"};
+  std::vector<std::string> edges_i2u = {"101\t1",
+                                        "101\t2",
+                                        "102\t1",
+                                        "102\t4",
+                                        "103\t1",
+                                        "104\t3",
+                                        "104\t4"};
+  std::vector<std::string> nodes = {"user\t1\ta u1",
+                                    "user\t2\ta u2",
+                                    "user\t3\ta u3",
+                                    "user\t4\ta u4",
+                                    "item\t101\ta i101",
+                                    "item\t102\ta i102",
+                                    "item\t103\ta i103",
+                                    "item\t104\ta i104"};
+  PrepareFile("subgraph_u2i.txt", edges_u2i);
+  PrepareFile("subgraph_i2u.txt", edges_i2u);
+  PrepareFile("subgraph_nodes.txt", nodes);
+
+  auto ps_param = GetGraphPsProto({"u2i", "i2u"}, {"user", "item"});
+  auto client = CreateClient(ps_param);
+  ASSERT_NE(client, nullptr);
+  client->Load(0, "subgraph_u2i.txt", "e>u2i").wait();
+  client->Load(0, "subgraph_i2u.txt", "e>i2u").wait();
+  client->Load(0, "subgraph_nodes.txt", "nuser").wait();
+  client->Load(0, "subgraph_nodes.txt", "nitem").wait();
+  unlink("subgraph_u2i.txt");
+  unlink("subgraph_i2u.txt");
+  unlink("subgraph_nodes.txt");
+
+  std::map<uint64_t, std::unordered_set<uint64_t>> adjacency[2];
+  for (int type = 0; type < 2; ++type) {
+    for (auto& edge : type == 0 ? edges_u2i : edges_i2u) {
+      uint64_t src = std::stoull(edge);
+      uint64_t dst = std::stoull(edge.substr(edge.find('\t') + 1));
+      adjacency[type][src].insert(dst);
+    }
+  }
+
+  GraphSubgraphParam param;
+  param.edge_idx = {0, 1};
+  param.fanouts = {2, 10};
+  param.feature_names = {"a"};
+  std::vector<uint64_t> seeds = {1, 3, 1, 99};
+  std::unique_ptr<char[]> buffer;
+  int64_t actual_size = 0;
+  auto* local_client = dynamic_cast<PsLocalClient*>(client.get());
+  ASSERT_NE(local_client, nullptr);
+  ASSERT_EQ(local_client
+                ->SampleSubgraph(
+                    0, param, seeds.data(), seeds.size(), &buffer, &actual_size)
+                .get(),
+            0);
+
+  GraphSubgraphView view;
+  ASSERT_EQ(view.parse(buffer.get(), actual_size), 0);
+  ASSERT_EQ(view.header.hop_num, 2);
+  // seeds are deduplicated, 99 is kept without neighbors
+  ASSERT_EQ(view.hop_node_offsets[1], 3);
+  EXPECT_EQ(view.node_ids[0], 1u);
+  EXPECT_EQ(view.node_ids[1], 3u);
+  EXPECT_EQ(view.node_ids[2], 99u);
+  std::unordered_set<uint64_t> unique_ids(
+      view.node_ids, view.node_ids + view.header.node_num);
+  EXPECT_EQ(unique_ids.size(), static_cast<size_t>(view.header.node_num));
+  EXPECT_EQ(view.hop_node_offsets[3], view.header.node_num);
+  EXPECT_EQ(view.hop_edge_offsets[2], view.header.edge_num);
+  // 2 items of user 1 and 1 item of user 3
+  EXPECT_EQ(view.hop_edge_offsets[1], 3);
+  for (int64_t h = 0; h < 2; ++h) {
+    std::map<int64_t, int> fanout;
+    for (int64_t e = view.hop_edge_offsets[h]; e < view.hop_edge_offsets[h + 1];
+         ++e) {
+      int64_t src = view.edge_src[e], dst = view.edge_dst[e];
+      // dst is in the frontier of hop h, src is reached by hop h at latest
+      EXPECT_GE(dst, view.hop_node_offsets[h]);
+      EXPECT_LT(dst, view.hop_node_offsets[h + 1]);
+      EXPECT_LT(src, view.hop_node_offsets[h + 2]);
+      EXPECT_TRUE(adjacency[h][view.node_ids[dst]].count(view.node_ids[src]));
+      ++fanout[dst];
+    }
+    for (auto& kv : fanout) {
+      EXPECT_EQ(kv.second,
+                std::min<int>(param.fanouts[h],
+                              adjacency[h][view.node_ids[kv.first]].size()));
+    }
+  }
+  ASSERT_EQ(view.header.feature_num, 1);
+  for (int64_t i = 0; i < view.header.node_num; ++i) {
+    uint64_t id = view.node_ids[i];
+    std::string expect =
+        id == 99 ? "" : (id > 100 ? "i" : "u") + std::to_string(id);
+    EXPECT_EQ(view.get_feature(0, i), expect);
+  }
+}
+
+TEST(GraphSubgraphSample, reject_invalid) {
+  PrepareFile("subgraph_invalid_edges.txt", {"1\t2", "1\t3", "2\t3"});
+  PrepareFile("subgraph_invalid_nodes.txt",
+              {"user\t1\ta u1", "user\t2\ta u2", "user\t3\ta u3"});
+  auto ps_param = GetGraphPsProto({"u2u"}, {"user"});
+  GraphTable graph_table;
+  graph_table.SetShard(0, 1);
+  graph_table.Initialize(
+      ps_param.server_param().downpour_server_param().downpour_table_param(0),
+      FsClientParameter());
+  graph_table.Load("subgraph_invalid_edges.txt", "e>u2u");
+  graph_table.Load("subgraph_invalid_nodes.txt", "nuser");
+  unlink("subgraph_invalid_edges.txt");
+  unlink("subgraph_invalid_nodes.txt");
+
+  GraphSubgraphParam param;
+  param.edge_idx = {0};
+  param.fanouts = {2};
+  param.feature_names = {"a"};
+  std::vector<uint64_t> seeds = {1};
+  std::unique_ptr<char[]> buffer;
+  int64_t actual_size = 0;
+  param.edge_idx = {-1};
+  EXPECT_ANY_THROW(graph_table.sample_subgraph(
+      param, seeds.data(), seeds.size(), buffer, actual_size));
+  param.edge_idx = {0};
+  ASSERT_EQ(graph_table.sample_subgraph(
+                param, seeds.data(), seeds.size(), buffer, actual_size),
+            0);
+
+  GraphSubgraphView view;
+  ASSERT_EQ(view.parse(buffer.get(), actual_size), 0);
+  ASSERT_EQ(view.header.node_num, 3);
+  ASSERT_EQ(view.header.feature_num, 1);
+  EXPECT_EQ(view.parse(buffer.get(), actual_size - 1), -1);
+
+  std::vector<char> copy(buffer.get(), buffer.get() + actual_size);
+  int64_t offsets_pos = reinterpret_cast<const char*>(view.feature_offsets) -
+                        buffer.get();
+  int64_t* offsets = reinterpret_cast<int64_t*>(copy.data() + offsets_pos);
+  ASSERT_EQ(view.parse(copy.data(), actual_size), 0);
+  // the last feature ends past the buffer
+  int64_t end = offsets[3];
+  offsets[3] = end + 1;
+  EXPECT_EQ(view.parse(copy.data(), actual_size), -1);
+  offsets[3] = end;
+  // the features of node 1 would start before those of node 0
+  int64_t second = offsets[1];
+  offsets[1] = offsets[2] + 1;
+  EXPECT_EQ(view.parse(copy.data(), actual_size), -1);
+  offsets[1] = second;
+  // negative counts
+  auto* header = reinterpret_cast<GraphSubgraphHeader*>(copy.data());
+  header->node_num = -1;
+  EXPECT_EQ(view.parse(copy.data(), actual_size), -1);
+  header->node_num = 3;
+  header->feature_num = -1;
+  EXPECT_EQ(view.parse(copy.data(), actual_size), -1);
+}
+
+TEST(GraphSubgraphSample, benchmark) {
+  // power-law graph, the degree of node i is about 2000 / (i + 1)^0.6
+  const int node_num = 100000;
+  std::mt19937_64 rng(2023);
+  std::uniform_int_distribution<uint64_t> id_dist(0, node_num - 1);
+  std::vector<std::string> edges;
+  for (int i = 0; i < node_num; ++i) {
+    int degree = std::max(2, static_cast<int>(2000 / pow(i + 1, 0.6)));
+    for (int j = 0; j < degree; ++j) {
+      edges.push_back(std::to_string(i) + "\t" + std::to_string(id_dist(rng)));
+    }
+  }
+  PrepareFile("subgraph_power_law.txt", edges);
+  auto ps_param = GetGraphPsProto({"u2u"}, {});
+  auto client = CreateClient(ps_param);
+  ASSERT_NE(client, nullptr);
+  client->Load(0, "subgraph_power_law.txt", "e>u2u").wait();
+  // the same graph for the client side pipeline
+  GraphTable graph_table;
+  graph_table.SetShard(0, 1);
+  graph_table.Initialize(
+      ps_param.server_param().downpour_server_param().downpour_table_param(0),
+      FsClientParameter());
+  graph_table.Load("subgraph_power_law.txt", "e>u2u");
+  unlink("subgraph_power_law.txt");
+  auto* local_client = dynamic_cast<PsLocalClient*>(client.get());
+  ASSERT_NE(local_client, nullptr);
+
+  const int batch_num = 50;
+  const int batch_size = 512;
+  std::vector<std::vector<uint64_t>> batches(batch_num);
+  for (auto& batch : batches) {
+    for (int i = 0; i < batch_size; ++i) {
+      batch.push_back(id_dist(rng));
+    }
+  }
+  GraphSubgraphParam param;
+  param.edge_idx = {0};
+  param.fanouts = {10, 5};
+
+  int64_t node_count = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& batch : batches) {
+    std::unique_ptr<char[]> buffer;
+    int64_t actual_size = 0;
+    local_client
+        ->SampleSubgraph(
+            0, param, batch.data(), batch.size(), &buffer, &actual_size)
+        .wait();
+    GraphSubgraphView view;
+    ASSERT_EQ(view.parse(buffer.get(), actual_size), 0);
+    node_count += view.header.node_num;
+  }
+  std::chrono::duration<double> server_cost =
+      std::chrono::steady_clock::now() - start;
+
+  // the client side pipeline: one call per hop, then dedup and reindex
+  int64_t baseline_node_count = 0;
+  start = std::chrono::steady_clock::now();
+  for (auto& batch : batches) {
+    std::vector<uint64_t> frontier = batch;
+    std::unordered_map<uint64_t, int64_t> node_index;
+    std::vector<uint64_t> node_ids;
+    std::vector<int64_t> edge_src, edge_dst;
+    for (uint64_t id : frontier) {
+      if (node_index.emplace(id, node_ids.size()).second) {
+        node_ids.push_back(id);
+      }
+    }
+    for (int fanout : param.fanouts) {
+      std::vector<std::shared_ptr<char>> buffers(frontier.size());
+      std::vector<int> actual_sizes(frontier.size(), 0);
+      graph_table.random_sample_neighbors(
+          0, frontier.data(), fanout, buffers, actual_sizes, false);
+      std::vector<uint64_t> next_frontier;
+      for (size_t i = 0; i < frontier.size(); ++i) {
+        const uint64_t* neighbors =
+            reinterpret_cast<const uint64_t*>(buffers[i].get());
+        for (size_t j = 0; j < actual_sizes[i] / sizeof(uint64_t); ++j) {
+          auto iter = node_index.emplace(neighbors[j], node_ids.size());
+          if (iter.second) {
+            node_ids.push_back(neighbors[j]);
+            next_frontier.push_back(neighbors[j]);
+          }
+          edge_src.push_back(iter.first->second);
+          edge_dst.push_back(node_index[frontier[i]]);
+        }
+      }
+      frontier.swap(next_frontier);
+    }
+    baseline_node_count += node_ids.size();
+  }
+  std::chrono::duration<double> client_cost =
+      std::chrono::steady_clock::now() - start;
+
+  LOG(INFO) << "2-hop subgraphs of " << batch_size << " seeds, "
+            << node_count / batch_num << " nodes on average";
+  LOG(INFO) << "subgraphs/sec: per-hop sampling "
+            << batch_num / client_cost.count() << ", server side k-hop "
+            << batch_num / server_cost.count();
+  EXPECT_GT(node_count, batch_num * batch_size / 2);
+  EXPECT_GT(baseline_node_count, 0);
+}
+
+}  // namespace distributed
+}  // namespace paddle
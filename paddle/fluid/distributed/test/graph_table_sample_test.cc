@@ -14,15 +14,19 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <condition_variable>  // NOLINT
 #include <fstream>
 #include <iomanip>
+#include <random>
 #include <string>
 #include <thread>  // NOLINT
 #include <unordered_set>
 #include <vector>
 
+#include "glog/logging.h"
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/ps/table/common_graph_table.h"
@@ -86,3 +90,192 @@ void testGraphSample() {
 }
 
 TEST(testGraphSample, Run) { testGraphSample(); }
+
+namespace {
+
+// edges of a power-law graph: the degree of node i is about
+// max_degree / (i + 1)^0.8, so a few hubs own a large share of the edges
+void prepare_power_law_file(const std::string &file_name,
+                            int node_num,
+                            int max_degree,
+                            uint64_t *edge_num) {
+  std::mt19937_64 rng(2023);
+  std::uniform_int_distribution<uint64_t> dst_dist(0, node_num - 1);
+  std::uniform_real_distribution<float> weight_dist(0.01, 10.0);
+  std::ofstream ofile(file_name);
+  *edge_num = 0;
+  for (int i = 0; i < node_num; ++i) {
+    int degree = std::max(1, static_cast<int>(max_degree / pow(i + 1, 0.8)));
+    for (int j = 0; j < degree; ++j) {
+      ofile << i << "\t" << dst_dist(rng) << "\t" << weight_dist(rng) << "\n";
+    }
+    *edge_num += degree;
+  }
+  ofile.close();
+}
+
+double sample_per_node(distributed::GraphTable *graph_table,
+                       const std::vector<uint64_t> &ids,
+                       int batch_size,
+                       int sample_size) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ids.size(); i += batch_size) {
+    int n = std::min(ids.size() - i, static_cast<size_t>(batch_size));
+    std::vector<std::shared_ptr<char>> buffers(n);
+    std::vector<int> actual_sizes(n, 0);
+    graph_table->random_sample_neighbors(
+        0,
+        const_cast<uint64_t *>(ids.data() + i),
+        sample_size,
+        buffers,
+        actual_sizes,
+        true);
+  }
+  std::chrono::duration<double> cost =
+      std::chrono::steady_clock::now() - start;
+  return cost.count();
+}
+
+}  // namespace
+
+TEST(testGraphSample, BatchSampleBenchmark) {
+  const int node_num = 100000;
+  const int sample_size = 10;
+  const int batch_size = 1024;
+  std::string file_name = "power_law_edges.txt";
+  uint64_t edge_num = 0;
+  prepare_power_law_file(file_name, node_num, 20000, &edge_num);
+
+  ::paddle::distributed::GraphParameter table_proto;
+  table_proto.add_edge_types("u2u");
+  table_proto.set_shard_num(24);
+  table_proto.set_task_pool_size(8);
+  distributed::GraphTable graph_table;
+  graph_table.Initialize(table_proto);
+  graph_table.load_edges(file_name, false, "u2u");
+  unlink(file_name.c_str());
+
+  // hubs are queried as often as the rest
+  std::mt19937_64 rng(1);
+  std::uniform_int_distribution<uint64_t> id_dist(0, node_num - 1);
+  std::vector<uint64_t> ids(200000);
+  for (auto &id : ids) {
+    id = id_dist(rng);
+  }
+  ids.push_back(node_num + 1);  // not in the graph
+
+  std::vector<uint64_t> neighbor_ids, offsets;
+  std::vector<float> weights;
+  graph_table.random_sample_neighbors_batch(0,
+                                            ids.data(),
+                                            ids.size(),
+                                            sample_size,
+                                            true,
+                                            &neighbor_ids,
+                                            &weights,
+                                            &offsets);
+  ASSERT_EQ(offsets.size(), ids.size() + 1);
+  ASSERT_EQ(neighbor_ids.size(), offsets.back());
+  ASSERT_EQ(weights.size(), offsets.back());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    auto *node = graph_table.find_node(
+        distributed::GraphTableType::EDGE_TABLE, 0, ids[i]);
+    size_t size = offsets[i + 1] - offsets[i];
+    if (node == nullptr) {
+      EXPECT_EQ(size, 0u);
+      continue;
+    }
+    EXPECT_EQ(size, std::min<size_t>(sample_size, node->get_neighbor_size()));
+    std::unordered_set<uint64_t> neighbors;
+    for (size_t j = 0; j < node->get_neighbor_size(); ++j) {
+      neighbors.insert(node->get_neighbor_id(j));
+    }
+    for (uint64_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+      EXPECT_TRUE(neighbors.count(neighbor_ids[j]));
+      EXPECT_GT(weights[j], 0);
+    }
+  }
+
+  // load_edges builds alias samplers for weighted edges
+  double alias_cost =
+      sample_per_node(&graph_table, ids, batch_size, sample_size);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ids.size(); i += batch_size) {
+    size_t n = std::min(ids.size() - i, static_cast<size_t>(batch_size));
+    graph_table.random_sample_neighbors_batch(0,
+                                              ids.data() + i,
+                                              n,
+                                              sample_size,
+                                              true,
+                                              &neighbor_ids,
+                                              &weights,
+                                              &offsets);
+  }
+  std::chrono::duration<double> batch_cost =
+      std::chrono::steady_clock::now() - start;
+  graph_table.build_sampler(0, "weighted");
+  double tree_cost =
+      sample_per_node(&graph_table, ids, batch_size, sample_size);
+
+  LOG(INFO) << node_num << " nodes, " << edge_num << " edges";
+  LOG(INFO) << "nodes/sec: weighted tree " << ids.size() / tree_cost
+            << ", alias " << ids.size() / alias_cost << ", alias batched "
+            << ids.size() / batch_cost.count();
+}
+
+// edges added after the sampler was built must be sampled from, without
+// reading the weights or the alias table of the old edges
+TEST(testGraphSample, AliasSamplerAddEdge) {
+  distributed::GraphNode node(1);
+  node.build_edges(true);
+  for (int i = 0; i < 4; ++i) {
+    node.add_edge(100 + i, 1.0);
+  }
+  node.build_sampler("alias");
+  auto rng = std::make_shared<std::mt19937_64>(2023);
+  for (int i = 4; i < 1000; ++i) {
+    node.add_edge(100 + i, i < 500 ? 0.0 : 1.0);
+    auto result = node.sample_k(3, rng);
+    ASSERT_EQ(result.size(), 3UL);
+    std::unordered_set<int> distinct(result.begin(), result.end());
+    ASSERT_EQ(distinct.size(), 3UL);
+    for (int idx : result) {
+      ASSERT_GE(idx, 0);
+      ASSERT_LE(idx, i);
+      // zero weight edges are never sampled
+      ASSERT_GT(node.get_neighbor_weight(idx), 0.0);
+    }
+  }
+
+  // a stale table falls back to sampling over the current weights
+  distributed::WeightedGraphEdgeBlob edges;
+  for (int i = 0; i < 4; ++i) {
+    edges.add_edge(i, 1.0);
+  }
+  distributed::AliasSampler sampler;
+  sampler.build(&edges);
+  for (int i = 4; i < 64; ++i) {
+    edges.add_edge(i, 1.0);
+  }
+  for (int idx : sampler.sample_k(32, rng)) {
+    ASSERT_LT(idx, 64);
+  }
+}
+
+// the sampler is rebuilt once by the first sample after edges are added
+TEST(testGraphSample, WeightedSamplerAddEdge) {
+  distributed::GraphNode node(1);
+  node.build_edges(true);
+  for (int i = 0; i < 4; ++i) {
+    node.add_edge(100 + i, 1.0);
+  }
+  node.build_sampler("weighted");
+  auto rng = std::make_shared<std::mt19937_64>(2023);
+  ASSERT_EQ(node.sample_k(8, rng).size(), 4UL);
+  for (int i = 4; i < 8; ++i) {
+    node.add_edge(100 + i, 1.0);
+  }
+  auto result = node.sample_k(8, rng);
+  std::unordered_set<int> distinct(result.begin(), result.end());
+  ASSERT_EQ(distinct.size(), 8UL);
+}
@@ -0,0 +1,238 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
+
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/ps/service/ps_local_client.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(SparsePullCache, admit_expire_invalidate) {
+  SparsePullCacheParameter param;
+  param.set_capacity(1024);
+  param.set_max_staleness_steps(2);
+  param.set_max_staleness_ms(100000);
+  param.set_admit_threshold(1);
+  const size_t dim = 4;
+  SparsePullCache cache(param, dim * sizeof(float));
+
+  std::vector<uint64_t> keys = {1, 2};
+  std::vector<float> values(keys.size() * dim, 0.0);
+  std::vector<float*> value_ptrs = {values.data(), values.data() + dim};
+  std::vector<uint64_t> miss_keys;
+  std::vector<float*> miss_values;
+
+  // step 1: everything misses, then filled from the "server"
+  uint64_t generation = cache.Lookup(
+      keys.data(), value_ptrs.data(), keys.size(), &miss_keys, &miss_values);
+  ASSERT_EQ(miss_keys.size(), 2UL);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = i;
+  cache.Update(
+      miss_keys.data(), miss_values.data(), miss_keys.size(), generation);
+
+  // step 2 and 3: served from the cache
+  for (int step = 0; step < 2; ++step) {
+    std::fill(values.begin(), values.end(), -1.0);
+    cache.Lookup(
+        keys.data(), value_ptrs.data(), keys.size(), &miss_keys, &miss_values);
+    ASSERT_EQ(miss_keys.size(), 0UL);
+    for (size_t i = 0; i < values.size(); ++i) {
+      ASSERT_FLOAT_EQ(values[i], i);
+    }
+  }
+
+  // step 4: older than max_staleness_steps
+  generation = cache.Lookup(
+      keys.data(), value_ptrs.data(), keys.size(), &miss_keys, &miss_values);
+  ASSERT_EQ(miss_keys.size(), 2UL);
+  cache.Update(
+      miss_keys.data(), miss_values.data(), miss_keys.size(), generation);
+
+  // a push of key 1 drops it
+  cache.Invalidate(keys.data(), 1);
+  cache.Lookup(
+      keys.data(), value_ptrs.data(), keys.size(), &miss_keys, &miss_values);
+  ASSERT_EQ(miss_keys.size(), 1UL);
+  ASSERT_EQ(miss_keys[0], 1UL);
+
+  auto stat = cache.GetStat();
+  ASSERT_EQ(stat.hit_num, 5UL);
+  ASSERT_EQ(stat.miss_num, 5UL);
+  ASSERT_EQ(stat.cached_num, 1UL);
+  ASSERT_EQ(stat.saved_bytes,
+            5 * (sizeof(uint64_t) + sizeof(uint32_t) + dim * sizeof(float)));
+}
+
+TEST(SparsePullCache, capacity) {
+  SparsePullCacheParameter param;
+  param.set_capacity(64);
+  param.set_admit_threshold(1);
+  SparsePullCache cache(param, sizeof(float));
+  std::vector<uint64_t> keys(1000);
+  std::vector<float> values(keys.size());
+  std::vector<float*> value_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+    value_ptrs[i] = values.data() + i;
+  }
+  std::vector<uint64_t> miss_keys;
+  std::vector<float*> miss_values;
+  uint64_t generation = cache.Lookup(
+      keys.data(), value_ptrs.data(), keys.size(), &miss_keys, &miss_values);
+  cache.Update(
+      miss_keys.data(), miss_values.data(), miss_keys.size(), generation);
+  ASSERT_LE(cache.GetStat().cached_num, 64UL);
+}
+
+TEST(SparsePullCache, pull_in_flight_during_push) {
+  SparsePullCacheParameter param;
+  param.set_capacity(1024);
+  param.set_max_staleness_steps(100);
+  param.set_max_staleness_ms(100000);
+  param.set_admit_threshold(2);
+  SparsePullCache cache(param, sizeof(float));
+  std::vector<uint64_t> keys = {1, 2};
+  std::vector<float> values = {1.0, 2.0};
+  std::vector<float*> value_ptrs = {values.data(), values.data() + 1};
+  std::vector<uint64_t> miss_keys;
+  std::vector<float*> miss_values;
+  auto pull = [&]() {
+    return cache.Lookup(
+        keys.data(), value_ptrs.data(), keys.size(), &miss_keys, &miss_values);
+  };
+
+  // misses are counted by Update only, a pull without response admits none
+  pull();
+  uint64_t generation = pull();
+  cache.Update(
+      miss_keys.data(), miss_values.data(), miss_keys.size(), generation);
+  ASSERT_EQ(cache.GetStat().cached_num, 0UL);
+
+  // key 1 is pushed while the second pull is in flight, the pulled value of
+  // key 1 may miss the push and is not cached
+  generation = pull();
+  cache.Invalidate(keys.data(), 1);
+  cache.Update(
+      miss_keys.data(), miss_values.data(), miss_keys.size(), generation);
+  ASSERT_EQ(cache.GetStat().cached_num, 1UL);
+  pull();
+  ASSERT_EQ(miss_keys, std::vector<uint64_t>{1});
+
+  // a key never pulled before is pushed during its first pull
+  std::vector<uint64_t> new_keys = {3};
+  generation = cache.Lookup(
+      new_keys.data(), value_ptrs.data(), 1, &miss_keys, &miss_values);
+  cache.Invalidate(new_keys.data(), 1);
+  for (int i = 0; i < 2; ++i) {
+    cache.Update(new_keys.data(), value_ptrs.data(), 1, generation);
+  }
+  ASSERT_EQ(cache.GetStat().cached_num, 1UL);
+}
+
+void GetSparseTableProto(TableParameter* sparse_table_proto) {
+  sparse_table_proto->set_table_id(0);
+  sparse_table_proto->set_table_class("MemorySparseTable");
+  sparse_table_proto->set_shard_num(10);
+  sparse_table_proto->set_type(PS_SPARSE_TABLE);
+  auto* cache_param = sparse_table_proto->mutable_pull_cache_param();
+  cache_param->set_capacity(4096);
+  cache_param->set_max_staleness_steps(20);
+  cache_param->set_max_staleness_ms(60000);
+  cache_param->set_admit_threshold(2);
+
+  auto* accessor_config = sparse_table_proto->mutable_accessor();
+  accessor_config->set_accessor_class("SparseAccessor");
+  accessor_config->set_fea_dim(9);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(0);
+  for (auto* sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto* naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+}
+
+TEST(SparsePullCache, ps_local_client_zipf) {
+  PSParameter ps_param;
+  auto* server_param =
+      ps_param.mutable_server_param()->mutable_downpour_server_param();
+  server_param->mutable_service_param()->set_client_class("PsLocalClient");
+  server_param->mutable_service_param()->set_server_class("PsLocalServer");
+  GetSparseTableProto(server_param->add_downpour_table_param());
+
+  PaddlePSEnvironment env;
+  std::map<uint64_t, std::vector<Region>> dense_regions;
+  std::unique_ptr<PSClient> client(PSClientFactory::Create(ps_param));
+  ASSERT_NE(client, nullptr);
+  client->Configure(ps_param, dense_regions, env, 0);
+  auto* pull_cache = client->GetSparsePullCache(0);
+  ASSERT_NE(pull_cache, nullptr);
+  size_t select_dim = pull_cache->ValueSize() / sizeof(float);
+
+  // zipf-like key stream: key k is drawn with probability ~ 1 / (k + 1)
+  const size_t key_space = 100000;
+  const size_t batch_size = 2048;
+  const int batch_num = 50;
+  std::vector<double> weights(key_space);
+  for (size_t k = 0; k < key_space; ++k) weights[k] = 1.0 / (k + 1);
+  std::discrete_distribution<uint64_t> dist(weights.begin(), weights.end());
+  std::mt19937_64 rng(0);
+
+  std::vector<uint64_t> keys(batch_size);
+  std::vector<float> values(batch_size * select_dim);
+  std::vector<float*> value_ptrs(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    value_ptrs[i] = values.data() + i * select_dim;
+  }
+  // nothing is pushed, so a key always pulls its first value
+  std::unordered_map<uint64_t, std::vector<float>> first_values;
+  for (int batch = 0; batch < batch_num; ++batch) {
+    for (auto& key : keys) key = dist(rng);
+    client->PullSparse(value_ptrs.data(), 0, keys.data(), batch_size, true)
+        .wait();
+    for (size_t i = 0; i < batch_size; ++i) {
+      auto itr = first_values.find(keys[i]);
+      if (itr == first_values.end()) {
+        first_values[keys[i]].assign(value_ptrs[i], value_ptrs[i] + select_dim);
+        continue;
+      }
+      for (size_t j = 0; j < select_dim; ++j) {
+        ASSERT_FLOAT_EQ(value_ptrs[i][j], itr->second[j]);
+      }
+    }
+  }
+
+  auto stat = pull_cache->GetStat();
+  ASSERT_EQ(stat.hit_num + stat.miss_num, batch_size * batch_num);
+  ASSERT_GT(stat.HitRate(), 0.3);
+  VLOG(0) << "pull cache hit rate: " << stat.HitRate()
+          << " cached keys: " << stat.cached_num
+          << " rpc bytes saved: " << stat.saved_bytes;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -14,9 +14,21 @@
 
 #include "paddle/fluid/eager/backward.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <mutex>  // NOLINT
+#include <typeindex>
+
 #include "paddle/fluid/eager/general_grad.h"
+#include "paddle/phi/core/threadpool.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
 
+DECLARE_bool(eager_backward_replay);
+DECLARE_int32(eager_backward_num_threads);
+DECLARE_bool(eager_backward_deterministic);
+
 namespace egr {
 
 std::unordered_map<GradNodeBase*, int> getInDegreeMap(
@@ -99,8 +111,613 @@ void DuplicateCheck(const std::vector<paddle::Tensor>& inputs, bool is_input) {
   }
 }
 
+void RunFinalBackwardHooks() {
+  VLOG(7) << "Run Backward Final hook size: "
+          << egr::Controller::Instance().FinalBackwardHooks().size();
+  for (auto& hook : egr::Controller::Instance().FinalBackwardHooks()) {
+    (*hook)();
+  }
+  egr::Controller::Instance().ClearFinalBackwardHooks();
+}
+
 GeneralGrad* GeneralGrad::general_grad_ = new GeneralGrad();
 
+/* --- Backward Replay --- */
+// A model with a fixed structure builds the same backward graph every step,
+// only the grad nodes are new objects. BackwardTape keeps the order in which
+// RunBackward visited the nodes of such a graph and the edges between them,
+// so that the next step can run the nodes in that order directly: the
+// in-degree pass, the hash maps and the ready queue are skipped, and the
+// GradTensorHolders of the tape are reused across steps.
+//
+// Before anything runs, the new graph is matched against the tape: the type
+// and the meta shapes of every node and the slots of every edge must be the
+// same and the nodes must be distinct. A graph that does not match runs the
+// ordinary traversal, which records a new tape.
+class BackwardTape {
+ public:
+  struct Start {
+    // index of the grad node in the order, -1 if the tensor was skipped
+    int64_t node;
+    size_t slot;
+    size_t rank;
+  };
+
+  struct TapeEdge {
+    size_t out_slot;
+    size_t out_rank;
+    size_t next;
+    size_t in_slot;
+    size_t in_rank;
+  };
+
+  struct TapeNode {
+    explicit TapeNode(std::type_index t) : type(t) {}
+    std::type_index type;
+    std::vector<size_t> input_shape;
+    std::vector<size_t> output_shape;
+    size_t edge_begin = 0;
+    size_t edge_end = 0;
+    // number of edges of the tape into this node
+    size_t in_edge_num = 0;
+  };
+
+  // binds the grad nodes reachable from tensors to the tape, returns false if
+  // the graph differs from the recorded one
+  bool Match(const std::vector<paddle::Tensor>& tensors);
+
+  // runs a matched graph, returns false if a node did not produce a grad for
+  // a recorded edge, the tape should not be used again in that case. A node
+  // that then misses some of its edges is skipped, as the ordinary traversal
+  // never gets it ready either.
+  bool Run(const std::vector<paddle::Tensor>& tensors,
+           const std::vector<paddle::Tensor>& grad_tensors,
+           bool retain_graph);
+
+ private:
+  friend class BackwardTapeRecorder;
+
+  void ResetHolder(size_t index);
+
+  std::vector<Start> starts_;
+  std::vector<TapeNode> nodes_;
+  std::vector<TapeEdge> edges_;
+  std::vector<std::unique_ptr<GradTensorHolder>> holders_;
+  // edges of the current step that reached each node
+  std::vector<size_t> arrived_;
+  // grad nodes of the current step, valid between Match and Run
+  std::vector<GradNodeBase*> bound_;
+  std::vector<GradNodeBase*> sorted_;
+};
+
+namespace {
+
+GradNodeBase* StartGradNode(const paddle::Tensor& tensor) {
+  AutogradMeta* auto_grad_meta = EagerUtils::nullable_autograd_meta(tensor);
+  if (auto_grad_meta == nullptr || auto_grad_meta->StopGradient()) {
+    return nullptr;
+  }
+  return auto_grad_meta->GetMutableGradNode().get();
+}
+
+template <typename MetaType>
+void GetMetaShape(const MetaType& metas, std::vector<size_t>* shape) {
+  shape->resize(metas.size());
+  for (size_t i = 0; i < metas.size(); i++) {
+    (*shape)[i] = metas[i].size();
+  }
+}
+
+template <typename MetaType>
+bool SameMetaShape(const MetaType& metas, const std::vector<size_t>& shape) {
+  if (metas.size() != shape.size()) return false;
+  for (size_t i = 0; i < metas.size(); i++) {
+    if (metas[i].size() != shape[i]) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool BackwardTape::Match(const std::vector<paddle::Tensor>& tensors) {
+  if (tensors.size() != starts_.size()) return false;
+  bound_.assign(nodes_.size(), nullptr);
+  for (size_t i = 0; i < tensors.size(); i++) {
+    GradNodeBase* grad_node = StartGradNode(tensors[i]);
+    const Start& start = starts_[i];
+    if ((grad_node == nullptr) != (start.node < 0)) return false;
+    if (grad_node == nullptr) continue;
+    auto input_info =
+        EagerUtils::nullable_autograd_meta(tensors[i])->OutRankInfo();
+    if (input_info.first != start.slot || input_info.second != start.rank) {
+      return false;
+    }
+    GradNodeBase*& bound = bound_[start.node];
+    if (bound != nullptr && bound != grad_node) return false;
+    bound = grad_node;
+  }
+
+  // every node is reached by a start or an edge of a node before it
+  for (size_t k = 0; k < nodes_.size(); k++) {
+    GradNodeBase* node = bound_[k];
+    const TapeNode& tape_node = nodes_[k];
+    if (node == nullptr || std::type_index(typeid(*node)) != tape_node.type ||
+        !SameMetaShape(node->InputMeta(), tape_node.input_shape) ||
+        !SameMetaShape(node->OutputMeta(), tape_node.output_shape)) {
+      return false;
+    }
+    size_t e = tape_node.edge_begin;
+    const auto& metas = node->OutputMeta();
+    for (size_t i = 0; i < metas.size(); i++) {
+      for (size_t j = 0; j < metas[i].size(); j++) {
+        const Edge& edge = metas[i][j].GetEdge();
+        GradNodeBase* next_node = edge.GetGradNode();
+        if (next_node == nullptr) continue;
+        if (e == tape_node.edge_end) return false;
+        const TapeEdge& tape_edge = edges_[e++];
+        auto edge_rank = edge.GetEdgeRankInfo();
+        if (tape_edge.out_slot != i || tape_edge.out_rank != j ||
+            tape_edge.in_slot != edge_rank.first ||
+            tape_edge.in_rank != edge_rank.second) {
+          return false;
+        }
+        GradNodeBase*& bound = bound_[tape_edge.next];
+        if (bound != nullptr && bound != next_node) return false;
+        bound = next_node;
+      }
+    }
+    if (e != tape_node.edge_end) return false;
+  }
+
+  // two nodes of the tape bound to the same grad node
+  sorted_ = bound_;
+  std::sort(sorted_.begin(), sorted_.end());
+  return std::adjacent_find(sorted_.begin(), sorted_.end()) == sorted_.end();
+}
+
+void BackwardTape::ResetHolder(size_t index) {
+  auto& buffers = holders_[index]->Buffers();
+  const auto& shape = nodes_[index].input_shape;
+  buffers.resize(shape.size());
+  for (size_t i = 0; i < shape.size(); i++) {
+    buffers[i].resize(shape[i]);
+    for (auto& tensor : buffers[i]) {
+      tensor = paddle::Tensor();
+    }
+  }
+}
+
+bool BackwardTape::Run(const std::vector<paddle::Tensor>& tensors,
+                       const std::vector<paddle::Tensor>& grad_tensors,
+                       bool retain_graph) {
+  // holders are normally reset after their node runs, this also drops the
+  // grads left by a step that failed halfway
+  for (size_t k = 0; k < holders_.size(); k++) {
+    ResetHolder(k);
+  }
+  for (size_t i = 0; i < tensors.size(); i++) {
+    const Start& start = starts_[i];
+    if (start.node < 0) continue;
+    if (grad_tensors.size() > 0 && grad_tensors[i].initialized()) {
+      PADDLE_ENFORCE(
+          grad_tensors.size() == tensors.size(),
+          paddle::platform::errors::Fatal(
+              "Detected size mismatch between tensors and grad_tensors"
+              "grad_tensors should either have "
+              "size = 0 or same size as tensors."));
+      holders_[start.node]->CopyValueFromTensor(
+          start.slot, start.rank, grad_tensors[i]);
+    } else {
+      holders_[start.node]->CopyValueFromTensor(
+          start.slot, start.rank, tensors[i], /*fill_one=*/true);
+    }
+  }
+
+  bool diverged = false;
+  arrived_.assign(nodes_.size(), 0);
+  for (size_t k = 0; k < nodes_.size(); k++) {
+    GradNodeBase* node = bound_[k];
+    const TapeNode& tape_node = nodes_[k];
+    if (arrived_[k] != tape_node.in_edge_num) {
+      VLOG(3) << "Skip GradNode:" << node->name() << " addr:" << node
+              << ", " << arrived_[k] << " of " << tape_node.in_edge_num
+              << " grads arrived";
+      diverged = true;
+      ResetHolder(k);
+      continue;
+    }
+    VLOG(3) << "Replay GradNode:" << node->name() << " addr:" << node;
+    paddle::platform::RecordEvent node_record_event(
+        std::string((*node).name()),
+        paddle::platform::TracerEventType::Operator,
+        1);
+    EnforceGradNodeHasInput(node);
+
+    paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
+        grad_output_tensors = (*node)(holders_[k]->Buffers(), false, false);
+    if (!retain_graph) {
+      node->ClearTensorWrappers();
+    }
+    ResetHolder(k);
+
+    PADDLE_ENFORCE(
+        tape_node.output_shape.size() == grad_output_tensors.size() ||
+            tape_node.output_shape.empty(),
+        paddle::platform::errors::Fatal(
+            "Number of edges should be either empty ( for leaf node "
+            ") or the same as number of output grad tensors, but we "
+            "got edges size is: %d, grad_output size is: %d",
+            tape_node.output_shape.size(),
+            grad_output_tensors.size()));
+    for (size_t e = tape_node.edge_begin; e < tape_node.edge_end; e++) {
+      const TapeEdge& tape_edge = edges_[e];
+      auto& grad_outputs = grad_output_tensors[tape_edge.out_slot];
+      if (grad_outputs.empty()) {
+        diverged = true;
+        continue;
+      }
+      PADDLE_ENFORCE_LT(
+          tape_edge.out_rank,
+          grad_outputs.size(),
+          paddle::platform::errors::Fatal(
+              "Rank of grad_output_tensors should be less than "
+              "grad_output_tensors[i].size(), which is: %d. This error may "
+              "indicate autoprune or autograd api error. ",
+              grad_outputs.size()));
+      holders_[tape_edge.next]->add(tape_edge.in_slot,
+                                    tape_edge.in_rank,
+                                    grad_outputs[tape_edge.out_rank],
+                                    false);
+      arrived_[tape_edge.next]++;
+    }
+  }
+  bound_.clear();
+  return !diverged;
+}
+
+// Records the traversal of RunBackward. The graph is not recorded if a grad
+// was missing on an edge, since the order then depends on the values.
+class BackwardTapeRecorder {
+ public:
+  explicit BackwardTapeRecorder(size_t tensor_num)
+      : tape_(new BackwardTape()) {
+    tape_->starts_.resize(tensor_num, BackwardTape::Start{-1, 0, 0});
+    start_nodes_.resize(tensor_num, nullptr);
+  }
+
+  void AddStart(size_t i, GradNodeBase* node, size_t slot, size_t rank) {
+    tape_->starts_[i].slot = slot;
+    tape_->starts_[i].rank = rank;
+    start_nodes_[i] = node;
+  }
+
+  void AddNode(GradNodeBase* node) {
+    node_index_[node] = tape_->nodes_.size();
+    tape_->nodes_.emplace_back(std::type_index(typeid(*node)));
+    auto& tape_node = tape_->nodes_.back();
+    GetMetaShape(node->InputMeta(), &tape_node.input_shape);
+    GetMetaShape(node->OutputMeta(), &tape_node.output_shape);
+    tape_node.edge_begin = tape_node.edge_end = tape_->edges_.size();
+    tape_->holders_.emplace_back(new GradTensorHolder(node->InputMeta()));
+  }
+
+  void AddEdge(size_t out_slot, size_t out_rank, const Edge& edge) {
+    auto edge_rank = edge.GetEdgeRankInfo();
+    tape_->edges_.push_back(BackwardTape::TapeEdge{
+        out_slot, out_rank, 0, edge_rank.first, edge_rank.second});
+    edge_nodes_.push_back(edge.GetGradNode());
+    edge_owners_.push_back(tape_->nodes_.size() - 1);
+    tape_->nodes_.back().edge_end = tape_->edges_.size();
+  }
+
+  void Abort() { aborted_ = true; }
+
+  // nullptr if the traversal can not be replayed
+  std::unique_ptr<BackwardTape> Finish() {
+    if (aborted_ || tape_->nodes_.empty()) return nullptr;
+    for (size_t i = 0; i < start_nodes_.size(); i++) {
+      if (start_nodes_[i] == nullptr) continue;
+      auto iter = node_index_.find(start_nodes_[i]);
+      if (iter == node_index_.end()) return nullptr;
+      tape_->starts_[i].node = iter->second;
+    }
+    for (size_t e = 0; e < edge_nodes_.size(); e++) {
+      auto iter = node_index_.find(edge_nodes_[e]);
+      // the next node did not run or ran before its input was ready
+      if (iter == node_index_.end() || iter->second <= edge_owners_[e]) {
+        return nullptr;
+      }
+      tape_->edges_[e].next = iter->second;
+      tape_->nodes_[iter->second].in_edge_num++;
+    }
+    return std::move(tape_);
+  }
+
+ private:
+  std::unique_ptr<BackwardTape> tape_;
+  std::vector<GradNodeBase*> start_nodes_;
+  std::vector<GradNodeBase*> edge_nodes_;
+  std::vector<size_t> edge_owners_;
+  std::unordered_map<GradNodeBase*, size_t> node_index_;
+  bool aborted_ = false;
+};
+
+namespace {
+
+constexpr size_t kMaxBackwardTapes = 4;
+
+std::vector<std::unique_ptr<BackwardTape>>& BackwardTapes() {
+  thread_local std::vector<std::unique_ptr<BackwardTape>> tapes;
+  return tapes;
+}
+
+// returns true if the backward graph was replayed from a tape
+bool ReplayBackward(const std::vector<paddle::Tensor>& tensors,
+                    const std::vector<paddle::Tensor>& grad_tensors,
+                    bool retain_graph) {
+  auto& tapes = BackwardTapes();
+  for (size_t i = 0; i < tapes.size(); i++) {
+    if (!tapes[i]->Match(tensors)) continue;
+    VLOG(3) << "Replay backward graph from tape " << i;
+    if (!tapes[i]->Run(tensors, grad_tensors, retain_graph)) {
+      VLOG(3) << "Backward graph diverged from tape " << i << ", drop it";
+      tapes.erase(tapes.begin() + i);
+    }
+    return true;
+  }
+  return false;
+}
+
+void SaveBackwardTape(std::unique_ptr<BackwardTape> tape) {
+  if (tape == nullptr) return;
+  auto& tapes = BackwardTapes();
+  if (tapes.size() == kMaxBackwardTapes) {
+    tapes.erase(tapes.begin());
+  }
+  tapes.push_back(std::move(tape));
+}
+
+}  // namespace
+
+/* --- Parallel Backward --- */
+// Runs the grad nodes reachable from queue on a thread pool, a node is
+// scheduled as soon as all grads flowing into it have arrived, so independent
+// branches of the graph run at the same time. The in-degrees are atomics and
+// the input buffers are filled with GradTensorHolder::add_with_lock, or with
+// add_ordered if FLAGS_eager_backward_deterministic is set, in which case the
+// grads of a node are summed in the order of the edges producing them.
+//
+// Tensor hooks and the reduce hooks of data parallel are neither thread safe
+// nor order independent, a graph with any of them is left to the serial
+// traversal, see HasHooks.
+class ParallelBackward {
+ public:
+  ParallelBackward(
+      std::deque<GradNodeBase*>* queue,
+      std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+          node_input_buffers_dict,
+      bool retain_graph)
+      : retain_graph_(retain_graph),
+        deterministic_(FLAGS_eager_backward_deterministic) {
+    // number the nodes in BFS order, same as getInDegreeMap
+    std::deque<GradNodeBase*> bfs_queue = *queue;
+    while (!bfs_queue.empty()) {
+      GradNodeBase* node = bfs_queue.front();
+      bfs_queue.pop_front();
+      if (node_index_.count(node)) continue;
+      node_index_[node] = nodes_.size();
+      nodes_.push_back(node);
+      auto* accumulation_node = dynamic_cast<GradNodeAccumulation*>(node);
+      if (node->GradientHooksRegistered() ||
+          (accumulation_node != nullptr &&
+           accumulation_node->ReduceHooksRegistered())) {
+        has_hooks_ = true;
+      }
+      const auto& metas = node->OutputMeta();
+      for (const auto& meta_list : metas) {
+        for (const GradSlotMeta& meta : meta_list) {
+          GradNodeBase* next_node = meta.GetEdge().GetGradNode();
+          if (next_node) bfs_queue.push_back(next_node);
+        }
+      }
+    }
+    // queue and node_input_buffers_dict are kept for the serial traversal
+    if (has_hooks_) return;
+
+    in_degree_.reset(new std::atomic<int>[nodes_.size()]);
+    edge_base_.resize(nodes_.size());
+    holders_.resize(nodes_.size());
+    int64_t edge_num = 0;
+    for (size_t k = 0; k < nodes_.size(); k++) {
+      in_degree_[k].store(0, std::memory_order_relaxed);
+    }
+    for (size_t k = 0; k < nodes_.size(); k++) {
+      GradNodeBase* node = nodes_[k];
+      edge_base_[k] = edge_num;
+      for (const auto& meta_list : node->OutputMeta()) {
+        edge_num += meta_list.size();
+        for (const GradSlotMeta& meta : meta_list) {
+          GradNodeBase* next_node = meta.GetEdge().GetGradNode();
+          if (next_node) {
+            in_degree_[node_index_[next_node]].fetch_add(
+                1, std::memory_order_relaxed);
+          }
+        }
+      }
+      // holders are created here so that workers only look them up
+      auto iter = node_input_buffers_dict->find(node);
+      if (iter != node_input_buffers_dict->end()) {
+        holders_[k] = std::move(iter->second);
+      } else {
+        holders_[k].reset(new GradTensorHolder(node->InputMeta()));
+      }
+    }
+    node_input_buffers_dict->clear();
+
+    for (GradNodeBase* node : *queue) {
+      size_t index = node_index_[node];
+      if (in_degree_[index].load(std::memory_order_relaxed) == 0 &&
+          std::find(start_nodes_.begin(), start_nodes_.end(), index) ==
+              start_nodes_.end()) {
+        start_nodes_.push_back(index);
+      }
+    }
+    queue->clear();
+
+    // the tracer flags of the calling thread are thread local
+    auto tracer = egr::Controller::Instance().GetCurrentTracer();
+    has_grad_ = tracer->HasGrad();
+    amp_level_ = tracer->GetAmpLevel();
+    amp_dtype_ = tracer->GetAmpDtype();
+    use_layout_autotune_ = tracer->UseLayoutAutoTune();
+    enable_program_desc_tracing_ = tracer->IsProgramDescTracingEnabled();
+  }
+
+  // true if a node has tensor hooks or reduce hooks, the graph is not taken
+  // over and must run serially
+  bool HasHooks() const { return has_hooks_; }
+
+  void Run(int num_threads) {
+    pool_ = GetThreadPool(num_threads);
+    for (size_t index : start_nodes_) {
+      Schedule(index);
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this] { return pending_ == 0; });
+    pool_.reset();
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+ private:
+  static std::shared_ptr<phi::ThreadPool> GetThreadPool(int num_threads) {
+    static std::mutex pool_mutex;
+    static std::shared_ptr<phi::ThreadPool> pool;
+    static int pool_threads = 0;
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    // a backward running on the old pool keeps it alive
+    if (pool == nullptr || pool_threads != num_threads) {
+      pool = std::make_shared<phi::ThreadPool>(num_threads);
+      pool_threads = num_threads;
+    }
+    return pool;
+  }
+
+  void Schedule(size_t index) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (exception_) return;
+      ++pending_;
+    }
+    pool_->Run([this, index] {
+      try {
+        RunNode(index);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!exception_) exception_ = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pending_ == 0) finished_.notify_all();
+    });
+  }
+
+  void RunNode(size_t index) {
+    auto tracer = egr::Controller::Instance().GetCurrentTracer();
+    tracer->SetHasGrad(has_grad_);
+    tracer->SetAmpLevel(amp_level_);
+    tracer->SetAmpDtype(amp_dtype_);
+    if (use_layout_autotune_) {
+      tracer->EnableLayoutAutoTune();
+    } else {
+      tracer->DisableLayoutAutoTune();
+    }
+    tracer->SetEnableProgramDescTracing(enable_program_desc_tracing_);
+
+    GradNodeBase* node = nodes_[index];
+    VLOG(3) << "Run GradNode:" << node->name() << " addr:" << node
+            << " in parallel";
+    paddle::platform::RecordEvent node_record_event(
+        std::string((*node).name()),
+        paddle::platform::TracerEventType::Operator,
+        1);
+    EnforceGradNodeHasInput(node);
+
+    paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
+        grad_output_tensors = (*node)(holders_[index]->Buffers(), false, false);
+    if (!retain_graph_) {
+      node->ClearTensorWrappers();
+    }
+    holders_[index].reset();
+
+    const auto& metas = node->OutputMeta();
+    PADDLE_ENFORCE(metas.size() == grad_output_tensors.size() || metas.empty(),
+                   paddle::platform::errors::Fatal(
+                       "Number of edges should be either empty ( for leaf node "
+                       ") or the same as number of output grad tensors, but we "
+                       "got edges size is: %d, grad_output size is: %d",
+                       metas.size(),
+                       grad_output_tensors.size()));
+    int64_t order = edge_base_[index];
+    for (size_t i = 0; i < metas.size(); i++) {
+      for (size_t j = 0; j < metas[i].size(); j++, order++) {
+        const Edge& edge = metas[i][j].GetEdge();
+        GradNodeBase* next_node = edge.GetGradNode();
+        // the next node never gets ready, as in the serial traversal
+        if (next_node == nullptr || grad_output_tensors[i].empty()) {
+          continue;
+        }
+        PADDLE_ENFORCE_LT(
+            j,
+            grad_output_tensors[i].size(),
+            paddle::platform::errors::Fatal(
+                "Rank of grad_output_tensors should be less than "
+                "grad_output_tensors[i].size(), which is: %d. This error may "
+                "indicate autoprune or autograd api error. ",
+                grad_output_tensors.size()));
+        auto edge_rank = edge.GetEdgeRankInfo();
+        size_t next = node_index_.at(next_node);
+        if (deterministic_) {
+          holders_[next]->add_ordered(edge_rank.first,
+                                      edge_rank.second,
+                                      grad_output_tensors[i][j],
+                                      order);
+        } else {
+          holders_[next]->add_with_lock(
+              edge_rank.first, edge_rank.second, grad_output_tensors[i][j]);
+        }
+        if (in_degree_[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          if (deterministic_) holders_[next]->SumOrdered();
+          Schedule(next);
+        }
+      }
+    }
+  }
+
+  bool retain_graph_;
+  bool deterministic_;
+  bool has_grad_;
+  paddle::imperative::AmpLevel amp_level_;
+  std::string amp_dtype_;
+  bool use_layout_autotune_;
+  bool enable_program_desc_tracing_;
+  bool has_hooks_ = false;
+
+  std::vector<GradNodeBase*> nodes_;
+  std::unordered_map<GradNodeBase*, size_t> node_index_;
+  std::unique_ptr<std::atomic<int>[]> in_degree_;
+  // order of the first output edge of each node
+  std::vector<int64_t> edge_base_;
+  std::vector<std::unique_ptr<GradTensorHolder>> holders_;
+  std::vector<size_t> start_nodes_;
+
+  std::shared_ptr<phi::ThreadPool> pool_;
+  std::mutex mutex_;
+  std::condition_variable finished_;
+  int pending_ = 0;
+  std::exception_ptr exception_;
+};
+
 std::vector<paddle::Tensor> RunBackward(
     const std::vector<paddle::Tensor>& tensors,  // output
     const std::vector<paddle::Tensor>& grad_tensors,
@@ -119,6 +736,20 @@ std::vector<paddle::Tensor> RunBackward(
   bool is_general_grad = !inputs.empty();
   if (is_general_grad) GeneralGrad::Instance().Clear();
 
+  bool use_parallel = FLAGS_eager_backward_num_threads > 1 &&
+                      !is_general_grad && !create_graph;
+
+  // Backward replay
+  std::unique_ptr<BackwardTapeRecorder> recorder;
+  if (FLAGS_eager_backward_replay && !is_general_grad && !create_graph &&
+      !use_parallel) {
+    if (ReplayBackward(tensors, grad_tensors, retain_graph)) {
+      RunFinalBackwardHooks();
+      return {};
+    }
+    recorder.reset(new BackwardTapeRecorder(tensors.size()));
+  }
+
   /* --- Initialization --- */
   // 1. Init queue with starting nodes
   // 2. Prepare initial input buffers
@@ -165,6 +796,10 @@ std::vector<paddle::Tensor> RunBackward(
       GeneralGrad::Instance().GetPotentialStartupNodes()->insert(grad_node);
     }
 
+    if (recorder) {
+      recorder->AddStart(i, grad_node, input_info.first, input_info.second);
+    }
+
     // Prepare GradTensorHolder
     if (!node_input_buffers_dict.count(grad_node)) {
       VLOG(5) << "Create Value for grad input tensor " << i
@@ -209,6 +844,19 @@ std::vector<paddle::Tensor> RunBackward(
         inputs, no_grad_vars, orig_queue, &queue, node_input_buffers_dict);
   }
 
+  if (use_parallel) {
+    VLOG(5) << "Run backward on " << FLAGS_eager_backward_num_threads
+            << " threads";
+    // consumes queue and node_input_buffers_dict unless it has hooks
+    ParallelBackward parallel_backward(
+        &queue, &node_input_buffers_dict, retain_graph);
+    if (parallel_backward.HasHooks()) {
+      VLOG(5) << "Backward graph has hooks, run it serially";
+    } else {
+      parallel_backward.Run(FLAGS_eager_backward_num_threads);
+    }
+  }
+
   VLOG(5) << "Update In degree Map for backward";
   // 3. Compute in_degree for each node
   std::unordered_map<GradNodeBase*, int> node_in_degree_map =
@@ -251,6 +899,7 @@ std::vector<paddle::Tensor> RunBackward(
 
     // Check input
     EnforceGradNodeHasInput(node);
+    if (recorder) recorder->AddNode(node);
 
     VLOG(7) << "Run Backward Kernel with GradTensorHolder.";
     // Run Pre Backward Node and get outputs
@@ -300,8 +949,11 @@ std::vector<paddle::Tensor> RunBackward(
         // Next node could be nullptr if it is leaf tensor with no
         // AccumulationNode attached
         // Or it could also originated from dispensable inputs
-        if (!next_node_shared || !next_node_shared.get() ||
-            grad_output_tensors[i].empty()) {
+        if (!next_node_shared || !next_node_shared.get()) {
+          continue;
+        }
+        if (grad_output_tensors[i].empty()) {
+          if (recorder) recorder->Abort();
           continue;
         }
 
@@ -342,6 +994,7 @@ std::vector<paddle::Tensor> RunBackward(
                                                 edge_rank.second,
                                                 grad_output_tensor,
                                                 create_graph);
+        if (recorder) recorder->AddEdge(i, j, edge);
 
         // Update queue
         node_in_degree_map[next_node]--;
@@ -366,12 +1019,9 @@ std::vector<paddle::Tensor> RunBackward(
     }
   }
 
-  VLOG(7) << "Run Backward Final hook size: "
-          << egr::Controller::Instance().FinalBackwardHooks().size();
-  for (auto& hook : egr::Controller::Instance().FinalBackwardHooks()) {
-    (*hook)();
-  }
-  egr::Controller::Instance().ClearFinalBackwardHooks();
+  if (recorder) SaveBackwardTape(recorder->Finish());
+
+  RunFinalBackwardHooks();
   if (!is_general_grad) return {};
   VLOG(3) << "Finish Backward";
   return GeneralGrad::Instance().GetResults(inputs, allow_unused, create_graph);
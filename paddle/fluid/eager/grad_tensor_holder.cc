@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/eager/grad_tensor_holder.h"
 
+#include <algorithm>
+
 #include "paddle/fluid/eager/api/generated/eager_generated/forwards/dygraph_functions.h"
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/var_type.h"
@@ -193,4 +195,33 @@ void GradTensorHolder::add(size_t slot_id,
   }
 }
 
+void GradTensorHolder::add_with_lock(size_t slot_id,
+                                     size_t rank,
+                                     const paddle::Tensor& t,
+                                     bool create_graph) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  add(slot_id, rank, t, create_graph);
+}
+
+void GradTensorHolder::add_ordered(size_t slot_id,
+                                   size_t rank,
+                                   const paddle::Tensor& t,
+                                   int64_t order) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ordered_grads_.push_back(OrderedGrad{order, slot_id, rank, t});
+}
+
+void GradTensorHolder::SumOrdered(bool create_graph) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::sort(ordered_grads_.begin(),
+            ordered_grads_.end(),
+            [](const OrderedGrad& a, const OrderedGrad& b) {
+              return a.order < b.order;
+            });
+  for (auto& grad : ordered_grads_) {
+    add(grad.slot_id, grad.rank, grad.tensor, create_graph);
+  }
+  ordered_grads_.clear();
+}
+
 }  // namespace egr
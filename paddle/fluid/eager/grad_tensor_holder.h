@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <mutex>  // NOLINT
+
 #include "paddle/fluid/eager/grad_node_info.h"
 
 namespace egr {
@@ -37,19 +39,37 @@ class GradTensorHolder {
     }
   }
 
-  GradTensorHolder(const GradTensorHolder& other) = default;
+  GradTensorHolder(const GradTensorHolder& other) : buffer_(other.buffer_) {}
 
   explicit GradTensorHolder(paddle::small_vector<std::vector<paddle::Tensor>,
                                                  kSlotSmallVectorSize>&& inputs)
       : buffer_(std::move(inputs)) {}
 
-  GradTensorHolder& operator=(const GradTensorHolder& other) = default;
+  GradTensorHolder& operator=(const GradTensorHolder& other) {
+    buffer_ = other.buffer_;
+    return *this;
+  }
 
   // Create new tensor and copy tensor->impl
   void add(size_t slot_id,
            size_t rank,
            const paddle::Tensor& t,
            bool create_graph = false);
+  // Same as add, for grads produced by several threads
+  void add_with_lock(size_t slot_id,
+                     size_t rank,
+                     const paddle::Tensor& t,
+                     bool create_graph = false);
+
+  // Grads added by add_ordered are kept aside until SumOrdered, which adds
+  // them in the order of their keys, so the sum does not depend on the order
+  // in which the producing threads finish. Thread safe.
+  void add_ordered(size_t slot_id,
+                   size_t rank,
+                   const paddle::Tensor& t,
+                   int64_t order);
+  void SumOrdered(bool create_graph = false);
+
   void CopyValueFromTensor(size_t slot_id,
                            size_t rank,
                            const paddle::Tensor& t,
@@ -67,8 +87,17 @@ class GradTensorHolder {
   void SetBufferSlotRankZeros(size_t slot_id, size_t rank);
 
  private:
+  struct OrderedGrad {
+    int64_t order;
+    size_t slot_id;
+    size_t rank;
+    paddle::Tensor tensor;
+  };
+
   paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
       buffer_;
+  std::vector<OrderedGrad> ordered_grads_;
+  std::mutex mutex_;
 };
 
 }  // namespace egr
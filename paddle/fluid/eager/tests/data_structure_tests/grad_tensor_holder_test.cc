@@ -106,6 +106,40 @@ TEST(GradTensorHolder, Interfaces) {
   CHECK_EQ(holder_et1_ptr[0], 30.0f);
 }
 
+TEST(GradTensorHolder, OrderedAdd) {
+  phi::DenseTensorMeta meta =
+      phi::DenseTensorMeta(phi::DataType::FLOAT32, phi::make_ddim({1, 1}));
+  std::vector<paddle::Tensor> grads;
+  for (float value : {10.0f, 20.0f, 40.0f}) {
+    std::shared_ptr<phi::DenseTensor> dt = std::make_shared<phi::DenseTensor>(
+        std::make_unique<paddle::experimental::DefaultAllocator>(
+            paddle::platform::CPUPlace())
+            .get(),
+        meta);
+    dt->mutable_data<float>(paddle::platform::CPUPlace())[0] = value;
+    grads.emplace_back(dt);
+  }
+
+  std::vector<GradSlotMeta> slot_meta(1);
+  GradTensorHolder grad_tensor_holder = GradTensorHolder({slot_meta});
+  // grads are kept aside until SumOrdered
+  grad_tensor_holder.add_ordered(0, 0, grads[2], 2);
+  grad_tensor_holder.add_ordered(0, 0, grads[0], 0);
+  CHECK(!grad_tensor_holder[0][0].initialized());
+  grad_tensor_holder.add_ordered(0, 0, grads[1], 1);
+  grad_tensor_holder.SumOrdered();
+
+  auto holder_value = [&grad_tensor_holder]() {
+    return std::dynamic_pointer_cast<phi::DenseTensor>(
+               grad_tensor_holder[0][0].impl())
+        ->data<float>()[0];
+  };
+  CHECK_EQ(holder_value(), 70.0f);
+
+  grad_tensor_holder.add_with_lock(0, 0, grads[2]);
+  CHECK_EQ(holder_value(), 110.0f);
+}
+
 TEST(GradTensorHolder, SelectedRowsMergeAdd) {
   phi::CPUPlace cpu;
 
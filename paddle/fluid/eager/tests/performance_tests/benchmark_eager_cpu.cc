@@ -41,6 +41,10 @@ PD_DECLARE_KERNEL(add_grad, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sum, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sum_grad, CPU, ALL_LAYOUT);
 
+DECLARE_bool(eager_backward_replay);
+DECLARE_int32(eager_backward_num_threads);
+DECLARE_bool(eager_backward_deterministic);
+
 using namespace egr;            // NOLINT
 using namespace egr_utils_api;  // NOLINT
 
@@ -246,6 +250,155 @@ TEST(Benchmark, EagerIntermediateMLPCPU) {
   }
 }
 
+TEST(Benchmark, EagerBackwardReplayCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+
+  auto tracer = std::make_shared<paddle::imperative::Tracer>();
+  paddle::imperative::SetCurrentTracer(tracer);
+
+  // a small MLP, where the framework overhead dominates the step time
+  const size_t num_linear = 4;
+  const int num_steps = 500;
+  for (bool replay : {false, true}) {
+    FLAGS_eager_backward_replay = replay;
+    paddle::framework::DDim ddimX = phi::make_ddim({MLP_M, MLP_N});
+    paddle::Tensor X = CreateTensorWithValue(ddimX,
+                                             paddle::platform::CPUPlace(),
+                                             phi::DataType::FLOAT32,
+                                             phi::DataLayout::NCHW,
+                                             MLP_X_VAL,
+                                             true);
+    RetainGradForTensor(X);
+
+    std::vector<paddle::Tensor> Ws;
+    std::vector<paddle::Tensor> Bs;
+    for (size_t i = 0; i < num_linear; i++) {
+      paddle::framework::DDim ddimW = phi::make_ddim({MLP_N, MLP_K});
+      paddle::Tensor W = CreateTensorWithValue(ddimW,
+                                               paddle::platform::CPUPlace(),
+                                               phi::DataType::FLOAT32,
+                                               phi::DataLayout::NCHW,
+                                               MLP_W_VAL,
+                                               true);
+      RetainGradForTensor(W);
+
+      paddle::framework::DDim ddimB = phi::make_ddim({MLP_K});
+      paddle::Tensor B = CreateTensorWithValue(ddimB,
+                                               paddle::platform::CPUPlace(),
+                                               phi::DataType::FLOAT32,
+                                               phi::DataLayout::NCHW,
+                                               MLP_B_VAL,
+                                               true);
+      RetainGradForTensor(B);
+
+      Ws.emplace_back(std::move(W));
+      Bs.emplace_back(std::move(B));
+    }
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for (int step = 0; step < num_steps; step++) {
+      paddle::Tensor input0 = X;
+      for (size_t i = 0; i < num_linear; i++) {
+        paddle::Tensor Out = matmul_v2_dygraph_function(
+            input0, Ws[i], {{"trans_x", false}, {"trans_y", false}});
+        input0 = elementwise_add_dygraph_function(Out, Bs[i], {});
+      }
+      paddle::Tensor Out =
+          reduce_sum_dygraph_function(input0, {{"reduce_all", true}});
+      std::vector<paddle::Tensor> target_tensors = {Out};
+      Backward(target_tensors, {});
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    double elapsed_time_ms =
+        std::chrono::duration<double, std::milli>(t_end - t_start).count();
+    std::cout << "Backward replay " << (replay ? "on" : "off")
+              << ", step time: " << elapsed_time_ms / num_steps << " ms"
+              << std::endl;
+
+    // grads accumulate over the steps
+    float grad_x = num_steps * pow(MLP_W_VAL * MLP_N, num_linear);
+    float grad_w0 =
+        num_steps * pow(MLP_W_VAL * MLP_N, num_linear - 1) * MLP_X_VAL * MLP_M;
+    eager_test::CompareGradTensorWithValue<float>(X, grad_x);
+    eager_test::CompareGradTensorWithValue<float>(Ws[0], grad_w0);
+  }
+  FLAGS_eager_backward_replay = false;
+}
+
+TEST(Benchmark, EagerParallelBackwardCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+
+  auto tracer = std::make_shared<paddle::imperative::Tracer>();
+  paddle::imperative::SetCurrentTracer(tracer);
+
+  // towers of linear layers on a shared input, summed at the end, like a
+  // multi-tower recommendation model. W = 1 / N keeps the values exact.
+  const int num_towers = 8;
+  const size_t num_linear = 4;
+  const int64_t batch = 64;
+  const int64_t width = 256;
+  const float w_val = 1.0 / width;
+  const int num_steps = 20;
+  FLAGS_eager_backward_deterministic = true;
+  for (int num_threads : {0, 2, 4, 8}) {
+    FLAGS_eager_backward_num_threads = num_threads;
+    paddle::Tensor X =
+        CreateTensorWithValue(phi::make_ddim({batch, width}),
+                              paddle::platform::CPUPlace(),
+                              phi::DataType::FLOAT32,
+                              phi::DataLayout::NCHW,
+                              1.0,
+                              true);
+    RetainGradForTensor(X);
+    std::vector<std::vector<paddle::Tensor>> Ws(num_towers);
+    for (auto& tower : Ws) {
+      for (size_t i = 0; i < num_linear; i++) {
+        paddle::Tensor W =
+            CreateTensorWithValue(phi::make_ddim({width, width}),
+                                  paddle::platform::CPUPlace(),
+                                  phi::DataType::FLOAT32,
+                                  phi::DataLayout::NCHW,
+                                  w_val,
+                                  true);
+        RetainGradForTensor(W);
+        tower.emplace_back(std::move(W));
+      }
+    }
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for (int step = 0; step < num_steps; step++) {
+      paddle::Tensor sum;
+      for (auto& tower : Ws) {
+        paddle::Tensor input0 = X;
+        for (auto& W : tower) {
+          input0 = matmul_v2_dygraph_function(
+              input0, W, {{"trans_x", false}, {"trans_y", false}});
+        }
+        sum = sum.initialized()
+                  ? elementwise_add_dygraph_function(sum, input0, {})
+                  : input0;
+      }
+      paddle::Tensor Out =
+          reduce_sum_dygraph_function(sum, {{"reduce_all", true}});
+      std::vector<paddle::Tensor> target_tensors = {Out};
+      Backward(target_tensors, {});
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    double elapsed_time_ms =
+        std::chrono::duration<double, std::milli>(t_end - t_start).count();
+    std::cout << "Backward threads " << num_threads
+              << ", step time: " << elapsed_time_ms / num_steps << " ms"
+              << std::endl;
+
+    eager_test::CompareGradTensorWithValue<float>(X, num_steps * num_towers);
+    eager_test::CompareGradTensorWithValue<float>(Ws[0][0], num_steps * batch);
+  }
+  FLAGS_eager_backward_num_threads = 0;
+  FLAGS_eager_backward_deterministic = false;
+}
+
 USE_OP_ITSELF(scale);
 USE_OP_ITSELF(elementwise_add);
 USE_OP_ITSELF(matmul_v2);
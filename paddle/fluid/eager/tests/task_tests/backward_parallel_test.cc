@@ -0,0 +1,178 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/eager/accumulation/accumulation_node.h"
+#include "paddle/fluid/eager/api/all.h"
+#include "paddle/fluid/eager/api/generated/eager_generated/backwards/scale_node.h"
+#include "paddle/fluid/eager/api/utils/hook_utils.h"
+#include "paddle/fluid/eager/api/utils/tensor_utils.h"
+#include "paddle/fluid/eager/autograd_meta.h"
+#include "paddle/fluid/eager/backward.h"
+#include "paddle/fluid/eager/grad_node_info.h"
+#include "paddle/fluid/eager/tests/test_utils.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+
+DECLARE_int32(eager_backward_num_threads);
+DECLARE_bool(eager_backward_deterministic);
+
+namespace egr {
+
+namespace {
+
+const int kBranchNum = 8;
+
+std::shared_ptr<GradNodeScale> MakeScaleNode(float scale) {
+  auto node = std::make_shared<GradNodeScale>(1, 1);
+  node->SetAttributes_scale(scale);
+  node->SetDefaultGradInOutMeta();
+  return node;
+}
+
+void ConnectTensor(paddle::Tensor* tensor, std::shared_ptr<GradNodeBase> node) {
+  AutogradMeta* meta = EagerUtils::autograd_meta(tensor);
+  meta->SetGradNode(node);
+  meta->SetSingleOutRankWithSlot(0, 0);
+  meta->SetStopGradient(false);
+}
+
+/*
+  out0   out1   ...   out7
+   |      |            |
+ Scale(1) Scale(2) ... Scale(8)
+   |  even  |  odd
+ Scale(2)  Scale(2)
+   |          |
+ leaf0      leaf1
+*/
+// leaf0 gets 2 * (1 + 3 + 5 + 7) = 32 and leaf1 gets 2 * (2 + 4 + 6 + 8) = 40
+std::vector<paddle::Tensor> BuildGraph(paddle::Tensor* leaf0,
+                                       paddle::Tensor* leaf1) {
+  paddle::framework::DDim ddim = phi::make_ddim({4, 16});
+  std::vector<paddle::Tensor> outs;
+  std::shared_ptr<GradNodeScale> sum_nodes[2] = {MakeScaleNode(2.0),
+                                                 MakeScaleNode(2.0)};
+  paddle::Tensor* leaves[2] = {leaf0, leaf1};
+  for (int j = 0; j < 2; j++) {
+    *leaves[j] = paddle::Tensor();
+    AutogradMeta* meta = EagerUtils::autograd_meta(leaves[j]);
+    ConnectTensor(leaves[j], std::make_shared<GradNodeAccumulation>(meta));
+    sum_nodes[j]->SetGradOutMeta(*leaves[j], 0);
+  }
+  for (int i = 0; i < kBranchNum; i++) {
+    outs.push_back(
+        egr_utils_api::CreateTensorWithValue(ddim,
+                                             paddle::platform::CPUPlace(),
+                                             phi::DataType::FLOAT32,
+                                             phi::DataLayout::NCHW,
+                                             1.0 /*value*/,
+                                             false /*is_leaf*/));
+    auto node = MakeScaleNode(i + 1);
+    ConnectTensor(&outs.back(), node);
+    paddle::Tensor tmp_tensor;
+    ConnectTensor(&tmp_tensor, sum_nodes[i % 2]);
+    node->SetGradOutMeta(tmp_tensor, 0);
+  }
+  return outs;
+}
+
+class BackwardFlagsGuard {
+ public:
+  BackwardFlagsGuard(int num_threads, bool deterministic)
+      : num_threads_(FLAGS_eager_backward_num_threads),
+        deterministic_(FLAGS_eager_backward_deterministic) {
+    FLAGS_eager_backward_num_threads = num_threads;
+    FLAGS_eager_backward_deterministic = deterministic;
+  }
+  ~BackwardFlagsGuard() {
+    FLAGS_eager_backward_num_threads = num_threads_;
+    FLAGS_eager_backward_deterministic = deterministic_;
+  }
+
+ private:
+  int num_threads_;
+  bool deterministic_;
+};
+
+}  // namespace
+
+TEST(ParallelBackward, SameAsSerial) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  // 0 runs the serial traversal
+  for (int num_threads : {0, 2, 4}) {
+    for (bool deterministic : {false, true}) {
+      BackwardFlagsGuard guard(num_threads, deterministic);
+      for (int step = 0; step < 3; step++) {
+        paddle::Tensor leaf0, leaf1;
+        Backward(BuildGraph(&leaf0, &leaf1), {});
+        eager_test::CompareGradTensorWithValue<float>(leaf0, 32.0);
+        eager_test::CompareGradTensorWithValue<float>(leaf1, 40.0);
+      }
+    }
+  }
+}
+
+TEST(ParallelBackward, HooksRunSerially) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  BackwardFlagsGuard guard(4, false);
+  std::mutex mutex;
+  std::vector<std::thread::id> hook_threads;
+  auto record_thread = [&mutex, &hook_threads] {
+    std::lock_guard<std::mutex> lock(mutex);
+    hook_threads.push_back(std::this_thread::get_id());
+  };
+
+  // tensor hooks
+  paddle::Tensor leaf0, leaf1;
+  auto outs = BuildGraph(&leaf0, &leaf1);
+  for (auto& out : outs) {
+    egr_utils_api::RegisterGradientHookForTensor(
+        out, [&record_thread](const paddle::Tensor& grad) {
+          record_thread();
+          return grad;
+        });
+  }
+  Backward(outs, {});
+  outs.clear();
+  eager_test::CompareGradTensorWithValue<float>(leaf0, 32.0);
+  eager_test::CompareGradTensorWithValue<float>(leaf1, 40.0);
+  EXPECT_EQ(hook_threads.size(), static_cast<size_t>(kBranchNum));
+
+  // reduce hooks, as registered by the data parallel reducer
+  outs = BuildGraph(&leaf0, &leaf1);
+  egr_utils_api::RegisterReduceHookForTensor(leaf0, record_thread);
+  egr_utils_api::RegisterReduceHookForTensor(leaf1, record_thread);
+  Backward(outs, {});
+  outs.clear();
+  eager_test::CompareGradTensorWithValue<float>(leaf0, 32.0);
+  eager_test::CompareGradTensorWithValue<float>(leaf1, 40.0);
+  EXPECT_EQ(hook_threads.size(), static_cast<size_t>(kBranchNum + 2));
+
+  for (auto& id : hook_threads) {
+    EXPECT_EQ(id, std::this_thread::get_id());
+  }
+}
+
+}  // namespace egr
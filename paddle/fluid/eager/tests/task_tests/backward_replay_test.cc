@@ -0,0 +1,185 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/eager/accumulation/accumulation_node.h"
+#include "paddle/fluid/eager/api/all.h"
+#include "paddle/fluid/eager/api/generated/eager_generated/backwards/scale_node.h"
+#include "paddle/fluid/eager/api/utils/tensor_utils.h"
+#include "paddle/fluid/eager/autograd_meta.h"
+#include "paddle/fluid/eager/backward.h"
+#include "paddle/fluid/eager/grad_node_info.h"
+#include "paddle/fluid/eager/tests/test_utils.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
+
+DECLARE_bool(eager_backward_replay);
+
+namespace egr {
+
+namespace {
+
+// Passes its grad through, or produces no grad at all if drop is set.
+class GradNodeMaybeDrop : public GradNodeBase {
+ public:
+  explicit GradNodeMaybeDrop(bool drop) : GradNodeBase(1, 1), drop_(drop) {}
+  ~GradNodeMaybeDrop() override = default;
+
+  paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
+  operator()(paddle::small_vector<std::vector<paddle::Tensor>,
+                                  kSlotSmallVectorSize>& grads,  // NOLINT
+             bool create_graph = false,
+             bool is_new_grad = false) override {
+    paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
+        outs(1);
+    if (!drop_) outs[0].push_back(grads[0][0]);
+    return outs;
+  }
+  void ClearTensorWrappers() override {}
+  std::string name() override { return "GradNodeMaybeDrop"; }
+  std::shared_ptr<GradNodeBase> Copy() const override {
+    return std::make_shared<GradNodeMaybeDrop>(*this);
+  }
+
+ private:
+  bool drop_;
+};
+
+std::shared_ptr<GradNodeScale> MakeScaleNode(float scale) {
+  auto node = std::make_shared<GradNodeScale>(1, 1);
+  node->SetAttributes_scale(scale);
+  node->SetDefaultGradInOutMeta();
+  return node;
+}
+
+// the grad of tensor flows into node
+void ConnectTensor(paddle::Tensor* tensor, std::shared_ptr<GradNodeBase> node) {
+  AutogradMeta* meta = EagerUtils::autograd_meta(tensor);
+  meta->SetGradNode(node);
+  meta->SetSingleOutRankWithSlot(0, 0);
+  meta->SetStopGradient(false);
+}
+
+void ConnectNodes(GradNodeBase* from, std::shared_ptr<GradNodeBase> to) {
+  paddle::Tensor tmp_tensor;
+  ConnectTensor(&tmp_tensor, to);
+  from->SetGradOutMeta(tmp_tensor, 0);
+}
+
+void ConnectLeaf(GradNodeBase* from, paddle::Tensor* leaf) {
+  AutogradMeta* meta = EagerUtils::autograd_meta(leaf);
+  ConnectTensor(leaf, std::make_shared<GradNodeAccumulation>(meta));
+  from->SetGradOutMeta(*leaf, 0);
+}
+
+/*
+  out0      out1       out2
+   |         |          |
+ Scale(2)  Scale(5)   Scale(7)
+   |         |          |
+ MaybeDrop   |        leaf1
+     \      /
+     Scale(3)
+        |
+      leaf0
+*/
+// builds the graph of a new step, leaf0 gets 21 and leaf1 gets 7 unless
+// drop is set, in which case leaf0 gets no grad
+std::vector<paddle::Tensor> BuildStep(bool drop,
+                                      paddle::Tensor* leaf0,
+                                      paddle::Tensor* leaf1) {
+  paddle::framework::DDim ddim = phi::make_ddim({4, 16});
+  std::vector<paddle::Tensor> outs;
+  for (int i = 0; i < 3; i++) {
+    outs.push_back(
+        egr_utils_api::CreateTensorWithValue(ddim,
+                                             paddle::platform::CPUPlace(),
+                                             phi::DataType::FLOAT32,
+                                             phi::DataLayout::NCHW,
+                                             1.0 /*value*/,
+                                             false /*is_leaf*/));
+  }
+  *leaf0 = paddle::Tensor();
+  *leaf1 = paddle::Tensor();
+
+  auto node0 = MakeScaleNode(2.0);
+  auto node1 = MakeScaleNode(5.0);
+  auto node2 = MakeScaleNode(7.0);
+  auto drop_node = std::make_shared<GradNodeMaybeDrop>(drop);
+  drop_node->SetDefaultGradInOutMeta();
+  auto sum_node = MakeScaleNode(3.0);
+  ConnectTensor(&outs[0], node0);
+  ConnectTensor(&outs[1], node1);
+  ConnectTensor(&outs[2], node2);
+  ConnectNodes(node0.get(), drop_node);
+  ConnectNodes(drop_node.get(), sum_node);
+  ConnectNodes(node1.get(), sum_node);
+  ConnectLeaf(sum_node.get(), leaf0);
+  ConnectLeaf(node2.get(), leaf1);
+  return outs;
+}
+
+bool HasGrad(const paddle::Tensor& leaf) {
+  return EagerUtils::unsafe_autograd_meta(leaf)->Grad().initialized();
+}
+
+}  // namespace
+
+TEST(BackwardReplay, SameAsSerial) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  bool replay = FLAGS_eager_backward_replay;
+  FLAGS_eager_backward_replay = true;
+  // the first step records the tape, the others replay it
+  for (int step = 0; step < 4; step++) {
+    paddle::Tensor leaf0, leaf1;
+    Backward(BuildStep(false, &leaf0, &leaf1), {});
+    eager_test::CompareGradTensorWithValue<float>(leaf0, 21.0);
+    eager_test::CompareGradTensorWithValue<float>(leaf1, 7.0);
+  }
+  FLAGS_eager_backward_replay = replay;
+}
+
+TEST(BackwardReplay, DivergedGraph) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  bool replay = FLAGS_eager_backward_replay;
+
+  // the serial traversal never runs the nodes that miss a grad
+  FLAGS_eager_backward_replay = false;
+  paddle::Tensor leaf0, leaf1;
+  Backward(BuildStep(true, &leaf0, &leaf1), {});
+  EXPECT_FALSE(HasGrad(leaf0));
+  eager_test::CompareGradTensorWithValue<float>(leaf1, 7.0);
+
+  FLAGS_eager_backward_replay = true;
+  for (bool drop : {false, false, true, false, false}) {
+    Backward(BuildStep(drop, &leaf0, &leaf1), {});
+    if (drop) {
+      EXPECT_FALSE(HasGrad(leaf0));
+    } else {
+      eager_test::CompareGradTensorWithValue<float>(leaf0, 21.0);
+    }
+    eager_test::CompareGradTensorWithValue<float>(leaf1, 7.0);
+  }
+  FLAGS_eager_backward_replay = replay;
+}
+
+}  // namespace egr
@@ -0,0 +1,356 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/aligned_tensor_container.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/core/allocator.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr char kContainerMagic[8] = {'P', 'D', 'T', 'C', 'N', 'T', 'R', '1'};
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignedTensorContainerAlignment - 1) /
+         kAlignedTensorContainerAlignment * kAlignedTensorContainerAlignment;
+}
+
+template <typename T>
+void AppendPod(std::string* out, T value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Build the index with the data offsets of the tensors. The size of the
+// index does not depend on the offsets.
+std::string BuildIndex(const std::vector<std::string>& names,
+                       const std::vector<const phi::DenseTensor*>& tensors,
+                       const std::vector<uint64_t>& offsets) {
+  std::string index;
+  AppendPod<uint32_t>(&index, tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto& tensor = *tensors[i];
+    AppendPod<uint32_t>(&index, names[i].size());
+    index.append(names[i]);
+    AppendPod<int32_t>(&index, TransToProtoVarType(tensor.dtype()));
+    auto dims = phi::vectorize(tensor.dims());
+    AppendPod<uint32_t>(&index, dims.size());
+    for (auto dim : dims) {
+      AppendPod<int64_t>(&index, dim);
+    }
+    AppendPod<uint32_t>(&index, tensor.lod().size());
+    for (auto& level : tensor.lod()) {
+      AppendPod<uint64_t>(&index, level.size());
+      for (auto offset : level) {
+        AppendPod<uint64_t>(&index, offset);
+      }
+    }
+    AppendPod<uint64_t>(&index, offsets[i]);
+    AppendPod<uint64_t>(&index, tensor.numel() * phi::SizeOf(tensor.dtype()));
+  }
+  return index;
+}
+
+class IndexReader {
+ public:
+  IndexReader(const char* begin, const char* end, const std::string& path)
+      : pos_(begin), end_(end), path_(path) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    Check(sizeof(T));
+    std::memcpy(&value, pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  // reads the number of the items that follow, each item takes at least
+  // item_bytes, so that a damaged count fails before anything is allocated
+  template <typename T>
+  size_t ReadCount(size_t item_bytes) {
+    T count = Read<T>();
+    Check(count, item_bytes);
+    return count;
+  }
+
+  std::string ReadString(size_t size) {
+    Check(size);
+    std::string value(pos_, size);
+    pos_ += size;
+    return value;
+  }
+
+ private:
+  // count items of item_bytes each fit in the rest of the index
+  void Check(uint64_t count, size_t item_bytes = 1) {
+    PADDLE_ENFORCE_LE(
+        count,
+        static_cast<uint64_t>(end_ - pos_) / item_bytes,
+        platform::errors::InvalidArgument(
+            "The index of the tensor container %s is truncated, please check "
+            "whether the file is complete or damaged.",
+            path_));
+  }
+
+  const char* pos_;
+  const char* end_;
+  const std::string& path_;
+};
+
+// Holds a tensor of the container and keeps the container alive.
+class ContainerAllocation : public phi::Allocation {
+ public:
+  ContainerAllocation(void* ptr,
+                      size_t size,
+                      std::shared_ptr<const AlignedTensorContainer> container)
+      : phi::Allocation(ptr, size, platform::CPUPlace()),
+        container_(std::move(container)) {}
+
+ private:
+  std::shared_ptr<const AlignedTensorContainer> container_;
+};
+
+}  // namespace
+
+bool IsAlignedTensorContainer(const char* data, size_t size) {
+  return size >= sizeof(kContainerMagic) &&
+         std::memcmp(data, kContainerMagic, sizeof(kContainerMagic)) == 0;
+}
+
+std::string AlignedContainerHeader(
+    const std::vector<std::string>& names,
+    const std::vector<const phi::DenseTensor*>& tensors,
+    std::vector<uint64_t>* data_offsets) {
+  PADDLE_ENFORCE_EQ(
+      names.size(),
+      tensors.size(),
+      platform::errors::InvalidArgument(
+          "The number of names (%d) should be equal to the number of "
+          "tensors (%d).",
+          names.size(),
+          tensors.size()));
+  std::vector<uint64_t>& offsets = *data_offsets;
+  offsets.assign(tensors.size(), 0);
+  size_t header_bytes = sizeof(kContainerMagic) + sizeof(uint64_t) +
+                        BuildIndex(names, tensors, offsets).size();
+  size_t offset = AlignUp(header_bytes);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    offsets[i] = offset;
+    offset = AlignUp(offset + tensors[i]->numel() *
+                                  phi::SizeOf(tensors[i]->dtype()));
+  }
+  std::string index = BuildIndex(names, tensors, offsets);
+
+  std::string header(kContainerMagic, sizeof(kContainerMagic));
+  AppendPod<uint64_t>(&header, index.size());
+  header.append(index);
+  return header;
+}
+
+void SerializeToAlignedContainer(
+    std::ostream& os,
+    const std::vector<std::string>& names,
+    const std::vector<const phi::DenseTensor*>& tensors) {
+  std::vector<uint64_t> offsets;
+  std::string header = AlignedContainerHeader(names, tensors, &offsets);
+  os.write(header.data(), header.size());
+
+  const char padding[kAlignedTensorContainerAlignment] = {0};
+  size_t written = header.size();
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    os.write(padding, offsets[i] - written);
+    const phi::DenseTensor* tensor = tensors[i];
+    phi::DenseTensor cpu_tensor;
+    if (!platform::is_cpu_place(tensor->place())) {
+      TensorCopySync(*tensor, platform::CPUPlace(), &cpu_tensor);
+      tensor = &cpu_tensor;
+    }
+    size_t bytes = tensor->numel() * phi::SizeOf(tensor->dtype());
+    if (bytes > 0) {
+      os.write(static_cast<const char*>(tensor->data()), bytes);
+    }
+    written = offsets[i] + bytes;
+  }
+}
+
+std::shared_ptr<AlignedTensorContainer> AlignedTensorContainer::Open(
+    const std::string& path) {
+  std::shared_ptr<AlignedTensorContainer> container(
+      new AlignedTensorContainer());
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(
+      fd,
+      0,
+      platform::errors::Unavailable("Failed to open tensor container %s.",
+                                    path));
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Failed to get the size of tensor container %s.", path));
+  }
+  container->size_ = file_stat.st_size;
+  if (container->size_ > 0) {
+    // a private mapping, so kernels can update the loaded tensors in place
+    // without writing back to the file
+    void* addr = mmap(nullptr,
+                      container->size_,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE,
+                      fd,
+                      0);
+    close(fd);
+    PADDLE_ENFORCE_NE(addr,
+                      MAP_FAILED,
+                      platform::errors::Unavailable(
+                          "Failed to mmap tensor container %s.", path));
+    container->data_ = static_cast<char*>(addr);
+    container->mapped_ = true;
+  } else {
+    close(fd);
+  }
+#else
+  std::ifstream fin(path, std::ios::binary);
+  PADDLE_ENFORCE_EQ(
+      static_cast<bool>(fin),
+      true,
+      platform::errors::Unavailable("Failed to open tensor container %s.",
+                                    path));
+  std::string buffer((std::istreambuf_iterator<char>(fin)),
+                     std::istreambuf_iterator<char>());
+  return FromBuffer(buffer);
+#endif
+  container->ParseIndex(path);
+  return container;
+}
+
+std::shared_ptr<AlignedTensorContainer> AlignedTensorContainer::FromBuffer(
+    const std::string& buffer) {
+  std::shared_ptr<AlignedTensorContainer> container(
+      new AlignedTensorContainer());
+  container->size_ = buffer.size();
+  container->buffer_.reset(
+      new char[buffer.size() + kAlignedTensorContainerAlignment]);
+  uintptr_t addr = reinterpret_cast<uintptr_t>(container->buffer_.get());
+  container->data_ = reinterpret_cast<char*>(AlignUp(addr));
+  std::memcpy(container->data_, buffer.data(), buffer.size());
+  container->ParseIndex("<memory>");
+  return container;
+}
+
+AlignedTensorContainer::~AlignedTensorContainer() {
+#ifndef _WIN32
+  if (mapped_) {
+    munmap(data_, size_);
+  }
+#endif
+}
+
+void AlignedTensorContainer::ParseIndex(const std::string& path) {
+  PADDLE_ENFORCE_EQ(
+      IsAlignedTensorContainer(data_, size_),
+      true,
+      platform::errors::InvalidArgument(
+          "%s is not a tensor container saved with aligned_format.", path));
+  IndexReader header(data_ + sizeof(kContainerMagic), data_ + size_, path);
+  uint64_t index_bytes = header.Read<uint64_t>();
+  const char* index_begin = data_ + sizeof(kContainerMagic) + sizeof(uint64_t);
+  PADDLE_ENFORCE_LE(
+      index_bytes,
+      static_cast<uint64_t>(data_ + size_ - index_begin),
+      platform::errors::InvalidArgument(
+          "The index of the tensor container %s is truncated, please check "
+          "whether the file is complete or damaged.",
+          path));
+
+  IndexReader reader(index_begin, index_begin + index_bytes, path);
+  // name size, dtype, dims size, lod size, offset and bytes of a tensor
+  constexpr size_t kMinTensorIndexBytes =
+      4 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+  infos_.resize(reader.ReadCount<uint32_t>(kMinTensorIndexBytes));
+  for (auto& info : infos_) {
+    info.name = reader.ReadString(reader.Read<uint32_t>());
+    info.dtype = static_cast<proto::VarType::Type>(reader.Read<int32_t>());
+    info.dims.resize(reader.ReadCount<uint32_t>(sizeof(int64_t)));
+    for (auto& dim : info.dims) {
+      dim = reader.Read<int64_t>();
+    }
+    info.lod.resize(reader.ReadCount<uint32_t>(sizeof(uint64_t)));
+    for (auto& level : info.lod) {
+      level.resize(reader.ReadCount<uint64_t>(sizeof(uint64_t)));
+      for (auto& offset : level) {
+        offset = reader.Read<uint64_t>();
+      }
+    }
+    info.offset = reader.Read<uint64_t>();
+    info.bytes = reader.Read<uint64_t>();
+    PADDLE_ENFORCE_EQ(
+        info.offset <= size_ && info.bytes <= size_ - info.offset &&
+            info.offset % kAlignedTensorContainerAlignment == 0,
+        true,
+        platform::errors::InvalidArgument(
+            "The data of tensor %s is out of the tensor container %s, please "
+            "check whether the file is complete or damaged.",
+            info.name,
+            path));
+    PADDLE_ENFORCE_EQ(
+        static_cast<uint64_t>(phi::product(phi::make_ddim(info.dims))) *
+            SizeOfType(info.dtype),
+        info.bytes,
+        platform::errors::InvalidArgument(
+            "The data size of tensor %s does not match its shape in the "
+            "tensor container %s.",
+            info.name,
+            path));
+  }
+}
+
+void AlignedTensorContainer::GetTensor(size_t i,
+                                       const platform::Place& place,
+                                       phi::DenseTensor* tensor) const {
+  const TensorInfo& tensor_info = info(i);
+  auto holder = std::make_shared<ContainerAllocation>(
+      data_ + tensor_info.offset, tensor_info.bytes, shared_from_this());
+  phi::DenseTensorMeta meta(TransToPhiDataType(tensor_info.dtype),
+                            phi::make_ddim(tensor_info.dims));
+  meta.lod = tensor_info.lod;
+  phi::DenseTensor view(holder, meta);
+  if (platform::is_cpu_place(place)) {
+    *tensor = std::move(view);
+  } else {
+    TensorCopySync(view, place, tensor);
+    tensor->set_lod(tensor_info.lod);
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,117 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * A file format holding a list of tensors, written by save_combine with
+ * `aligned_format` and read back by load_combine.
+ *
+ *   char[8]   magic "PDTCNTR1"
+ *   uint64_t  bytes of the index
+ *   index     uint32_t tensor number, then for every tensor:
+ *               uint32_t name length, name, int32_t proto::VarType::Type,
+ *               uint32_t rank, int64_t dims[rank], uint32_t lod levels,
+ *               for every level uint64_t length, uint64_t offsets[length],
+ *               uint64_t data offset from the file begin, uint64_t bytes
+ *   data      the raw bytes of every tensor, each begins at a multiple of
+ *             kAlignedTensorContainerAlignment
+ *
+ * As the data is aligned and stored in the same layout as in memory, a
+ * container can be mapped into memory and the CPU tensors read from it share
+ * the mapped pages instead of copying them.
+ */
+constexpr size_t kAlignedTensorContainerAlignment = 64;
+
+// Whether the first bytes of a file are the magic of the container.
+bool IsAlignedTensorContainer(const char* data, size_t size);
+
+// The magic and the index of a container of the tensors, which are followed
+// by the data of the tensors at the offsets filled in data_offsets.
+std::string AlignedContainerHeader(
+    const std::vector<std::string>& names,
+    const std::vector<const phi::DenseTensor*>& tensors,
+    std::vector<uint64_t>* data_offsets);
+
+// Write the tensors with their names as a container. Tensors not on CPU are
+// copied to CPU first.
+void SerializeToAlignedContainer(
+    std::ostream& os,
+    const std::vector<std::string>& names,
+    const std::vector<const phi::DenseTensor*>& tensors);
+
+class AlignedTensorContainer
+    : public std::enable_shared_from_this<AlignedTensorContainer> {
+ public:
+  struct TensorInfo {
+    std::string name;
+    proto::VarType::Type dtype;
+    std::vector<int64_t> dims;
+    LoD lod;
+    uint64_t offset;
+    uint64_t bytes;
+  };
+
+  // Map the file into memory, the file is read lazily by page faults.
+  static std::shared_ptr<AlignedTensorContainer> Open(const std::string& path);
+
+  // Copy a container held in memory, e.g. a model loaded from memory, into
+  // an aligned buffer.
+  static std::shared_ptr<AlignedTensorContainer> FromBuffer(
+      const std::string& buffer);
+
+  ~AlignedTensorContainer();
+
+  size_t size() const { return infos_.size(); }
+
+  const TensorInfo& info(size_t i) const { return infos_.at(i); }
+
+  // Read the i-th tensor. On CPU the tensor is a view of the container and
+  // keeps it alive; writing to it only changes the private copy of the
+  // touched pages, never the file. On other places the data is copied.
+  void GetTensor(size_t i,
+                 const platform::Place& place,
+                 phi::DenseTensor* tensor) const;
+
+ private:
+  AlignedTensorContainer() = default;
+
+  void ParseIndex(const std::string& path);
+
+  char* data_{nullptr};
+  size_t size_{0};
+  // set when data_ is mapped from a file
+  bool mapped_{false};
+  std::unique_ptr<char[]> buffer_;
+  std::vector<TensorInfo> infos_;
+
+  DISABLE_COPY_AND_ASSIGN(AlignedTensorContainer);
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,213 @@
+//   Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/aligned_tensor_container.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace paddle {
+namespace framework {
+
+TEST(AlignedTensorContainer, SaveAndLoad) {
+  platform::CPUPlace place;
+  phi::DenseTensor x;
+  x.Resize({3, 5});
+  float* x_data = x.mutable_data<float>(place);
+  for (int i = 0; i < 15; ++i) {
+    x_data[i] = i * 0.5f;
+  }
+  x.set_lod({{0, 1, 3}});
+  phi::DenseTensor y;
+  y.Resize({7});
+  int64_t* y_data = y.mutable_data<int64_t>(place);
+  for (int i = 0; i < 7; ++i) {
+    y_data[i] = i - 3;
+  }
+  phi::DenseTensor empty;
+  empty.Resize({0, 4});
+  empty.mutable_data<int>(place);
+
+  std::string path = "aligned_tensor_container_test.bin";
+  {
+    std::ofstream fout(path, std::ios::binary);
+    SerializeToAlignedContainer(fout, {"x", "y", "empty"}, {&x, &y, &empty});
+  }
+  std::ifstream fin(path, std::ios::binary);
+  std::string buffer((std::istreambuf_iterator<char>(fin)),
+                     std::istreambuf_iterator<char>());
+  EXPECT_TRUE(IsAlignedTensorContainer(buffer.data(), buffer.size()));
+
+  for (auto container : {AlignedTensorContainer::Open(path),
+                         AlignedTensorContainer::FromBuffer(buffer)}) {
+    ASSERT_EQ(container->size(), 3UL);
+    EXPECT_EQ(container->info(0).name, "x");
+    EXPECT_EQ(container->info(1).name, "y");
+    EXPECT_EQ(container->info(2).name, "empty");
+
+    phi::DenseTensor x_load, y_load, empty_load;
+    container->GetTensor(0, place, &x_load);
+    container->GetTensor(1, place, &y_load);
+    container->GetTensor(2, place, &empty_load);
+    EXPECT_EQ(x_load.dims(), x.dims());
+    EXPECT_EQ(x_load.dtype(), phi::DataType::FLOAT32);
+    EXPECT_EQ(x_load.lod(), x.lod());
+    EXPECT_EQ(y_load.dims(), y.dims());
+    EXPECT_EQ(y_load.dtype(), phi::DataType::INT64);
+    EXPECT_EQ(empty_load.dims(), empty.dims());
+    EXPECT_EQ(empty_load.dtype(), phi::DataType::INT32);
+    for (int i = 0; i < 15; ++i) {
+      EXPECT_EQ(x_load.data<float>()[i], x_data[i]);
+    }
+    for (int i = 0; i < 7; ++i) {
+      EXPECT_EQ(y_load.data<int64_t>()[i], y_data[i]);
+    }
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(x_load.data()) %
+                  kAlignedTensorContainerAlignment,
+              0UL);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(y_load.data()) %
+                  kAlignedTensorContainerAlignment,
+              0UL);
+
+    x_load.data<float>()[0] = 100.0f;
+    EXPECT_EQ(x_load.data<float>()[0], 100.0f);
+  }
+
+  // the views keep the container alive, and writing to them never changes
+  // the file
+  phi::DenseTensor x_load;
+  AlignedTensorContainer::Open(path)->GetTensor(0, place, &x_load);
+  EXPECT_EQ(x_load.data<float>()[0], 0.0f);
+  EXPECT_EQ(x_load.data<float>()[14], 7.0f);
+
+  // damaged counts of tensors, dims and lod fail before they are allocated,
+  // the index starts with the tensor number, then "x" is described by name
+  // size, name, dtype, dims size, 2 dims, lod size and the size of level 0
+  auto damaged = [&buffer](size_t pos, uint64_t value, size_t bytes) {
+    std::string copy = buffer;
+    std::memcpy(&copy[pos], &value, bytes);
+    return copy;
+  };
+  const size_t tensor_num_pos = 16;
+  const size_t dims_size_pos = tensor_num_pos + 4 + 4 + 1 + 4;
+  const size_t level_size_pos = dims_size_pos + 4 + 2 * 8 + 4;
+  EXPECT_THROW(
+      AlignedTensorContainer::FromBuffer(damaged(tensor_num_pos, 1 << 30, 4)),
+      platform::EnforceNotMet);
+  EXPECT_THROW(
+      AlignedTensorContainer::FromBuffer(damaged(dims_size_pos, 1 << 30, 4)),
+      platform::EnforceNotMet);
+  EXPECT_THROW(AlignedTensorContainer::FromBuffer(
+                   damaged(level_size_pos, uint64_t(1) << 60, 8)),
+               platform::EnforceNotMet);
+  EXPECT_NO_THROW(
+      AlignedTensorContainer::FromBuffer(damaged(level_size_pos, 3, 8)));
+
+  buffer.resize(buffer.size() / 2);
+  EXPECT_THROW(AlignedTensorContainer::FromBuffer(buffer),
+               platform::EnforceNotMet);
+  buffer = "not a container";
+  EXPECT_FALSE(IsAlignedTensorContainer(buffer.data(), buffer.size()));
+  EXPECT_THROW(AlignedTensorContainer::FromBuffer(buffer),
+               platform::EnforceNotMet);
+  std::remove(path.c_str());
+}
+
+TEST(AlignedTensorContainer, LoadBenchmark) {
+  // a checkpoint of 256MB in 64 tensors
+  constexpr int kTensorNum = 64;
+  constexpr int64_t kNumel = 1 << 20;
+  platform::CPUPlace place;
+  std::vector<phi::DenseTensor> tensors(kTensorNum);
+  std::vector<const phi::DenseTensor*> tensor_ptrs;
+  std::vector<std::string> names;
+  for (int i = 0; i < kTensorNum; ++i) {
+    tensors[i].Resize({kNumel});
+    float* data = tensors[i].mutable_data<float>(place);
+    for (int64_t j = 0; j < kNumel; ++j) {
+      data[j] = static_cast<float>(i + j % 7);
+    }
+    tensor_ptrs.push_back(&tensors[i]);
+    names.push_back("param_" + std::to_string(i));
+  }
+
+  std::string stream_path = "aligned_tensor_container_bench.stream";
+  std::string container_path = "aligned_tensor_container_bench.bin";
+  {
+    std::ofstream fout(stream_path, std::ios::binary);
+    for (auto* tensor : tensor_ptrs) {
+      SerializeToStream(fout, *tensor);
+    }
+  }
+  {
+    std::ofstream fout(container_path, std::ios::binary);
+    SerializeToAlignedContainer(fout, names, tensor_ptrs);
+  }
+
+  auto sum_all = [](const std::vector<phi::DenseTensor>& loaded) {
+    double sum = 0;
+    for (auto& tensor : loaded) {
+      const float* data = tensor.data<float>();
+      for (int64_t j = 0; j < tensor.numel(); j += 1024) {
+        sum += data[j];
+      }
+    }
+    return sum;
+  };
+  double expect = sum_all(tensors);
+
+  auto stream_start = std::chrono::steady_clock::now();
+  std::vector<phi::DenseTensor> stream_loaded(kTensorNum);
+  {
+    std::ifstream fin(stream_path, std::ios::binary);
+    for (auto& tensor : stream_loaded) {
+      DeserializeFromStream(fin, &tensor);
+    }
+  }
+  auto stream_end = std::chrono::steady_clock::now();
+  EXPECT_EQ(sum_all(stream_loaded), expect);
+
+  auto container_start = std::chrono::steady_clock::now();
+  std::vector<phi::DenseTensor> container_loaded(kTensorNum);
+  {
+    auto container = AlignedTensorContainer::Open(container_path);
+    for (int i = 0; i < kTensorNum; ++i) {
+      container->GetTensor(i, place, &container_loaded[i]);
+    }
+  }
+  auto container_end = std::chrono::steady_clock::now();
+  // touch every page, so the time of reading the file is counted as well
+  EXPECT_EQ(sum_all(container_loaded), expect);
+  auto touch_end = std::chrono::steady_clock::now();
+
+  auto ms = [](std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  };
+  LOG(INFO) << "Load 256MB checkpoint, stream: "
+            << ms(stream_end - stream_start)
+            << " ms, mmap container: " << ms(container_end - container_start)
+            << " ms, mmap container with first touch: "
+            << ms(touch_end - container_start) << " ms";
+  std::remove(stream_path.c_str());
+  std::remove(container_path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,349 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/combined_tensor_io.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "paddle/fluid/framework/aligned_tensor_container.h"
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/framework/version.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+// Run func(i) for i in [0, n) on num_threads threads including the calling
+// one, the first exception is rethrown after all threads finish.
+template <typename Func>
+void ParallelFor(size_t n, int num_threads, Func&& func) {
+  std::atomic<size_t> next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&] {
+    for (size_t i = next++; i < n; i = next++) {
+      try {
+        func(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        next = n;
+      }
+    }
+  };
+  size_t thread_num = std::min(static_cast<size_t>(std::max(num_threads, 1)),
+                               std::max(n, static_cast<size_t>(1)));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_num; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+template <typename T>
+void AppendPod(std::string* out, T value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// The bytes SerializeToStream writes before the data of the tensor.
+std::string StreamHeader(const phi::DenseTensor& tensor) {
+  std::string header;
+  AppendPod<uint32_t>(&header, kCurTensorVersion);
+  AppendPod<uint64_t>(&header, tensor.lod().size());
+  for (auto& level : tensor.lod()) {
+    uint64_t size = level.size() * sizeof(LoD::value_type::value_type);
+    AppendPod<uint64_t>(&header, size);
+    header.append(reinterpret_cast<const char*>(level.data()), size);
+  }
+  // the tensor version
+  AppendPod<uint32_t>(&header, 0);
+  proto::VarType::TensorDesc desc;
+  desc.set_data_type(TransToProtoVarType(tensor.dtype()));
+  auto dims = phi::vectorize(tensor.dims());
+  auto* pb_dims = desc.mutable_dims();
+  pb_dims->Resize(static_cast<int>(dims.size()), 0);
+  std::copy(dims.begin(), dims.end(), pb_dims->begin());
+  std::string desc_str = desc.SerializeAsString();
+  AppendPod<int32_t>(&header, desc_str.size());
+  header.append(desc_str);
+  return header;
+}
+
+#ifndef _WIN32
+void PReadFull(
+    int fd, char* buf, size_t size, uint64_t offset, const std::string& path) {
+  while (size > 0) {
+    ssize_t read_bytes = pread(fd, buf, size, offset);
+    PADDLE_ENFORCE_GT(read_bytes,
+                      0,
+                      platform::errors::Unavailable(
+                          "Failed to read %s at offset %d, please check "
+                          "whether the file is complete or damaged.",
+                          path,
+                          offset));
+    buf += read_bytes;
+    size -= read_bytes;
+    offset += read_bytes;
+  }
+}
+
+void PWriteFull(int fd,
+                const char* buf,
+                size_t size,
+                uint64_t offset,
+                const std::string& path) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, buf, size, offset);
+    PADDLE_ENFORCE_GT(
+        written,
+        0,
+        platform::errors::Unavailable(
+            "Failed to write %s at offset %d.", path, offset));
+    buf += written;
+    size -= written;
+    offset += written;
+  }
+}
+#endif
+
+}  // namespace
+
+std::vector<SerializedTensorInfo> ScanSerializedTensors(
+    const std::string& path) {
+  std::ifstream fin(path, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin),
+                    true,
+                    platform::errors::Unavailable(
+                        "Failed to open %s, please check whether the model "
+                        "file is complete or damaged.",
+                        path));
+  auto read = [&fin, &path](void* data, size_t size) {
+    fin.read(static_cast<char*>(data), size);
+    PADDLE_ENFORCE_EQ(
+        static_cast<size_t>(fin.gcount()),
+        size,
+        platform::errors::Unavailable(
+            "The tensors in %s are truncated, please check whether the model "
+            "file is complete or damaged.",
+            path));
+  };
+
+  std::vector<SerializedTensorInfo> infos;
+  while (fin.peek() != std::ifstream::traits_type::eof()) {
+    SerializedTensorInfo info;
+    uint32_t version;
+    read(&version, sizeof(version));
+    PADDLE_ENFORCE_EQ(IsTensorVersionSupported(version),
+                      true,
+                      platform::errors::InvalidArgument(
+                          "Tensor version %u is not supported.", version));
+    uint64_t lod_level;
+    read(&lod_level, sizeof(lod_level));
+    info.lod.resize(lod_level);
+    for (auto& level : info.lod) {
+      uint64_t size;
+      read(&size, sizeof(size));
+      level.resize(size / sizeof(LoD::value_type::value_type));
+      read(level.data(), size);
+    }
+
+    read(&version, sizeof(version));
+    PADDLE_ENFORCE_EQ(
+        version,
+        0U,
+        platform::errors::InvalidArgument(
+            "tensor version %u is not supported, Only version 0 is supported",
+            version));
+    int32_t desc_size;
+    read(&desc_size, sizeof(desc_size));
+    PADDLE_ENFORCE_GE(desc_size,
+                      0,
+                      platform::errors::InvalidArgument(
+                          "phi::DenseTensor desc size should >= 0"));
+    std::string desc_str(desc_size, '\0');
+    read(&desc_str[0], desc_size);
+    proto::VarType::TensorDesc desc;
+    PADDLE_ENFORCE_EQ(
+        desc.ParseFromString(desc_str),
+        true,
+        platform::errors::InvalidArgument("Cannot parse tensor desc"));
+    info.dtype = desc.data_type();
+    info.dims.assign(desc.dims().begin(), desc.dims().end());
+    info.bytes = phi::product(phi::make_ddim(info.dims)) *
+                 SizeOfType(info.dtype);
+    info.data_offset = fin.tellg();
+    fin.seekg(info.bytes, std::ios::cur);
+    infos.push_back(std::move(info));
+  }
+  return infos;
+}
+
+void LoadCombinedTensors(const std::string& path,
+                         const std::vector<phi::DenseTensor*>& tensors,
+                         const platform::Place& place,
+                         int num_threads) {
+#ifdef _WIN32
+  // no pread on Windows, fall back to reading one by one
+  std::ifstream fin(path, std::ios::binary);
+  auto& dev_ctx = *platform::DeviceContextPool::Instance().Get(place);
+  for (auto* tensor : tensors) {
+    DeserializeFromStream(fin, tensor, dev_ctx);
+  }
+#else
+  auto infos = ScanSerializedTensors(path);
+  PADDLE_ENFORCE_EQ(
+      infos.size(),
+      tensors.size(),
+      platform::errors::Unavailable(
+          "The file %s holds %d tensors but %d tensors are to be loaded. "
+          "Not allowed to load partial data via load_combine_op, please use "
+          "load_op instead.",
+          path,
+          infos.size(),
+          tensors.size()));
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(
+      fd, 0, platform::errors::Unavailable("Failed to open %s.", path));
+  try {
+    ParallelFor(tensors.size(), num_threads, [&](size_t i) {
+      const SerializedTensorInfo& info = infos[i];
+      phi::DenseTensor* tensor = tensors[i];
+      phi::DenseTensor cpu_tensor;
+      phi::DenseTensor* dst =
+          platform::is_cpu_place(place) ? tensor : &cpu_tensor;
+      dst->Resize(phi::make_ddim(info.dims));
+      char* data = static_cast<char*>(dst->mutable_data(
+          platform::CPUPlace(), TransToPhiDataType(info.dtype)));
+      PReadFull(fd, data, info.bytes, info.data_offset, path);
+      if (dst != tensor) {
+        TensorCopySync(cpu_tensor, place, tensor);
+      }
+      tensor->set_lod(info.lod);
+    });
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+#endif
+}
+
+void SaveCombinedTensors(const std::string& path,
+                         const std::vector<const phi::DenseTensor*>& tensors,
+                         bool aligned_format,
+                         int num_threads) {
+#ifdef _WIN32
+  // no pwrite on Windows, fall back to writing one by one
+  std::ofstream fout(path, std::ios::binary);
+  if (aligned_format) {
+    SerializeToAlignedContainer(
+        fout, std::vector<std::string>(tensors.size()), tensors);
+  } else {
+    for (auto* tensor : tensors) {
+      SerializeToStream(fout, *tensor);
+    }
+  }
+#else
+  std::string header;
+  std::vector<std::string> record_headers;
+  std::vector<uint64_t> data_offsets;
+  if (aligned_format) {
+    header = AlignedContainerHeader(
+        std::vector<std::string>(tensors.size()), tensors, &data_offsets);
+  } else {
+    uint64_t offset = 0;
+    for (auto* tensor : tensors) {
+      record_headers.push_back(StreamHeader(*tensor));
+      data_offsets.push_back(offset + record_headers.back().size());
+      offset = data_offsets.back() +
+               tensor->numel() * phi::SizeOf(tensor->dtype());
+    }
+  }
+  uint64_t file_size = header.size();
+  if (!tensors.empty()) {
+    file_size = data_offsets.back() +
+                tensors.back()->numel() * phi::SizeOf(tensors.back()->dtype());
+  }
+
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  PADDLE_ENFORCE_GE(
+      fd,
+      0,
+      platform::errors::Unavailable("Cannot open %s to save variables.", path));
+  try {
+    // the gaps between the aligned tensors are left as holes of zeros
+    PADDLE_ENFORCE_EQ(
+        ftruncate(fd, file_size),
+        0,
+        platform::errors::Unavailable(
+            "Failed to resize %s to %d bytes.", path, file_size));
+    PWriteFull(fd, header.data(), header.size(), 0, path);
+    ParallelFor(tensors.size(), num_threads, [&](size_t i) {
+      if (!aligned_format) {
+        auto& record_header = record_headers[i];
+        PWriteFull(fd,
+                   record_header.data(),
+                   record_header.size(),
+                   data_offsets[i] - record_header.size(),
+                   path);
+      }
+      const phi::DenseTensor* tensor = tensors[i];
+      size_t bytes = tensor->numel() * phi::SizeOf(tensor->dtype());
+      if (bytes == 0) {
+        return;
+      }
+      phi::DenseTensor cpu_tensor;
+      if (!platform::is_cpu_place(tensor->place())) {
+        TensorCopySync(*tensor, platform::CPUPlace(), &cpu_tensor);
+        tensor = &cpu_tensor;
+      }
+      PWriteFull(fd,
+                 static_cast<const char*>(tensor->data()),
+                 bytes,
+                 data_offsets[i],
+                 path);
+    });
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+#endif
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,67 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * Parallel IO of the files written by save_combine. The offsets of all
+ * tensors are known before any data is touched, either scanned from the
+ * headers of the stream format or computed from the shapes when saving, so
+ * every tensor is read with pread or written with pwrite at its own offset
+ * on a pool of threads. Only the tensors not on CPU need a staging copy,
+ * and a thread holds at most one of them, so the extra memory is bounded by
+ * the number of threads.
+ */
+
+// The header of a tensor serialized by SerializeToStream.
+struct SerializedTensorInfo {
+  proto::VarType::Type dtype;
+  std::vector<int64_t> dims;
+  LoD lod;
+  // offset of the raw data from the file begin
+  uint64_t data_offset;
+  uint64_t bytes;
+};
+
+// Read the headers of the tensors serialized one after another by
+// SerializeToStream, skipping their data.
+std::vector<SerializedTensorInfo> ScanSerializedTensors(
+    const std::string& path);
+
+// Load all tensors of a file in the stream format on num_threads threads.
+void LoadCombinedTensors(const std::string& path,
+                         const std::vector<phi::DenseTensor*>& tensors,
+                         const platform::Place& place,
+                         int num_threads);
+
+// Save the tensors in the stream format, or the aligned container format
+// with empty names, on num_threads threads.
+void SaveCombinedTensors(const std::string& path,
+                         const std::vector<const phi::DenseTensor*>& tensors,
+                         bool aligned_format,
+                         int num_threads);
+
+}  // namespace framework
+}  // namespace paddle
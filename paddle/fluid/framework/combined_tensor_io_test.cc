@@ -0,0 +1,187 @@
+//   Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/combined_tensor_io.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "paddle/fluid/framework/aligned_tensor_container.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+void FillTensors(std::vector<phi::DenseTensor>* tensors) {
+  platform::CPUPlace place;
+  auto& x = (*tensors)[0];
+  x.Resize({3, 5});
+  float* x_data = x.mutable_data<float>(place);
+  for (int i = 0; i < 15; ++i) {
+    x_data[i] = i * 0.5f;
+  }
+  x.set_lod({{0, 1, 3}, {0, 1, 2, 3}});
+  auto& y = (*tensors)[1];
+  y.Resize({7});
+  int64_t* y_data = y.mutable_data<int64_t>(place);
+  for (int i = 0; i < 7; ++i) {
+    y_data[i] = i - 3;
+  }
+  auto& empty = (*tensors)[2];
+  empty.Resize({0, 4});
+  empty.mutable_data<int>(place);
+}
+
+void ExpectEqual(const phi::DenseTensor& expect,
+                 const phi::DenseTensor& actual) {
+  EXPECT_EQ(actual.dims(), expect.dims());
+  EXPECT_EQ(actual.dtype(), expect.dtype());
+  EXPECT_EQ(actual.lod(), expect.lod());
+  size_t bytes = expect.numel() * phi::SizeOf(expect.dtype());
+  if (bytes > 0) {
+    EXPECT_EQ(std::memcmp(expect.data(), actual.data(), bytes), 0);
+  }
+}
+
+}  // namespace
+
+TEST(CombinedTensorIO, ParallelSave) {
+  std::vector<phi::DenseTensor> tensors(3);
+  FillTensors(&tensors);
+  std::string path = "combined_tensor_io_test_save.bin";
+  for (int num_threads : {1, 2, 4}) {
+    SaveCombinedTensors(
+        path, {&tensors[0], &tensors[1], &tensors[2]}, false, num_threads);
+    std::ifstream fin(path, std::ios::binary);
+    for (auto& tensor : tensors) {
+      phi::DenseTensor loaded;
+      DeserializeFromStream(fin, &loaded);
+      ExpectEqual(tensor, loaded);
+    }
+    fin.peek();
+    EXPECT_TRUE(fin.eof());
+  }
+
+  SaveCombinedTensors(path, {&tensors[0], &tensors[1], &tensors[2]}, true, 4);
+  auto container = AlignedTensorContainer::Open(path);
+  ASSERT_EQ(container->size(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    phi::DenseTensor loaded;
+    container->GetTensor(i, platform::CPUPlace(), &loaded);
+    ExpectEqual(tensors[i], loaded);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(CombinedTensorIO, ParallelLoad) {
+  std::vector<phi::DenseTensor> tensors(3);
+  FillTensors(&tensors);
+  std::string path = "combined_tensor_io_test_load.bin";
+  {
+    std::ofstream fout(path, std::ios::binary);
+    for (auto& tensor : tensors) {
+      SerializeToStream(fout, tensor);
+    }
+  }
+
+  auto infos = ScanSerializedTensors(path);
+  ASSERT_EQ(infos.size(), tensors.size());
+  EXPECT_EQ(infos[0].dtype, proto::VarType::FP32);
+  EXPECT_EQ(infos[0].dims, std::vector<int64_t>({3, 5}));
+  EXPECT_EQ(infos[0].bytes, 15 * sizeof(float));
+  EXPECT_EQ(infos[1].dtype, proto::VarType::INT64);
+  EXPECT_EQ(infos[2].bytes, 0UL);
+
+  for (int num_threads : {1, 2, 4}) {
+    std::vector<phi::DenseTensor> loaded(tensors.size());
+    LoadCombinedTensors(path,
+                        {&loaded[0], &loaded[1], &loaded[2]},
+                        platform::CPUPlace(),
+                        num_threads);
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      ExpectEqual(tensors[i], loaded[i]);
+    }
+  }
+
+  // loading part of the tensors is not allowed
+  phi::DenseTensor partial;
+  EXPECT_THROW(
+      LoadCombinedTensors(path, {&partial}, platform::CPUPlace(), 2),
+      platform::EnforceNotMet);
+  std::remove(path.c_str());
+}
+
+TEST(CombinedTensorIO, Benchmark) {
+  // a model of 2000 small parameters, 128MB in total
+  constexpr int kTensorNum = 2000;
+  constexpr int64_t kNumel = 16 << 10;
+  platform::CPUPlace place;
+  std::vector<phi::DenseTensor> tensors(kTensorNum);
+  std::vector<const phi::DenseTensor*> tensor_ptrs;
+  for (int i = 0; i < kTensorNum; ++i) {
+    tensors[i].Resize({kNumel});
+    float* data = tensors[i].mutable_data<float>(place);
+    for (int64_t j = 0; j < kNumel; ++j) {
+      data[j] = static_cast<float>(i + j % 7);
+    }
+    tensor_ptrs.push_back(&tensors[i]);
+  }
+
+  auto ms = [](std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  };
+  std::string path = "combined_tensor_io_bench.bin";
+  for (int num_threads : {1, 2, 4, 8}) {
+    auto save_start = std::chrono::steady_clock::now();
+    SaveCombinedTensors(path, tensor_ptrs, false, num_threads);
+    auto save_end = std::chrono::steady_clock::now();
+
+    std::vector<phi::DenseTensor> loaded(kTensorNum);
+    std::vector<phi::DenseTensor*> loaded_ptrs;
+    for (auto& tensor : loaded) {
+      loaded_ptrs.push_back(&tensor);
+    }
+    auto load_start = std::chrono::steady_clock::now();
+    LoadCombinedTensors(path, loaded_ptrs, place, num_threads);
+    auto load_end = std::chrono::steady_clock::now();
+    EXPECT_EQ(loaded.back().data<float>()[kNumel - 1],
+              tensors.back().data<float>()[kNumel - 1]);
+
+    LOG(INFO) << "Save and load " << kTensorNum << " tensors with "
+              << num_threads << " threads, save: " << ms(save_end - save_start)
+              << " ms, load: " << ms(load_end - load_start) << " ms";
+  }
+
+  std::vector<phi::DenseTensor> loaded(kTensorNum);
+  auto stream_start = std::chrono::steady_clock::now();
+  {
+    std::ifstream fin(path, std::ios::binary);
+    for (auto& tensor : loaded) {
+      DeserializeFromStream(fin, &tensor);
+    }
+  }
+  auto stream_end = std::chrono::steady_clock::now();
+  LOG(INFO) << "Load " << kTensorNum << " tensors by stream: "
+            << ms(stream_end - stream_start) << " ms";
+  std::remove(path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -32,6 +32,7 @@ limitations under the License. */
 
 DECLARE_bool(benchmark);
 DECLARE_bool(use_mkldnn);
+DECLARE_bool(executor_var_slots);
 
 namespace paddle {
 namespace framework {
@@ -562,6 +563,16 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
     }
   }
 
+  // a local scope lives for one run only, resolving slots in it does not pay
+  if (FLAGS_executor_var_slots && local_scope == scope) {
+    for (int64_t i = start_op_index; i < end_op_index; ++i) {
+      auto& op = ctx->ops_[i];
+      if (!op->HasVarSlots(*local_scope)) {
+        op->PrepareVarSlots(*local_scope);
+      }
+    }
+    local_scope->RefreshSlotVars();
+  }
   for (int64_t i = start_op_index; i < end_op_index; ++i) {
     auto& op = ctx->ops_[i];
     op->Run(*local_scope, place_);
@@ -13,7 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/framework/ir/constant_folding_pass.h"
+#include <algorithm>
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include "glog/logging.h"
 #include "paddle/fluid/framework/ir/graph_helper.h"
@@ -22,6 +24,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/op_version_registry.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/pretty_log.h"
 
 #include "paddle/fluid/framework/convert_utils.h"
 
@@ -38,6 +41,12 @@ class Node;
  * model, we can remove this op from the model. This ConstantFolding pass can
  * remove all these like ops.
  *
+ * A shape op of a parameter is folded as well, with the dims of the
+ * parameter tensor in the scope, so the ops computing on the shape only are
+ * folded in turn. The shapes of other variables are only known at run time.
+ * The parameters which are only read by the folded ops are erased from the
+ * scope, so they are neither kept in memory nor saved with the optimized
+ * model.
  */
 
 namespace paddle {
@@ -51,8 +60,94 @@ struct ConstantFolding : public PatternBase {
 };
 }  // namespace patterns
 
+namespace {
+
+// Whether no other variable node of the graph has the name of var_node, so
+// persisting or erasing it does not affect another use of the name.
+bool HasUniqueName(const Graph *graph, const Node *var_node) {
+  for (auto *node : graph->Nodes()) {
+    if (node != var_node && node->IsVar() &&
+        node->Name() == var_node->Name()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Whether an op of a block other than the main block uses the variable,
+// which the graph of the main block does not know about.
+bool UsedBySubBlocks(const ProgramDesc &program, const std::string &name) {
+  for (size_t i = 1; i < program.Size(); ++i) {
+    for (auto *op : program.Block(i).AllOps()) {
+      auto inputs = op->InputArgumentNames();
+      auto outputs = op->OutputArgumentNames();
+      if (std::find(inputs.begin(), inputs.end(), name) != inputs.end() ||
+          std::find(outputs.begin(), outputs.end(), name) != outputs.end()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 ConstantFoldingPass::ConstantFoldingPass() {}
 
+// Replace the shape op of a parameter by its output, a persistable int32
+// tensor of the dims of the parameter tensor. A parameter read by the shape
+// op only is appended to erased_params.
+bool ConstantFoldingPass::FoldShape(
+    ir::Graph *graph,
+    Node *op_node,
+    std::vector<std::string> *erased_params) const {
+  if (op_node->Name() != "shape" || op_node->inputs.size() != 1 ||
+      op_node->outputs.size() != 1) {
+    return false;
+  }
+  auto *in_node = op_node->inputs[0];
+  auto *out_node = op_node->outputs[0];
+  if (in_node->Var() == nullptr || !in_node->Var()->Persistable() ||
+      out_node->Var() == nullptr || out_node->outputs.empty() ||
+      !HasUniqueName(graph, in_node) || !HasUniqueName(graph, out_node)) {
+    return false;
+  }
+  auto *in_var = param_scope()->FindVar(in_node->Name());
+  if (in_var == nullptr || !in_var->IsType<phi::DenseTensor>()) {
+    return false;
+  }
+  const auto &in_tensor = in_var->Get<phi::DenseTensor>();
+  if (!in_tensor.IsInitialized() || !in_tensor.lod().empty()) {
+    return false;
+  }
+  auto in_dims = in_tensor.dims();
+  auto *out_tensor =
+      param_scope()->Var(out_node->Name())->GetMutable<phi::DenseTensor>();
+  out_tensor->Resize({static_cast<int64_t>(in_dims.size())});
+  int32_t *out_data = out_tensor->mutable_data<int32_t>(platform::CPUPlace());
+  for (int i = 0; i < in_dims.size(); ++i) {
+    out_data[i] = static_cast<int32_t>(in_dims[i]);
+  }
+  std::vector<int64_t> out_shape{static_cast<int64_t>(in_dims.size())};
+  for (auto *out_desc :
+       {out_node->Var(), op_node->Op()->Block()->Var(out_node->Name())}) {
+    out_desc->SetShape(out_shape);
+    out_desc->SetDataType(proto::VarType::INT32);
+    out_desc->SetPersistable(true);
+  }
+  op_node->Op()->Block()->Var(out_node->Name())->Flush();
+  std::unordered_set<const Node *> remove_nodes{op_node};
+  if (in_node->outputs.size() == 1L && in_node->inputs.empty()) {
+    remove_nodes.emplace(in_node);
+    if (in_node->Var()->Persistable() &&
+        !UsedBySubBlocks(graph->OriginProgram(), in_node->Name())) {
+      erased_params->push_back(in_node->Name());
+    }
+  }
+  GraphSafeRemoveNodes(graph, remove_nodes);
+  return true;
+}
+
 void ConstantFoldingPass::ApplyImpl(ir::Graph *graph) const {
   PADDLE_ENFORCE_NOT_NULL(
       graph, platform::errors::PreconditionNotMet("graph should not be null."));
@@ -68,11 +163,17 @@ void ConstantFoldingPass::ApplyImpl(ir::Graph *graph) const {
 
   auto op_node_sorted = framework::ir::TopologyVarientSort(
       *graph, static_cast<framework::ir::SortKind>(0));
+  int folded_num = 0;
+  std::vector<std::string> erased_params;
   for (auto *op_node : op_node_sorted) {
     if (!op_node->IsOp()) continue;
     if (std::find(blacklist.begin(), blacklist.end(), op_node->Name()) !=
         blacklist.end())
       continue;
+    if (FoldShape(graph, op_node, &erased_params)) {
+      ++folded_num;
+      continue;
+    }
 
     bool input_persis = true;
     // map is used to record how many time a name string occures in the whole
@@ -151,10 +252,25 @@ void ConstantFoldingPass::ApplyImpl(ir::Graph *graph) const {
             scope->Var(out_name)->GetMutable<phi::DenseTensor>();
         *global_out_tensor = *local_out_tensor;
       }
+      // the exclusive persistable inputs are not read by any other op, so
+      // their tensors are dropped with them
+      for (auto *node : remove_nodes) {
+        if (node->IsVar() && node->Var()->Persistable() &&
+            !UsedBySubBlocks(graph->OriginProgram(), node->Name())) {
+          erased_params.push_back(node->Name());
+        }
+      }
       GraphSafeRemoveNodes(graph, remove_nodes);
+      ++folded_num;
     }
     delete local_scope;
   }
+  scope->EraseVars(erased_params);
+  AddStatis(folded_num);
+  if (!Has("disable_logs") || !Get<bool>("disable_logs"))
+    string::PrettyLogDetail("---    folded %d ops, erased %d parameters",
+                            folded_num,
+                            erased_params.size());
 }
 
 }  // namespace ir
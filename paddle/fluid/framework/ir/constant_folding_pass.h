@@ -14,6 +14,9 @@ limitations under the License. */
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
 
 namespace paddle {
@@ -30,6 +33,11 @@ class ConstantFoldingPass : public FusePassBase {
 
  protected:
   void ApplyImpl(ir::Graph* graph) const override;
+
+ private:
+  bool FoldShape(ir::Graph* graph,
+                 Node* op_node,
+                 std::vector<std::string>* erased_params) const;
 };
 
 }  // namespace ir
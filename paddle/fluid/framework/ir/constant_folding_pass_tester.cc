@@ -0,0 +1,154 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include "paddle/fluid/framework/ir/constant_folding_pass.h"
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+void AddVarToScope(Scope* param_scope,
+                   const std::string& name,
+                   const DDim& dims) {
+  auto* tensor = param_scope->Var(name)->GetMutable<phi::DenseTensor>();
+  tensor->Resize(dims);
+  tensor->mutable_data<float>(platform::CPUPlace());
+}
+
+VarDesc* FindVarDesc(const std::unique_ptr<ir::Graph>& graph,
+                     const std::string& name) {
+  for (auto* node : graph->Nodes()) {
+    if (node->IsVar() && node->Name() == name) {
+      return node->Var();
+    }
+  }
+  return nullptr;
+}
+
+std::unique_ptr<ir::Graph> ApplyConstantFolding(const ProgramDesc& program,
+                                                Scope* param_scope) {
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(program));
+  graph->Set("__param_scope__", param_scope);
+  auto pass = PassRegistry::Instance().Get("constant_folding_pass");
+  graph.reset(pass->Apply(graph.release()));
+  return graph;
+}
+
+TEST(ConstantFoldingPass, fold_shape) {
+  // inputs      operator           output
+  // ------------------------------------------------
+  // (w)         shape           -> w_shape
+  // (w_shape,y) elementwise_add -> add_out
+  // (x)         shape           -> x_shape       [not a parameter, kept]
+  // (x_shape,y) elementwise_add -> add_out2
+  // (x)         relu            -> relu_out
+  Layers layers;
+  auto* w = layers.data("w", {-1, 4}, true);
+  auto* x = layers.data("x", {2, 3, 4});
+  auto* y = layers.data("y", {3}, false, proto::VarType::INT32);
+  auto* w_shape = layers.shape(w);
+  layers.elementwise_add(w_shape, y);
+  auto* x_shape = layers.shape(x);
+  layers.elementwise_add(x_shape, y);
+  layers.relu(x);
+
+  // the dims come from the tensor, not from the desc
+  auto* scope = new Scope();
+  AddVarToScope(scope, "w", {3, 4});
+  auto graph = ApplyConstantFolding(layers.main_program(), scope);
+
+  EXPECT_EQ(GetNumOpNodes(graph, "shape"), 1);
+  EXPECT_NE(FindVarDesc(graph, "x"), nullptr);
+  auto* w_shape_desc = FindVarDesc(graph, w_shape->Name());
+  ASSERT_NE(w_shape_desc, nullptr);
+  EXPECT_TRUE(w_shape_desc->Persistable());
+  EXPECT_EQ(w_shape_desc->GetDataType(), proto::VarType::INT32);
+  EXPECT_EQ(w_shape_desc->GetShape(), std::vector<int64_t>({2}));
+  EXPECT_FALSE(FindVarDesc(graph, x_shape->Name())->Persistable());
+
+  auto* var = scope->FindVar(w_shape->Name());
+  ASSERT_NE(var, nullptr);
+  const auto& tensor = var->Get<phi::DenseTensor>();
+  ASSERT_EQ(tensor.numel(), 2);
+  EXPECT_EQ(tensor.data<int32_t>()[0], 3);
+  EXPECT_EQ(tensor.data<int32_t>()[1], 4);
+  EXPECT_EQ(scope->FindVar(x_shape->Name()), nullptr);
+}
+
+TEST(ConstantFoldingPass, keep_shape_of_rewritten_param) {
+  // inputs      operator           output
+  // ------------------------------------------------
+  // (w)         shape           -> w_shape
+  // (w_shape,y) elementwise_add -> add_out
+  // (x, y)      elementwise_add -> w             [w has two nodes]
+  Layers layers;
+  auto* w = layers.data("w", {4}, true, proto::VarType::INT32);
+  auto* x = layers.data("x", {4}, false, proto::VarType::INT32);
+  auto* y = layers.data("y", {1}, false, proto::VarType::INT32);
+  auto* w_shape = layers.shape(w);
+  layers.elementwise_add(w_shape, y);
+  layers.elementwise_add(x, y, w);
+
+  auto* scope = new Scope();
+  AddVarToScope(scope, "w", {4});
+  auto graph = ApplyConstantFolding(layers.main_program(), scope);
+
+  EXPECT_EQ(GetNumOpNodes(graph, "shape"), 1);
+  EXPECT_FALSE(FindVarDesc(graph, w_shape->Name())->Persistable());
+  EXPECT_NE(scope->FindVar("w"), nullptr);
+  EXPECT_EQ(scope->FindVar(w_shape->Name()), nullptr);
+}
+
+TEST(ConstantFoldingPass, erase_params) {
+  // inputs       operator           output
+  // ------------------------------------------------
+  // (w0)         shape           -> w0_shape  [w0 read by shape only]
+  // (w1)         shape           -> w1_shape
+  // (x, w1)      matmul_v2       -> matmul_out
+  // (w0_shape,y) elementwise_add -> add_out
+  // (w1_shape,y) elementwise_add -> add_out2
+  Layers layers;
+  auto* x = layers.data("x", {2, 8});
+  auto* y = layers.data("y", {2}, false, proto::VarType::INT32);
+  auto* w0 = layers.data("w0", {4, 8}, true);
+  auto* w1 = layers.data("w1", {8, 2}, true);
+  auto* w0_shape = layers.shape(w0);
+  auto* w1_shape = layers.shape(w1);
+  layers.matmul_v2(x, w1);
+  layers.elementwise_add(w0_shape, y);
+  layers.elementwise_add(w1_shape, y);
+
+  auto* scope = new Scope();
+  AddVarToScope(scope, "w0", {4, 8});
+  AddVarToScope(scope, "w1", {8, 2});
+  auto graph = ApplyConstantFolding(layers.main_program(), scope);
+
+  EXPECT_EQ(GetNumOpNodes(graph, "shape"), 0);
+  // w0 is dropped with its shape op, w1 is still read by matmul_v2
+  EXPECT_EQ(FindVarDesc(graph, "w0"), nullptr);
+  EXPECT_EQ(scope->FindVar("w0"), nullptr);
+  EXPECT_NE(FindVarDesc(graph, "w1"), nullptr);
+  EXPECT_NE(scope->FindVar("w1"), nullptr);
+  EXPECT_NE(scope->FindVar(w0_shape->Name()), nullptr);
+  EXPECT_NE(scope->FindVar(w1_shape->Name()), nullptr);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(constant_folding_pass);
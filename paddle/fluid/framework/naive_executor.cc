@@ -32,6 +32,8 @@
 #include "paddle/fluid/platform/device/gpu/cuda/cuda_profiler.h"
 #endif
 
+DECLARE_bool(executor_var_slots);
+
 namespace paddle {
 namespace framework {
 void NaiveExecutor::Prepare(Scope *scope,
@@ -46,6 +48,11 @@ void NaiveExecutor::Prepare(Scope *scope,
 
   VLOG(3) << "NaiveExecutor init with scope " << scope;
   CreateOps(program_desc, block_id, with_feed_fetch_ops);
+  if (FLAGS_executor_var_slots) {
+    for (auto &op : ops_) {
+      op->PrepareVarSlots(*scope_);
+    }
+  }
 }
 
 void NaiveExecutor::Run() {
@@ -57,6 +64,9 @@ void NaiveExecutor::Run() {
 #ifdef PADDLE_WITH_INFERENCE_NVTX
   platform::CudaNvtxRangePush("model", platform::NvtxRangeColor::Yellow);
 #endif
+  if (FLAGS_executor_var_slots) {
+    scope_->RefreshSlotVars();
+  }
   for (auto &op : ops_) {
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
@@ -25,6 +25,7 @@
 #include "paddle/fluid/platform/device/gpu/gpu_info.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
+#include "paddle/fluid/platform/profiler/mem_tracing.h"
 #include "paddle/fluid/platform/profiler/supplement_tracing.h"
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/kernel_context.h"
@@ -981,6 +982,24 @@ void InterpreterCore::RunOperator(const Instruction& instr_node) {
   }
 }
 
+void InterpreterCore::RecordOutputMemVarNames(const Instruction& instr_node) {
+  Scope* local_scope = HasLocalScope() ? var_scope_.GetMutableLocalScope()
+                                       : var_scope_.GetMutableScope();
+  for (auto& var_name_item : instr_node.Outputs()) {
+    for (auto& id : var_name_item.second) {
+      const std::string& name = var_scope_.GetNameById(id);
+      auto* var = local_scope->FindVar(name);
+      if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+        continue;
+      }
+      const auto& tensor = var->Get<phi::DenseTensor>();
+      if (tensor.IsInitialized()) {
+        platform::RecordMemVarName(tensor.Holder()->ptr(), name);
+      }
+    }
+  }
+}
+
 void InterpreterCore::RunInstruction(const Instruction& instr_node) {
   VLOG(5) << __func__ << " OP id:" << instr_node.Id()
           << " name:" << instr_node.OpBase()->Type() << " type:"
@@ -994,6 +1013,7 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
   auto* op = instr_node.OpBase();
   platform::RecordEvent instruction_event(
       op->Type(), platform::TracerEventType::Operator, 1);
+  platform::RecordMemOwner mem_owner(op->Type());
 
   SetDeviceId(instr_node.DeviceContext().GetPlace());
 
@@ -1002,6 +1022,9 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
 
     if (!instr_node.IsArtificial()) {
       RunOperator(instr_node);
+      if (platform::RecordMemEvent::IsEnabled()) {
+        RecordOutputMemVarNames(instr_node);
+      }
       CheckGC(instr_node);
       interpreter::LogDeviceMemoryStats(place_);
     }
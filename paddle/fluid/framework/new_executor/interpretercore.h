@@ -110,6 +110,8 @@ class InterpreterCore {
   void RunNextInstructions(const Instruction& instr_id,
                            SchedulingQueue* reserved_next_ops);
   void RunOperator(const Instruction& instr_node);
+  // name the memory held by the outputs for memory profiling
+  void RecordOutputMemVarNames(const Instruction& instr_node);
   // Trace
   void TraceInstructionList(const std::vector<Instruction>& vec_instr);
 
@@ -214,6 +214,31 @@ RuntimeContext::RuntimeContext(const VariableNameMap& innames,
   }
 }
 
+RuntimeContext::RuntimeContext(const VariableNameMap& innames,
+                               const VariableNameMap& outnames,
+                               const std::vector<std::vector<int>>& in_slots,
+                               const std::vector<std::vector<int>>& out_slots,
+                               Variable* const* slot_vars) {
+  size_t i = 0;
+  for (auto& var_name_item : innames) {
+    std::vector<Variable*>& input_vars = inputs[var_name_item.first];
+    input_vars.reserve(in_slots[i].size());
+    for (int slot : in_slots[i]) {
+      input_vars.push_back(slot_vars[slot]);
+    }
+    ++i;
+  }
+  i = 0;
+  for (auto& var_name_item : outnames) {
+    std::vector<Variable*>& output_vars = outputs[var_name_item.first];
+    output_vars.reserve(out_slots[i].size());
+    for (int slot : out_slots[i]) {
+      output_vars.push_back(slot_vars[slot]);
+    }
+    ++i;
+  }
+}
+
 RuntimeInferShapeContext::RuntimeInferShapeContext(const OperatorBase& op,
                                                    const RuntimeContext& ctx)
     : op_(op), ctx_(ctx) {}
@@ -975,6 +1000,24 @@ OperatorBase::OperatorBase(const std::string& type,
   }
 }
 
+void OperatorBase::PrepareVarSlots(const Scope& scope) {
+  auto resolve = [&scope](const VariableNameMap& names,
+                          std::vector<std::vector<int>>* slots) {
+    slots->clear();
+    slots->reserve(names.size());
+    for (auto& var_name_item : names) {
+      slots->emplace_back();
+      slots->back().reserve(var_name_item.second.size());
+      for (auto& var_name : var_name_item.second) {
+        slots->back().push_back(scope.VarSlot(var_name));
+      }
+    }
+  };
+  resolve(inputs_, &input_var_slots_);
+  resolve(outputs_, &output_var_slots_);
+  var_slots_scope_id_ = scope.Id();
+}
+
 std::vector<std::string> OperatorBase::InputVars() const {
   std::vector<std::string> ret_val;
   for (auto& o : inputs_) {
@@ -1632,8 +1675,16 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   const Scope* cur_scope = &scope;
   CheckWhetherPreparePhiData(Inputs(), Outputs(), scope);
   if (!enable_cache_runtime_context_) {
-    RuntimeContext ctx(Inputs(), Outputs(), scope);
-    RunImpl(scope, place, &ctx);
+    Variable* const* slot_vars =
+        HasVarSlots(scope) ? scope.SlotVars() : nullptr;
+    if (slot_vars != nullptr) {
+      RuntimeContext ctx(
+          Inputs(), Outputs(), input_var_slots_, output_var_slots_, slot_vars);
+      RunImpl(scope, place, &ctx);
+    } else {
+      RuntimeContext ctx(Inputs(), Outputs(), scope);
+      RunImpl(scope, place, &ctx);
+    }
   } else if (run_phi_kernel_ && impl_ != nullptr && !need_prepare_data_ &&
              !need_prepare_phi_data_) {
     if (!all_kernels_must_compute_runtime_shape_ && impl_->NeedInferShape()) {
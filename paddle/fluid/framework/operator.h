@@ -142,6 +142,15 @@ class RuntimeContext {
                  const VariableValueMap& outvars)
       : inputs(invars), outputs(outvars) {}
 
+  // Fetch the variables from slot_vars, the Scope::SlotVars of the scope the
+  // slots are resolved in by OperatorBase::PrepareVarSlots. in_slots and
+  // out_slots follow the order of innames and outnames.
+  RuntimeContext(const VariableNameMap& innames,
+                 const VariableNameMap& outnames,
+                 const std::vector<std::vector<int>>& in_slots,
+                 const std::vector<std::vector<int>>& out_slots,
+                 Variable* const* slot_vars);
+
   VariableValueMap inputs;
   VariableValueMap outputs;
 };
@@ -321,8 +330,14 @@ class OperatorBase {
 
   const VariableNameMap& Inputs() const { return inputs_; }
   const VariableNameMap& Outputs() const { return outputs_; }
-  VariableNameMap& Inputs() { return inputs_; }
-  VariableNameMap& Outputs() { return outputs_; }
+  VariableNameMap& Inputs() {
+    var_slots_scope_id_ = 0;
+    return inputs_;
+  }
+  VariableNameMap& Outputs() {
+    var_slots_scope_id_ = 0;
+    return outputs_;
+  }
 
   const OpInfo& Info() const {
     PADDLE_ENFORCE_NOT_NULL(
@@ -364,6 +379,17 @@ class OperatorBase {
 
   void SetId(uint64_t id) { id_ = id; }
 
+  /// Resolve the input and output variable names to slots of scope once, so
+  /// the following runs in the same scope fetch variables by index after
+  /// Scope::RefreshSlotVars. The slots are not used when running in another
+  /// scope and are dropped by changing the inputs or outputs, call it again
+  /// after that.
+  void PrepareVarSlots(const Scope& scope);
+
+  bool HasVarSlots(const Scope& scope) const {
+    return var_slots_scope_id_ == scope.Id();
+  }
+
  protected:
   std::string type_;
   // NOTE: in case of OpGrad, inputs_ contains:
@@ -392,6 +418,11 @@ class OperatorBase {
   // Whether this operator executes in an Executor.
   bool run_by_executor_{true};
 
+  // Id of the scope the slots are resolved in, 0 if not resolved.
+  uint64_t var_slots_scope_id_{0};
+  std::vector<std::vector<int>> input_var_slots_;
+  std::vector<std::vector<int>> output_var_slots_;
+
  private:
   void GenerateTemporaryNames();
   void CheckAllInputOutputSet() const;
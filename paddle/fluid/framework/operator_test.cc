@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 #include "paddle/fluid/framework/operator.h"
 
+#include <chrono>
+
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_registry.h"
@@ -689,3 +691,158 @@ TEST(OpWithoutUnusedVar, all) {
   ASSERT_NO_THROW(op->Run(scope, cpu_place));
   FLAGS_enable_unused_var_check = false;
 }
+
+namespace paddle {
+namespace framework {
+
+class OpWithVarSlotsProtoAndCheckerMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "input of test op");
+    AddInput("Bias", "bias of test op").AsDuplicable();
+    AddOutput("Y", "output of test op");
+    AddComment("This is test op, Y = X + sum(Bias).");
+  }
+};
+
+class CPUKernelWithVarSlotsTest : public OpKernel<float> {
+ public:
+  void Compute(const ExecutionContext& ctx) const {
+    auto* x = ctx.Input<phi::DenseTensor>("X");
+    auto biases = ctx.MultiInput<phi::DenseTensor>("Bias");
+    auto* y = ctx.Output<phi::DenseTensor>("Y");
+    float value = x->data<float>()[0];
+    for (auto* bias : biases) {
+      value += bias->data<float>()[0];
+    }
+    y->Resize({1});
+    y->mutable_data<float>(ctx.GetPlace())[0] = value;
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(
+    op_with_var_slots,
+    paddle::framework::OpWithKernelTest,
+    paddle::framework::OpWithVarSlotsProtoAndCheckerMaker);
+REGISTER_OP_CPU_KERNEL(op_with_var_slots,
+                       paddle::framework::CPUKernelWithVarSlotsTest);
+
+// A chain of tiny ops x0 -> x1 -> ... -> x{op_num}, every op adds two
+// biases of the parent scope, so the time of a run is dominated by the
+// per-op overhead.
+static std::vector<std::unique_ptr<paddle::framework::OperatorBase>>
+BuildVarSlotsOps(paddle::framework::Scope* scope, int op_num) {
+  paddle::platform::CPUPlace cpu_place;
+  auto* parent = const_cast<paddle::framework::Scope*>(scope->parent());
+  for (const char* name : {"bias0", "bias1"}) {
+    auto* bias = parent->Var(name)->GetMutable<phi::DenseTensor>();
+    bias->Resize({1});
+    bias->mutable_data<float>(cpu_place)[0] = 1.0f;
+  }
+  // unrelated variables make the scope as large as a real model's
+  for (int i = 0; i < 10 * op_num; ++i) {
+    parent->Var("param" + std::to_string(i));
+  }
+  auto* x0 = scope->Var("x0")->GetMutable<phi::DenseTensor>();
+  x0->Resize({1});
+  x0->mutable_data<float>(cpu_place)[0] = 0.0f;
+
+  std::vector<std::unique_ptr<paddle::framework::OperatorBase>> ops;
+  for (int i = 0; i < op_num; ++i) {
+    std::string x = "x" + std::to_string(i);
+    std::string y = "x" + std::to_string(i + 1);
+    scope->Var(y)->GetMutable<phi::DenseTensor>();
+    paddle::framework::proto::OpDesc op_desc;
+    op_desc.set_type("op_with_var_slots");
+    BuildVar("X", {x.c_str()}, op_desc.add_inputs());
+    BuildVar("Bias", {"bias0", "bias1"}, op_desc.add_inputs());
+    BuildVar("Y", {y.c_str()}, op_desc.add_outputs());
+    ops.emplace_back(paddle::framework::OpRegistry::CreateOp(op_desc));
+  }
+  return ops;
+}
+
+TEST(OpWithVarSlots, all) {
+  paddle::framework::InitDevices();
+  paddle::platform::CPUPlace cpu_place;
+  paddle::framework::Scope parent;
+  auto& scope = parent.NewScope();
+  auto ops = BuildVarSlotsOps(&scope, 10);
+  for (auto& op : ops) {
+    op->PrepareVarSlots(scope);
+    ASSERT_TRUE(op->HasVarSlots(scope));
+    ASSERT_FALSE(op->HasVarSlots(parent));
+  }
+  scope.RefreshSlotVars();
+  ASSERT_NE(scope.SlotVars(), nullptr);
+  for (auto& op : ops) {
+    op->Run(scope, cpu_place);
+  }
+  ASSERT_EQ(scope.FindVar("x10")->Get<phi::DenseTensor>().data<float>()[0],
+            20.0f);
+
+  // a bias shadowed in the scope after the slots are looked up, the ops
+  // look up their variables by name until the slots are refreshed
+  auto* bias = scope.Var("bias1")->GetMutable<phi::DenseTensor>();
+  bias->Resize({1});
+  bias->mutable_data<float>(cpu_place)[0] = 2.0f;
+  ASSERT_EQ(scope.SlotVars(), nullptr);
+  for (auto& op : ops) {
+    op->Run(scope, cpu_place);
+  }
+  ASSERT_EQ(scope.FindVar("x10")->Get<phi::DenseTensor>().data<float>()[0],
+            30.0f);
+  scope.RefreshSlotVars();
+  ASSERT_NE(scope.SlotVars(), nullptr);
+  for (auto& op : ops) {
+    op->Run(scope, cpu_place);
+  }
+  ASSERT_EQ(scope.FindVar("x10")->Get<phi::DenseTensor>().data<float>()[0],
+            40.0f);
+
+  // the slots of another scope are not used
+  auto& other = parent.NewScope();
+  BuildVarSlotsOps(&other, 10);
+  for (auto& op : ops) {
+    ASSERT_FALSE(op->HasVarSlots(other));
+    op->Run(other, cpu_place);
+  }
+  ASSERT_EQ(other.FindVar("x10")->Get<phi::DenseTensor>().data<float>()[0],
+            20.0f);
+}
+
+TEST(OpWithVarSlots, benchmark) {
+  paddle::framework::InitDevices();
+  paddle::platform::CPUPlace cpu_place;
+  constexpr int kOpNum = 1000;
+  constexpr int kRepeat = 20;
+  paddle::framework::Scope parent;
+  auto& scope = parent.NewScope();
+  auto ops = BuildVarSlotsOps(&scope, kOpNum);
+
+  // a run refreshes the slots once, as the executors do
+  auto run = [&] {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepeat; ++i) {
+      scope.RefreshSlotVars();
+      for (auto& op : ops) {
+        op->Run(scope, cpu_place);
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() /
+           (kRepeat * kOpNum);
+  };
+  double by_name = run();
+  for (auto& op : ops) {
+    op->PrepareVarSlots(scope);
+  }
+  double by_slot = run();
+  const auto& y = scope.FindVar("x1000")->Get<phi::DenseTensor>();
+  ASSERT_EQ(y.data<float>()[0], 2.0f * kOpNum);
+  std::cout << "Per-op overhead of " << kOpNum << " tiny ops, lookup by name: "
+            << by_name << " us, by slot: " << by_slot << " us" << std::endl;
+}
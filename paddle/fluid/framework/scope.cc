@@ -33,6 +33,23 @@ PADDLE_DEFINE_EXPORTED_bool(
 namespace paddle {
 namespace framework {
 
+static uint64_t NewScopeId() {
+  static std::atomic<uint64_t> next_id{1};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Bumped whenever a variable is created, erased or renamed in any scope, so
+// a single load tells whether the slot variables of a scope may be stale.
+static std::atomic<uint64_t> vars_version{1};
+
+static void BumpVarsVersion() {
+  vars_version.fetch_add(1, std::memory_order_release);
+}
+
+Scope::Scope() : id_(NewScopeId()) {}
+
+Scope::Scope(Scope const* parent) : parent_(parent), id_(NewScopeId()) {}
+
 Scope::~Scope() { DropKids(); }
 
 Scope& Scope::NewScope() const {
@@ -167,6 +184,7 @@ void Scope::EraseVars(const std::vector<std::string>& var_names) {
     for (auto it = vars_.begin(); it != vars_.end();) {
       if (var_set.find(it->first) != var_set.end()) {
         it = vars_.erase(it);
+        BumpVarsVersion();
       } else {
         ++it;
       }
@@ -196,6 +214,7 @@ Variable* Scope::VarInternal(const std::string& name) {
   if (v != nullptr) return v;
   v = new Variable();
   vars_.emplace(name, std::unique_ptr<Variable>(v));
+  BumpVarsVersion();
   VLOG(3) << "Create variable " << name;
   return v;
 }
@@ -233,6 +252,7 @@ void Scope::RenameInternal(const std::string& origin_name,
           "The variable with name %s already exists in the scope.", new_name));
   vars_[new_name].reset(origin_it->second.release());
   vars_.erase(origin_it);
+  BumpVarsVersion();
 }
 
 Variable* Scope::FindVarInternal(const std::string& name) const {
@@ -258,10 +278,48 @@ void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
       ++iter;
     } else {
       vars_.erase(iter++);
+      BumpVarsVersion();
     }
   }
 }
 
+int Scope::VarSlot(const std::string& name) const {
+  std::lock_guard<std::mutex> guard(var_slots_mutex_);
+  auto it = var_slot_index_.find(name);
+  if (it != var_slot_index_.end()) {
+    return it->second;
+  }
+  int slot = static_cast<int>(var_slot_names_.size());
+  var_slot_index_.emplace(name, slot);
+  var_slot_names_.push_back(name);
+  // RefreshSlotVars looks up the new slot together with the others
+  slot_vars_version_.store(0, std::memory_order_release);
+  slot_vars_.push_back(nullptr);
+  return slot;
+}
+
+void Scope::RefreshSlotVars() const {
+  std::lock_guard<std::mutex> guard(var_slots_mutex_);
+  // read before the lookups, so a variable changed meanwhile makes the
+  // slots stale
+  uint64_t version = vars_version.load(std::memory_order_acquire);
+  if (version == slot_vars_version_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  for (size_t i = 0; i < var_slot_names_.size(); ++i) {
+    slot_vars_[i] = FindVar(var_slot_names_[i]);
+  }
+  slot_vars_version_.store(version, std::memory_order_release);
+}
+
+Variable* const* Scope::SlotVars() const {
+  if (slot_vars_version_.load(std::memory_order_acquire) !=
+      vars_version.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return slot_vars_.data();
+}
+
 std::string GenScopeTreeDebugInfo(Scope* root) {
   std::stringstream os;
 
@@ -18,8 +18,10 @@ extern "C" {
 #include <xxhash.h>
 }
 
+#include <atomic>
 #include <list>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -48,7 +50,7 @@ namespace framework {
  */
 class Scope {
  public:
-  Scope() {}
+  Scope();
   ~Scope();
 
   /// Create a sub-scope. Returns a reference other than a pointer so
@@ -126,6 +128,28 @@ class Scope {
 
   void SetCanReuesd(bool can_reused) { can_reused_ = can_reused; }
 
+  /// Process-unique id of the scope, never reused by another scope even if
+  /// it is allocated at the same address.
+  uint64_t Id() const { return id_; }
+
+  /// Resolve a variable name to a stable slot index of this scope. The
+  /// variable of the slot is looked up in this scope and its ancestors, the
+  /// same as FindVar, and may be nullptr. Resolving the same name again
+  /// returns the same slot. Slots are resolved when ops are prepared, not
+  /// while ops run in this scope, since it invalidates SlotVars.
+  int VarSlot(const std::string& name) const;
+
+  /// Look up the variables of all resolved slots again if a variable has
+  /// been created, erased or renamed since the last refresh. Executors call
+  /// it once per run, before running the prepared ops.
+  void RefreshSlotVars() const;
+
+  /// Variables of all resolved slots as of the last RefreshSlotVars,
+  /// indexed by slot, or nullptr if they may be stale, in which case ops
+  /// look up their variables by name. It takes no lock, so ops running in
+  /// this scope check it on every run.
+  Variable* const* SlotVars() const;
+
  protected:
   struct KeyHasher {
     std::size_t operator()(const std::string& key) const {
@@ -138,7 +162,7 @@ class Scope {
 
  private:
   // Call Scope::NewScope for a sub-scope.
-  explicit Scope(Scope const* parent) : parent_(parent) {}
+  explicit Scope(Scope const* parent);
 
   // Called by Var.
   Variable* VarInternal(const std::string& name);
@@ -166,6 +190,16 @@ class Scope {
   // only for dygraph_to_static
   bool can_reused_{false};
 
+  uint64_t id_;
+
+  mutable std::unordered_map<std::string, int, KeyHasher> var_slot_index_;
+  mutable std::vector<std::string> var_slot_names_;
+  mutable std::vector<Variable*> slot_vars_;
+  // version of the variables of all scopes slot_vars_ was looked up at, 0 if
+  // it was never looked up or new slots were resolved since
+  mutable std::atomic<uint64_t> slot_vars_version_{0};
+  mutable std::mutex var_slots_mutex_;
+
   DISABLE_COPY_AND_ASSIGN(Scope);
 
  private:
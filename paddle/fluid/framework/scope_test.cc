@@ -14,6 +14,9 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/scope.h"
 
+#include <string>
+#include <thread>  // NOLINT
+
 #include "gtest/gtest.h"
 
 namespace paddle {
@@ -77,3 +80,75 @@ TEST(Scope, GetAllNames) {
 
   EXPECT_STREQ("a", str.c_str());
 }
+
+TEST(Scope, VarSlot) {
+  Scope s;
+  Scope& ss = s.NewScope();
+  Variable* a = s.Var("a");
+
+  int slot_a = ss.VarSlot("a");
+  int slot_b = ss.VarSlot("b");
+  EXPECT_NE(slot_a, slot_b);
+  EXPECT_EQ(slot_a, ss.VarSlot("a"));
+  // not looked up yet
+  EXPECT_EQ(nullptr, ss.SlotVars());
+  ss.RefreshSlotVars();
+  ASSERT_NE(nullptr, ss.SlotVars());
+  EXPECT_EQ(a, ss.SlotVars()[slot_a]);
+  EXPECT_EQ(nullptr, ss.SlotVars()[slot_b]);
+
+  // variables created after the slots are looked up
+  Variable* b = s.Var("b");
+  EXPECT_EQ(nullptr, ss.SlotVars());
+  ss.RefreshSlotVars();
+  EXPECT_EQ(b, ss.SlotVars()[slot_b]);
+  Variable* local_a = ss.Var("a");
+  ss.RefreshSlotVars();
+  EXPECT_EQ(local_a, ss.SlotVars()[slot_a]);
+
+  ss.EraseVars({"a"});
+  EXPECT_EQ(nullptr, ss.SlotVars());
+  ss.RefreshSlotVars();
+  EXPECT_EQ(a, ss.SlotVars()[slot_a]);
+  s.Rename("b", "c");
+  int slot_c = ss.VarSlot("c");
+  EXPECT_EQ(nullptr, ss.SlotVars());
+  ss.RefreshSlotVars();
+  EXPECT_EQ(nullptr, ss.SlotVars()[slot_b]);
+  EXPECT_EQ(b, ss.SlotVars()[slot_c]);
+}
+
+TEST(Scope, VarSlotConcurrent) {
+  // variables are created in another scope while the slots are refreshed
+  // and read, the slots read are never stale
+  Scope s;
+  Scope other;
+  const int slot_num = 100;
+  for (int i = 0; i < slot_num; ++i) {
+    s.Var("v" + std::to_string(i));
+    s.VarSlot("v" + std::to_string(i));
+  }
+  std::thread creator([&other] {
+    for (int i = 0; i < 10000; ++i) {
+      other.Var("w" + std::to_string(i));
+    }
+  });
+  for (int i = 0; i < 1000; ++i) {
+    s.RefreshSlotVars();
+    Variable* const* slot_vars = s.SlotVars();
+    if (slot_vars == nullptr) continue;
+    for (int j = 0; j < slot_num; ++j) {
+      EXPECT_EQ(s.FindVar("v" + std::to_string(j)), slot_vars[j]);
+    }
+  }
+  creator.join();
+  s.RefreshSlotVars();
+  EXPECT_NE(nullptr, s.SlotVars());
+}
+
+TEST(Scope, Id) {
+  Scope s;
+  std::unique_ptr<Scope> tmp = s.NewTmpScope();
+  EXPECT_NE(s.Id(), s.NewScope().Id());
+  EXPECT_NE(s.Id(), tmp->Id());
+}
@@ -23,11 +23,13 @@
 #include "paddle/fluid/imperative/execution_context.h"
 #include "paddle/fluid/imperative/layout_autotune.h"
 #include "paddle/fluid/imperative/op_base.h"
+#include "paddle/fluid/imperative/var_helper.h"
 #include "paddle/fluid/operators/ops_extra_info.h"
 #include "paddle/fluid/platform/denormal.h"
 #include "paddle/fluid/platform/device/device_wrapper.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
+#include "paddle/fluid/platform/profiler/mem_tracing.h"
 #include "paddle/fluid/string/string_helper.h"
 #include "paddle/phi/common/place.h"
 
@@ -222,6 +224,7 @@ void Tracer::TraceOpImpl(const std::string& type,
                          bool use_default_attr_map) {
   platform::RecordEvent op_type_record_event(
       type, platform::TracerEventType::Operator, 1);
+  platform::RecordMemOwner mem_owner(type);
   platform::ScopedFlushDenormal flush;
   VLOG(4) << "Trace Op: " << type;
   if (FLAGS_use_mkldnn) {
@@ -357,6 +360,21 @@ void Tracer::TraceOpImpl(const std::string& type,
         "Operator %s raises an unknown exception.", type));
   }
 
+  if (platform::RecordMemEvent::IsEnabled()) {
+    for (auto& pair : outs) {
+      for (auto& var : pair.second) {
+        if (var == nullptr || !var->Var().template IsType<phi::DenseTensor>()) {
+          continue;
+        }
+        const auto& tensor = var->Var().template Get<phi::DenseTensor>();
+        if (tensor.IsInitialized()) {
+          platform::RecordMemVarName(tensor.Holder()->ptr(),
+                                     GetNameFromVar(var));
+        }
+      }
+    }
+  }
+
   if (enable_program_desc_tracing_) {
     VLOG(5) << "Trace op " << type << " into ProgramDesc";
     program_desc_tracer_->InsertOp(type, new_ins, outs, attrs);
@@ -2309,32 +2309,37 @@ std::string AnalysisPredictor::GetSerializedProgram() const {
 
 // Add SaveOptimModel
 void AnalysisPredictor::SaveOptimModel(const std::string &dir) {
+  // drop the weights no op uses and save the duplicated ones once, on a copy
+  // of the program so the running one is not changed
+  framework::ProgramDesc optim_program(*inference_program_->Proto());
+  inference::ModelShrinkStats stats;
+  std::vector<std::string> save_var_list =
+      inference::ShrinkModelWeights(&optim_program, *scope(), &stats);
+  LOG(INFO) << "Save the optimized model with " << save_var_list.size()
+            << " of " << stats.params_num << " parameters, "
+            << stats.pruned_num << " unused and " << stats.deduplicated_num
+            << " duplicated ones removed, " << stats.bytes_before << " -> "
+            << stats.bytes_after << " bytes";
+
   // save model
   std::string model_name = dir + "/model";
   std::ofstream outfile;
   outfile.open(model_name, std::ios::out | std::ios::binary);
-  std::string inference_prog_desc = GetSerializedProgram();
-  outfile << inference_prog_desc;
+  outfile << optim_program.Proto()->SerializeAsString();
   // save params
   framework::ProgramDesc save_program;
   auto *save_block = save_program.MutableBlock(0);
 
-  const framework::ProgramDesc &main_program = program();
-  const framework::BlockDesc &global_block = main_program.Block(0);
-  std::vector<std::string> save_var_list;
-  for (framework::VarDesc *var : global_block.AllVars()) {
-    if (IsPersistable(var)) {
-      framework::VarDesc *new_var = save_block->Var(var->Name());
-      new_var->SetShape(var->GetShape());
-      new_var->SetDataType(var->GetDataType());
-      new_var->SetType(var->GetType());
-      new_var->SetLoDLevel(var->GetLoDLevel());
-      new_var->SetPersistable(true);
-
-      save_var_list.push_back(new_var->Name());
-    }
+  const framework::BlockDesc &global_block = optim_program.Block(0);
+  for (auto &name : save_var_list) {
+    framework::VarDesc *var = global_block.FindVar(name);
+    framework::VarDesc *new_var = save_block->Var(name);
+    new_var->SetShape(var->GetShape());
+    new_var->SetDataType(var->GetDataType());
+    new_var->SetType(var->GetType());
+    new_var->SetLoDLevel(var->GetLoDLevel());
+    new_var->SetPersistable(true);
   }
-  std::sort(save_var_list.begin(), save_var_list.end());
   auto *op = save_block->AppendOp();
   op->SetType("save_combine");
   op->SetInput("X", save_var_list);
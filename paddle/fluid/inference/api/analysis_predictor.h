@@ -321,7 +321,8 @@ class AnalysisPredictor : public PaddlePredictor {
   bool MkldnnQuantize();
 
   ///
-  /// \brief save program to model and save parameters to params
+  /// \brief save program to model and save parameters to params, without
+  /// the parameters no op uses and with a single copy of duplicated ones
   ///
   /// \param[in] dir path to save the model
   ///
@@ -13,8 +13,15 @@
 // limitations under the License.
 
 #include "paddle/fluid/inference/utils/model_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <set>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/var_type_inference.h"
 #include "paddle/phi/common/data_type.h"
 
@@ -70,5 +77,182 @@ phi::DataType GetModelPrecision(const framework::ProgramDesc& program) {
   return ret;
 }
 
+namespace {
+
+bool IsPersistable(const framework::VarDesc* var) {
+  return var->Persistable() && var->GetType() != VarType::FEED_MINIBATCH &&
+         var->GetType() != VarType::FETCH_LIST &&
+         var->GetType() != VarType::RAW;
+}
+
+// The initialized dense tensor of a weight on CPU, or nullptr.
+const phi::DenseTensor* FindCPUTensor(const framework::Scope& scope,
+                                      const std::string& name) {
+  auto* var = scope.FindVar(name);
+  if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+    return nullptr;
+  }
+  const auto& tensor = var->Get<phi::DenseTensor>();
+  if (!tensor.initialized() || !platform::is_cpu_place(tensor.place())) {
+    return nullptr;
+  }
+  return &tensor;
+}
+
+int64_t TensorBytes(const phi::DenseTensor& tensor) {
+  return tensor.numel() * static_cast<int64_t>(phi::SizeOf(tensor.dtype()));
+}
+
+// FNV-1a over the 8-byte words of data, then over the remaining bytes.
+uint64_t HashBytes(const void* data, size_t size) {
+  constexpr uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  const char* bytes = static_cast<const char*>(data);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(bytes[i])) * kPrime;
+  }
+  return hash;
+}
+
+}  // namespace
+
+std::vector<std::string> ShrinkModelWeights(framework::ProgramDesc* program,
+                                            const framework::Scope& scope,
+                                            ModelShrinkStats* stats) {
+  PADDLE_ENFORCE_NOT_NULL(
+      program,
+      platform::errors::InvalidArgument("The program to shrink is nullptr."));
+  PADDLE_ENFORCE_NOT_NULL(
+      stats,
+      platform::errors::InvalidArgument("The shrink stats are nullptr."));
+  *stats = ModelShrinkStats();
+
+  // the variables the ops read or write, and the ones named by attributes,
+  // e.g. the parameters of tensorrt_engine, which must keep their names
+  std::unordered_set<std::string> used;
+  std::unordered_set<std::string> written;
+  std::unordered_set<std::string> named_by_attrs;
+  for (size_t i = 0; i < program->Size(); ++i) {
+    for (auto* op : program->Block(i).AllOps()) {
+      for (auto& name : op->InputArgumentNames()) {
+        used.insert(name);
+      }
+      for (auto& name : op->OutputArgumentNames()) {
+        used.insert(name);
+        written.insert(name);
+      }
+      for (auto& attr_name : op->AttrNames()) {
+        auto attr_type = op->GetAttrType(attr_name);
+        if (attr_type == framework::proto::AttrType::STRING) {
+          named_by_attrs.insert(
+              PADDLE_GET_CONST(std::string, op->GetAttr(attr_name)));
+        } else if (attr_type == framework::proto::AttrType::STRINGS) {
+          for (auto& name : PADDLE_GET_CONST(std::vector<std::string>,
+                                             op->GetAttr(attr_name))) {
+            named_by_attrs.insert(name);
+          }
+        }
+      }
+    }
+  }
+
+  auto* block = program->MutableBlock(0);
+  std::vector<std::string> params;
+  std::vector<std::string> pruned;
+  for (auto* var : block->AllVars()) {
+    if (!IsPersistable(var)) continue;
+    const auto& name = var->Name();
+    auto* tensor = FindCPUTensor(scope, name);
+    if (tensor != nullptr) {
+      stats->bytes_before += TensorBytes(*tensor);
+    }
+    if (used.count(name) || named_by_attrs.count(name)) {
+      params.push_back(name);
+    } else {
+      pruned.push_back(name);
+    }
+  }
+  stats->params_num = params.size() + pruned.size();
+  stats->pruned_num = pruned.size();
+  std::sort(params.begin(), params.end());
+
+  // weights grouped by data type, dims and a hash of their contents, with
+  // the first of every group in name order kept
+  using WeightKey = std::tuple<int, std::string, uint64_t>;
+  std::map<WeightKey, std::vector<const std::string*>> groups;
+  std::unordered_map<std::string, std::string> duplicate_of;
+  for (auto& name : params) {
+    auto* var = block->FindVar(name);
+    auto* tensor = FindCPUTensor(scope, name);
+    if (var->GetType() != VarType::LOD_TENSOR || tensor == nullptr ||
+        written.count(name) || named_by_attrs.count(name) ||
+        !tensor->lod().empty()) {
+      continue;
+    }
+    size_t bytes = TensorBytes(*tensor);
+    WeightKey key(static_cast<int>(tensor->dtype()),
+                  tensor->dims().to_str(),
+                  HashBytes(tensor->data(), bytes));
+    auto& group = groups[key];
+    auto same = std::find_if(
+        group.begin(), group.end(), [&](const std::string* kept) {
+          return std::memcmp(FindCPUTensor(scope, *kept)->data(),
+                             tensor->data(),
+                             bytes) == 0;
+        });
+    if (same == group.end()) {
+      group.push_back(&name);
+    } else {
+      duplicate_of[name] = **same;
+    }
+  }
+  stats->deduplicated_num = duplicate_of.size();
+  if (!duplicate_of.empty()) {
+    for (size_t i = 0; i < program->Size(); ++i) {
+      for (auto* op : program->MutableBlock(i)->AllOps()) {
+        for (auto& name : op->InputArgumentNames()) {
+          auto it = duplicate_of.find(name);
+          if (it != duplicate_of.end()) {
+            op->RenameInput(name, it->second);
+          }
+        }
+      }
+    }
+  }
+
+  // RemoveVar does not mark the block for update, so the variables are
+  // dropped from its proto as well
+  std::unordered_set<std::string> removed(pruned.begin(), pruned.end());
+  for (auto& dup : duplicate_of) {
+    removed.insert(dup.first);
+  }
+  for (auto& name : removed) {
+    block->RemoveVar(name);
+  }
+  auto* vars = block->Proto()->mutable_vars();
+  for (int i = vars->size() - 1; i >= 0; --i) {
+    if (removed.count(vars->Get(i).name())) {
+      vars->DeleteSubrange(i, 1);
+    }
+  }
+
+  std::vector<std::string> kept;
+  for (auto& name : params) {
+    if (duplicate_of.count(name)) continue;
+    kept.push_back(name);
+    auto* tensor = FindCPUTensor(scope, name);
+    if (tensor != nullptr) {
+      stats->bytes_after += TensorBytes(*tensor);
+    }
+  }
+  return kept;
+}
+
 }  // namespace inference
 }  // namespace paddle
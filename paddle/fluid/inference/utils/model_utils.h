@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
 #include "paddle/phi/common/data_type.h"
 
 namespace paddle {
@@ -27,5 +28,25 @@ namespace inference {
 // Get all model's weights and return the data_type, e.g., fp16/bf16 or fp32.
 phi::DataType GetModelPrecision(const framework::ProgramDesc& program);
 
+// What ShrinkModelWeights removed from a model.
+struct ModelShrinkStats {
+  size_t params_num{0};
+  // persistable variables no op reads or writes
+  size_t pruned_num{0};
+  // weights with the same contents as another one
+  size_t deduplicated_num{0};
+  int64_t bytes_before{0};
+  int64_t bytes_after{0};
+};
+
+// Remove the persistable variables of program that no op reads or writes,
+// and let the ops read a single copy of the weights with the same data type,
+// dims and contents, so they are saved once. The weights are read from
+// scope, which is not modified. Returns the sorted names of the persistable
+// variables left in program, which are the ones to save.
+std::vector<std::string> ShrinkModelWeights(framework::ProgramDesc* program,
+                                            const framework::Scope& scope,
+                                            ModelShrinkStats* stats);
+
 }  // namespace inference
 }  // namespace paddle
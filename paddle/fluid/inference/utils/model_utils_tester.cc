@@ -0,0 +1,144 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/inference/utils/model_utils.h"
+
+namespace paddle {
+namespace inference {
+namespace {
+
+void AddWeight(framework::ProgramDesc* program,
+               framework::Scope* scope,
+               const std::string& name,
+               const std::vector<float>& values) {
+  auto* var = program->MutableBlock(0)->Var(name);
+  var->SetType(framework::proto::VarType::LOD_TENSOR);
+  var->SetDataType(framework::proto::VarType::FP32);
+  var->SetShape({static_cast<int64_t>(values.size())});
+  var->SetPersistable(true);
+  auto* tensor = scope->Var(name)->GetMutable<phi::DenseTensor>();
+  tensor->Resize({static_cast<int64_t>(values.size())});
+  float* data = tensor->mutable_data<float>(platform::CPUPlace());
+  std::copy(values.begin(), values.end(), data);
+}
+
+framework::OpDesc* AddOp(framework::ProgramDesc* program,
+                         const std::string& type,
+                         const std::vector<std::string>& inputs,
+                         const std::vector<std::string>& outputs) {
+  auto* block = program->MutableBlock(0);
+  for (auto& name : inputs) block->Var(name);
+  for (auto& name : outputs) block->Var(name);
+  auto* op = block->AppendOp();
+  op->SetType(type);
+  op->SetInput("X", inputs);
+  op->SetOutput("Out", outputs);
+  return op;
+}
+
+// Whether the main block still has the variable, in its descs or its proto.
+bool HasVar(framework::ProgramDesc* program, const std::string& name) {
+  auto* block = program->MutableBlock(0);
+  if (block->FindVar(name) != nullptr) return true;
+  for (auto& var : block->Proto()->vars()) {
+    if (var.name() == name) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST(ShrinkModelWeights, prune_unused) {
+  framework::ProgramDesc program;
+  framework::Scope scope;
+  AddWeight(&program, &scope, "w", {1, 2, 3, 4});
+  AddWeight(&program, &scope, "unused", {5, 6});
+  AddOp(&program, "relu", {"w"}, {"out"});
+
+  ModelShrinkStats stats;
+  auto kept = ShrinkModelWeights(&program, scope, &stats);
+  EXPECT_EQ(kept, std::vector<std::string>({"w"}));
+  EXPECT_FALSE(HasVar(&program, "unused"));
+  EXPECT_TRUE(HasVar(&program, "w"));
+  EXPECT_EQ(stats.params_num, 2UL);
+  EXPECT_EQ(stats.pruned_num, 1UL);
+  EXPECT_EQ(stats.deduplicated_num, 0UL);
+  EXPECT_EQ(stats.bytes_before, 24);
+  EXPECT_EQ(stats.bytes_after, 16);
+  // the scope is left as is
+  EXPECT_NE(scope.FindVar("unused"), nullptr);
+}
+
+TEST(ShrinkModelWeights, deduplicate) {
+  // w0 and w1 are the same, w2 has other contents, w3 has other dims
+  framework::ProgramDesc program;
+  framework::Scope scope;
+  AddWeight(&program, &scope, "w0", {1, 2, 3, 4});
+  AddWeight(&program, &scope, "w1", {1, 2, 3, 4});
+  AddWeight(&program, &scope, "w2", {1, 2, 3, 5});
+  AddWeight(&program, &scope, "w3", {1, 2, 3, 4, 0});
+  auto* op0 = AddOp(&program, "mul", {"x", "w0"}, {"out0"});
+  auto* op1 = AddOp(&program, "mul", {"x", "w1"}, {"out1"});
+  auto* op2 = AddOp(&program, "mul", {"x", "w2"}, {"out2"});
+  auto* op3 = AddOp(&program, "mul", {"x", "w3"}, {"out3"});
+
+  ModelShrinkStats stats;
+  auto kept = ShrinkModelWeights(&program, scope, &stats);
+  EXPECT_EQ(kept, std::vector<std::string>({"w0", "w2", "w3"}));
+  EXPECT_EQ(op0->Input("X"), std::vector<std::string>({"x", "w0"}));
+  EXPECT_EQ(op1->Input("X"), std::vector<std::string>({"x", "w0"}));
+  EXPECT_EQ(op2->Input("X"), std::vector<std::string>({"x", "w2"}));
+  EXPECT_EQ(op3->Input("X"), std::vector<std::string>({"x", "w3"}));
+  EXPECT_FALSE(HasVar(&program, "w1"));
+  EXPECT_EQ(stats.params_num, 4UL);
+  EXPECT_EQ(stats.pruned_num, 0UL);
+  EXPECT_EQ(stats.deduplicated_num, 1UL);
+  EXPECT_EQ(stats.bytes_before, 68);
+  EXPECT_EQ(stats.bytes_after, 52);
+}
+
+TEST(ShrinkModelWeights, keep_written_and_named) {
+  // w1 is written by an op and w2 and w3 are named by the attribute of an
+  // engine op, so none of them is merged into w0 or pruned
+  framework::ProgramDesc program;
+  framework::Scope scope;
+  for (auto* name : {"w0", "w1", "w2", "w3"}) {
+    AddWeight(&program, &scope, name, {1, 2, 3, 4});
+  }
+  AddOp(&program, "mul", {"x", "w0"}, {"out0"});
+  AddOp(&program, "assign", {"x"}, {"w1"});
+  auto* op = AddOp(&program, "tensorrt_engine", {"x", "w2"}, {"out1"});
+  op->SetAttr("parameters", std::vector<std::string>({"w2", "w3"}));
+
+  ModelShrinkStats stats;
+  auto kept = ShrinkModelWeights(&program, scope, &stats);
+  EXPECT_EQ(kept, std::vector<std::string>({"w0", "w1", "w2", "w3"}));
+  EXPECT_EQ(op->Input("X"), std::vector<std::string>({"x", "w2"}));
+  EXPECT_EQ(stats.params_num, 4UL);
+  EXPECT_EQ(stats.pruned_num, 0UL);
+  EXPECT_EQ(stats.deduplicated_num, 0UL);
+  EXPECT_EQ(stats.bytes_before, 64);
+  EXPECT_EQ(stats.bytes_after, 64);
+}
+
+}  // namespace inference
+}  // namespace paddle
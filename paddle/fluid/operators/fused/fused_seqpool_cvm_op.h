@@ -14,11 +14,13 @@ limitations under the License. */
 
 #pragma once
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/operators/math/seqpool_cvm.h"
 
 namespace paddle {
 namespace operators {
@@ -27,9 +29,22 @@ template <typename T>
 class FusedSeqpoolCVMOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW(platform::errors::Unimplemented(
-        "Unimplemented CPU kernel for FusedSeqpoolCVMOp, only support GPU "
-        "now."));
+    auto inputs = ctx.MultiInput<phi::DenseTensor>("X");
+    auto outputs = ctx.MultiOutput<phi::DenseTensor>("Out");
+    std::string pooltype = ctx.Attr<std::string>("pooltype");
+    PADDLE_ENFORCE_EQ(pooltype,
+                      "SUM",
+                      platform::errors::InvalidArgument(
+                          "FusedSeqpoolCVMOp only supports SUM pooling, but "
+                          "received %s.",
+                          pooltype));
+    math::MultiSlotSeqPoolCVMFunctor<T>()(
+        ctx.template device_context<phi::CPUContext>(),
+        inputs,
+        ctx.Attr<float>("pad_value"),
+        ctx.Attr<bool>("use_cvm"),
+        ctx.Attr<int>("cvm_offset"),
+        outputs);
   }
 };
 
@@ -37,9 +52,18 @@ template <typename T>
 class FusedSeqpoolCVMGradOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW(platform::errors::Unimplemented(
-        "Unimplemented CPU kernel for FusedSeqpoolCVMGradOp, only support GPU "
-        "now."));
+    auto out_grads =
+        ctx.MultiInput<phi::DenseTensor>(framework::GradVarName("Out"));
+    auto in_grads =
+        ctx.MultiOutput<phi::DenseTensor>(framework::GradVarName("X"));
+    auto* cvm = ctx.Input<phi::DenseTensor>("CVM");
+    math::MultiSlotSeqPoolCVMGradFunctor<T>()(
+        ctx.template device_context<phi::CPUContext>(),
+        out_grads,
+        *cvm,
+        ctx.Attr<bool>("use_cvm"),
+        ctx.Attr<int>("cvm_offset"),
+        in_grads);
   }
 };
 
@@ -0,0 +1,143 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/fused/fusion_embedding_seqpool_cvm_op.h"
+
+#include <vector>
+
+#include "paddle/fluid/operators/math/seqpool_cvm.h"
+
+namespace paddle {
+namespace operators {
+
+void FusionEmbeddingSeqPoolCVMOp::InferShape(
+    framework::InferShapeContext* ctx) const {
+  OP_INOUT_CHECK(
+      ctx->HasInput("W"), "Input", "W", "FusionEmbeddingSeqPoolCVM");
+  PADDLE_ENFORCE_GE(
+      ctx->Inputs("Ids").size(),
+      1UL,
+      platform::errors::InvalidArgument(
+          "Inputs(Ids) of FusionEmbeddingSeqPoolCVMOp should not be empty."));
+  PADDLE_ENFORCE_EQ(
+      ctx->Outputs("Out").size(),
+      ctx->Inputs("Ids").size(),
+      platform::errors::InvalidArgument(
+          "Outputs(Out) of FusionEmbeddingSeqPoolCVMOp should have the same "
+          "number as Inputs(Ids), but got %d and %d.",
+          ctx->Outputs("Out").size(),
+          ctx->Inputs("Ids").size()));
+
+  auto table_dims = ctx->GetInputDim("W");
+  PADDLE_ENFORCE_EQ(table_dims.size(),
+                    2,
+                    platform::errors::InvalidArgument(
+                        "The rank of Input(W) should be 2, but got %d.",
+                        table_dims.size()));
+  bool use_cvm = ctx->Attrs().Get<bool>("use_cvm");
+  int cvm_offset = ctx->Attrs().Get<int>("cvm_offset");
+  if (table_dims[1] > 0) {
+    PADDLE_ENFORCE_GT(table_dims[1],
+                      use_cvm ? 2 : cvm_offset,
+                      platform::errors::InvalidArgument(
+                          "The width of Input(W) should be greater than %d, "
+                          "but got %d.",
+                          use_cvm ? 2 : cvm_offset,
+                          table_dims[1]));
+  }
+
+  auto ids_dims = ctx->GetInputsDim("Ids");
+  for (size_t i = 0; i < ids_dims.size(); ++i) {
+    PADDLE_ENFORCE_EQ(
+        ids_dims[i].size() == 2 && ids_dims[i][1] == 1,
+        true,
+        platform::errors::InvalidArgument(
+            "The ids of slot %d should be of shape [N, 1], but got [%s].",
+            i,
+            ids_dims[i]));
+  }
+  // the batch size is known from the LoD of Ids at run time
+  int64_t out_width = table_dims[1];
+  if (out_width > 0 && !use_cvm) {
+    out_width -= cvm_offset;
+  }
+  std::vector<framework::DDim> outs_dims(ids_dims.size(),
+                                         phi::make_ddim({-1, out_width}));
+  ctx->SetOutputsDim("Out", outs_dims);
+}
+
+phi::KernelKey FusionEmbeddingSeqPoolCVMOp::GetExpectedKernelType(
+    const framework::ExecutionContext& ctx) const {
+  return phi::KernelKey(OperatorWithKernel::IndicateVarDataType(ctx, "W"),
+                        ctx.GetPlace());
+}
+
+void FusionEmbeddingSeqPoolCVMOpMaker::Make() {
+  AddInput("W",
+           "(phi::DenseTensor) The embedding table of shape [H, D], whose "
+           "first two columns are the show and click when use_cvm is true.");
+  AddInput("Ids",
+           "(vector<phi::DenseTensor>) The int64 ids of every slot, of shape "
+           "[N, 1] with the LoD of the instances.")
+      .AsDuplicable();
+  AddOutput("Out",
+            "(vector<phi::DenseTensor>) The pooled embeddings of every slot, "
+            "of shape [batch_size, D] or [batch_size, D - cvm_offset].")
+      .AsDuplicable();
+  AddAttr<float>("pad_value",
+                 "(float, default 0.0) The value to pad for empty sequence.")
+      .SetDefault(0.0);
+  AddAttr<bool>("use_cvm", "bool, use cvm or not").SetDefault(true);
+  AddAttr<int>("cvm_offset", "(int, default 2)").SetDefault(2);
+  AddComment(R"DOC(
+Fusion of Lookup Table, Sequence Pool of SUM and CVM for all slots.
+
+The rows of the ids of every instance of every slot are looked up and summed
+in one pass over the batch, without materializing the embedded sequences.
+The outputs are the same as lookup_table followed by fused_seqpool_cvm.
+)DOC");
+}
+
+template <typename T>
+class FusionEmbeddingSeqPoolCVMKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto* table = ctx.Input<phi::DenseTensor>("W");
+    auto ids = ctx.MultiInput<phi::DenseTensor>("Ids");
+    auto outs = ctx.MultiOutput<phi::DenseTensor>("Out");
+    math::MultiSlotEmbeddingSeqPoolCVMFunctor<T>()(
+        ctx.template device_context<phi::CPUContext>(),
+        *table,
+        ids,
+        ctx.Attr<float>("pad_value"),
+        ctx.Attr<bool>("use_cvm"),
+        ctx.Attr<int>("cvm_offset"),
+        outs);
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(
+    fusion_embedding_seqpool_cvm,
+    ops::FusionEmbeddingSeqPoolCVMOp,
+    ops::FusionEmbeddingSeqPoolCVMOpMaker,
+    paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
+    paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+
+REGISTER_OP_CPU_KERNEL(fusion_embedding_seqpool_cvm,
+                       ops::FusionEmbeddingSeqPoolCVMKernel<float>,
+                       ops::FusionEmbeddingSeqPoolCVMKernel<double>);
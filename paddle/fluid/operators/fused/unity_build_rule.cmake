@@ -17,4 +17,5 @@ register_unity_group(
   fusion_squared_mat_sub_op.cc
   multi_gru_op.cc
   mkldnn/multi_gru_mkldnn_op.cc
-  fusion_seqpool_cvm_concat_op.cc)
+  fusion_seqpool_cvm_concat_op.cc
+  fusion_embedding_seqpool_cvm_op.cc)
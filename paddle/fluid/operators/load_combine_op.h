@@ -18,6 +18,8 @@ limitations under the License. */
 #include <string>
 #include <vector>
 
+#include "paddle/fluid/framework/aligned_tensor_container.h"
+#include "paddle/fluid/framework/combined_tensor_io.h"
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
@@ -26,6 +28,8 @@ limitations under the License. */
 #include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/platform/device_context.h"
 
+DECLARE_int32(save_load_combine_threads);
+
 namespace paddle {
 namespace operators {
 template <typename DeviceContext, typename T>
@@ -53,6 +57,21 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
               "LoadCombine operator fails to open file %s, please check "
               "whether the model file is complete or damaged.",
               filename));
+      char magic[8];
+      fin.read(magic, sizeof(magic));
+      if (framework::IsAlignedTensorContainer(magic, fin.gcount())) {
+        fin.close();
+        auto container = framework::AlignedTensorContainer::Open(filename);
+        LoadParamsFromContainer(
+            ctx, place, *container, load_as_fp16, out_var_names);
+        return;
+      }
+      if (FLAGS_save_load_combine_threads > 1 &&
+          LoadParamsInParallel(ctx, place, filename, load_as_fp16)) {
+        return;
+      }
+      fin.clear();
+      fin.seekg(0);
       LoadParamsFromBuffer(ctx, place, &fin, load_as_fp16, out_var_names);
     } else {
       PADDLE_ENFORCE_NE(
@@ -62,6 +81,14 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
               "LoadCombine operator fails to open file %s, please check "
               "whether the model file is complete or damaged.",
               filename));
+      if (framework::IsAlignedTensorContainer(filename.data(),
+                                              filename.size())) {
+        auto container =
+            framework::AlignedTensorContainer::FromBuffer(filename);
+        LoadParamsFromContainer(
+            ctx, place, *container, load_as_fp16, out_var_names);
+        return;
+      }
       std::stringstream fin(filename, std::ios::in | std::ios::binary);
       LoadParamsFromBuffer(ctx, place, &fin, load_as_fp16, out_var_names);
     }
@@ -115,28 +142,7 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
 
         // Get data from fin to tensor
         paddle::framework::DeserializeFromStream(*buffer, tensor, dev_ctx);
-
-        auto in_dtype = tensor->dtype();
-        auto out_dtype = load_as_fp16 ? phi::DataType::FLOAT16 : in_dtype;
-
-        if (in_dtype != out_dtype) {
-          // convert to float16 tensor
-          auto in_kernel_type =
-              phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, in_dtype);
-          auto out_kernel_type =
-              phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, out_dtype);
-          phi::DenseTensor fp16_tensor;
-          // copy LoD info to the new tensor
-          fp16_tensor.set_lod(tensor->lod());
-          framework::TransDataType(
-              in_kernel_type, out_kernel_type, *tensor, &fp16_tensor);
-
-          // reset output tensor
-          out_vars[i]->Clear();
-          tensor = out_vars[i]->GetMutable<phi::DenseTensor>();
-          tensor->set_lod(fp16_tensor.lod());
-          tensor->ShareDataWith(fp16_tensor);
-        }
+        CastToFP16IfNeeded(place, load_as_fp16, out_vars[i]);
       }
     }
     buffer->peek();
@@ -146,6 +152,102 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "Not allowed to load partial data via "
                           "load_combine_op, please use load_op instead."));
   }
+
+  // Read the tensors of a file in the stream format with pread on several
+  // threads. Returns false if some variable is a Vocab, which is not stored
+  // at a known offset and has to be read by LoadParamsFromBuffer.
+  bool LoadParamsInParallel(const framework::ExecutionContext &context,
+                            const platform::Place &place,
+                            const std::string &filename,
+                            bool load_as_fp16) const {
+    auto out_vars = context.MultiOutputVar("Out");
+    auto out_var_names = context.OutputNames("Out");
+    std::vector<phi::DenseTensor *> tensors;
+    for (size_t i = 0; i < out_vars.size(); i++) {
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i],
+          platform::errors::InvalidArgument(
+              "The variable %s to be loaded cannot be found.",
+              out_var_names[i]));
+      if (out_vars[i]->IsType<framework::Vocab>()) {
+        return false;
+      }
+    }
+    for (auto *out_var : out_vars) {
+      tensors.push_back(out_var->GetMutable<phi::DenseTensor>());
+    }
+    framework::LoadCombinedTensors(
+        filename, tensors, place, FLAGS_save_load_combine_threads);
+    for (auto *out_var : out_vars) {
+      CastToFP16IfNeeded(place, load_as_fp16, out_var);
+    }
+    return true;
+  }
+
+  // The tensors of a container are read in the order they are saved, the
+  // tensors on CPU share the memory of the container without copying.
+  void LoadParamsFromContainer(
+      const framework::ExecutionContext &context,
+      const platform::Place &place,
+      const framework::AlignedTensorContainer &container,
+      bool load_as_fp16,
+      const std::vector<std::string> &out_var_names) const {
+    auto out_vars = context.MultiOutputVar("Out");
+    PADDLE_ENFORCE_EQ(
+        container.size(),
+        out_var_names.size(),
+        platform::errors::Unavailable(
+            "The file holds %d tensors but %d variables are to be loaded. "
+            "Not allowed to load partial data via load_combine_op, please "
+            "use load_op instead.",
+            container.size(),
+            out_var_names.size()));
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      VLOG(4) << "loading tensor: " << out_var_names[i];
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i],
+          platform::errors::InvalidArgument(
+              "The variable %s to be loaded cannot be found.",
+              out_var_names[i]));
+      PADDLE_ENFORCE_EQ(
+          out_vars[i]->IsType<framework::Vocab>(),
+          false,
+          platform::errors::InvalidArgument(
+              "The variable %s is a Vocab, which cannot be loaded from a "
+              "file saved with aligned_format.",
+              out_var_names[i]));
+      container.GetTensor(
+          i, place, out_vars[i]->GetMutable<phi::DenseTensor>());
+      CastToFP16IfNeeded(place, load_as_fp16, out_vars[i]);
+    }
+  }
+
+  void CastToFP16IfNeeded(const platform::Place &place,
+                          bool load_as_fp16,
+                          framework::Variable *var) const {
+    auto *tensor = var->GetMutable<phi::DenseTensor>();
+    auto in_dtype = tensor->dtype();
+    auto out_dtype = load_as_fp16 ? phi::DataType::FLOAT16 : in_dtype;
+
+    if (in_dtype != out_dtype) {
+      // convert to float16 tensor
+      auto in_kernel_type =
+          phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, in_dtype);
+      auto out_kernel_type =
+          phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, out_dtype);
+      phi::DenseTensor fp16_tensor;
+      // copy LoD info to the new tensor
+      fp16_tensor.set_lod(tensor->lod());
+      framework::TransDataType(
+          in_kernel_type, out_kernel_type, *tensor, &fp16_tensor);
+
+      // reset output tensor
+      var->Clear();
+      tensor = var->GetMutable<phi::DenseTensor>();
+      tensor->set_lod(fp16_tensor.lod());
+      tensor->ShareDataWith(fp16_tensor);
+    }
+  }
 };
 
 }  // namespace operators
@@ -0,0 +1,355 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/seqpool_cvm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
+#include "paddle/phi/kernels/funcs/sequence_partition.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+namespace {
+
+// The row offsets of the instances of every slot, i.e. the first level of
+// the absolute LoD, or one row per instance for a slot without LoD. Returns
+// the batch size shared by the slots.
+size_t GetSlotLoDs(const std::vector<const phi::DenseTensor*>& tensors,
+                   std::vector<std::vector<size_t>>* lods) {
+  PADDLE_ENFORCE_GT(tensors.size(),
+                    0UL,
+                    platform::errors::InvalidArgument(
+                        "The number of slots should be greater than 0."));
+  lods->resize(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const auto& lod = tensors[i]->lod();
+    auto& slot_lod = (*lods)[i];
+    if (lod.empty()) {
+      slot_lod.resize(tensors[i]->dims()[0] + 1);
+      for (size_t j = 0; j < slot_lod.size(); ++j) {
+        slot_lod[j] = j;
+      }
+    } else {
+      auto abs_lod = framework::ToAbsOffset(lod);
+      slot_lod.assign(abs_lod[0].begin(), abs_lod[0].end());
+    }
+    PADDLE_ENFORCE_EQ(slot_lod.size(),
+                      lods->front().size(),
+                      platform::errors::InvalidArgument(
+                          "The batch size of all slots should be the same, "
+                          "but the batch size of slot 0 is %d and the batch "
+                          "size of slot %d is %d.",
+                          lods->front().size() - 1,
+                          i,
+                          slot_lod.size() - 1));
+  }
+  return lods->front().size() - 1;
+}
+
+// Call func(slot, ins) on all (slot, instance) pairs, split over threads by
+// the rows of the sequences.
+template <typename Func>
+void ForEachSlotInstance(const std::vector<std::vector<size_t>>& lods,
+                         size_t batch_size,
+                         int64_t width,
+                         Func&& func) {
+  size_t pair_num = lods.size() * batch_size;
+  std::vector<size_t> offsets;
+  offsets.reserve(pair_num + 1);
+  offsets.push_back(0);
+  for (auto& lod : lods) {
+    for (size_t ins = 0; ins < batch_size; ++ins) {
+      offsets.push_back(offsets.back() + lod[ins + 1] - lod[ins]);
+    }
+  }
+  phi::funcs::ParallelForSequences(
+      offsets, pair_num, width, [&](size_t begin, size_t end) {
+        for (size_t pair = begin; pair < end; ++pair) {
+          func(pair / batch_size, pair % batch_size);
+        }
+      });
+}
+
+void CheckCVMWidth(int64_t width, bool use_cvm, int cvm_offset) {
+  PADDLE_ENFORCE_GT(width,
+                    use_cvm ? 2 : cvm_offset,
+                    platform::errors::InvalidArgument(
+                        "The embedding width should be greater than %d, but "
+                        "got %d.",
+                        use_cvm ? 2 : cvm_offset,
+                        width));
+}
+
+void ResizeOutputs(const std::vector<phi::DenseTensor*>& outputs,
+                   size_t batch_size,
+                   int64_t width) {
+  for (auto* output : outputs) {
+    output->Resize({static_cast<int64_t>(batch_size), width});
+  }
+}
+
+// The sum of a sequence starts from pad_value, as in the GPU kernel.
+template <typename T>
+void AddPadValue(T* pooled, int64_t width, float pad_value) {
+  if (pad_value == 0.0f) {
+    return;
+  }
+  for (int64_t k = 0; k < width; ++k) {
+    pooled[k] += static_cast<T>(pad_value);
+  }
+}
+
+// Turn the sum of a sequence into the output row, pooled may be out when
+// use_cvm is true.
+template <typename T>
+void CVM(const T* pooled, int64_t width, bool use_cvm, int cvm_offset, T* out) {
+  if (use_cvm) {
+    if (out != pooled) {
+      std::memcpy(out, pooled, width * sizeof(T));
+    }
+    T show = std::log(pooled[0] + 1);
+    out[1] = std::log(pooled[1] + 1) - show;
+    out[0] = show;
+  } else {
+    std::memcpy(out, pooled + cvm_offset, (width - cvm_offset) * sizeof(T));
+  }
+}
+
+// Fetch the rows of ids into the cache ahead of the pooling of them, the ids
+// are in the range of the table.
+template <typename T>
+inline void PrefetchRows(const T* table,
+                         int64_t width,
+                         const int64_t* ids,
+                         size_t num) {
+#if defined(__GNUC__) || defined(__clang__)
+  constexpr size_t kCacheLineBytes = 64;
+  size_t row_bytes = width * sizeof(T);
+  for (size_t i = 0; i < num; ++i) {
+    const char* row = reinterpret_cast<const char*>(table + ids[i] * width);
+    for (size_t offset = 0; offset < row_bytes; offset += kCacheLineBytes) {
+      __builtin_prefetch(row + offset);
+    }
+  }
+#endif
+}
+
+}  // namespace
+
+template <typename T>
+void MultiSlotSeqPoolCVMFunctor<T>::operator()(
+    const phi::CPUContext& context,
+    const std::vector<const phi::DenseTensor*>& inputs,
+    float pad_value,
+    bool use_cvm,
+    int cvm_offset,
+    const std::vector<phi::DenseTensor*>& outputs) {
+  std::vector<std::vector<size_t>> lods;
+  size_t batch_size = GetSlotLoDs(inputs, &lods);
+  int64_t width = inputs[0]->numel() / inputs[0]->dims()[0];
+  CheckCVMWidth(width, use_cvm, cvm_offset);
+  int64_t out_width = use_cvm ? width : width - cvm_offset;
+  ResizeOutputs(outputs, batch_size, out_width);
+
+  std::vector<const T*> in_data(inputs.size());
+  std::vector<T*> out_data(outputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    PADDLE_ENFORCE_EQ(inputs[i]->numel(),
+                      static_cast<int64_t>(lods[i].back()) * width,
+                      platform::errors::InvalidArgument(
+                          "The rows of slot %d should be %d of width %d, but "
+                          "got %d elements.",
+                          i,
+                          lods[i].back(),
+                          width,
+                          inputs[i]->numel()));
+    in_data[i] = inputs[i]->data<T>();
+    out_data[i] = context.template Alloc<T>(outputs[i]);
+  }
+
+  phi::jit::seq_pool_attr_t attr(static_cast<int>(width),
+                                 phi::jit::SeqPoolType::kSum);
+  auto seqpool = phi::jit::KernelFuncs<phi::jit::SeqPoolTuple<T>,
+                                       platform::CPUPlace>::Cache()
+                     .At(attr);
+  // the jit kernel takes the attribute by pointer, so each thread sets the
+  // height in its own copy
+  ForEachSlotInstance(lods, batch_size, width, [&](size_t slot, size_t ins) {
+    thread_local std::vector<T> buffer;
+    buffer.resize(width);
+    T* out = out_data[slot] + ins * out_width;
+    T* pooled = use_cvm ? out : buffer.data();
+    phi::jit::seq_pool_attr_t seq_attr = attr;
+    seq_attr.h = static_cast<int>(lods[slot][ins + 1] - lods[slot][ins]);
+    if (seq_attr.h == 0) {
+      std::fill(pooled, pooled + width, static_cast<T>(pad_value));
+    } else {
+      seqpool(in_data[slot] + lods[slot][ins] * width, pooled, &seq_attr);
+      AddPadValue(pooled, width, pad_value);
+    }
+    CVM(pooled, width, use_cvm, cvm_offset, out);
+  });
+}
+
+template <typename T>
+void MultiSlotEmbeddingSeqPoolCVMFunctor<T>::operator()(
+    const phi::CPUContext& context,
+    const phi::DenseTensor& table,
+    const std::vector<const phi::DenseTensor*>& ids,
+    float pad_value,
+    bool use_cvm,
+    int cvm_offset,
+    const std::vector<phi::DenseTensor*>& outputs) {
+  std::vector<std::vector<size_t>> lods;
+  size_t batch_size = GetSlotLoDs(ids, &lods);
+  int64_t height = table.dims()[0];
+  int64_t width = table.dims()[1];
+  CheckCVMWidth(width, use_cvm, cvm_offset);
+  int64_t out_width = use_cvm ? width : width - cvm_offset;
+  ResizeOutputs(outputs, batch_size, out_width);
+
+  const T* table_data = table.data<T>();
+  std::vector<const int64_t*> ids_data(ids.size());
+  std::vector<T*> out_data(outputs.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    PADDLE_ENFORCE_EQ(ids[i]->numel(),
+                      static_cast<int64_t>(lods[i].back()),
+                      platform::errors::InvalidArgument(
+                          "The ids of slot %d should have a single column.",
+                          i));
+    ids_data[i] = ids[i]->data<int64_t>();
+    // the pooling runs on threads that must not throw, and the jit kernels
+    // do not check the ids, so they are checked here
+    for (int64_t j = 0; j < ids[i]->numel(); ++j) {
+      PADDLE_ENFORCE_EQ(
+          ids_data[i][j] >= 0 && ids_data[i][j] < height,
+          true,
+          platform::errors::InvalidArgument(
+              "The ids of slot %d should be in [0, %d), but got %d.",
+              i,
+              height,
+              ids_data[i][j]));
+    }
+    out_data[i] = context.template Alloc<T>(outputs[i]);
+  }
+
+  phi::jit::emb_seq_pool_attr_t attr(
+      height, width, 0, 1, width, phi::jit::SeqPoolType::kSum);
+  auto emb_seqpool = phi::jit::KernelFuncs<phi::jit::EmbSeqPoolTuple<T>,
+                                           platform::CPUPlace>::Cache()
+                         .At(attr);
+  ForEachSlotInstance(lods, batch_size, width, [&](size_t slot, size_t ins) {
+    thread_local std::vector<T> buffer;
+    buffer.resize(width);
+    const auto& lod = lods[slot];
+    // the rows of an instance are scattered over the table, so they are
+    // requested from memory while the previous instance is pooled
+    if (ins + 1 < batch_size) {
+      PrefetchRows(table_data,
+                   width,
+                   ids_data[slot] + lod[ins + 1],
+                   lod[ins + 2] - lod[ins + 1]);
+    }
+    T* out = out_data[slot] + ins * out_width;
+    T* pooled = use_cvm ? out : buffer.data();
+    phi::jit::emb_seq_pool_attr_t seq_attr = attr;
+    seq_attr.index_height = static_cast<int64_t>(lod[ins + 1] - lod[ins]);
+    if (seq_attr.index_height == 0) {
+      std::fill(pooled, pooled + width, static_cast<T>(pad_value));
+    } else {
+      emb_seqpool(table_data, ids_data[slot] + lod[ins], pooled, &seq_attr);
+      AddPadValue(pooled, width, pad_value);
+    }
+    CVM(pooled, width, use_cvm, cvm_offset, out);
+  });
+}
+
+template <typename T>
+void MultiSlotSeqPoolCVMGradFunctor<T>::operator()(
+    const phi::CPUContext& context,
+    const std::vector<const phi::DenseTensor*>& out_grads,
+    const phi::DenseTensor& cvm,
+    bool use_cvm,
+    int cvm_offset,
+    const std::vector<phi::DenseTensor*>& in_grads) {
+  std::vector<const phi::DenseTensor*> const_in_grads(in_grads.begin(),
+                                                      in_grads.end());
+  std::vector<std::vector<size_t>> lods;
+  size_t batch_size = GetSlotLoDs(const_in_grads, &lods);
+  int64_t width = in_grads[0]->numel() / in_grads[0]->dims()[0];
+  int64_t out_width = use_cvm ? width : width - cvm_offset;
+  int64_t cvm_width = cvm.dims()[1];
+  PADDLE_ENFORCE_LE(cvm_offset,
+                    cvm_width,
+                    platform::errors::InvalidArgument(
+                        "The cvm_offset should not be greater than the width "
+                        "of Input(CVM) %d, but got %d.",
+                        cvm_width,
+                        cvm_offset));
+  PADDLE_ENFORCE_EQ(cvm.dims()[0],
+                    static_cast<int64_t>(batch_size),
+                    platform::errors::InvalidArgument(
+                        "The height of Input(CVM) should be the batch size "
+                        "%d, but got %d.",
+                        batch_size,
+                        cvm.dims()[0]));
+
+  const T* cvm_data = cvm.data<T>();
+  std::vector<const T*> out_grad_data(out_grads.size());
+  std::vector<T*> in_grad_data(in_grads.size());
+  for (size_t i = 0; i < in_grads.size(); ++i) {
+    PADDLE_ENFORCE_EQ(out_grads[i]->numel(),
+                      static_cast<int64_t>(batch_size) * out_width,
+                      platform::errors::InvalidArgument(
+                          "The gradient of output %d should be of [%d, %d], "
+                          "but got [%s].",
+                          i,
+                          batch_size,
+                          out_width,
+                          out_grads[i]->dims()));
+    out_grad_data[i] = out_grads[i]->data<T>();
+    in_grad_data[i] = context.template Alloc<T>(in_grads[i]);
+  }
+
+  ForEachSlotInstance(lods, batch_size, width, [&](size_t slot, size_t ins) {
+    const T* show_click = cvm_data + ins * cvm_width;
+    const T* out_grad = out_grad_data[slot] + ins * out_width;
+    if (use_cvm) {
+      out_grad += cvm_offset;
+    }
+    for (size_t row = lods[slot][ins]; row < lods[slot][ins + 1]; ++row) {
+      T* in_grad = in_grad_data[slot] + row * width;
+      std::memcpy(in_grad, show_click, cvm_offset * sizeof(T));
+      std::memcpy(in_grad + cvm_offset,
+                  out_grad,
+                  (width - cvm_offset) * sizeof(T));
+    }
+  });
+}
+
+template class MultiSlotSeqPoolCVMFunctor<float>;
+template class MultiSlotSeqPoolCVMFunctor<double>;
+template class MultiSlotEmbeddingSeqPoolCVMFunctor<float>;
+template class MultiSlotEmbeddingSeqPoolCVMFunctor<double>;
+template class MultiSlotSeqPoolCVMGradFunctor<float>;
+template class MultiSlotSeqPoolCVMGradFunctor<double>;
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
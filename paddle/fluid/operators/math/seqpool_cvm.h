@@ -0,0 +1,81 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The functors below process the sequences of all slots of a batch in one
+// pass, with the (slot, instance) pairs split over threads by the number of
+// rows they pool. The instances are given by the first level of LoD, and a
+// slot without LoD has a sequence of one row per instance.
+// All slots should have the same number of instances.
+//
+// The sum of every sequence starts from pad_value, so an empty sequence gives
+// pad_value, and is followed by CVM: with use_cvm, the first two columns
+// (show and click) become log(show + 1) and log(click + 1) - log(show + 1);
+// without it, the first cvm_offset columns are dropped.
+
+// Pool the embedded sequences of every slot, inputs[i] of [rows, width] to
+// outputs[i] of [batch_size, width] or [batch_size, width - cvm_offset].
+template <typename T>
+class MultiSlotSeqPoolCVMFunctor {
+ public:
+  void operator()(const phi::CPUContext& context,
+                  const std::vector<const phi::DenseTensor*>& inputs,
+                  float pad_value,
+                  bool use_cvm,
+                  int cvm_offset,
+                  const std::vector<phi::DenseTensor*>& outputs);
+};
+
+// Look the ids of every slot up in table and pool them, without
+// materializing the embedded sequences. ids[i] is an int64 tensor of
+// [rows, 1], and the rows of the next instance are prefetched while the
+// current one is pooled.
+template <typename T>
+class MultiSlotEmbeddingSeqPoolCVMFunctor {
+ public:
+  void operator()(const phi::CPUContext& context,
+                  const phi::DenseTensor& table,
+                  const std::vector<const phi::DenseTensor*>& ids,
+                  float pad_value,
+                  bool use_cvm,
+                  int cvm_offset,
+                  const std::vector<phi::DenseTensor*>& outputs);
+};
+
+// The gradient of MultiSlotSeqPoolCVMFunctor: every row of a sequence gets
+// the show and click of its instance from cvm in the first cvm_offset
+// columns, and the gradient of the pooled output in the others.
+template <typename T>
+class MultiSlotSeqPoolCVMGradFunctor {
+ public:
+  void operator()(const phi::CPUContext& context,
+                  const std::vector<const phi::DenseTensor*>& out_grads,
+                  const phi::DenseTensor& cvm,
+                  bool use_cvm,
+                  int cvm_offset,
+                  const std::vector<phi::DenseTensor*>& in_grads);
+};
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
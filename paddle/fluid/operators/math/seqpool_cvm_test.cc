@@ -0,0 +1,293 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/seqpool_cvm.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+namespace {
+
+const phi::CPUContext& GetCPUContext() {
+  return *static_cast<phi::CPUContext*>(
+      platform::DeviceContextPool::Instance().Get(platform::CPUPlace()));
+}
+
+// The ids of slot_num slots of batch_size instances, each instance with 0 to
+// max_len ids drawn uniformly from the table.
+std::vector<phi::DenseTensor> MakeIds(size_t slot_num,
+                                      size_t batch_size,
+                                      size_t max_len,
+                                      int64_t table_height) {
+  std::mt19937 rng(2023);
+  std::vector<phi::DenseTensor> ids(slot_num);
+  for (auto& slot_ids : ids) {
+    std::vector<size_t> lod(1, 0);
+    for (size_t i = 0; i < batch_size; ++i) {
+      lod.push_back(lod.back() + rng() % (max_len + 1));
+    }
+    slot_ids.Resize({static_cast<int64_t>(lod.back()), 1});
+    int64_t* data = slot_ids.mutable_data<int64_t>(platform::CPUPlace());
+    for (size_t i = 0; i < lod.back(); ++i) {
+      data[i] = rng() % table_height;
+    }
+    slot_ids.set_lod({lod});
+  }
+  return ids;
+}
+
+phi::DenseTensor MakeTable(int64_t height, int64_t width) {
+  phi::DenseTensor table;
+  table.Resize({height, width});
+  float* data = table.mutable_data<float>(platform::CPUPlace());
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  for (int64_t i = 0; i < table.numel(); ++i) {
+    data[i] = dist(rng);
+  }
+  return table;
+}
+
+// What lookup_table does: the rows of the ids of every slot.
+std::vector<phi::DenseTensor> Lookup(const phi::DenseTensor& table,
+                                     const std::vector<phi::DenseTensor>& ids) {
+  int64_t width = table.dims()[1];
+  std::vector<phi::DenseTensor> embeddings(ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    embeddings[i].Resize({ids[i].numel(), width});
+    float* dst = embeddings[i].mutable_data<float>(platform::CPUPlace());
+    for (int64_t j = 0; j < ids[i].numel(); ++j) {
+      std::memcpy(dst + j * width,
+                  table.data<float>() + ids[i].data<int64_t>()[j] * width,
+                  width * sizeof(float));
+    }
+    embeddings[i].set_lod(ids[i].lod());
+  }
+  return embeddings;
+}
+
+// Sequence pool and CVM of every instance, one after another.
+std::vector<std::vector<float>> ReferenceSeqPoolCVM(
+    const std::vector<phi::DenseTensor>& inputs,
+    float pad_value,
+    bool use_cvm,
+    int cvm_offset) {
+  std::vector<std::vector<float>> outs;
+  for (auto& input : inputs) {
+    const auto& lod = input.lod()[0];
+    int64_t width = input.dims()[1];
+    std::vector<float> out;
+    for (size_t i = 0; i + 1 < lod.size(); ++i) {
+      std::vector<float> sum(width, pad_value);
+      for (size_t j = lod[i]; j < lod[i + 1]; ++j) {
+        for (int64_t k = 0; k < width; ++k) {
+          sum[k] += input.data<float>()[j * width + k];
+        }
+      }
+      if (use_cvm) {
+        float show = std::log(sum[0] + 1);
+        sum[1] = std::log(sum[1] + 1) - show;
+        sum[0] = show;
+        out.insert(out.end(), sum.begin(), sum.end());
+      } else {
+        out.insert(out.end(), sum.begin() + cvm_offset, sum.end());
+      }
+    }
+    outs.push_back(out);
+  }
+  return outs;
+}
+
+template <typename T>
+std::vector<const T*> ConstPtrs(const std::vector<T>& tensors) {
+  std::vector<const T*> ptrs;
+  for (auto& tensor : tensors) {
+    ptrs.push_back(&tensor);
+  }
+  return ptrs;
+}
+
+template <typename T>
+std::vector<T*> Ptrs(std::vector<T>* tensors) {
+  std::vector<T*> ptrs;
+  for (auto& tensor : *tensors) {
+    ptrs.push_back(&tensor);
+  }
+  return ptrs;
+}
+
+}  // namespace
+
+TEST(SeqPoolCVM, Forward) {
+  auto& context = GetCPUContext();
+  auto table = MakeTable(1000, 11);
+  auto ids = MakeIds(5, 64, 6, 1000);
+  auto embeddings = Lookup(table, ids);
+  // a non-zero pad_value is added to the sum of every sequence, not only to
+  // the empty ones
+  for (float pad_value : {0.0f, 0.5f}) {
+    for (bool use_cvm : {true, false}) {
+      auto expected = ReferenceSeqPoolCVM(embeddings, pad_value, use_cvm, 2);
+      std::vector<phi::DenseTensor> outs(ids.size());
+      MultiSlotSeqPoolCVMFunctor<float>()(context,
+                                          ConstPtrs(embeddings),
+                                          pad_value,
+                                          use_cvm,
+                                          2,
+                                          Ptrs(&outs));
+      std::vector<phi::DenseTensor> fused_outs(ids.size());
+      MultiSlotEmbeddingSeqPoolCVMFunctor<float>()(context,
+                                                   table,
+                                                   ConstPtrs(ids),
+                                                   pad_value,
+                                                   use_cvm,
+                                                   2,
+                                                   Ptrs(&fused_outs));
+      for (size_t i = 0; i < ids.size(); ++i) {
+        EXPECT_EQ(outs[i].dims(), phi::make_ddim({64, use_cvm ? 11 : 9}));
+        EXPECT_EQ(fused_outs[i].dims(), outs[i].dims());
+        ASSERT_EQ(outs[i].numel(), static_cast<int64_t>(expected[i].size()));
+        for (int64_t j = 0; j < outs[i].numel(); ++j) {
+          EXPECT_NEAR(outs[i].data<float>()[j], expected[i][j], 1e-5);
+          EXPECT_NEAR(fused_outs[i].data<float>()[j], expected[i][j], 1e-5);
+        }
+      }
+    }
+  }
+}
+
+TEST(SeqPoolCVM, InvalidIds) {
+  auto& context = GetCPUContext();
+  auto table = MakeTable(100, 11);
+  for (int64_t bad_id : {int64_t{-1}, int64_t{100}}) {
+    auto ids = MakeIds(3, 16, 4, 100);
+    // the last id of the last slot, pooled on any thread
+    auto& slot_ids = ids.back();
+    ASSERT_GT(slot_ids.numel(), 0);
+    slot_ids.data<int64_t>()[slot_ids.numel() - 1] = bad_id;
+    std::vector<phi::DenseTensor> outs(ids.size());
+    MultiSlotEmbeddingSeqPoolCVMFunctor<float> functor;
+    EXPECT_THROW(
+        functor(context, table, ConstPtrs(ids), 0.0f, true, 2, Ptrs(&outs)),
+        platform::EnforceNotMet);
+  }
+}
+
+TEST(SeqPoolCVM, Backward) {
+  auto& context = GetCPUContext();
+  const int64_t width = 5;
+  const int cvm_offset = 2;
+  auto ids = MakeIds(3, 16, 4, 100);
+  phi::DenseTensor cvm;
+  cvm.Resize({16, 2});
+  float* cvm_data = cvm.mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < cvm.numel(); ++i) {
+    cvm_data[i] = i;
+  }
+  for (bool use_cvm : {true, false}) {
+    int64_t out_width = use_cvm ? width : width - cvm_offset;
+    std::vector<phi::DenseTensor> out_grads(ids.size());
+    std::vector<phi::DenseTensor> in_grads(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      out_grads[i].Resize({16, out_width});
+      float* data = out_grads[i].mutable_data<float>(platform::CPUPlace());
+      for (int64_t j = 0; j < out_grads[i].numel(); ++j) {
+        data[j] = 1000.0f * i + j;
+      }
+      in_grads[i].Resize({ids[i].numel(), width});
+      in_grads[i].set_lod(ids[i].lod());
+    }
+    MultiSlotSeqPoolCVMGradFunctor<float>()(context,
+                                            ConstPtrs(out_grads),
+                                            cvm,
+                                            use_cvm,
+                                            cvm_offset,
+                                            Ptrs(&in_grads));
+    for (size_t i = 0; i < ids.size(); ++i) {
+      const auto& lod = ids[i].lod()[0];
+      for (size_t ins = 0; ins + 1 < lod.size(); ++ins) {
+        for (size_t row = lod[ins]; row < lod[ins + 1]; ++row) {
+          const float* in_grad = in_grads[i].data<float>() + row * width;
+          for (int64_t k = 0; k < width; ++k) {
+            float expected =
+                k < cvm_offset
+                    ? cvm_data[ins * 2 + k]
+                    : out_grads[i].data<float>()[ins * out_width + k -
+                                                 (use_cvm ? 0 : cvm_offset)];
+            EXPECT_EQ(in_grad[k], expected);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(SeqPoolCVM, Benchmark) {
+  // 100 slots of 512 instances with up to 8 ids each, looked up in a table
+  // of 1M rows of show, click and 9 embedding values
+  constexpr size_t kSlotNum = 100;
+  constexpr size_t kBatchSize = 512;
+  constexpr int64_t kHeight = 1 << 20;
+  constexpr int kRepeat = 10;
+  auto& context = GetCPUContext();
+  auto table = MakeTable(kHeight, 11);
+  auto ids = MakeIds(kSlotNum, kBatchSize, 8, kHeight);
+  auto ms = [](std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count() / kRepeat;
+  };
+
+  // lookup_table, then a sequence pool and CVM per slot and instance
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    auto embeddings = Lookup(table, ids);
+    ReferenceSeqPoolCVM(embeddings, 0.0f, true, 2);
+  }
+  auto unfused = std::chrono::steady_clock::now() - start;
+
+  std::vector<phi::DenseTensor> outs(kSlotNum);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    auto embeddings = Lookup(table, ids);
+    MultiSlotSeqPoolCVMFunctor<float>()(
+        context, ConstPtrs(embeddings), 0.0f, true, 2, Ptrs(&outs));
+  }
+  auto lookup_then_pool = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    MultiSlotEmbeddingSeqPoolCVMFunctor<float>()(
+        context, table, ConstPtrs(ids), 0.0f, true, 2, Ptrs(&outs));
+  }
+  auto fused = std::chrono::steady_clock::now() - start;
+
+  LOG(INFO) << kSlotNum << " slots of " << kBatchSize
+            << " instances: lookup and serial pool " << ms(unfused)
+            << " ms, lookup and multi-slot pool " << ms(lookup_then_pool)
+            << " ms, fused lookup and pool " << ms(fused) << " ms";
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
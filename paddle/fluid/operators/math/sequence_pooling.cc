@@ -16,10 +16,10 @@ limitations under the License. */
 
 #include <string>
 
-#include "paddle/phi/kernels/funcs/blas/blas.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/jit/kernels.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
+#include "paddle/phi/kernels/funcs/sequence_partition.h"
 
 namespace paddle {
 namespace operators {
@@ -88,27 +88,30 @@ class MaxSeqPoolFunctor {
 
     int64_t num_seq = out_dims[0];
     int64_t dim = output->numel() / num_seq;
-    for (int64_t i = 0; i < num_seq; ++i) {
-      if (starts[i] == starts[i + 1]) {
-        for (int64_t k = 0; k < dim; ++k) {
-          out_data[i * dim + k] = pad_value;
-          max_index[i * dim + k] = -1;
+    auto pool = [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        if (starts[i] == starts[i + 1]) {
+          for (int64_t k = 0; k < dim; ++k) {
+            out_data[i * dim + k] = pad_value;
+            max_index[i * dim + k] = -1;
+          }
+          continue;
         }
-        continue;
-      }
-      for (int64_t k = 0; k < dim; ++k) {
-        out_data[i * dim + k] = in_data[starts[i] * dim + k];
-        max_index[i * dim + k] = starts[i];
-      }
-      for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
         for (int64_t k = 0; k < dim; ++k) {
-          if (in_data[j * dim + k] > out_data[i * dim + k]) {
-            out_data[i * dim + k] = in_data[j * dim + k];
-            max_index[i * dim + k] = j;
+          out_data[i * dim + k] = in_data[starts[i] * dim + k];
+          max_index[i * dim + k] = starts[i];
+        }
+        for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
+          for (int64_t k = 0; k < dim; ++k) {
+            if (in_data[j * dim + k] > out_data[i * dim + k]) {
+              out_data[i * dim + k] = in_data[j * dim + k];
+              max_index[i * dim + k] = j;
+            }
           }
         }
       }
-    }
+    };
+    phi::funcs::ParallelForSequences(starts, num_seq, dim, pool);
   }
 };
 // Instantisation of Max Sequence Pooling for test phase eg. no need to fill
@@ -155,23 +158,26 @@ class MaxSeqPoolFunctor<T, true> {
 
     int64_t num_seq = out_dims[0];
     int64_t dim = output->numel() / num_seq;
-    for (int64_t i = 0; i < num_seq; ++i) {
-      if (starts[i] == starts[i + 1]) {
-        for (int64_t k = 0; k < dim; ++k) {
-          out_data[i * dim + k] = pad_value;
+    auto pool = [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        T* out_row = out_data + i * dim;
+        if (starts[i] == starts[i + 1]) {
+          for (int64_t k = 0; k < dim; ++k) {
+            out_row[k] = pad_value;
+          }
+          continue;
         }
-        continue;
-      }
-      std::memcpy(
-          &out_data[i * dim], &in_data[starts[i] * dim], dim * sizeof(T));
-      for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
-        for (int64_t k = 0; k < dim; ++k) {
-          if (in_data[j * dim + k] > out_data[i * dim + k]) {
-            out_data[i * dim + k] = in_data[j * dim + k];
+        std::memcpy(out_row, &in_data[starts[i] * dim], dim * sizeof(T));
+        for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
+          const T* in_row = in_data + j * dim;
+          // no index to track, so the loop is vectorized
+          for (int64_t k = 0; k < dim; ++k) {
+            out_row[k] = in_row[k] > out_row[k] ? in_row[k] : out_row[k];
           }
         }
       }
-    }
+    };
+    phi::funcs::ParallelForSequences(starts, num_seq, dim, pool);
   }
 };
 template <typename T>
@@ -252,22 +258,23 @@ class LastSeqPoolFunctor {
     int64_t item_size = input.numel() / input.dims()[0];
     auto lod_level = input.lod().size();
     auto lod = input.lod()[lod_level - 1];
-    int seq_num = static_cast<int>(lod.size()) - 1;
-    for (int i = 0; i < seq_num; ++i) {
-      // Calculate the length of each sequence
-      int64_t seq_len = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (seq_len == 0) {
-        for (int j = 0; j < item_size; ++j) {
-          out_data[j] = pad_value;
+    size_t seq_num = lod.size() - 1;
+    auto pool = [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        T* out_row = out_data + i * item_size;
+        if (lod[i] == lod[i + 1]) {
+          for (int j = 0; j < item_size; ++j) {
+            out_row[j] = pad_value;
+          }
+        } else {
+          // Copy the last item of sequence to output
+          std::memcpy(out_row,
+                      in_data + (lod[i + 1] - 1) * item_size,
+                      item_size * sizeof(T));
         }
-      } else {
-        // Point to the begin of next sequence
-        in_data += seq_len * item_size;
-        // Copy the last item of sequence to output
-        std::memcpy(out_data, (in_data - item_size), item_size * sizeof(T));
       }
-      out_data += item_size;
-    }
+    };
+    phi::funcs::ParallelForSequences(lod, seq_num, item_size, pool);
   }
 };
 
@@ -286,22 +293,22 @@ class FirstSeqPoolFunctor {
     int64_t item_size = input.numel() / input.dims()[0];
     auto lod_level = input.lod().size();
     auto lod = input.lod()[lod_level - 1];
-    int seq_num = static_cast<int>(lod.size()) - 1;
-    for (int i = 0; i < seq_num; ++i) {
-      // Calculate the length of each sequence
-      int64_t seq_len = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (seq_len == 0) {
-        for (int j = 0; j < item_size; ++j) {
-          out_data[j] = pad_value;
+    size_t seq_num = lod.size() - 1;
+    auto pool = [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        T* out_row = out_data + i * item_size;
+        if (lod[i] == lod[i + 1]) {
+          for (int j = 0; j < item_size; ++j) {
+            out_row[j] = pad_value;
+          }
+        } else {
+          // Copy the first item of sequence to output
+          std::memcpy(
+              out_row, in_data + lod[i] * item_size, item_size * sizeof(T));
         }
-      } else {
-        // Copy the first item of sequence to output
-        std::memcpy(out_data, in_data, item_size * sizeof(T));
-        // Point to the next sequence
-        in_data += seq_len * item_size;
       }
-      out_data += item_size;
-    }
+    };
+    phi::funcs::ParallelForSequences(lod, seq_num, item_size, pool);
   }
 };
 
@@ -327,17 +334,15 @@ class SumSeqPoolGradFunctor {
                           out_w));
     const T* out_g_data = out_grad.data<T>();
     T* in_g_data = in_grad->mutable_data<T>(context.GetPlace());
-    auto blas = phi::funcs::GetBlas<phi::CPUContext, T>(context);
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (h == 0) continue;
-      int64_t in_offset = lod[i] * in_w;
-      const T* out_pos = out_g_data + i * out_w;
-      T* in_pos = in_g_data + in_offset;
-      for (int r = 0; r != h; ++r) {
-        blas.VCOPY(in_w, out_pos, in_pos + r * in_w);
+    auto pool_grad = [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const T* out_pos = out_g_data + i * out_w;
+        for (size_t r = lod[i]; r < lod[i + 1]; ++r) {
+          std::memcpy(in_g_data + r * in_w, out_pos, in_w * sizeof(T));
+        }
       }
-    }
+    };
+    phi::funcs::ParallelForSequences(lod, lod.size() - 1, in_w, pool_grad);
   }
 };
 
@@ -374,62 +379,48 @@ class SequencePoolFunctor<phi::CPUContext, T> {
     }
     auto lod_level = input.lod().size();
     auto lod = input.lod()[lod_level - 1];
-    if (pooltype == "SUM") {
+    if (pooltype == "SUM" || pooltype == "AVERAGE" || pooltype == "SQRT") {
       auto place = context.GetPlace();
       PADDLE_ENFORCE_EQ(
           platform::is_cpu_place(place),
           true,
           platform::errors::InvalidArgument(
-              "Sequence_pool should run on CPU Device when pooltype is SUM"));
+              "Sequence_pool should run on CPU Device when pooltype is %s",
+              pooltype));
       const T* src = input.data<T>();
       T* dst = output->mutable_data<T>(place);
-      phi::jit::seq_pool_attr_t attr(
-          static_cast<int>(input.numel() / input.dims()[0]),
-          phi::jit::SeqPoolType::kSum);
+      phi::jit::SeqPoolType type = phi::jit::SeqPoolType::kSum;
+      if (pooltype == "AVERAGE") {
+        type = phi::jit::SeqPoolType::kAvg;
+      } else if (pooltype == "SQRT") {
+        type = phi::jit::SeqPoolType::kSqrt;
+      }
+      const phi::jit::seq_pool_attr_t attr(
+          static_cast<int>(input.numel() / input.dims()[0]), type);
       auto seqpool = phi::jit::KernelFuncs<phi::jit::SeqPoolTuple<T>,
                                            platform::CPUPlace>::Cache()
                          .At(attr);
-      for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-        attr.h = static_cast<int>(lod[i + 1] - lod[i]);
-        if (attr.h == 0) {
-          for (int j = 0; j < attr.w; ++j) {
-            dst[j] = pad_value;
+      auto pool = [&](size_t begin, size_t end) {
+        phi::jit::seq_pool_attr_t seq_attr = attr;
+        for (size_t i = begin; i < end; ++i) {
+          T* out_row = dst + i * attr.w;
+          seq_attr.h = static_cast<int>(lod[i + 1] - lod[i]);
+          if (seq_attr.h == 0) {
+            for (int j = 0; j < attr.w; ++j) {
+              out_row[j] = pad_value;
+            }
+          } else {
+            seqpool(src + lod[i] * attr.w, out_row, &seq_attr);
           }
-        } else {
-          seqpool(src, dst, &attr);
         }
-        dst += attr.w;
-        src += attr.h * attr.w;
-      }
+      };
+      phi::funcs::ParallelForSequences(lod, lod.size() - 1, attr.w, pool);
       return;
     }
-    auto& place = *context.eigen_device();
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      phi::DenseTensor out_t = output->Slice(i, i + 1);
-      int64_t w = input.numel() / input.dims()[0];
-      if (lod[i] == lod[i + 1]) {
-        for (int j = 0; j < w; ++j) {
-          out_t.data<T>()[j] = pad_value;
-        }
-        continue;
-      }
-      phi::DenseTensor in_t =
-          input.Slice(static_cast<int>(lod[i]), static_cast<int>(lod[i + 1]));
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      auto in_e = EigenMatrix<T>::From(in_t, phi::make_ddim({h, w}));
-      auto out_e = EigenVector<T>::Flatten(out_t);
-      if (pooltype == "AVERAGE") {
-        out_e.device(place) = in_e.mean(Eigen::array<int, 1>({{0}}));
-      } else if (pooltype == "SQRT") {
-        out_e.device(place) = in_e.sum(Eigen::array<int, 1>({{0}})) /
-                              std::sqrt(static_cast<T>(h));
-      } else {
-        PADDLE_THROW(platform::errors::InvalidArgument(
-            "unsupported pooling pooltype: %s. Only support \"AVERAGE\" and "
-            "\"SQRT\"",
-            pooltype));
-      }
-    }
+    PADDLE_THROW(platform::errors::InvalidArgument(
+        "unsupported pooling pooltype: %s. Only support \"MAX\", "
+        "\"AVERAGE\", \"SUM\", \"SQRT\", \"LAST\" and \"FIRST\"",
+        pooltype));
   }
 };
 
@@ -16,6 +16,13 @@ limitations under the License. */
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "glog/logging.h"
+
 template <typename DeviceContext, typename T>
 void TestSequencePoolingSum(const DeviceContext &context,
                             const paddle::framework::LoD &lod,
@@ -129,6 +136,149 @@ TEST(SequencePoolingGrad, CPU_SUM) {
   TestSequencePoolingSum<phi::CPUContext, float>(*context, lod2, 128);
 }
 
+namespace {
+
+using SequencePoolFunctor =
+    paddle::operators::math::SequencePoolFunctor<phi::CPUContext, float>;
+
+// The LoD of seq_num sequences, whose lengths are drawn by the distribution:
+// "uniform" of 1 to 16 steps, "skewed" with a few sequences 100 times longer
+// than the others, and "empty" with about a third of empty sequences.
+paddle::framework::LoD MakeLoD(const std::string &distribution,
+                               size_t seq_num) {
+  std::mt19937 rng(2023);
+  std::vector<size_t> offsets(1, 0);
+  for (size_t i = 0; i < seq_num; ++i) {
+    size_t len = rng() % 16 + 1;
+    if (distribution == "skewed" && rng() % 64 == 0) {
+      len *= 100;
+    } else if (distribution == "empty" && rng() % 3 == 0) {
+      len = 0;
+    }
+    offsets.push_back(offsets.back() + len);
+  }
+  paddle::framework::LoD lod;
+  lod.push_back(offsets);
+  return lod;
+}
+
+// Pool the sequences one by one on a single thread.
+std::vector<float> ReferenceSequencePool(const std::string &pooltype,
+                                         float pad_value,
+                                         const phi::DenseTensor &input) {
+  const auto &lod = input.lod()[0];
+  int64_t width = input.numel() / input.dims()[0];
+  const float *in_data = input.data<float>();
+  std::vector<float> out((lod.size() - 1) * width, pad_value);
+  for (size_t i = 0; i + 1 < lod.size(); ++i) {
+    size_t len = lod[i + 1] - lod[i];
+    if (len == 0) {
+      continue;
+    }
+    for (int64_t k = 0; k < width; ++k) {
+      float result = 0;
+      if (pooltype == "MAX") {
+        result = in_data[lod[i] * width + k];
+        for (size_t j = lod[i]; j < lod[i + 1]; ++j) {
+          result = std::max(result, in_data[j * width + k]);
+        }
+      } else if (pooltype == "FIRST") {
+        result = in_data[lod[i] * width + k];
+      } else if (pooltype == "LAST") {
+        result = in_data[(lod[i + 1] - 1) * width + k];
+      } else {
+        for (size_t j = lod[i]; j < lod[i + 1]; ++j) {
+          result += in_data[j * width + k];
+        }
+        if (pooltype == "AVERAGE") {
+          result /= len;
+        } else if (pooltype == "SQRT") {
+          result /= std::sqrt(static_cast<float>(len));
+        }
+      }
+      out[i * width + k] = result;
+    }
+  }
+  return out;
+}
+
+phi::DenseTensor MakeSequenceInput(const paddle::framework::LoD &lod,
+                                   int64_t width) {
+  phi::DenseTensor input;
+  input.set_lod(lod);
+  input.Resize({static_cast<int64_t>(lod[0].back()), width});
+  float *data = input.mutable_data<float>(paddle::platform::CPUPlace());
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (int64_t i = 0; i < input.numel(); ++i) {
+    data[i] = dist(rng);
+  }
+  return input;
+}
+
+}  // namespace
+
+TEST(SequencePooling, CPU) {
+  auto place = paddle::platform::CPUPlace();
+  auto *context = static_cast<phi::CPUContext *>(
+      paddle::platform::DeviceContextPool::Instance().Get(place));
+  const float pad_value = -7.0f;
+  for (const std::string distribution : {"uniform", "skewed", "empty"}) {
+    for (size_t seq_num : {1UL, 3UL, 4096UL}) {
+      phi::DenseTensor input = MakeSequenceInput(MakeLoD(distribution, seq_num),
+                                                 /*width=*/24);
+      for (const std::string pooltype :
+           {"MAX", "AVERAGE", "SUM", "SQRT", "FIRST", "LAST"}) {
+        for (bool is_test : {false, true}) {
+          phi::DenseTensor out;
+          phi::DenseTensor index;
+          out.Resize({static_cast<int64_t>(seq_num), 24});
+          out.mutable_data<float>(place);
+          index.Resize(out.dims());
+          index.mutable_data<int>(place);
+          SequencePoolFunctor()(
+              *context, pooltype, pad_value, input, &out, is_test, &index);
+          auto expected = ReferenceSequencePool(pooltype, pad_value, input);
+          ASSERT_EQ(out.numel(), static_cast<int64_t>(expected.size()));
+          for (int64_t i = 0; i < out.numel(); ++i) {
+            ASSERT_NEAR(out.data<float>()[i], expected[i], 1e-4)
+                << pooltype << " of " << distribution << " sequences at " << i;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(SequencePooling, Benchmark) {
+  auto place = paddle::platform::CPUPlace();
+  auto *context = static_cast<phi::CPUContext *>(
+      paddle::platform::DeviceContextPool::Instance().Get(place));
+  constexpr int64_t kWidth = 128;
+  constexpr int kRepeat = 10;
+  for (const std::string distribution : {"uniform", "skewed", "empty"}) {
+    phi::DenseTensor input =
+        MakeSequenceInput(MakeLoD(distribution, 8192), kWidth);
+    for (const std::string pooltype : {"MAX", "AVERAGE", "SUM", "LAST"}) {
+      phi::DenseTensor out;
+      out.Resize({8192, kWidth});
+      out.mutable_data<float>(place);
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kRepeat; ++i) {
+        SequencePoolFunctor()(
+            *context, pooltype, 0.0f, input, &out, /*is_test=*/true);
+      }
+      auto end = std::chrono::steady_clock::now();
+      LOG(INFO) << pooltype << " pooling of " << distribution << " sequences ("
+                << input.dims()[0] << " steps): "
+                << std::chrono::duration<double, std::milli>(end - start)
+                           .count() /
+                       kRepeat
+                << " ms";
+    }
+  }
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 TEST(SequencePoolingGrad, CUDA_SUM) {
   auto place = paddle::platform::CUDAPlace(0);
@@ -0,0 +1,336 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/batch_pipeline.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+SampleTransformRegistry& SampleTransformRegistry::Instance() {
+  static SampleTransformRegistry registry;
+  return registry;
+}
+
+void SampleTransformRegistry::Register(const std::string& name,
+                                       SampleTransform transform) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  PADDLE_ENFORCE_EQ(transforms_.count(name),
+                    0UL,
+                    platform::errors::AlreadyExists(
+                        "The sample transform %s has been registered.", name));
+  transforms_.emplace(name, std::move(transform));
+}
+
+bool SampleTransformRegistry::Has(const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return transforms_.count(name) > 0;
+}
+
+const SampleTransform& SampleTransformRegistry::Get(
+    const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = transforms_.find(name);
+  PADDLE_ENFORCE_NE(it,
+                    transforms_.end(),
+                    platform::errors::NotFound(
+                        "The sample transform %s is not registered.", name));
+  return it->second;
+}
+
+BatchPipeline::BatchPipeline(SampleSource source,
+                             std::vector<int64_t> sample_indices,
+                             const BatchPipelineOptions& options,
+                             std::shared_ptr<LoDTensorBlockingQueue> queue)
+    : source_(std::move(source)),
+      sample_indices_(std::move(sample_indices)),
+      options_(options),
+      queue_(std::move(queue)),
+      place_(platform::CPUPlace()) {
+  PADDLE_ENFORCE_GT(options_.batch_size,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The batch size should be greater than 0, but got %d.",
+                        options_.batch_size));
+  PADDLE_ENFORCE_GT(
+      options_.num_threads,
+      0,
+      platform::errors::InvalidArgument(
+          "The thread number should be greater than 0, but got %d.",
+          options_.num_threads));
+  PADDLE_ENFORCE_GT(
+      options_.buffers_per_thread,
+      0,
+      platform::errors::InvalidArgument(
+          "The buffer number per thread should be greater than 0, but got %d.",
+          options_.buffers_per_thread));
+  PADDLE_ENFORCE_NOT_NULL(
+      queue_,
+      platform::errors::InvalidArgument(
+          "The queue to push the batches to should not be null."));
+  if (options_.pin_memory) {
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+    place_ = platform::CUDAPinnedPlace();
+#else
+    PADDLE_THROW(platform::errors::PreconditionNotMet(
+        "pin_memory of BatchPipeline requires PaddlePaddle compiled with "
+        "CUDA or HIP."));
+#endif
+  }
+}
+
+BatchPipeline::~BatchPipeline() { Shutdown(); }
+
+void BatchPipeline::AddTransform(SampleTransform transform) {
+  PADDLE_ENFORCE_EQ(threads_.empty(),
+                    true,
+                    platform::errors::PreconditionNotMet(
+                        "Cannot add transforms to a started BatchPipeline."));
+  transforms_.push_back(std::move(transform));
+}
+
+void BatchPipeline::AddTransform(const std::string& name) {
+  AddTransform(SampleTransformRegistry::Instance().Get(name));
+}
+
+size_t BatchPipeline::BatchNum() const {
+  size_t batch_size = options_.batch_size;
+  if (options_.drop_last) {
+    return sample_indices_.size() / batch_size;
+  }
+  return (sample_indices_.size() + batch_size - 1) / batch_size;
+}
+
+void BatchPipeline::Start() {
+  PADDLE_ENFORCE_EQ(threads_.empty(),
+                    true,
+                    platform::errors::PreconditionNotMet(
+                        "The BatchPipeline has been started."));
+  if (BatchNum() == 0) {
+    queue_->Close();
+    return;
+  }
+  for (int i = 0; i < options_.num_threads; ++i) {
+    threads_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+void BatchPipeline::Join() {
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  std::lock_guard<std::mutex> lock(push_mutex_);
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void BatchPipeline::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(push_mutex_);
+    stopped_ = true;
+  }
+  push_cv_.notify_all();
+  // wake up the thread blocked on pushing to a full queue
+  queue_->Close();
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+void BatchPipeline::Abort(std::exception_ptr error) {
+  {
+    std::lock_guard<std::mutex> lock(push_mutex_);
+    if (!error_) {
+      error_ = error;
+    }
+    stopped_ = true;
+  }
+  push_cv_.notify_all();
+  queue_->Kill();
+}
+
+void BatchPipeline::WorkerLoop(size_t thread_id) {
+  VLOG(4) << "BatchPipeline worker " << thread_id << " starts";
+  std::vector<BatchBuffer> buffers(options_.buffers_per_thread);
+  std::vector<framework::LoDTensorArray> samples;
+  size_t batch_num = BatchNum();
+  try {
+    for (size_t i = 0; !stopped_; ++i) {
+      size_t batch_id = next_batch_++;
+      if (batch_id >= batch_num) {
+        break;
+      }
+      BatchBuffer* buffer = &buffers[i % buffers.size()];
+      BuildBatch(batch_id, &samples, buffer);
+      {
+        std::unique_lock<std::mutex> lock(push_mutex_);
+        push_cv_.wait(lock, [this, batch_id] {
+          return stopped_ || next_push_ == batch_id;
+        });
+        if (stopped_) {
+          break;
+        }
+      }
+      // only this thread pushes until next_push_ moves on, the queue holds
+      // tensors sharing the memory of the buffer
+      bool pushed = queue_->Push(buffer->tensors);
+      {
+        std::lock_guard<std::mutex> lock(push_mutex_);
+        if (!pushed) {
+          // the queue is closed or killed by others, the threads waiting for
+          // their turns should exit as well
+          stopped_ = true;
+        }
+        ++next_push_;
+        if (next_push_ == batch_num) {
+          queue_->Close();
+        }
+      }
+      push_cv_.notify_all();
+    }
+  } catch (...) {
+    Abort(std::current_exception());
+  }
+  VLOG(4) << "BatchPipeline worker " << thread_id << " exits";
+}
+
+void BatchPipeline::BuildBatch(size_t batch_id,
+                               std::vector<framework::LoDTensorArray>* samples,
+                               BatchBuffer* buffer) {
+  size_t batch_size = options_.batch_size;
+  size_t begin = batch_id * batch_size;
+  size_t end = std::min(begin + batch_size, sample_indices_.size());
+  samples->resize(end - begin);
+  for (size_t i = 0; i < samples->size(); ++i) {
+    auto& sample = (*samples)[i];
+    source_(sample_indices_[begin + i], &sample);
+    for (auto& transform : transforms_) {
+      transform(&sample);
+    }
+  }
+
+  size_t field_num = samples->front().size();
+  for (auto& sample : *samples) {
+    PADDLE_ENFORCE_EQ(sample.size(),
+                      field_num,
+                      platform::errors::InvalidArgument(
+                          "The samples of a batch should have the same number "
+                          "of fields, but got %d and %d.",
+                          sample.size(),
+                          field_num));
+  }
+  buffer->tensors.resize(field_num);
+  for (size_t field = 0; field < field_num; ++field) {
+    Collate(*samples, field, &buffer->tensors[field]);
+  }
+}
+
+bool BatchPipeline::IsLoDField(size_t field) const {
+  return field < options_.lod_fields.size() && options_.lod_fields[field];
+}
+
+void BatchPipeline::Collate(
+    const std::vector<framework::LoDTensorArray>& samples,
+    size_t field,
+    phi::DenseTensor* batch) {
+  const phi::DenseTensor& first = samples.front()[field];
+  auto dtype = first.dtype();
+  auto dims = first.dims();
+  bool is_lod = IsLoDField(field);
+  PADDLE_ENFORCE_EQ(is_lod && dims.size() == 0,
+                    false,
+                    platform::errors::InvalidArgument(
+                        "The samples of the sequence field %d should have at "
+                        "least one dim.",
+                        field));
+
+  std::vector<size_t> level(1, 0);
+  for (auto& sample : samples) {
+    const phi::DenseTensor& tensor = sample[field];
+    PADDLE_ENFORCE_EQ(platform::is_cpu_place(tensor.place()),
+                      true,
+                      platform::errors::InvalidArgument(
+                          "The samples of a BatchPipeline should be on CPU."));
+    PADDLE_ENFORCE_EQ(
+        tensor.dtype(),
+        dtype,
+        platform::errors::InvalidArgument(
+            "The samples of field %d should have the same data type.", field));
+    if (is_lod) {
+      PADDLE_ENFORCE_EQ(
+          tensor.dims().size() == dims.size() &&
+              phi::slice_ddim(tensor.dims(), 1, dims.size()) ==
+                  phi::slice_ddim(dims, 1, dims.size()),
+          true,
+          platform::errors::InvalidArgument(
+              "The samples of the sequence field %d should have the same "
+              "dims except the first one, but got [%s] and [%s].",
+              field,
+              tensor.dims(),
+              dims));
+      level.push_back(level.back() + tensor.dims()[0]);
+    } else {
+      PADDLE_ENFORCE_EQ(tensor.dims(),
+                        dims,
+                        platform::errors::InvalidArgument(
+                            "The samples of field %d should have the same "
+                            "dims, but got [%s] and [%s].",
+                            field,
+                            tensor.dims(),
+                            dims));
+    }
+  }
+
+  std::vector<int64_t> batch_dims = phi::vectorize(dims);
+  if (is_lod) {
+    batch_dims[0] = level.back();
+  } else {
+    batch_dims.insert(batch_dims.begin(), samples.size());
+  }
+  // reuse the memory of the buffer, unless the consumer still holds the
+  // batch written to it last time
+  if (batch->Holder() && batch->Holder().use_count() > 1) {
+    *batch = phi::DenseTensor();
+  }
+  batch->Resize(phi::make_ddim(batch_dims));
+  char* dst = static_cast<char*>(batch->mutable_data(place_, dtype));
+  for (auto& sample : samples) {
+    const phi::DenseTensor& tensor = sample[field];
+    size_t bytes = tensor.numel() * phi::SizeOf(dtype);
+    if (bytes > 0) {
+      std::memcpy(dst, tensor.data(), bytes);
+      dst += bytes;
+    }
+  }
+  if (is_lod) {
+    batch->set_lod({level});
+  } else {
+    batch->set_lod({});
+  }
+}
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
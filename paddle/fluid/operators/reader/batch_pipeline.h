@@ -0,0 +1,158 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/lod_tensor_array.h"
+#include "paddle/fluid/operators/reader/lod_tensor_blocking_queue.h"
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+// Fill the fields of the sample of the given index.
+using SampleSource =
+    std::function<void(int64_t index, framework::LoDTensorArray* sample)>;
+
+// Transform the fields of a sample in place, e.g. decode or normalize.
+using SampleTransform = std::function<void(framework::LoDTensorArray* sample)>;
+
+// The transforms registered by name, so a pipeline can be configured with a
+// list of names.
+class SampleTransformRegistry {
+ public:
+  static SampleTransformRegistry& Instance();
+
+  void Register(const std::string& name, SampleTransform transform);
+
+  bool Has(const std::string& name) const;
+
+  const SampleTransform& Get(const std::string& name) const;
+
+ private:
+  SampleTransformRegistry() = default;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, SampleTransform> transforms_;
+
+  DISABLE_COPY_AND_ASSIGN(SampleTransformRegistry);
+};
+
+struct BatchPipelineOptions {
+  int64_t batch_size{1};
+  bool drop_last{false};
+  int num_threads{1};
+  // Whether a field is a sequence. The samples of a sequence field are
+  // concatenated along the first dim and the batch gets a level of LoD,
+  // the samples of the other fields are stacked into a new first dim.
+  // Fields not listed are not sequences.
+  std::vector<bool> lod_fields;
+  // Collate the batches in CUDA pinned memory, so the BufferedReader copies
+  // them to GPU asynchronously without a staging copy.
+  bool pin_memory{false};
+  // The batch buffers owned by every worker thread. A buffer is reused once
+  // the consumer has released the batch written to it before.
+  int buffers_per_thread{2};
+};
+
+/*
+ * Build batches on a pool of threads and push them to a
+ * LoDTensorBlockingQueue in order. Every thread takes the next batch,
+ * reads its samples from the source, runs the transforms on them and
+ * collates them into one of its preallocated batch buffers, so no batch
+ * goes through Python or is serialized on its way to the reader.
+ */
+class BatchPipeline {
+ public:
+  BatchPipeline(SampleSource source,
+                std::vector<int64_t> sample_indices,
+                const BatchPipelineOptions& options,
+                std::shared_ptr<LoDTensorBlockingQueue> queue);
+
+  ~BatchPipeline();
+
+  // Append a transform, or a registered one by its name. The transforms
+  // run in the order they are added and must be thread safe.
+  void AddTransform(SampleTransform transform);
+  void AddTransform(const std::string& name);
+
+  // Start building the batches, the queue is closed after the last batch.
+  void Start();
+
+  // Wait for all batches to be pushed, and rethrow the first error raised
+  // by the source or the transforms.
+  void Join();
+
+  // Stop building the batches and close the queue. If the source or a
+  // transform fails, the queue is killed instead, so the reader does not
+  // take the batches pushed before as a complete epoch.
+  void Shutdown();
+
+  size_t BatchNum() const;
+
+ private:
+  struct BatchBuffer {
+    framework::LoDTensorArray tensors;
+  };
+
+  void WorkerLoop(size_t thread_id);
+
+  void BuildBatch(size_t batch_id,
+                  std::vector<framework::LoDTensorArray>* samples,
+                  BatchBuffer* buffer);
+
+  void Collate(const std::vector<framework::LoDTensorArray>& samples,
+               size_t field,
+               phi::DenseTensor* batch);
+
+  bool IsLoDField(size_t field) const;
+
+  void Abort(std::exception_ptr error);
+
+  SampleSource source_;
+  std::vector<int64_t> sample_indices_;
+  BatchPipelineOptions options_;
+  std::shared_ptr<LoDTensorBlockingQueue> queue_;
+  std::vector<SampleTransform> transforms_;
+  platform::Place place_;
+
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_batch_{0};
+  std::atomic<bool> stopped_{false};
+  // the batches are pushed in order, next_push_ is the next to be pushed
+  size_t next_push_{0};
+  std::mutex push_mutex_;
+  std::condition_variable push_cv_;
+  std::exception_ptr error_;
+
+  DISABLE_COPY_AND_ASSIGN(BatchPipeline);
+};
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,265 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/batch_pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>  // NOLINT
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+namespace {
+
+// field 0: float [2] of {i, i + 0.5}, field 1: int64 sequence of i % 3 + 1
+// elements of i
+void MakeSample(int64_t index, framework::LoDTensorArray* sample) {
+  platform::CPUPlace place;
+  sample->resize(2);
+  auto& dense = (*sample)[0];
+  dense.Resize({2});
+  float* dense_data = dense.mutable_data<float>(place);
+  dense_data[0] = index;
+  dense_data[1] = index + 0.5f;
+  auto& seq = (*sample)[1];
+  seq.Resize({index % 3 + 1, 1});
+  int64_t* seq_data = seq.mutable_data<int64_t>(place);
+  for (int64_t i = 0; i < seq.numel(); ++i) {
+    seq_data[i] = index;
+  }
+}
+
+std::vector<int64_t> Range(int64_t n) {
+  std::vector<int64_t> indices(n);
+  for (int64_t i = 0; i < n; ++i) {
+    indices[i] = i;
+  }
+  return indices;
+}
+
+}  // namespace
+
+TEST(BatchPipeline, CollateInOrder) {
+  SampleTransformRegistry::Instance().Register(
+      "batch_pipeline_test_add_one", [](framework::LoDTensorArray* sample) {
+        float* data = (*sample)[0].data<float>();
+        for (int64_t i = 0; i < (*sample)[0].numel(); ++i) {
+          data[i] += 1;
+        }
+      });
+  EXPECT_TRUE(
+      SampleTransformRegistry::Instance().Has("batch_pipeline_test_add_one"));
+
+  for (int num_threads : {1, 4}) {
+    auto queue = std::make_shared<LoDTensorBlockingQueue>(2);
+    BatchPipelineOptions options;
+    options.batch_size = 4;
+    options.num_threads = num_threads;
+    options.lod_fields = {false, true};
+    BatchPipeline pipeline(MakeSample, Range(10), options, queue);
+    pipeline.AddTransform("batch_pipeline_test_add_one");
+    EXPECT_EQ(pipeline.BatchNum(), 3UL);
+    pipeline.Start();
+
+    int64_t sample_id = 0;
+    while (true) {
+      bool ok;
+      auto batch = queue->Pop(&ok);
+      if (!ok) {
+        break;
+      }
+      ASSERT_EQ(batch.size(), 2UL);
+      int64_t batch_size = batch[0].dims()[0];
+      EXPECT_EQ(batch_size, std::min<int64_t>(4, 10 - sample_id));
+      EXPECT_EQ(batch[0].dims(), phi::make_ddim({batch_size, 2}));
+      ASSERT_EQ(batch[1].lod().size(), 1UL);
+      auto& level = batch[1].lod()[0];
+      ASSERT_EQ(level.size(), static_cast<size_t>(batch_size + 1));
+      EXPECT_EQ(batch[1].dims()[0], static_cast<int64_t>(level.back()));
+      for (int64_t i = 0; i < batch_size; ++i, ++sample_id) {
+        EXPECT_EQ(batch[0].data<float>()[i * 2], sample_id + 1);
+        EXPECT_EQ(batch[0].data<float>()[i * 2 + 1], sample_id + 1.5f);
+        EXPECT_EQ(level[i + 1] - level[i],
+                  static_cast<size_t>(sample_id % 3 + 1));
+        for (size_t j = level[i]; j < level[i + 1]; ++j) {
+          EXPECT_EQ(batch[1].data<int64_t>()[j], sample_id);
+        }
+      }
+    }
+    pipeline.Join();
+    EXPECT_EQ(sample_id, 10);
+  }
+}
+
+TEST(BatchPipeline, DropLast) {
+  auto queue = std::make_shared<LoDTensorBlockingQueue>(4);
+  BatchPipelineOptions options;
+  options.batch_size = 4;
+  options.drop_last = true;
+  options.num_threads = 2;
+  options.lod_fields = {false, true};
+  BatchPipeline pipeline(MakeSample, Range(10), options, queue);
+  EXPECT_EQ(pipeline.BatchNum(), 2UL);
+  pipeline.Start();
+  size_t batch_num = 0;
+  while (true) {
+    bool ok;
+    auto batch = queue->Pop(&ok);
+    if (!ok) {
+      break;
+    }
+    EXPECT_EQ(batch[0].dims()[0], 4);
+    ++batch_num;
+  }
+  pipeline.Join();
+  EXPECT_EQ(batch_num, 2UL);
+}
+
+TEST(BatchPipeline, Error) {
+  auto queue = std::make_shared<LoDTensorBlockingQueue>(2);
+  BatchPipelineOptions options;
+  options.batch_size = 2;
+  options.num_threads = 4;
+  // the samples of field 1 have different shapes, but it is not a sequence
+  BatchPipeline pipeline(MakeSample, Range(10), options, queue);
+  pipeline.Start();
+  // the queue is killed, so the batches are not taken as a complete epoch
+  EXPECT_THROW(
+      {
+        while (true) {
+          bool ok;
+          queue->Pop(&ok);
+          if (!ok) {
+            break;
+          }
+        }
+      },
+      platform::EnforceNotMet);
+  EXPECT_THROW(pipeline.Join(), platform::EnforceNotMet);
+}
+
+TEST(BatchPipeline, Benchmark) {
+  // samples of 3x64x64 float images, normalized and collated into batches
+  // of 64
+  constexpr int64_t kSampleNum = 4096;
+  constexpr int64_t kBatchSize = 64;
+  SampleSource source = [](int64_t index, framework::LoDTensorArray* sample) {
+    sample->resize(2);
+    auto& image = (*sample)[0];
+    image.Resize({3, 64, 64});
+    uint8_t* pixels = image.mutable_data<uint8_t>(platform::CPUPlace());
+    for (int64_t i = 0; i < image.numel(); ++i) {
+      pixels[i] = static_cast<uint8_t>(index + i);
+    }
+    auto& label = (*sample)[1];
+    label.Resize({1});
+    label.mutable_data<int64_t>(platform::CPUPlace())[0] = index % 1000;
+  };
+  SampleTransform normalize = [](framework::LoDTensorArray* sample) {
+    auto& image = (*sample)[0];
+    phi::DenseTensor normalized;
+    normalized.Resize(image.dims());
+    float* dst = normalized.mutable_data<float>(platform::CPUPlace());
+    const uint8_t* src = image.data<uint8_t>();
+    for (int64_t i = 0; i < image.numel(); ++i) {
+      dst[i] = (src[i] / 255.0f - 0.5f) / 0.25f;
+    }
+    image = std::move(normalized);
+  };
+
+  auto consume = [](LoDTensorBlockingQueue* queue) {
+    int64_t sample_num = 0;
+    while (true) {
+      bool ok;
+      auto batch = queue->Pop(&ok);
+      if (!ok) {
+        break;
+      }
+      sample_num += batch[0].dims()[0];
+    }
+    return sample_num;
+  };
+  auto ms = [](std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  };
+
+  // what the Python workers do: a worker builds a batch and the batch is
+  // serialized to be sent to the reader, where it is deserialized again
+  {
+    auto queue = std::make_shared<LoDTensorBlockingQueue>(8);
+    auto start = std::chrono::steady_clock::now();
+    std::thread worker([&] {
+      auto indices = Range(kSampleNum);
+      for (int64_t begin = 0; begin < kSampleNum; begin += kBatchSize) {
+        framework::LoDTensorArray batch(2);
+        std::vector<framework::LoDTensorArray> samples(kBatchSize);
+        for (int64_t i = 0; i < kBatchSize; ++i) {
+          source(indices[begin + i], &samples[i]);
+          normalize(&samples[i]);
+        }
+        for (size_t field = 0; field < 2; ++field) {
+          std::vector<phi::DenseTensor> tensors(samples.size());
+          std::vector<const phi::DenseTensor*> tensor_ptrs;
+          for (size_t i = 0; i < samples.size(); ++i) {
+            tensors[i].ShareDataWith(samples[i][field]);
+            auto dims = phi::vectorize(tensors[i].dims());
+            dims.insert(dims.begin(), 1);
+            tensors[i].Resize(phi::make_ddim(dims));
+            tensor_ptrs.push_back(&tensors[i]);
+          }
+          phi::DenseTensor collated;
+          framework::MergeLoDTensor(
+              &collated, tensor_ptrs, platform::CPUPlace());
+          std::ostringstream os;
+          framework::SerializeToStream(os, collated);
+          std::istringstream is(os.str());
+          framework::DeserializeFromStream(is, &batch[field]);
+        }
+        queue->Push(std::move(batch));
+      }
+      queue->Close();
+    });
+    EXPECT_EQ(consume(queue.get()), kSampleNum);
+    worker.join();
+    auto end = std::chrono::steady_clock::now();
+    LOG(INFO) << "Serialized batches from a worker: "
+              << kSampleNum / ms(end - start) * 1000 << " samples/s";
+  }
+
+  for (int num_threads : {1, 2, 4, 8}) {
+    auto queue = std::make_shared<LoDTensorBlockingQueue>(8);
+    BatchPipelineOptions options;
+    options.batch_size = kBatchSize;
+    options.num_threads = num_threads;
+    BatchPipeline pipeline(source, Range(kSampleNum), options, queue);
+    pipeline.AddTransform(normalize);
+    auto start = std::chrono::steady_clock::now();
+    pipeline.Start();
+    EXPECT_EQ(consume(queue.get()), kSampleNum);
+    pipeline.Join();
+    auto end = std::chrono::steady_clock::now();
+    LOG(INFO) << "BatchPipeline with " << num_threads << " threads: "
+              << kSampleNum / ms(end - start) * 1000 << " samples/s";
+  }
+}
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
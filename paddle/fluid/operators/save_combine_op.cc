@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <string>
 
+#include "paddle/fluid/framework/op_version_registry.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/bfloat16.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -79,6 +80,12 @@ to a file on disk.
                   "(boolean, default false)"
                   "If true, the variables will be saved to binary strings.")
         .SetDefault(false);
+    AddAttr<bool>("aligned_format",
+                  "(boolean, default false)"
+                  "If true, the tensors will be saved in a container with an "
+                  "index of all tensors and 64-byte aligned data, which "
+                  "load_combine maps into memory without copying.")
+        .SetDefault(false);
     AddOutput("Y",
               "(RAW, default empty)."
               "This output is used when saving variables to binary strings.")
@@ -104,6 +111,15 @@ REGISTER_OPERATOR(save_combine,
                   ops::SaveCombineOpProtoMaker,
                   ops::SaveCombineOpInferVarType);
 
+REGISTER_OP_VERSION(save_combine)
+    .AddCheckpoint(
+        R"ROC(
+              Upgrade save_combine, add a new attribute [aligned_format])ROC",
+        paddle::framework::compatible::OpVersionDesc().NewAttr(
+            "aligned_format",
+            "Whether to save the tensors in the aligned container format.",
+            false));
+
 PD_REGISTER_KERNEL(save_combine_tensor,
                    CPU,
                    ALL_LAYOUT,
@@ -22,6 +22,8 @@ limitations under the License. */
 #include <string>
 #include <unordered_map>
 
+#include "paddle/fluid/framework/aligned_tensor_container.h"
+#include "paddle/fluid/framework/combined_tensor_io.h"
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
@@ -33,6 +35,8 @@ limitations under the License. */
 #include "paddle/phi/backends/dynload/port.h"
 #include "paddle/phi/core/dense_tensor.h"
 
+DECLARE_int32(save_load_combine_threads);
+
 namespace paddle {
 namespace operators {
 
@@ -65,6 +69,7 @@ void SaveCombineTensorKernel(const Context& dev_ctx,
                              bool overwrite,
                              bool save_as_fp16,
                              bool save_to_memory,
+                             bool aligned_format,
                              phi::ExtendedTensor* out) {
   std::string* y = nullptr;
   if (out != nullptr) {
@@ -89,6 +94,12 @@ void SaveCombineTensorKernel(const Context& dev_ctx,
                         "it to be greater than 0.",
                         x.size()));
 
+  // write the tensors to the file with pwrite on several threads
+  bool parallel = !save_to_memory && FLAGS_save_load_combine_threads > 1;
+  // the fp16 copies of the tensors, kept until a container is written or
+  // the tensors are written in parallel
+  std::vector<phi::DenseTensor> fp16_tensors(x.size());
+  std::vector<const phi::DenseTensor*> to_save(x.size());
   for (size_t i = 0; i < x.size(); i++) {
     auto& tensor = *(x[i]);
     PADDLE_ENFORCE_EQ(
@@ -100,20 +111,36 @@ void SaveCombineTensorKernel(const Context& dev_ctx,
     // Check types to see if a fp16 transformation is required
     auto in_dtype = tensor.dtype();
     auto out_dtype = save_as_fp16 ? phi::DataType::FLOAT16 : in_dtype;
+    to_save[i] = &tensor;
     if (in_dtype != out_dtype) {
       auto place = dev_ctx.GetPlace();
       auto in_kernel_type =
           phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, in_dtype);
       auto out_kernel_type =
           phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, out_dtype);
-      phi::DenseTensor out;
+      phi::DenseTensor& out = fp16_tensors[i];
       framework::TransDataType(in_kernel_type, out_kernel_type, tensor, &out);
       // copy LoD info to the new tensor
       out.set_lod(tensor.lod());
-      framework::SerializeToStream(ss, out, dev_ctx);
-    } else {
-      framework::SerializeToStream(ss, tensor, dev_ctx);
+      to_save[i] = &out;
     }
+    if (!aligned_format && !parallel) {
+      framework::SerializeToStream(ss, *to_save[i], dev_ctx);
+      // release the fp16 copy once it is written
+      fp16_tensors[i] = phi::DenseTensor();
+    }
+  }
+  if (parallel) {
+    MkDirRecursively(DirName(file_path).c_str());
+    framework::SaveCombinedTensors(
+        file_path, to_save, aligned_format, FLAGS_save_load_combine_threads);
+    return;
+  }
+  if (aligned_format) {
+    // the kernel does not know the names of the variables, the tensors are
+    // loaded by their order as in the stream format
+    framework::SerializeToAlignedContainer(
+        ss, std::vector<std::string>(x.size()), to_save);
   }
 
   SaveToMemory(file_path, ss, save_to_memory, y);
@@ -127,6 +154,7 @@ void SaveCombineVocabKernel(
     bool overwrite,
     bool save_as_fp16,
     bool save_to_memory,
+    bool aligned_format,
     phi::ExtendedTensor* out) {
   std::string* y = nullptr;
   if (out != nullptr) {
@@ -148,6 +176,12 @@ void SaveCombineVocabKernel(
         overwrite));
   }
 
+  PADDLE_ENFORCE_EQ(aligned_format,
+                    false,
+                    phi::errors::InvalidArgument(
+                        "Vocab variables cannot be saved with "
+                        "aligned_format."));
+
   std::ostringstream ss;
   PADDLE_ENFORCE_GT(x.size(),
                     0UL,
@@ -179,6 +213,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
     auto save_to_memory = ctx.Attr<bool>("save_to_memory");
+    auto aligned_format = ctx.Attr<bool>("aligned_format");
     auto output = ctx.Output<framework::RawTensor>("Y");
     auto inp_var_names = ctx.InputNames("X");
     auto& inp_vars = ctx.MultiInputVar("X");
@@ -216,6 +251,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
                                  overwrite,
                                  save_as_fp16,
                                  save_to_memory,
+                                 aligned_format,
                                  output);
     } else {
       std::vector<const phi::ExtendedTensor*> x(inp_vars.size());
@@ -239,6 +275,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
                                 overwrite,
                                 save_as_fp16,
                                 save_to_memory,
+                                aligned_format,
                                 output);
     }
   }
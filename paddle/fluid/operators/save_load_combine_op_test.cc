@@ -18,6 +18,7 @@ limitations under the License. */
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/raw_tensor.h"
 #include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/float16.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -26,6 +27,8 @@ USE_OP_ITSELF(save_combine);
 PD_DECLARE_KERNEL(save_combine_tensor, CPU, ALL_LAYOUT);
 USE_CPU_ONLY_OP(load_combine);
 
+DECLARE_int32(save_load_combine_threads);
+
 template <typename T, typename U>
 T* CreateForSaveCombineOp(int x,
                           int y,
@@ -86,7 +89,7 @@ void CheckValues(T* expect,
 // Here, we create 4 LoDTensors and use save_combine_op to first save these
 // in a single file. Then, we use load_combine_op to load these sequentially
 template <typename T, typename U>
-void SaveLoadCombineOp() {
+void SaveLoadCombineOp(bool aligned_format = false) {
   paddle::framework::Scope scope;
   paddle::platform::CPUPlace place;
 
@@ -118,13 +121,15 @@ void SaveLoadCombineOp() {
   std::string filename = "check_tensor.ls";
   paddle::framework::AttributeMap attrs;
   attrs.insert({"file_path", std::string(filename)});
+  paddle::framework::AttributeMap save_attrs = attrs;
+  save_attrs.insert({"aligned_format", aligned_format});
 
   // Run the save_combine_op
   auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
       "save_combine",
       {{"X", {"test_var1", "test_var2", "test_var3", "test_var4"}}},
       {},
-      attrs);
+      save_attrs);
   save_combine_op->Run(scope, place);
 
   // Set up output vars
@@ -155,6 +160,67 @@ void SaveLoadCombineOp() {
 
 TEST(SaveLoadCombineOp, CPU) { SaveLoadCombineOp<int, int>(); }
 
+TEST(SaveLoadCombineOp, AlignedFormat) {
+  SaveLoadCombineOp<float, float>(true);
+}
+
+TEST(SaveLoadCombineOp, MultiThreads) {
+  FLAGS_save_load_combine_threads = 4;
+  SaveLoadCombineOp<float, float>();
+  SaveLoadCombineOp<float, float>(true);
+  FLAGS_save_load_combine_threads = 1;
+}
+
+// Save a container to a binary string and load it from memory, loading a
+// part of the tensors is not allowed.
+TEST(SaveLoadCombineOp, AlignedFormatFromMemory) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+  std::vector<std::string> names = {"test_var1", "test_var2", "test_var3"};
+  std::vector<paddle::framework::LoD> expect_lods(names.size());
+  std::vector<float*> expects;
+  for (size_t i = 0; i < names.size(); ++i) {
+    expects.push_back(CreateForSaveCombineOp<float, float>(
+        10, 10, {0, 5, 10}, names[i], place, &scope, &expect_lods[i]));
+  }
+  scope.Var("saved")->GetMutable<paddle::framework::RawTensor>();
+  paddle::framework::AttributeMap save_attrs;
+  save_attrs.insert({"file_path", std::string("unused")});
+  save_attrs.insert({"save_to_memory", true});
+  save_attrs.insert({"aligned_format", true});
+  paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", names}}, {{"Y", {"saved"}}}, save_attrs)
+      ->Run(scope, place);
+  std::string saved = scope.FindVar("saved")
+                          ->Get<paddle::framework::RawTensor>()
+                          .Get<std::string>();
+
+  paddle::framework::AttributeMap load_attrs;
+  load_attrs.insert({"file_path", saved});
+  load_attrs.insert({"model_from_memory", true});
+  std::vector<std::string> out_names = {"out_var1", "out_var2", "out_var3"};
+  std::vector<phi::DenseTensor*> targets;
+  for (auto& name : out_names) {
+    targets.push_back(GeneratePlaceholderBeforeLoad(name, &scope));
+  }
+  paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", out_names}}, load_attrs)
+      ->Run(scope, place);
+  for (size_t i = 0; i < names.size(); ++i) {
+    paddle::framework::LoD actual_lod;
+    float* actual =
+        GetValuesAfterLoadCombineOp<float>(targets[i], scope, &actual_lod);
+    CheckValues<float, float>(
+        expects[i], actual, expect_lods[i], actual_lod, 100);
+  }
+
+  out_names.pop_back();
+  auto partial_load = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", out_names}}, load_attrs);
+  EXPECT_THROW(partial_load->Run(scope, place),
+               paddle::platform::EnforceNotMet);
+}
+
 TEST(SaveLoadCombineBF16Op, CPU) {
   SaveLoadCombineOp<paddle::platform::bfloat16, paddle::platform::bfloat16>();
 }
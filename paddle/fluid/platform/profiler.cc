@@ -108,6 +108,34 @@ RecordOpInfoSupplement::RecordOpInfoSupplement(
 
 bool RecordMemEvent::IsEnabled() { return FLAGS_enable_record_memory; }
 
+static thread_local const std::string *g_mem_owner_op = nullptr;
+
+RecordMemOwner::RecordMemOwner(const std::string &op_type) {
+  if (RecordMemEvent::IsEnabled() == false) {
+    return;
+  }
+  is_enabled_ = true;
+  prev_op_ = g_mem_owner_op;
+  g_mem_owner_op = &op_type;
+}
+
+RecordMemOwner::~RecordMemOwner() {
+  if (is_enabled_) {
+    g_mem_owner_op = prev_op_;
+  }
+}
+
+const std::string *RecordMemOwner::CurrentOp() { return g_mem_owner_op; }
+
+void RecordMemVarName(const void *ptr, const std::string &var_name) {
+  if (ptr == nullptr || RecordMemEvent::IsEnabled() == false ||
+      FLAGS_enable_host_event_recorder_hook == false) {
+    return;
+  }
+  HostEventRecorder<CommonMemNameEvent>::GetInstance().RecordEvent(
+      PosixInNsec(), reinterpret_cast<uint64_t>(ptr), var_name);
+}
+
 std::map<const char *, std::map<uint64_t, std::vector<uint64_t>>>
     RecordMemEvent::size_cache;
 
@@ -490,6 +518,21 @@ void MemEvenRecorder::PushMemRecord(const void *ptr,
                                     uint64_t peak_reserved) {
   std::lock_guard<std::mutex> guard(mtx_);
   if (FLAGS_enable_host_event_recorder_hook) {  // new MemRecord
+    const std::string *op_name = RecordMemOwner::CurrentOp();
+    if (op_name != nullptr) {
+      HostEventRecorder<CommonMemEvent>::GetInstance().RecordEvent(
+          PosixInNsec(),
+          reinterpret_cast<uint64_t>(ptr),
+          type,
+          size,
+          place,
+          current_allocated,
+          current_reserved,
+          peak_allocated,
+          peak_reserved,
+          *op_name);
+      return;
+    }
     HostEventRecorder<CommonMemEvent>::GetInstance().RecordEvent(
         PosixInNsec(),
         reinterpret_cast<uint64_t>(ptr),
@@ -540,6 +583,21 @@ void MemEvenRecorder::PopMemRecord(const void *ptr,
                                    uint64_t peak_reserved) {
   std::lock_guard<std::mutex> guard(mtx_);
   if (FLAGS_enable_host_event_recorder_hook) {  // new MemRecord
+    const std::string *op_name = RecordMemOwner::CurrentOp();
+    if (op_name != nullptr) {
+      HostEventRecorder<CommonMemEvent>::GetInstance().RecordEvent(
+          PosixInNsec(),
+          reinterpret_cast<uint64_t>(ptr),
+          type,
+          -size,
+          place,
+          current_allocated,
+          current_reserved,
+          peak_allocated,
+          peak_reserved,
+          *op_name);
+      return;
+    }
     HostEventRecorder<CommonMemEvent>::GetInstance().RecordEvent(
         PosixInNsec(),
         reinterpret_cast<uint64_t>(ptr),
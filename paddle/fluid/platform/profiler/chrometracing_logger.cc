@@ -141,7 +141,9 @@ void ChromeTracingLogger::LogMemTraceEventNode(
       "current_allocated": %llu,
       "current_reserved": %llu,
       "peak_allocated": %llu,
-      "peak_reserved": %llu
+      "peak_reserved": %llu,
+      "op": "%s",
+      "var": "%s"
     }
   },
   )JSON"),
@@ -155,7 +157,28 @@ void ChromeTracingLogger::LogMemTraceEventNode(
       mem_node.CurrentAllocated(),
       mem_node.CurrentReserved(),
       mem_node.PeakAllocated(),
-      mem_node.PeakReserved());
+      mem_node.PeakReserved(),
+      mem_node.OpName().c_str(),
+      mem_node.VarName().c_str());
+  // allocation timeline of the place, shown as a counter track
+  output_file_stream_ << string_format(
+      std::string(
+          R"JSON(
+  {
+    "name": "memory %s", "pid": %lld,
+    "ts": %lld,
+    "ph": "C",
+    "args": {
+      "allocated": %llu,
+      "reserved": %llu
+    }
+  },
+  )JSON"),
+      mem_node.Place().c_str(),
+      mem_node.ProcessId(),
+      nsToUs(mem_node.TimeStampNs()),
+      mem_node.CurrentAllocated(),
+      mem_node.CurrentReserved());
   pid_tid_set_.insert({mem_node.ProcessId(), mem_node.ThreadId()});
 }
 
@@ -30,6 +30,8 @@ using CommonEvent = phi::CommonEvent;
 
 using CommonMemEvent = phi::CommonMemEvent;
 
+using CommonMemNameEvent = phi::CommonMemNameEvent;
+
 struct OperatorSupplementOriginEvent {
  public:
   OperatorSupplementOriginEvent(
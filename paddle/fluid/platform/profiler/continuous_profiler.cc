@@ -0,0 +1,134 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/profiler/continuous_profiler.h"
+
+#include <chrono>  // NOLINT
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/profiler/utils.h"
+
+namespace paddle {
+namespace platform {
+
+FileSummaryExporter::FileSummaryExporter(const std::string& filename,
+                                         bool dump_recent_events)
+    : dump_recent_events_(dump_recent_events) {
+  output_file_stream_.open(filename, std::ofstream::out | std::ofstream::app);
+  PADDLE_ENFORCE_EQ(
+      output_file_stream_.is_open(),
+      true,
+      platform::errors::Unavailable("Can not open %s to export profiling "
+                                    "summary.",
+                                    filename));
+}
+
+void FileSummaryExporter::Export(const AggregatedSummary& summary) {
+  uint64_t end_ms = summary.end_ns / 1000000;
+  for (const auto& kv : summary.histograms) {
+    const LatencyHistogram& histogram = kv.second;
+    output_file_stream_ << string_format(
+        std::string("%llu %s %s %llu %.3f %.3f %.3f %.3f %.3f %.3f\n"),
+        end_ms,
+        kv.first.c_str(),
+        StringTracerEventType(summary.types.at(kv.first)),
+        histogram.Count(),
+        histogram.SumNs() / 1000.0,
+        histogram.SumNs() / 1000.0 / histogram.Count(),
+        histogram.Percentile(0.5) / 1000.0,
+        histogram.Percentile(0.9) / 1000.0,
+        histogram.Percentile(0.99) / 1000.0,
+        histogram.MaxNs() / 1000.0);
+  }
+  if (dump_recent_events_) {
+    for (const auto& event : summary.recent_events) {
+      output_file_stream_ << "# event " << *event.name << " "
+                          << event.start_ns << " " << event.end_ns << "\n";
+    }
+  }
+  output_file_stream_.flush();
+}
+
+std::atomic<bool> ContinuousProfiler::alive_{false};
+
+std::unique_ptr<ContinuousProfiler> ContinuousProfiler::Create(
+    const ContinuousProfilerOptions& options,
+    std::unique_ptr<SummaryExporter> exporter) {
+  if (alive_.exchange(true)) {
+    return nullptr;
+  }
+  return std::unique_ptr<ContinuousProfiler>(
+      new ContinuousProfiler(options, std::move(exporter)));
+}
+
+ContinuousProfiler::ContinuousProfiler(
+    const ContinuousProfilerOptions& options,
+    std::unique_ptr<SummaryExporter> exporter)
+    : options_(options), exporter_(std::move(exporter)) {}
+
+ContinuousProfiler::~ContinuousProfiler() {
+  Stop();
+  alive_.store(false);
+}
+
+void ContinuousProfiler::Start() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (running_) {
+    return;
+  }
+  phi::EventAggregator::GetInstance().Enable(options_.aggregator_options);
+  running_ = true;
+  flush_thread_ = std::thread([this] { FlushLoop(); });
+}
+
+void ContinuousProfiler::Stop() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  cv_.notify_all();
+  flush_thread_.join();
+  phi::EventAggregator::GetInstance().Disable();
+  Flush();
+}
+
+void ContinuousProfiler::Flush() {
+  AggregatedSummary summary = phi::EventAggregator::GetInstance().Flush();
+  std::lock_guard<std::mutex> guard(export_mutex_);
+  if (exporter_ != nullptr) {
+    exporter_->Export(summary);
+  }
+}
+
+void ContinuousProfiler::FlushLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    cv_.wait_for(lock,
+                 std::chrono::seconds(options_.flush_interval_s),
+                 [this] { return !running_; });
+    if (!running_) {
+      break;
+    }
+    lock.unlock();
+    Flush();
+    lock.lock();
+  }
+}
+
+}  // namespace platform
+}  // namespace paddle
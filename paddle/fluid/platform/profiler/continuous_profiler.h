@@ -0,0 +1,100 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/phi/api/profiler/event_aggregator.h"
+
+namespace paddle {
+namespace platform {
+
+using AggregatedSummary = phi::AggregatedSummary;
+using LatencyHistogram = phi::LatencyHistogram;
+
+class SummaryExporter {
+ public:
+  virtual ~SummaryExporter() {}
+  virtual void Export(const AggregatedSummary& summary) = 0;
+};
+
+// Appends one line per event name and flush:
+// end_ms name type count total_us avg_us p50_us p90_us p99_us max_us
+// the recent events are written as "# event name start_ns end_ns" lines if
+// dump_recent_events is set.
+class FileSummaryExporter : public SummaryExporter {
+ public:
+  explicit FileSummaryExporter(const std::string& filename,
+                               bool dump_recent_events = false);
+  void Export(const AggregatedSummary& summary) override;
+
+ private:
+  std::ofstream output_file_stream_;
+  bool dump_recent_events_;
+};
+
+struct ContinuousProfilerOptions {
+  phi::AggregatorOptions aggregator_options;
+  uint32_t flush_interval_s = 60;
+};
+
+// Always-on profiling for production jobs. Instead of tracing every event
+// like Profiler, RecordEvent is aggregated online into per-thread latency
+// histograms, and a background thread hands a summary to the exporter every
+// flush_interval_s seconds. Only one ContinuousProfiler can be alive.
+class ContinuousProfiler {
+ public:
+  static std::unique_ptr<ContinuousProfiler> Create(
+      const ContinuousProfilerOptions& options,
+      std::unique_ptr<SummaryExporter> exporter);
+
+  void Start();
+
+  // stops aggregation and exports what is left
+  void Stop();
+
+  // export a summary right now, thread-safe
+  void Flush();
+
+  ~ContinuousProfiler();
+
+ private:
+  ContinuousProfiler(const ContinuousProfilerOptions& options,
+                     std::unique_ptr<SummaryExporter> exporter);
+
+  DISABLE_COPY_AND_ASSIGN(ContinuousProfiler);
+
+  void FlushLoop();
+
+  static std::atomic<bool> alive_;
+  ContinuousProfilerOptions options_;
+  std::unique_ptr<SummaryExporter> exporter_;
+  std::mutex export_mutex_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  std::thread flush_thread_;
+};
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,197 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/profiler/continuous_profiler.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/profiler/event_tracing.h"
+
+using paddle::platform::AggregatedSummary;
+using paddle::platform::ContinuousProfiler;
+using paddle::platform::ContinuousProfilerOptions;
+using paddle::platform::LatencyHistogram;
+using paddle::platform::RecordEvent;
+using paddle::platform::SummaryExporter;
+using paddle::platform::TracerEventType;
+
+class CollectExporter : public SummaryExporter {
+ public:
+  explicit CollectExporter(std::vector<AggregatedSummary>* summaries)
+      : summaries_(summaries) {}
+  void Export(const AggregatedSummary& summary) override {
+    summaries_->push_back(summary);
+  }
+
+ private:
+  std::vector<AggregatedSummary>* summaries_;
+};
+
+TEST(ContinuousProfilerTest, TestLatencyHistogram) {
+  LatencyHistogram histogram;
+  for (uint64_t ns = 1; ns <= 1000; ++ns) {
+    histogram.Add(ns * 1000);
+  }
+  EXPECT_EQ(histogram.Count(), 1000u);
+  EXPECT_EQ(histogram.MinNs(), 1000u);
+  EXPECT_EQ(histogram.MaxNs(), 1000000u);
+  // log-linear buckets with 4 sub buckets are within 25%
+  for (double p : {0.5, 0.9, 0.99}) {
+    double expect = p * 1000000;
+    EXPECT_GE(histogram.Percentile(p), expect);
+    EXPECT_LE(histogram.Percentile(p), expect * 1.25);
+  }
+  LatencyHistogram other;
+  other.Add(5);
+  histogram.Merge(other);
+  EXPECT_EQ(histogram.Count(), 1001u);
+  EXPECT_EQ(histogram.MinNs(), 5u);
+}
+
+TEST(ContinuousProfilerTest, TestAggregate) {
+  std::vector<AggregatedSummary> summaries;
+  ContinuousProfilerOptions options;
+  options.aggregator_options.trace_level = 2;
+  options.aggregator_options.ring_buffer_size = 8;
+  options.flush_interval_s = 3600;
+  auto profiler = ContinuousProfiler::Create(
+      options,
+      std::unique_ptr<SummaryExporter>(new CollectExporter(&summaries)));
+  EXPECT_TRUE(profiler);
+  EXPECT_FALSE(ContinuousProfiler::Create(options, nullptr));
+  profiler->Start();
+  auto run = [](int times) {
+    for (int i = 0; i < times; ++i) {
+      RecordEvent op_event("matmul", TracerEventType::Operator, 1);
+      RecordEvent inner_event(
+          std::string("matmul_compute"), TracerEventType::OperatorInner, 2);
+      RecordEvent filtered_event("filtered", TracerEventType::UserDefined, 3);
+    }
+  };
+  std::thread worker(run, 100);
+  run(50);
+  worker.join();
+  profiler->Stop();
+
+  ASSERT_EQ(summaries.size(), 1u);
+  const auto& histograms = summaries[0].histograms;
+  EXPECT_EQ(histograms.size(), 2u);
+  EXPECT_EQ(histograms.at("matmul").Count(), 150u);
+  EXPECT_EQ(histograms.at("matmul_compute").Count(), 150u);
+  EXPECT_EQ(histograms.count("filtered"), 0u);
+  EXPECT_EQ(summaries[0].types.at("matmul"), TracerEventType::Operator);
+  // ring buffers of two threads
+  EXPECT_EQ(summaries[0].recent_events.size(), 16u);
+}
+
+namespace {
+
+// a small cpu mlp, every layer is recorded like an operator
+class CpuMlp {
+ public:
+  CpuMlp(int batch, int width, int layers)
+      : batch_(batch), width_(width), layers_(layers) {
+    weight_.resize(width * width);
+    for (size_t i = 0; i < weight_.size(); ++i) {
+      weight_[i] = 0.001f * static_cast<float>(i % 97);
+    }
+    input_.assign(batch * width, 0.5f);
+    output_.resize(batch * width);
+  }
+
+  float Forward() {
+    for (int l = 0; l < layers_; ++l) {
+      {
+        RecordEvent record_event("matmul", TracerEventType::Operator, 1);
+        for (int b = 0; b < batch_; ++b) {
+          for (int j = 0; j < width_; ++j) {
+            float sum = 0.f;
+            for (int k = 0; k < width_; ++k) {
+              sum += input_[b * width_ + k] * weight_[k * width_ + j];
+            }
+            output_[b * width_ + j] = sum;
+          }
+        }
+      }
+      {
+        RecordEvent record_event("relu", TracerEventType::Operator, 1);
+        for (size_t i = 0; i < output_.size(); ++i) {
+          input_[i] = std::max(output_[i], 0.f) * 0.01f;
+        }
+      }
+    }
+    return input_[0];
+  }
+
+ private:
+  int batch_;
+  int width_;
+  int layers_;
+  std::vector<float> weight_;
+  std::vector<float> input_;
+  std::vector<float> output_;
+};
+
+double RunMlp(CpuMlp* mlp, int steps) {
+  // best of several rounds to filter out noise of the machine
+  double best = 1e30;
+  for (int round = 0; round < 5; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+      mlp->Forward();
+    }
+    std::chrono::duration<double> cost =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, cost.count());
+  }
+  return best;
+}
+
+}  // namespace
+
+TEST(ContinuousProfilerTest, BenchmarkOverhead) {
+  CpuMlp mlp(16, 128, 8);
+  const int steps = 50;
+  RunMlp(&mlp, steps);  // warm up
+  double base_cost = RunMlp(&mlp, steps);
+
+  std::vector<AggregatedSummary> summaries;
+  ContinuousProfilerOptions options;
+  options.flush_interval_s = 1;
+  auto profiler = ContinuousProfiler::Create(
+      options,
+      std::unique_ptr<SummaryExporter>(new CollectExporter(&summaries)));
+  EXPECT_TRUE(profiler);
+  profiler->Start();
+  double profile_cost = RunMlp(&mlp, steps);
+  profiler->Stop();
+
+  uint64_t op_count = 0;
+  for (const auto& summary : summaries) {
+    for (const auto& kv : summary.histograms) {
+      op_count += kv.second.Count();
+    }
+  }
+  EXPECT_EQ(op_count, 5u * steps * 8 * 2);
+  LOG(INFO) << "cpu mlp step: " << base_cost / steps * 1e3
+            << " ms, with continuous profiling: "
+            << profile_cost / steps * 1e3 << " ms, overhead: "
+            << (profile_cost / base_cost - 1.0) * 100 << "%";
+}
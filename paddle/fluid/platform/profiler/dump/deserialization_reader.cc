@@ -262,6 +262,8 @@ MemTraceEventNode* DeserializationReader::RestoreMemTraceEventNode(
   mem_event.current_reserved = mem_event_proto.current_reserved();
   mem_event.peak_allocated = mem_event_proto.peak_allocated();
   mem_event.peak_reserved = mem_event_proto.peak_reserved();
+  mem_event.op_name = mem_event_proto.op_name();
+  mem_event.var_name = mem_event_proto.var_name();
   return new MemTraceEventNode(mem_event);
 }
 
@@ -49,6 +49,8 @@ class MemTraceEventNode {
   uint64_t CurrentReserved() const { return mem_event_.current_reserved; }
   uint64_t PeakAllocated() const { return mem_event_.peak_allocated; }
   uint64_t PeakReserved() const { return mem_event_.peak_reserved; }
+  const std::string& OpName() const { return mem_event_.op_name; }
+  const std::string& VarName() const { return mem_event_.var_name; }
 
   // member function
   void LogMe(BaseLogger* logger) { logger->LogMemTraceEventNode(*this); }
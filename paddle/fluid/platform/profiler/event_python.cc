@@ -122,6 +122,8 @@ HostPythonNode* ProfilerResult::CopyTree(HostTraceEventNode* root) {
     mem_python_node->current_reserved = (*memnode)->CurrentReserved();
     mem_python_node->peak_allocated = (*memnode)->PeakAllocated();
     mem_python_node->peak_reserved = (*memnode)->PeakReserved();
+    mem_python_node->op_name = (*memnode)->OpName();
+    mem_python_node->var_name = (*memnode)->VarName();
     host_python_node->mem_node_ptrs.push_back(mem_python_node);
   }
   // copy OperatorSupplementEventNode's information if exists
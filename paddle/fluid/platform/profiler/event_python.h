@@ -97,6 +97,10 @@ struct MemPythonNode {
   uint64_t peak_allocated;
   // peak  reserved memory
   uint64_t peak_reserved;
+  // operator running when the memory is manipulated
+  std::string op_name;
+  // variable holding the allocation
+  std::string var_name;
 };
 
 struct HostPythonNode {
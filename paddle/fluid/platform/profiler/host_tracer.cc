@@ -13,7 +13,10 @@
 // limitations under the License.
 #include "paddle/fluid/platform/profiler/host_tracer.h"
 
+#include <algorithm>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
 #include "glog/logging.h"
 #include "paddle/fluid/framework/op_proto_maker.h"
@@ -55,7 +58,9 @@ void ProcessHostEvents(const HostEventSection<CommonEvent>& host_events,
 
 void ProcessHostMemEvents(
     const HostEventSection<CommonMemEvent>& host_mem_events,
+    const HostEventSection<CommonMemNameEvent>& host_mem_name_events,
     TraceEventCollector* collector) {
+  std::vector<MemTraceEvent> mem_events;
   for (const auto& thr_sec : host_mem_events.thr_sections) {
     uint64_t tid = thr_sec.thread_id;
     if (thr_sec.thread_name != phi::kDefaultThreadName) {
@@ -72,11 +77,52 @@ void ProcessHostMemEvents(
       event.current_reserved = evt.current_reserved;
       event.peak_allocated = evt.peak_allocated;
       event.peak_reserved = evt.peak_reserved;
+      if (evt.op_name != nullptr) {
+        event.op_name = evt.op_name;
+      }
       event.process_id = host_mem_events.process_id;
       event.thread_id = tid;
-      collector->AddMemEvent(std::move(event));
+      mem_events.push_back(std::move(event));
+    }
+  }
+  // a variable name belongs to the latest allocation of the same address
+  // before it is recorded
+  std::unordered_map<uint64_t, std::vector<size_t>> allocations;
+  for (size_t i = 0; i < mem_events.size(); ++i) {
+    if (mem_events[i].type == TracerMemEventType::Allocate) {
+      allocations[mem_events[i].addr].push_back(i);
+    }
+  }
+  for (auto& kv : allocations) {
+    std::sort(kv.second.begin(),
+              kv.second.end(),
+              [&mem_events](size_t a, size_t b) {
+                return mem_events[a].timestamp_ns < mem_events[b].timestamp_ns;
+              });
+  }
+  for (const auto& thr_sec : host_mem_name_events.thr_sections) {
+    for (const auto& evt : thr_sec.events) {
+      auto iter = allocations.find(evt.addr);
+      if (iter == allocations.end()) {
+        continue;
+      }
+      const auto& indices = iter->second;
+      auto upper = std::upper_bound(
+          indices.begin(),
+          indices.end(),
+          evt.timestamp_ns,
+          [&mem_events](uint64_t ts, size_t idx) {
+            return ts < mem_events[idx].timestamp_ns;
+          });
+      if (upper == indices.begin()) {
+        continue;
+      }
+      mem_events[*(upper - 1)].var_name = evt.var_name;
     }
   }
+  for (auto& event : mem_events) {
+    collector->AddMemEvent(std::move(event));
+  }
 }
 
 void ProcessOperatorSupplementEvents(
@@ -154,6 +200,7 @@ void HostTracer::StartTracing() {
       platform::errors::PreconditionNotMet("TracerState must be READY"));
   HostEventRecorder<CommonEvent>::GetInstance().GatherEvents();
   HostEventRecorder<CommonMemEvent>::GetInstance().GatherEvents();
+  HostEventRecorder<CommonMemNameEvent>::GetInstance().GatherEvents();
   HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance()
       .GatherEvents();
   HostTraceLevel::GetInstance().SetLevel(options_.trace_level);
@@ -179,7 +226,9 @@ void HostTracer::CollectTraceData(TraceEventCollector* collector) {
   ProcessHostEvents(host_events, collector);
   HostEventSection<CommonMemEvent> host_mem_events =
       HostEventRecorder<CommonMemEvent>::GetInstance().GatherEvents();
-  ProcessHostMemEvents(host_mem_events, collector);
+  HostEventSection<CommonMemNameEvent> host_mem_name_events =
+      HostEventRecorder<CommonMemNameEvent>::GetInstance().GatherEvents();
+  ProcessHostMemEvents(host_mem_events, host_mem_name_events, collector);
   HostEventSection<OperatorSupplementOriginEvent> op_supplement_events =
       HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance()
           .GatherEvents();
@@ -52,5 +52,25 @@ class RecordMemEvent {
   static std::map<const char*, std::map<uint64_t, bool>> has_initialized;
 };
 
+// Attributes the memory events recorded on this thread to an operator until
+// the object is destroyed. op_type must outlive the object.
+class RecordMemOwner {
+ public:
+  explicit RecordMemOwner(const std::string& op_type);
+
+  ~RecordMemOwner();
+
+  // nullptr if no operator is running on this thread
+  static const std::string* CurrentOp();
+
+ private:
+  bool is_enabled_{false};
+  const std::string* prev_op_{nullptr};
+};
+
+// Names the variable whose tensor holds the allocation at ptr, used to
+// attribute the allocation to the variable in memory summaries.
+void RecordMemVarName(const void* ptr, const std::string& var_name);
+
 }  // namespace platform
 }  // namespace paddle
@@ -141,3 +141,64 @@ TEST(ProfilerTest, TestHostTracerForMem) {
   auto profiler_result = profiler->Stop();
   auto nodetree = profiler_result->GetNodeTrees();
 }
+
+TEST(ProfilerTest, TestMemOwner) {
+  using paddle::platform::CPUPlace;
+  using paddle::platform::DisableMemoryRecorder;
+  using paddle::platform::EnableHostEventRecorder;
+  using paddle::platform::EnableMemoryRecorder;
+  using paddle::platform::MemTraceEventNode;
+  using paddle::platform::Profiler;
+  using paddle::platform::ProfilerOptions;
+  using paddle::platform::RecordEvent;
+  using paddle::platform::RecordMemEvent;
+  using paddle::platform::RecordMemOwner;
+  using paddle::platform::RecordMemVarName;
+  using paddle::platform::TracerEventType;
+  using paddle::platform::TracerMemEventType;
+  ProfilerOptions options;
+  options.trace_level = 1;
+  options.trace_switch = 3;
+  auto profiler = Profiler::Create(options);
+  EXPECT_TRUE(profiler);
+  EnableHostEventRecorder();
+  EnableMemoryRecorder();
+  profiler->Prepare();
+  profiler->Start();
+  const std::string op_type("TestMemOwner_op");
+  {
+    RecordEvent event(op_type, TracerEventType::Operator, 1);
+    RecordMemOwner mem_owner(op_type);
+    RecordMemEvent(reinterpret_cast<void*>(2048),
+                   CPUPlace(),
+                   1024,
+                   TracerMemEventType::Allocate);
+    RecordMemVarName(reinterpret_cast<void*>(2048), "TestMemOwner_var");
+  }
+  RecordMemEvent(
+      reinterpret_cast<void*>(2048), CPUPlace(), 1024, TracerMemEventType::Free);
+  auto profiler_result = profiler->Stop();
+  DisableMemoryRecorder();
+  auto nodetree = profiler_result->GetNodeTrees();
+  int allocate_num = 0;
+  int free_num = 0;
+  for (const auto& pair : nodetree->Traverse(true)) {
+    for (const auto evt : pair.second) {
+      for (const MemTraceEventNode* mem_node : evt->GetMemTraceEventNodes()) {
+        if (mem_node->Addr() != 2048) {
+          continue;
+        }
+        if (mem_node->Type() == TracerMemEventType::Allocate) {
+          ++allocate_num;
+          EXPECT_EQ(mem_node->OpName(), op_type);
+          EXPECT_EQ(mem_node->VarName(), "TestMemOwner_var");
+        } else if (mem_node->Type() == TracerMemEventType::Free) {
+          ++free_num;
+          EXPECT_EQ(mem_node->OpName(), "");
+        }
+      }
+    }
+  }
+  EXPECT_EQ(allocate_num, 1);
+  EXPECT_EQ(free_num, 1);
+}
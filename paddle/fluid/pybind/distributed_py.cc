@@ -1279,7 +1279,16 @@ void BindDistributed(py::module *m) {
                   py::arg("group_id") = 0,
                   py::call_guard<py::gil_scoped_release>())
       .def_static("create_default_device",
-                  &ProcessGroupGloo::createDefaultDevice);
+                  &ProcessGroupGloo::createDefaultDevice)
+      .def("set_hierarchical_allreduce",
+           &ProcessGroupGloo::SetHierarchicalAllReduce,
+           py::arg("enable"),
+           py::arg("node_key") = "",
+           py::arg("chunk_bytes") =
+               distributed::GlooHierarchicalAllReduce::kDefaultChunkBytes,
+           py::arg("small_bytes") =
+               distributed::GlooHierarchicalAllReduce::kDefaultSmallBytes,
+           py::call_guard<py::gil_scoped_release>());
 #endif
 
   m->def(
@@ -94,6 +94,32 @@ struct CommonMemEvent {
         current_reserved(current_reserved),
         peak_allocated(peak_allocated),
         peak_reserved(peak_reserved) {}
+
+  CommonMemEvent(std::function<void *(size_t)> arena_allocator,
+                 uint64_t timestamp_ns,
+                 uint64_t addr,
+                 TracerMemEventType type,
+                 int64_t increase_bytes,
+                 const Place &place,
+                 uint64_t current_allocated,
+                 uint64_t current_reserved,
+                 uint64_t peak_allocated,
+                 uint64_t peak_reserved,
+                 const std::string &op_name_str)
+      : timestamp_ns(timestamp_ns),
+        addr(addr),
+        type(type),
+        increase_bytes(increase_bytes),
+        place(place),
+        current_allocated(current_allocated),
+        current_reserved(current_reserved),
+        peak_allocated(peak_allocated),
+        peak_reserved(peak_reserved) {
+    auto buf = static_cast<char *>(arena_allocator(op_name_str.length() + 1));
+    strncpy(buf, op_name_str.c_str(), op_name_str.length() + 1);
+    op_name = buf;
+  }
+
   uint64_t timestamp_ns;
   uint64_t addr;
   TracerMemEventType type;
@@ -103,6 +129,28 @@ struct CommonMemEvent {
   uint64_t current_reserved;
   uint64_t peak_allocated;
   uint64_t peak_reserved;
+  // operator running when the memory is manipulated
+  const char *op_name = nullptr;  // not owned, designed for performance
+};
+
+// Names the variable whose tensor holds the allocation at addr, it belongs
+// to the latest allocation of addr before timestamp_ns.
+struct CommonMemNameEvent {
+ public:
+  CommonMemNameEvent(std::function<void *(size_t)> arena_allocator,
+                     uint64_t timestamp_ns,
+                     uint64_t addr,
+                     const std::string &var_name_str)
+      : timestamp_ns(timestamp_ns), addr(addr) {
+    auto buf =
+        static_cast<char *>(arena_allocator(var_name_str.length() + 1));
+    strncpy(buf, var_name_str.c_str(), var_name_str.length() + 1);
+    var_name = buf;
+  }
+
+  uint64_t timestamp_ns;
+  uint64_t addr;
+  const char *var_name = nullptr;  // not owned, designed for performance
 };
 
 struct OperatorSupplementOriginEvent {
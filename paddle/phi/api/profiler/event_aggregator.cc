@@ -0,0 +1,157 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/api/profiler/event_aggregator.h"
+
+#include <algorithm>
+
+#include "paddle/phi/common/thread_data_registry.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/os_info.h"
+
+namespace phi {
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  count_ += other.count_;
+  sum_ns_ += other.sum_ns_;
+  min_ns_ = std::min(min_ns_, other.min_ns_);
+  max_ns_ = std::max(max_ns_, other.max_ns_);
+  for (int i = 0; i < kNumBuckets; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  int msb = index / kSubBuckets + kSubBucketBits - 1;
+  uint64_t sub = index % kSubBuckets;
+  uint64_t width = uint64_t(1) << (msb - kSubBucketBits);
+  return (uint64_t(1) << msb) + sub * width + width - 1;
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(p * count_);
+  rank = std::max<uint64_t>(1, std::min(rank, count_));
+  uint64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min(std::max(BucketUpperBound(i), min_ns_), max_ns_);
+    }
+  }
+  return max_ns_;
+}
+
+AggregatedEventSlot* ThreadEventAggregator::NewSlot(const std::string& name,
+                                                    TracerEventType type) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& slot = slots_[name];
+  if (slot == nullptr) {
+    slot.reset(new AggregatedEventSlot);
+    slot->type = type;
+    slot->name = &slots_.find(name)->first;
+  }
+  return slot.get();
+}
+
+AggregatedEventSlot* ThreadEventAggregator::GetSlot(const char* name,
+                                                    TracerEventType type) {
+  auto itr = ptr_slots_.find(name);
+  if (LIKELY(itr != ptr_slots_.end())) {
+    return itr->second;
+  }
+  auto* slot = NewSlot(name, type);
+  ptr_slots_.emplace(name, slot);
+  return slot;
+}
+
+AggregatedEventSlot* ThreadEventAggregator::GetSlot(const std::string& name,
+                                                    TracerEventType type) {
+  auto itr = slots_.find(name);
+  if (LIKELY(itr != slots_.end())) {
+    return itr->second.get();
+  }
+  return NewSlot(name, type);
+}
+
+void ThreadEventAggregator::Flush(AggregatedSummary* summary) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto& kv : slots_) {
+    auto& histogram = kv.second->histogram;
+    if (histogram.Count() == 0) {
+      continue;
+    }
+    summary->histograms[kv.first].Merge(histogram);
+    summary->types[kv.first] = kv.second->type;
+    histogram.Clear();
+  }
+  size_t ring_num = std::min<uint64_t>(ring_pos_, ring_buffer_.size());
+  for (size_t i = ring_pos_ - ring_num; i < ring_pos_; ++i) {
+    summary->recent_events.push_back(ring_buffer_[i % ring_buffer_.size()]);
+  }
+  ring_pos_ = 0;
+}
+
+std::atomic<bool> EventAggregator::enabled_{false};
+
+void EventAggregator::Enable(const AggregatorOptions& options) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  options_ = options;
+  options_.sample_period = std::max<uint32_t>(options_.sample_period, 1);
+  last_flush_ns_ = PosixInNsec();
+  enabled_.store(true);
+}
+
+void EventAggregator::Disable() { enabled_.store(false); }
+
+ThreadEventAggregator* EventAggregator::GetThreadAggregator() {
+  using ThreadAggregatorRegistry =
+      ThreadDataRegistry<std::shared_ptr<ThreadEventAggregator>>;
+  auto* thr_aggregator =
+      ThreadAggregatorRegistry::GetInstance().GetMutableCurrentThreadData();
+  if (UNLIKELY(thr_aggregator->get() == nullptr)) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    *thr_aggregator =
+        std::make_shared<ThreadEventAggregator>(options_.ring_buffer_size);
+    thr_aggregators_.push_back(*thr_aggregator);
+  }
+  return thr_aggregator->get();
+}
+
+AggregatedSummary EventAggregator::Flush() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  AggregatedSummary summary;
+  summary.start_ns = last_flush_ns_;
+  summary.end_ns = PosixInNsec();
+  last_flush_ns_ = summary.end_ns;
+  for (auto& thr_aggregator : thr_aggregators_) {
+    thr_aggregator->Flush(&summary);
+  }
+  std::sort(summary.recent_events.begin(),
+            summary.recent_events.end(),
+            [](const AggregatedEvent& a, const AggregatedEvent& b) {
+              return a.start_ns < b.start_ns;
+            });
+  return summary;
+}
+
+}  // namespace phi
@@ -0,0 +1,225 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/phi/api/profiler/trace_event.h"
+#include "paddle/phi/core/macros.h"
+
+namespace phi {
+
+// Latency histogram with log-linear buckets: every power of two of the
+// nanosecond latency is split into kSubBuckets linear buckets, which bounds
+// the relative error of a percentile to 1 / kSubBuckets.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 2;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kNumBuckets = 64 * kSubBuckets;
+
+  void Add(uint64_t ns) {
+    ++count_;
+    sum_ns_ += ns;
+    min_ns_ = ns < min_ns_ ? ns : min_ns_;
+    max_ns_ = ns > max_ns_ ? ns : max_ns_;
+    ++buckets_[BucketIndex(ns)];
+  }
+
+  void Merge(const LatencyHistogram& other);
+
+  void Clear() { *this = LatencyHistogram(); }
+
+  // p in [0, 1], returns the upper bound of the bucket holding p
+  uint64_t Percentile(double p) const;
+
+  uint64_t Count() const { return count_; }
+  uint64_t SumNs() const { return sum_ns_; }
+  uint64_t MinNs() const { return count_ == 0 ? 0 : min_ns_; }
+  uint64_t MaxNs() const { return max_ns_; }
+
+ private:
+  static int BucketIndex(uint64_t ns) {
+    if (ns < kSubBuckets) {
+      return static_cast<int>(ns);
+    }
+    int msb = HighestBit(ns);
+    int sub = static_cast<int>((ns >> (msb - kSubBucketBits)) &
+                               (kSubBuckets - 1));
+    return (msb - kSubBucketBits + 1) * kSubBuckets + sub;
+  }
+  static int HighestBit(uint64_t v) {
+    int bit = 0;
+    for (int shift = 32; shift > 0; shift >>= 1) {
+      if (v >> shift) {
+        v >>= shift;
+        bit += shift;
+      }
+    }
+    return bit;
+  }
+  static uint64_t BucketUpperBound(int index);
+
+  uint64_t count_ = 0;
+  uint64_t sum_ns_ = 0;
+  uint64_t min_ns_ = UINT64_MAX;
+  uint64_t max_ns_ = 0;
+  uint32_t buckets_[kNumBuckets] = {0};
+};
+
+struct AggregatedEvent {
+  const std::string* name;
+  TracerEventType type;
+  uint64_t start_ns;
+  uint64_t end_ns;
+};
+
+// Aggregation state of one event name on one thread. Slots are never
+// released, so RecordEvent can hold a pointer from its construction to End.
+struct AggregatedEventSlot {
+  const std::string* name = nullptr;
+  TracerEventType type = TracerEventType::UserDefined;
+  LatencyHistogram histogram;
+};
+
+struct AggregatorOptions {
+  // events with a level not larger than trace_level are aggregated
+  uint32_t trace_level = 1;
+  // aggregate one of every sample_period events of a thread
+  uint32_t sample_period = 1;
+  // number of recent events kept per thread
+  size_t ring_buffer_size = 4096;
+};
+
+struct AggregatedSummary {
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+  // histograms of all threads, keyed by event name
+  std::map<std::string, LatencyHistogram> histograms;
+  std::map<std::string, TracerEventType> types;
+  // the most recent events of every thread, the name points into the slots
+  std::vector<AggregatedEvent> recent_events;
+};
+
+// Per-thread state of EventAggregator: a histogram per event name and a
+// fixed-size ring buffer of the latest events. Only the owner thread writes
+// the slot map, the flusher reads it under mutex_.
+class ThreadEventAggregator {
+ public:
+  explicit ThreadEventAggregator(size_t ring_buffer_size)
+      : ring_buffer_(ring_buffer_size) {}
+
+  bool Sample(uint32_t sample_period) {
+    if (++sample_counter_ < sample_period) {
+      return false;
+    }
+    sample_counter_ = 0;
+    return true;
+  }
+
+  AggregatedEventSlot* GetSlot(const char* name, TracerEventType type);
+
+  AggregatedEventSlot* GetSlot(const std::string& name, TracerEventType type);
+
+  void Record(AggregatedEventSlot* slot, uint64_t start_ns, uint64_t end_ns) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    slot->histogram.Add(end_ns - start_ns);
+    if (!ring_buffer_.empty()) {
+      ring_buffer_[ring_pos_ % ring_buffer_.size()] =
+          AggregatedEvent{slot->name, slot->type, start_ns, end_ns};
+      ++ring_pos_;
+    }
+  }
+
+  // merge into summary and reset the histograms
+  void Flush(AggregatedSummary* summary);
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(ThreadEventAggregator);
+
+  AggregatedEventSlot* NewSlot(const std::string& name, TracerEventType type);
+
+  std::mutex mutex_;
+  uint32_t sample_counter_ = 0;
+  // const char* names are mostly literals, look them up by address first
+  std::unordered_map<const char*, AggregatedEventSlot*> ptr_slots_;
+  std::unordered_map<std::string, std::unique_ptr<AggregatedEventSlot>>
+      slots_;
+  std::vector<AggregatedEvent> ring_buffer_;
+  uint64_t ring_pos_ = 0;
+};
+
+// Online aggregation of RecordEvent for continuous profiling. Unlike
+// HostEventRecorder it does not keep every event, memory is bounded by the
+// number of event names and the ring buffer size.
+class EventAggregator {
+ public:
+  static EventAggregator& GetInstance() {
+    static EventAggregator instance;
+    return instance;
+  }
+
+  static bool IsEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  void Enable(const AggregatorOptions& options);
+
+  void Disable();
+
+  // returns nullptr if the event is filtered out or not sampled
+  template <typename NameType>
+  AggregatedEventSlot* BeginEvent(const NameType& name,
+                                  TracerEventType type,
+                                  uint32_t level) {
+    if (level > options_.trace_level) {
+      return nullptr;
+    }
+    auto* thr_aggregator = GetThreadAggregator();
+    if (!thr_aggregator->Sample(options_.sample_period)) {
+      return nullptr;
+    }
+    return thr_aggregator->GetSlot(name, type);
+  }
+
+  void EndEvent(AggregatedEventSlot* slot, uint64_t start_ns, uint64_t end_ns) {
+    GetThreadAggregator()->Record(slot, start_ns, end_ns);
+  }
+
+  // summary since the last Flush, thread-safe
+  AggregatedSummary Flush();
+
+ private:
+  EventAggregator() = default;
+  DISABLE_COPY_AND_ASSIGN(EventAggregator);
+
+  ThreadEventAggregator* GetThreadAggregator();
+
+  static std::atomic<bool> enabled_;
+  AggregatorOptions options_;
+  uint64_t last_flush_ns_ = 0;
+  std::mutex mutex_;
+  // aggregators outlive their threads so that no sample is lost
+  std::vector<std::shared_ptr<ThreadEventAggregator>> thr_aggregators_;
+};
+
+}  // namespace phi
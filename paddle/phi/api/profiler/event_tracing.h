@@ -21,6 +21,8 @@ limitations under the License. */
 
 namespace phi {
 
+struct AggregatedEventSlot;
+
 // Default tracing level.
 // It is Recommended to set the level explicitly.
 static constexpr uint32_t kDefaultTraceLevel = 4;
@@ -91,6 +93,9 @@ class RecordEvent {
   TracerEventType type_{TracerEventType::UserDefined};
   std::string* attr_{nullptr};
   bool finished_{false};
+  // set when the event is aggregated by EventAggregator
+  AggregatedEventSlot* aggregate_slot_{nullptr};
+  uint64_t aggregate_start_ns_;
 };
 
 }  // namespace phi
@@ -22,6 +22,7 @@ limitations under the License. */
 
 #include "paddle/phi/api/profiler/common_event.h"
 #include "paddle/phi/api/profiler/device_tracer.h"
+#include "paddle/phi/api/profiler/event_aggregator.h"
 #include "paddle/phi/api/profiler/host_event_recorder.h"
 #include "paddle/phi/api/profiler/host_tracer.h"
 #include "paddle/phi/api/profiler/profiler_helper.h"
@@ -106,6 +107,13 @@ RecordEvent::RecordEvent(const char *name,
   }
 #endif
 #endif
+  if (UNLIKELY(EventAggregator::IsEnabled())) {
+    aggregate_slot_ =
+        EventAggregator::GetInstance().BeginEvent(name, type, level);
+    if (aggregate_slot_ != nullptr) {
+      aggregate_start_ns_ = PosixInNsec();
+    }
+  }
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
     return;
   }
@@ -140,6 +148,13 @@ RecordEvent::RecordEvent(const std::string &name,
   }
 #endif
 #endif
+  if (UNLIKELY(EventAggregator::IsEnabled())) {
+    aggregate_slot_ =
+        EventAggregator::GetInstance().BeginEvent(name, type, level);
+    if (aggregate_slot_ != nullptr) {
+      aggregate_start_ns_ = PosixInNsec();
+    }
+  }
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
     return;
   }
@@ -174,6 +189,13 @@ RecordEvent::RecordEvent(const std::string &name,
 #endif
 #endif
 
+  if (UNLIKELY(EventAggregator::IsEnabled())) {
+    aggregate_slot_ =
+        EventAggregator::GetInstance().BeginEvent(name, type, level);
+    if (aggregate_slot_ != nullptr) {
+      aggregate_start_ns_ = PosixInNsec();
+    }
+  }
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
     return;
   }
@@ -222,6 +244,11 @@ void RecordEvent::End() {
   }
 #endif
 #endif
+  if (UNLIKELY(aggregate_slot_ != nullptr)) {
+    EventAggregator::GetInstance().EndEvent(
+        aggregate_slot_, aggregate_start_ns_, PosixInNsec());
+    aggregate_slot_ = nullptr;
+  }
   if (LIKELY(FLAGS_enable_host_event_recorder_hook && is_enabled_)) {
     uint64_t end_ns = PosixInNsec();
     if (LIKELY(shallow_copy_name_ != nullptr)) {
@@ -265,6 +292,7 @@ void RecordEvent::End() {
 
 bool RecordEvent::IsEnabled() {
   return FLAGS_enable_host_event_recorder_hook ||
+         EventAggregator::IsEnabled() ||
          ProfilerHelper::g_enable_nvprof_hook ||
          ProfilerHelper::g_state != ProfilerState::kDisabled;
 }
@@ -331,6 +331,10 @@ struct MemTraceEvent {
   uint64_t peak_allocated;
   // current peak reserved memory
   uint64_t peak_reserved;
+  // operator running when the memory is manipulated, empty if unknown
+  std::string op_name;
+  // variable holding the allocation, empty if unknown
+  std::string var_name;
 };
 
 }  // namespace phi
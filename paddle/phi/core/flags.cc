@@ -1222,3 +1222,96 @@ PADDLE_DEFINE_EXPORTED_bool(use_shm_cache,
 PADDLE_DEFINE_EXPORTED_string(tensor_operants_mode,
                               "eager",
                               "Tensor operants mode");
+
+/**
+ * Eager backward related FLAG
+ * Name: eager_backward_replay
+ * Since Version: 2.5.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, the order of grad nodes and the input buffers of a backward
+ * pass are recorded on the first step and replayed on later steps with the
+ * same backward graph, skipping the in-degree pass and the dynamic ready
+ * queue. Only used by paddle.autograd.backward / Tensor.backward, a graph
+ * that differs from the recorded one runs the ordinary traversal.
+ */
+PADDLE_DEFINE_EXPORTED_bool(eager_backward_replay,
+                            false,
+                            "Replay recorded backward graphs in eager mode.");
+
+/**
+ * Eager backward related FLAG
+ * Name: eager_backward_num_threads
+ * Since Version: 2.5.0
+ * Value Range: int32, default=0
+ * Example:
+ * Note: If larger than 1, the grad nodes of a backward pass whose inputs are
+ * ready run on a pool of this many threads, so independent branches of the
+ * backward graph run in parallel. Only used by paddle.autograd.backward /
+ * Tensor.backward.
+ */
+PADDLE_DEFINE_EXPORTED_int32(eager_backward_num_threads,
+                             0,
+                             "Number of threads to run eager grad nodes.");
+
+/**
+ * Eager backward related FLAG
+ * Name: eager_backward_deterministic
+ * Since Version: 2.5.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, the parallel backward sums the grads flowing into a node in
+ * a fixed order instead of the order in which they arrive, so results are
+ * reproducible across runs.
+ */
+PADDLE_DEFINE_EXPORTED_bool(eager_backward_deterministic,
+                            false,
+                            "Sum grads in a fixed order in parallel backward.");
+
+/**
+ * Fleet executor related FLAG
+ * Name: fleet_executor_shm_transport
+ * Since Version: 2.5.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: If True, the message bus of the fleet executor sends the messages
+ * between ranks on the same host through shared memory queues instead of
+ * brpc. Ranks are on the same host if their addresses have the same ip.
+ */
+PADDLE_DEFINE_EXPORTED_bool(fleet_executor_shm_transport,
+                            true,
+                            "Send fleet executor messages between ranks on "
+                            "the same host through shared memory.");
+
+/**
+ * Executor related FLAG
+ * Name: executor_var_slots
+ * Since Version: 2.5.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, the NaiveExecutor and the Executor without local scope
+ * resolve the input and output names of every op to slots of the scope when
+ * the ops are prepared and look up the variables of the slots once per run,
+ * so running an op fetches its variables by index instead of looking up
+ * every name in the scope chain.
+ */
+PADDLE_DEFINE_EXPORTED_bool(executor_var_slots,
+                            false,
+                            "Resolve the variables of prepared ops to scope "
+                            "slots once instead of on every run.");
+
+/**
+ * Operator related FLAG
+ * Name: save_load_combine_threads
+ * Since Version: 2.5.0
+ * Value Range: int32, default=1
+ * Example:
+ * Note: If larger than 1, save_combine and load_combine write and read the
+ * tensors of a file at their own offsets with pwrite and pread on this number
+ * of threads, instead of serializing them one by one through a stream. It has
+ * no effect on Windows and on the models saved to or loaded from memory.
+ */
+PADDLE_DEFINE_EXPORTED_int32(save_load_combine_threads,
+                             1,
+                             "Number of threads used by save_combine and "
+                             "load_combine to write and read the tensors.");
@@ -279,6 +279,35 @@ KernelResult KernelFactory::SelectKernelOrThrowError(
   return {kernel_iter->second, false};
 }
 
+KernelResult KernelDispatchCache::SelectKernelOrThrowError(
+    const KernelKey& kernel_key) {
+#if defined(PADDLE_WITH_XPU_KP)
+  // the selection also depends on FLAGS_run_kp_kernel
+  return KernelFactory::Instance().SelectKernelOrThrowError(kernel_name_,
+                                                            kernel_key);
+#else
+  auto& factory = KernelFactory::Instance();
+  uint64_t version = factory.kernels_version();
+  for (const auto& entry : entries_) {
+    if (entry.kernel != nullptr && entry.version == version &&
+        entry.kernel_key == kernel_key &&
+        entry.api_kernel_fallback == FLAGS_enable_api_kernel_fallback) {
+      return {*entry.kernel, entry.has_fallback_cpu};
+    }
+  }
+  auto kernel_result =
+      factory.SelectKernelOrThrowError(kernel_name_, kernel_key);
+  Entry& entry = entries_[next_entry_];
+  next_entry_ = (next_entry_ + 1) % kCacheSize;
+  entry.kernel_key = kernel_key;
+  entry.kernel = &kernel_result.kernel;
+  entry.has_fallback_cpu = kernel_result.has_fallback_cpu;
+  entry.api_kernel_fallback = FLAGS_enable_api_kernel_fallback;
+  entry.version = version;
+  return kernel_result;
+#endif
+}
+
 const KernelArgsDef& KernelFactory::GetFirstKernelArgsDef(
     const std::string& kernel_name) const {
   auto iter = kernels_.find(kernel_name);
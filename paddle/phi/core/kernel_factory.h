@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <ostream>
 #include <string>
@@ -317,7 +318,16 @@ class KernelFactory {
  public:
   static KernelFactory& Instance();
 
-  KernelNameMap& kernels() { return kernels_; }
+  // the map may be modified through the returned reference, which
+  // invalidates the kernels memoized by KernelDispatchCache
+  KernelNameMap& kernels() {
+    kernels_version_.fetch_add(1, std::memory_order_relaxed);
+    return kernels_;
+  }
+
+  uint64_t kernels_version() const {
+    return kernels_version_.load(std::memory_order_relaxed);
+  }
 
   bool HasCompatiblePhiKernel(const std::string& op_type) const;
 
@@ -347,11 +357,42 @@ class KernelFactory {
   KernelFactory() = default;
 
   KernelNameMap kernels_;
+  std::atomic<uint64_t> kernels_version_{0};
 
   // Get the low precision kernel list of current module.
   std::map<const std::string, OpCount> low_precision_kernels_;
 };
 
+/**
+ * Note: KernelDispatchCache memoizes SelectKernelOrThrowError for one call
+ *       site, the generated API functions keep a thread local one per kernel,
+ *       so that a hit costs a few KernelKey compares instead of building the
+ *       kernel name string and two hash lookups. Entries are dropped when the
+ *       kernel map is modified.
+ */
+class KernelDispatchCache {
+ public:
+  explicit KernelDispatchCache(const char* kernel_name)
+      : kernel_name_(kernel_name) {}
+
+  KernelResult SelectKernelOrThrowError(const KernelKey& kernel_key);
+
+ private:
+  static constexpr int kCacheSize = 4;
+
+  struct Entry {
+    KernelKey kernel_key;
+    const Kernel* kernel = nullptr;
+    bool has_fallback_cpu = false;
+    bool api_kernel_fallback = false;
+    uint64_t version = 0;
+  };
+
+  const char* kernel_name_;
+  Entry entries_[kCacheSize];
+  int next_entry_ = 0;
+};
+
 inline std::ostream& operator<<(std::ostream& os, const KernelKey& kernel_key) {
   os << "(" << kernel_key.backend() << ", " << kernel_key.layout() << ", "
      << kernel_key.dtype() << ")";
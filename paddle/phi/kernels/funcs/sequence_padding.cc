@@ -14,7 +14,10 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/funcs/sequence_padding.h"
 
+#include <algorithm>
+
 #include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/sequence_partition.h"
 
 #ifdef PADDLE_WITH_XPU
 #include "paddle/phi/backends/xpu/enforce_xpu.h"
@@ -24,6 +27,10 @@ limitations under the License. */
 namespace phi {
 namespace funcs {
 
+// Copy the valid steps of every sequence between the sequence tensor and
+// the padded tensor. When pad_value is given, the padded steps behind the
+// valid ones are filled with it as well, so the padded tensor is written
+// once. pad_value holds 1 or step_width values.
 template <typename T>
 void CopyValidData(phi::DenseTensor* dst_tensor,
                    const phi::DenseTensor* src_tensor,
@@ -32,14 +39,13 @@ void CopyValidData(phi::DenseTensor* dst_tensor,
                    int step_width,
                    bool norm_by_len,
                    CopyType type,
-                   PadLayout layout) {
+                   PadLayout layout,
+                   const T* pad_value = nullptr,
+                   int64_t pad_value_numel = 0) {
   int seq_num = seq_offsets.size() - 1;
   const T* src_data = src_tensor->data<T>();
   T* dst_data = dst_tensor->data<T>();
 
-  int seq_cpy_gap = step_width;
-  int pad_cpy_gap =
-      layout == kBatchLengthWidth ? step_width : seq_num * step_width;
   for (int seq_idx = 0; seq_idx < seq_num; ++seq_idx) {
     int valid_seq_len = seq_offsets[seq_idx + 1] - seq_offsets[seq_idx];
     PADDLE_ENFORCE_GE(
@@ -53,45 +59,49 @@ void CopyValidData(phi::DenseTensor* dst_tensor,
             valid_seq_len,
             pad_seq_len,
             valid_seq_len));
-    int seq_data_offset = seq_offsets[seq_idx] * step_width;
-    int pad_data_offset = layout == kBatchLengthWidth
-                              ? seq_idx * pad_seq_len * step_width
-                              : seq_idx * step_width;
-    float scale = 1.0f / static_cast<float>(valid_seq_len);
-
-    for (int step_idx = 0; step_idx < valid_seq_len; ++step_idx) {
-      const T* src =
-          src_data + (type == kSeqToPad ? seq_data_offset : pad_data_offset);
-      T* dst =
-          dst_data + (type == kSeqToPad ? pad_data_offset : seq_data_offset);
-      memcpy(dst, src, step_width * sizeof(T));
-      if (norm_by_len) {
-        for (int i = 0; i < step_width; ++i) {
-          *(dst + i) *= scale;
+  }
+
+  int64_t seq_cpy_gap = step_width;
+  int64_t pad_cpy_gap =
+      layout == kBatchLengthWidth ? step_width : seq_num * step_width;
+  auto copy = [&](size_t begin, size_t end) {
+    for (size_t seq_idx = begin; seq_idx < end; ++seq_idx) {
+      int valid_seq_len = seq_offsets[seq_idx + 1] - seq_offsets[seq_idx];
+      int64_t seq_data_offset = seq_offsets[seq_idx] * step_width;
+      int64_t pad_data_offset = layout == kBatchLengthWidth
+                                    ? seq_idx * pad_seq_len * step_width
+                                    : seq_idx * step_width;
+      float scale = 1.0f / static_cast<float>(valid_seq_len);
+
+      for (int step_idx = 0; step_idx < valid_seq_len; ++step_idx) {
+        const T* src =
+            src_data + (type == kSeqToPad ? seq_data_offset : pad_data_offset);
+        T* dst =
+            dst_data + (type == kSeqToPad ? pad_data_offset : seq_data_offset);
+        memcpy(dst, src, step_width * sizeof(T));
+        if (norm_by_len) {
+          for (int i = 0; i < step_width; ++i) {
+            *(dst + i) *= scale;
+          }
         }
+        seq_data_offset += seq_cpy_gap;
+        pad_data_offset += pad_cpy_gap;
+      }
+      if (pad_value == nullptr) {
+        continue;
+      }
+      for (int step_idx = valid_seq_len; step_idx < pad_seq_len; ++step_idx) {
+        T* dst = dst_data + pad_data_offset;
+        if (pad_value_numel == 1) {
+          std::fill(dst, dst + step_width, *pad_value);
+        } else {
+          memcpy(dst, pad_value, step_width * sizeof(T));
+        }
+        pad_data_offset += pad_cpy_gap;
       }
-      seq_data_offset += seq_cpy_gap;
-      pad_data_offset += pad_cpy_gap;
     }
-  }
-}
-
-template <typename T>
-static void fast_mem_init(void* dest,
-                          size_t dest_size,
-                          const T* src,
-                          size_t num_bytes) {
-  if (dest == nullptr || dest_size == 0 || src == nullptr) return;
-
-  memcpy(dest, src, num_bytes);
-
-  dest_size *= num_bytes;
-  while (dest_size > num_bytes) {
-    size_t remaining = dest_size - num_bytes;
-    size_t count = (remaining > num_bytes) ? num_bytes : remaining;
-    memcpy((unsigned char*)dest + num_bytes, dest, count);
-    num_bytes += count;
-  }
+  };
+  ParallelForSequences(seq_offsets, seq_num, step_width, copy);
 }
 
 template <typename T>
@@ -131,18 +141,7 @@ class PaddingLoDTensorFunctor<phi::CPUContext, T> {
             pad_value.numel(),
             step_width));
 
-    // fill padding value
-    T* pad_data = pad_tensor->data<T>();
-    const T* pad_value_data = pad_value.data<T>();
-    if (pad_value.numel() == 1) {
-      fast_mem_init<T>(
-          pad_data, pad_tensor->numel(), pad_value_data, sizeof(T));
-    } else {
-      for (int i = 0; i < pad_tensor->numel(); i += step_width) {
-        memcpy(pad_data + i, pad_value_data, step_width * sizeof(T));
-      }
-    }
-
+    // the padding value is filled along with the copy of every sequence
     CopyValidData<T>(pad_tensor,
                      &seq_tensor,
                      seq_offsets,
@@ -150,7 +149,9 @@ class PaddingLoDTensorFunctor<phi::CPUContext, T> {
                      step_width,
                      norm_by_times,
                      kSeqToPad,
-                     layout);
+                     layout,
+                     pad_value.data<T>(),
+                     pad_value.numel());
   }
 };
 
@@ -0,0 +1,107 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace phi {
+namespace funcs {
+
+// Below this number of elements a batch of sequences is processed by the
+// calling thread only.
+constexpr int64_t kMinSequenceParallelNumel = 1 << 15;
+
+// Split the sequences given by the offsets of a LoD level into at most
+// max_parts contiguous ranges of about the same cost, where a sequence costs
+// its length plus one so that empty sequences are counted as well. Returns
+// the first sequence of every range followed by seq_num.
+template <typename Offsets>
+std::vector<size_t> BalancedSequencePartition(const Offsets& offsets,
+                                              size_t seq_num,
+                                              size_t max_parts) {
+  std::vector<size_t> bounds(1, 0);
+  if (seq_num == 0) {
+    return bounds;
+  }
+  max_parts = std::max<size_t>(1, std::min(max_parts, seq_num));
+  size_t first_row = offsets[0];
+  size_t total_cost = offsets[seq_num] - first_row + seq_num;
+  size_t seq = 0;
+  for (size_t part = 1; part < max_parts; ++part) {
+    size_t target = total_cost * part / max_parts;
+    // the cost of the sequences before seq is offsets[seq] - first_row + seq,
+    // which grows with seq, so the bound is found by a binary search
+    size_t lo = seq;
+    size_t hi = seq_num;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (offsets[mid] - first_row + mid < target) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo > bounds.back() && lo < seq_num) {
+      bounds.push_back(lo);
+    }
+    seq = lo;
+  }
+  bounds.push_back(seq_num);
+  return bounds;
+}
+
+// Call func(begin, end) on ranges of the sequences [0, seq_num) on all
+// threads, with the ranges balanced by the lengths of the sequences. width
+// is the number of elements of a step, used to skip threading for small
+// batches. func must not throw.
+template <typename Offsets, typename Func>
+void ParallelForSequences(const Offsets& offsets,
+                          size_t seq_num,
+                          int64_t width,
+                          Func&& func) {
+  if (seq_num == 0) {
+    return;
+  }
+  int64_t numel = static_cast<int64_t>(offsets[seq_num] - offsets[0]) * width;
+  size_t num_threads = 1;
+#ifdef PADDLE_WITH_MKLML
+  if (numel >= kMinSequenceParallelNumel) {
+    num_threads = omp_get_max_threads();
+  }
+#endif
+  if (num_threads <= 1) {
+    func(0, seq_num);
+    return;
+  }
+  // more ranges than threads, so the dynamic schedule evens out the cost
+  // model
+  auto bounds = BalancedSequencePartition(offsets, seq_num, num_threads * 4);
+  int64_t part_num = static_cast<int64_t>(bounds.size()) - 1;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t part = 0; part < part_num; ++part) {
+    func(bounds[part], bounds[part + 1]);
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,365 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/ddim.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/sparse_coo_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/core/visit_type.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+
+namespace phi {
+namespace funcs {
+namespace sparse {
+
+/************* CPU CSR MATRIX ************/
+
+// A batch of CSR matrices. The crows of every batch start from 0, the cols
+// and values of the batches are stored one after another.
+template <typename T, typename IntT>
+struct CpuCsrMatrix {
+  int64_t batch_size = 1;
+  int64_t rows = 0;
+  int64_t cols = 0;
+  const IntT* crows = nullptr;
+  const IntT* col_index = nullptr;
+  const T* values = nullptr;
+  // the offset of the first non zero element of every batch, and the nnz
+  std::vector<int64_t> batch_offsets;
+
+  // the storage of a transposed matrix
+  std::vector<IntT> crows_buffer;
+  std::vector<IntT> cols_buffer;
+  std::vector<T> values_buffer;
+
+  int64_t RowBegin(int64_t batch, int64_t row) const {
+    return batch_offsets[batch] + crows[batch * (rows + 1) + row];
+  }
+  int64_t RowEnd(int64_t batch, int64_t row) const {
+    return batch_offsets[batch] + crows[batch * (rows + 1) + row + 1];
+  }
+};
+
+inline void GetCsrMatrixShape(const DDim& dims,
+                              int64_t* batch_size,
+                              int64_t* rows,
+                              int64_t* cols) {
+  int ndims = dims.size();
+  PADDLE_ENFORCE_GE(
+      ndims,
+      2,
+      phi::errors::InvalidArgument("the dim size of SparseCsrTensor must be "
+                                   "greater than or eaqual to 2."));
+  *batch_size = 1;
+  for (int i = 0; i < ndims - 2; ++i) {
+    *batch_size *= dims[i];
+  }
+  *rows = dims[ndims - 2];
+  *cols = dims[ndims - 1];
+}
+
+template <typename T, typename IntT>
+CpuCsrMatrix<T, IntT> GetCpuCsrMatrix(const phi::SparseCsrTensor& x) {
+  CpuCsrMatrix<T, IntT> mat;
+  GetCsrMatrixShape(x.dims(), &mat.batch_size, &mat.rows, &mat.cols);
+  PADDLE_ENFORCE_EQ(x.non_zero_crows().numel(),
+                    mat.batch_size * (mat.rows + 1),
+                    phi::errors::PreconditionNotMet(
+                        "the length of SparseCsrTensor crows is not right."));
+  mat.crows = x.non_zero_crows().data<IntT>();
+  mat.col_index = x.non_zero_cols().data<IntT>();
+  mat.values = x.non_zero_elements().data<T>();
+  mat.batch_offsets.resize(mat.batch_size + 1, 0);
+  for (int64_t b = 0; b < mat.batch_size; ++b) {
+    mat.batch_offsets[b + 1] =
+        mat.batch_offsets[b] + mat.crows[b * (mat.rows + 1) + mat.rows];
+  }
+  return mat;
+}
+
+// Counting sort of the non zero elements by column, the rows of the result
+// stay sorted since the input is visited row by row.
+template <typename T, typename IntT>
+CpuCsrMatrix<T, IntT> TransposeCpuCsrMatrix(const CpuCsrMatrix<T, IntT>& x) {
+  CpuCsrMatrix<T, IntT> out;
+  out.batch_size = x.batch_size;
+  out.rows = x.cols;
+  out.cols = x.rows;
+  out.batch_offsets = x.batch_offsets;
+  int64_t nnz = x.batch_offsets[x.batch_size];
+  out.crows_buffer.assign(out.batch_size * (out.rows + 1), 0);
+  out.cols_buffer.resize(nnz);
+  out.values_buffer.resize(nnz);
+
+  std::vector<int64_t> next(out.rows);
+  for (int64_t b = 0; b < x.batch_size; ++b) {
+    IntT* crows = out.crows_buffer.data() + b * (out.rows + 1);
+    for (int64_t p = x.batch_offsets[b]; p < x.batch_offsets[b + 1]; ++p) {
+      ++crows[x.col_index[p] + 1];
+    }
+    for (int64_t i = 0; i < out.rows; ++i) {
+      crows[i + 1] += crows[i];
+      next[i] = out.batch_offsets[b] + crows[i];
+    }
+    for (int64_t i = 0; i < x.rows; ++i) {
+      for (int64_t p = x.RowBegin(b, i); p < x.RowEnd(b, i); ++p) {
+        int64_t q = next[x.col_index[p]]++;
+        out.cols_buffer[q] = i;
+        out.values_buffer[q] = x.values[p];
+      }
+    }
+  }
+  out.crows = out.crows_buffer.data();
+  out.col_index = out.cols_buffer.data();
+  out.values = out.values_buffer.data();
+  return out;
+}
+
+// Transposes the last two dims of a batch of rows x cols matrices.
+template <typename T>
+void TransposeLastTwoDims(
+    const T* x, int64_t batch_size, int64_t rows, int64_t cols, T* out) {
+  constexpr int64_t kBlock = 32;
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const T* x_mat = x + b * rows * cols;
+    T* out_mat = out + b * rows * cols;
+    for (int64_t i0 = 0; i0 < rows; i0 += kBlock) {
+      for (int64_t j0 = 0; j0 < cols; j0 += kBlock) {
+        int64_t i1 = std::min(i0 + kBlock, rows);
+        int64_t j1 = std::min(j0 + kBlock, cols);
+        for (int64_t i = i0; i < i1; ++i) {
+          for (int64_t j = j0; j < j1; ++j) {
+            out_mat[j * rows + i] = x_mat[i * cols + j];
+          }
+        }
+      }
+    }
+  }
+}
+
+/************* SPARSE*DENSE->DENSE MATMUL ************/
+
+// out[b] = alpha * a[b] * b_mat[b] + beta * out[b], where b_mat[b] is a
+// dense a.cols x n matrix. Rows of out are computed in parallel and each
+// non zero element of a row adds a scaled row of b_mat with AXPY, which
+// is vectorized over the n dense columns.
+template <typename T, typename IntT>
+void CpuCsrDenseMatmul(const phi::CPUContext& dev_ctx,
+                       T alpha,
+                       const CpuCsrMatrix<T, IntT>& a,
+                       const T* b_mat,
+                       int64_t n,
+                       T beta,
+                       T* out) {
+  auto blas = phi::funcs::GetBlas<phi::CPUContext, T>(dev_ctx);
+  int64_t total_rows = a.batch_size * a.rows;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t r = 0; r < total_rows; ++r) {
+    int64_t b = r / a.rows;
+    int64_t i = r % a.rows;
+    T* out_row = out + r * n;
+    if (beta == static_cast<T>(0)) {
+      std::fill(out_row, out_row + n, static_cast<T>(0));
+    } else {
+      blas.SCAL(n, beta, out_row);
+    }
+    const T* b_batch = b_mat + b * a.cols * n;
+    for (int64_t p = a.RowBegin(b, i); p < a.RowEnd(b, i); ++p) {
+      blas.AXPY(n, alpha * a.values[p], b_batch + a.col_index[p] * n, out_row);
+    }
+  }
+}
+
+template <typename T>
+void CpuSpmm(const phi::CPUContext& dev_ctx,
+             bool transa,
+             bool transb,
+             T alpha,
+             const phi::SparseCsrTensor& mat_a,
+             const phi::DenseTensor& mat_b,
+             T beta,
+             phi::DenseTensor* mat_out) {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      mat_a.non_zero_crows().dtype(), "CpuSpmm", ([&] {
+        auto a = GetCpuCsrMatrix<T, data_t>(mat_a);
+        if (transa) {
+          a = TransposeCpuCsrMatrix(a);
+        }
+        int64_t n = mat_out->dims()[mat_out->dims().size() - 1];
+        PADDLE_ENFORCE_EQ(
+            mat_b.numel(),
+            a.batch_size * a.cols * n,
+            phi::errors::InvalidArgument(
+                "The shape of the dense matrix of 'sparse.matmul' does not "
+                "match the sparse matrix, which has %d columns.",
+                a.cols));
+        PADDLE_ENFORCE_EQ(mat_out->numel(),
+                          a.batch_size * a.rows * n,
+                          phi::errors::InvalidArgument(
+                              "The shape of the output of 'sparse.matmul' "
+                              "does not match its inputs."));
+        const T* b_data = mat_b.data<T>();
+        std::vector<T> trans_b;
+        if (transb) {
+          trans_b.resize(mat_b.numel());
+          TransposeLastTwoDims(
+              b_data, a.batch_size, n, a.cols, trans_b.data());
+          b_data = trans_b.data();
+        }
+        CpuCsrDenseMatmul<T, data_t>(
+            dev_ctx, alpha, a, b_data, n, beta, mat_out->data<T>());
+      }));
+}
+
+template <typename T>
+void CpuSpmm(const phi::CPUContext& dev_ctx,
+             bool transa,
+             bool transb,
+             T alpha,
+             const phi::SparseCooTensor& mat_a,
+             const phi::DenseTensor& mat_b,
+             T beta,
+             phi::DenseTensor* mat_out) {
+  PADDLE_THROW(phi::errors::Unimplemented(
+      "CPU 'sparse.matmul' only supports SparseCsrTensor, please convert "
+      "the SparseCooTensor with to_sparse_csr() first."));
+}
+
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMM(bool transa,
+                                       bool transb,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& mat_b,
+                                       T beta,
+                                       phi::DenseTensor* mat_out) const {
+  CpuSpmm<T>(dev_ctx_, transa, transb, alpha, mat_a, mat_b, beta, mat_out);
+}
+
+/************* DENSE*DENSE->SPARSE MATMUL ************/
+
+// Only the elements of out that are in its sparsity pattern are computed,
+// each one is a dot product of a row of a_mat and a row of b_mat, where
+// a_mat is out.rows x k and b_mat is out.cols x k.
+template <typename T, typename IntT>
+void CpuSampledDenseDenseMatmul(const phi::CPUContext& dev_ctx,
+                                T alpha,
+                                const T* a_mat,
+                                const T* b_mat,
+                                int64_t k,
+                                T beta,
+                                const CpuCsrMatrix<T, IntT>& out_mat,
+                                T* out_values) {
+  auto blas = phi::funcs::GetBlas<phi::CPUContext, T>(dev_ctx);
+  int64_t total_rows = out_mat.batch_size * out_mat.rows;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t r = 0; r < total_rows; ++r) {
+    int64_t b = r / out_mat.rows;
+    int64_t i = r % out_mat.rows;
+    const T* a_row = a_mat + r * k;
+    const T* b_batch = b_mat + b * out_mat.cols * k;
+    for (int64_t p = out_mat.RowBegin(b, i); p < out_mat.RowEnd(b, i); ++p) {
+      T value =
+          alpha * blas.DOT(k, a_row, b_batch + out_mat.col_index[p] * k);
+      out_values[p] = beta == static_cast<T>(0)
+                          ? value
+                          : value + beta * out_values[p];
+    }
+  }
+}
+
+template <typename T>
+void CpuSddmm(const phi::CPUContext& dev_ctx,
+              bool transa,
+              bool transb,
+              T alpha,
+              const phi::DenseTensor& mat_a,
+              const phi::DenseTensor& mat_b,
+              T beta,
+              phi::SparseCsrTensor* mat_out) {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      mat_out->non_zero_crows().dtype(), "CpuSddmm", ([&] {
+        auto out_mat = GetCpuCsrMatrix<T, data_t>(*mat_out);
+        int64_t k = mat_a.numel() / (out_mat.batch_size * out_mat.rows);
+        PADDLE_ENFORCE_EQ(
+            mat_a.numel(),
+            out_mat.batch_size * out_mat.rows * k,
+            phi::errors::InvalidArgument(
+                "The shape of Input(x) of 'sparse.masked_matmul' does not "
+                "match the mask, which has %d rows.",
+                out_mat.rows));
+        PADDLE_ENFORCE_EQ(
+            mat_b.numel(),
+            out_mat.batch_size * out_mat.cols * k,
+            phi::errors::InvalidArgument(
+                "The shape of Input(y) of 'sparse.masked_matmul' does not "
+                "match the mask, which has %d columns.",
+                out_mat.cols));
+        // rows of a_data are the rows of op(a), rows of b_data are the
+        // columns of op(b), so both are read contiguously
+        const T* a_data = mat_a.data<T>();
+        std::vector<T> trans_a;
+        if (transa) {
+          trans_a.resize(mat_a.numel());
+          TransposeLastTwoDims(
+              a_data, out_mat.batch_size, k, out_mat.rows, trans_a.data());
+          a_data = trans_a.data();
+        }
+        const T* b_data = mat_b.data<T>();
+        std::vector<T> trans_b;
+        if (!transb) {
+          trans_b.resize(mat_b.numel());
+          TransposeLastTwoDims(
+              b_data, out_mat.batch_size, k, out_mat.cols, trans_b.data());
+          b_data = trans_b.data();
+        }
+        CpuSampledDenseDenseMatmul<T, data_t>(
+            dev_ctx,
+            alpha,
+            a_data,
+            b_data,
+            k,
+            beta,
+            out_mat,
+            mat_out->mutable_non_zero_elements()->data<T>());
+      }));
+}
+
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SDDMM(bool transa,
+                                        bool transb,
+                                        T alpha,
+                                        const phi::DenseTensor& mat_a,
+                                        const phi::DenseTensor& mat_b,
+                                        T beta,
+                                        TensorType* mat_out) const {
+  CpuSddmm<T>(dev_ctx_, transa, transb, alpha, mat_a, mat_b, beta, mat_out);
+}
+
+}  // namespace sparse
+}  // namespace funcs
+}  // namespace phi
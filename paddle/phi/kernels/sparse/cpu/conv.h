@@ -14,7 +14,10 @@ limitations under the License. */
 
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -30,7 +33,9 @@ using Dims4D = phi::funcs::sparse::Dims4D;
 
 // such as: kernel(3, 3, 3), kernel_size = 27
 // counter_per_weight: (kernel_size)
-// TODO(zhangkaihuo): optimize performance with multithreading
+// The input points are put in a hash grid for the subm check, then the
+// kernel offsets are visited in parallel and the rules of every offset
+// are concatenated in the order of the offsets.
 template <typename T, typename Context, typename IntT = int>
 void ProductRuleBook(const Context& dev_ctx,
                      const SparseCooTensor& x,
@@ -46,10 +51,7 @@ void ProductRuleBook(const Context& dev_ctx,
   const auto& indices = x.indices();
   const IntT* indices_ptr = indices.data<IntT>();
   int kernel_size = kernel_sizes[0] * kernel_sizes[1] * kernel_sizes[2];
-  memset(counter_per_kernel, 0, kernel_size * sizeof(int));
 
-  int rulebook_len = 0;
-  // calc the rulebook_len
   const auto& x_dims = x.dims();
   const Dims4D c_x_dims(x_dims[0], x_dims[3], x_dims[2], x_dims[1]);
   const Dims4D c_kernel_dims(
@@ -59,9 +61,10 @@ void ProductRuleBook(const Context& dev_ctx,
   const Dims4D c_strides(1, strides[2], strides[1], strides[0]);
   const Dims4D c_dilations(1, dilations[2], dilations[1], dilations[0]);
 
-  std::set<IntT> hash_in;
+  std::unordered_set<IntT> hash_in;
   if (subm) {
-    for (int i = 0; i < non_zero_num; i++) {
+    hash_in.reserve(non_zero_num);
+    for (int64_t i = 0; i < non_zero_num; i++) {
       IntT batch = indices_ptr[i];
       IntT in_z = indices_ptr[i + non_zero_num];
       IntT in_y = indices_ptr[i + 2 * non_zero_num];
@@ -72,58 +75,53 @@ void ProductRuleBook(const Context& dev_ctx,
     }
   }
 
-  auto f_calc_rulebook = [&](IntT* rulebook_ptr) {
-    int kernel_index = 0, rulebook_index = 0;
-    for (int kz = 0; kz < kernel_sizes[0]; kz++) {
-      for (int ky = 0; ky < kernel_sizes[1]; ky++) {
-        for (int kx = 0; kx < kernel_sizes[2]; kx++) {
-          ++kernel_index;
-          for (int64_t i = 0; i < non_zero_num; i++) {
-            IntT batch = indices_ptr[i];
-            IntT in_z = indices_ptr[i + non_zero_num];
-            IntT in_y = indices_ptr[i + 2 * non_zero_num];
-            IntT in_x = indices_ptr[i + 3 * non_zero_num];
-            IntT out_z = (in_z + paddings[0] - kz * dilations[0]) / strides[0];
-            IntT out_y = (in_y + paddings[1] - ky * dilations[1]) / strides[1];
-            IntT out_x = (in_x + paddings[2] - kx * dilations[2]) / strides[2];
-            if (phi::funcs::sparse::Check(c_x_dims,
-                                          c_kernel_dims,
-                                          c_paddings,
-                                          c_dilations,
-                                          c_strides,
-                                          in_x,
-                                          in_y,
-                                          in_z,
-                                          kx,
-                                          ky,
-                                          kz)) {
-              if (subm) {
-                IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
-                    batch, out_x, out_y, out_z, out_dims);
-                if (hash_in.find(out_index) == hash_in.end()) {
-                  continue;
-                }
-              }
-
-              if (rulebook_ptr == nullptr) {
-                counter_per_kernel[kernel_index - 1] += 1;
-                ++rulebook_len;
-              } else {
-                rulebook_ptr[rulebook_index] = kernel_index - 1;
-                rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
-                rulebook_ptr[rulebook_index + rulebook_len * 2] =
-                    phi::funcs::sparse::PointToIndex<DDim>(
-                        batch, out_x, out_y, out_z, out_dims);  // out_index
-                ++rulebook_index;
-              }
-            }
-          }
-        }
+  // in_i and out_index of the rules of every kernel offset
+  std::vector<std::vector<IntT>> in_rows(kernel_size);
+  std::vector<std::vector<IntT>> out_indexs(kernel_size);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int kernel_index = 0; kernel_index < kernel_size; ++kernel_index) {
+    const int kz = kernel_index / (kernel_sizes[1] * kernel_sizes[2]);
+    const int ky = kernel_index / kernel_sizes[2] % kernel_sizes[1];
+    const int kx = kernel_index % kernel_sizes[2];
+    for (int64_t i = 0; i < non_zero_num; i++) {
+      IntT batch = indices_ptr[i];
+      IntT in_z = indices_ptr[i + non_zero_num];
+      IntT in_y = indices_ptr[i + 2 * non_zero_num];
+      IntT in_x = indices_ptr[i + 3 * non_zero_num];
+      if (!phi::funcs::sparse::Check(c_x_dims,
+                                     c_kernel_dims,
+                                     c_paddings,
+                                     c_dilations,
+                                     c_strides,
+                                     in_x,
+                                     in_y,
+                                     in_z,
+                                     kx,
+                                     ky,
+                                     kz)) {
+        continue;
       }
+      IntT out_z = (in_z + paddings[0] - kz * dilations[0]) / strides[0];
+      IntT out_y = (in_y + paddings[1] - ky * dilations[1]) / strides[1];
+      IntT out_x = (in_x + paddings[2] - kx * dilations[2]) / strides[2];
+      IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
+          batch, out_x, out_y, out_z, out_dims);
+      if (subm && hash_in.find(out_index) == hash_in.end()) {
+        continue;
+      }
+      in_rows[kernel_index].push_back(i);
+      out_indexs[kernel_index].push_back(out_index);
     }
-  };
+    counter_per_kernel[kernel_index] = in_rows[kernel_index].size();
+  }
 
-  f_calc_rulebook(nullptr);
+  std::vector<int> offsets(kernel_size + 1, 0);
+  for (int i = 0; i < kernel_size; i++) {
+    offsets[i + 1] = offsets[i] + counter_per_kernel[i];
+  }
+  const int rulebook_len = offsets[kernel_size];
   // alloc the rulebook
   *rulebook = phi::Empty(
       dev_ctx,
@@ -131,9 +129,25 @@ void ProductRuleBook(const Context& dev_ctx,
                       {3, rulebook_len},
                       DataLayout::NCHW));
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  f_calc_rulebook(rulebook_ptr);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int kernel_index = 0; kernel_index < kernel_size; ++kernel_index) {
+    int offset = offsets[kernel_index];
+    std::fill(rulebook_ptr + offset,
+              rulebook_ptr + offsets[kernel_index + 1],
+              kernel_index);
+    std::copy(in_rows[kernel_index].begin(),
+              in_rows[kernel_index].end(),
+              rulebook_ptr + rulebook_len + offset);
+    std::copy(out_indexs[kernel_index].begin(),
+              out_indexs[kernel_index].end(),
+              rulebook_ptr + rulebook_len * 2 + offset);
+  }
 }
 
+// The out indexs of the rulebook are replaced by the rows of the sorted
+// unique out points.
 template <typename T, typename Context, typename IntT = int>
 void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                const SparseCooTensor& x,
@@ -142,12 +156,12 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                const DDim& out_dims,
                                DenseTensor* rulebook,
                                SparseCooTensor* out) {
-  std::set<IntT> out_indexs;
   int n = rulebook->dims()[1];
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  for (int i = 0; i < n; i++) {
-    out_indexs.insert(rulebook_ptr[i + n * 2]);
-  }
+  std::vector<IntT> out_indexs(rulebook_ptr + n * 2, rulebook_ptr + n * 3);
+  std::sort(out_indexs.begin(), out_indexs.end());
+  out_indexs.erase(std::unique(out_indexs.begin(), out_indexs.end()),
+                   out_indexs.end());
 
   int out_non_zero_num = out_indexs.size();
   const int64_t sparse_dim = 4;
@@ -160,9 +174,11 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
   phi::DenseTensor out_indices = phi::Empty(dev_ctx, std::move(indices_meta));
   phi::DenseTensor out_values = phi::Empty(dev_ctx, std::move(values_meta));
   IntT* out_indices_ptr = out_indices.data<IntT>();
-  int i = 0;
-  for (auto it = out_indexs.begin(); it != out_indexs.end(); it++, i++) {
-    const IntT index = *it;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < out_non_zero_num; i++) {
+    const IntT index = out_indexs[i];
     IntT batch, x, y, z;
     phi::funcs::sparse::IndexToPoint<DDim>(index, out_dims, &batch, &x, &y, &z);
     out_indices_ptr[i] = batch;
@@ -170,18 +186,47 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
     out_indices_ptr[i + out_non_zero_num * 2] = y;
     out_indices_ptr[i + out_non_zero_num * 3] = x;
   }
-  for (i = 0; i < n; i++) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < n; i++) {
     IntT out_index = rulebook_ptr[i + n * 2];
     rulebook_ptr[i + n * 2] =
-        std::distance(out_indexs.begin(), out_indexs.find(out_index));
+        std::lower_bound(out_indexs.begin(), out_indexs.end(), out_index) -
+        out_indexs.begin();
   }
 
   out->SetMember(out_indices, out_values, out_dims, true);
 }
 
+// The key a subm rulebook is cached with when the user gives none. It
+// holds the kernel geometry and a fingerprint of the indices, since the
+// indices dict is shared by the tensors of different resolutions.
+template <typename IntT = int>
+std::string SubmRulebookKey(const SparseCooTensor& x,
+                            const std::vector<int>& kernel_sizes,
+                            const std::vector<int>& dilations) {
+  const IntT* indices_ptr = x.indices().data<IntT>();
+  uint64_t hash = 14695981039346656037ULL;
+  for (int64_t i = 0; i < x.indices().numel(); i++) {
+    hash = (hash ^ static_cast<uint64_t>(indices_ptr[i])) * 1099511628211ULL;
+  }
+  std::string key = "subm_rulebook";
+  for (int i = 0; i < 3; i++) {
+    key += "_" + std::to_string(kernel_sizes[i]) + "x" +
+           std::to_string(dilations[i]);
+  }
+  return key + "_" + std::to_string(x.nnz()) + "_" + std::to_string(hash);
+}
+
+// The rows of a kernel offset are gathered, multiplied and scattered in
+// parallel, so indexs must not repeat, which holds within an offset.
 template <typename T, typename IntT = int>
 void Gather(
     const T* x, const IntT* indexs, const int n, const int channels, T* out) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
   for (int i = 0; i < n; i++) {
     IntT real_i = indexs[i];
     memcpy(out + i * channels, x + real_i * channels, channels * sizeof(T));
@@ -191,6 +236,9 @@ void Gather(
 template <typename T, typename IntT = int>
 void Scatter(
     const T* x, const IntT* indexs, const int n, const int channels, T* out) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
   for (int i = 0; i < n; i++) {
     IntT real_i = indexs[i];
     for (int j = 0; j < channels; j++) {
@@ -56,22 +56,6 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
       out, rulebook, key, &rulebook_len);
   const int* counter_ptr = phi::funcs::sparse::GetCounterPtr(out, counter, key);
 
-  DenseTensorMeta in_features_meta(
-      x.dtype(), {rulebook_len, in_channels}, DataLayout::NCHW);
-  DenseTensorMeta d_x_features_meta(
-      x.dtype(), {rulebook_len, in_channels}, DataLayout::NCHW);
-  DenseTensorMeta out_grad_features_meta(
-      x.dtype(), {rulebook_len, out_channels}, DataLayout::NCHW);
-  phi::DenseTensor in_features =
-      phi::Empty(dev_ctx, std::move(in_features_meta));
-  phi::DenseTensor d_x_features =
-      phi::Empty(dev_ctx, std::move(d_x_features_meta));
-  phi::DenseTensor out_grad_features =
-      phi::Empty(dev_ctx, std::move(out_grad_features_meta));
-
-  T* in_features_ptr = in_features.data<T>();
-  T* d_x_features_ptr = d_x_features.data<T>();
-  T* out_grad_features_ptr = out_grad_features.data<T>();
   *kernel_grad = phi::EmptyLike<T>(dev_ctx, kernel);
   T* d_kernel_ptr = kernel_grad->data<T>();
   memset(d_kernel_ptr, 0, sizeof(T) * kernel_grad->numel());
@@ -82,7 +66,6 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
   DenseTensor x_grad_values = phi::EmptyLike<T>(dev_ctx, x.values());
   T* x_grad_values_ptr = x_grad_values.data<T>();
   memset(x_grad_values_ptr, 0, sizeof(T) * x_grad_values.numel());
-  memset(d_x_features_ptr, 0, sizeof(T) * d_x_features.numel());
   phi::Copy<CPUContext>(
       dev_ctx, x.indices(), dev_ctx.GetPlace(), false, &x_grad_indices);
   x_grad->SetMember(x_grad_indices, x_grad_values, x.dims(), true);
@@ -90,12 +73,14 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
   std::vector<IntT> offsets(kernel_size + 1);
   IntT offset = 0;
   int max_count = 0;
+  int max_features = 0;
   for (int i = 0; i < kernel_size; i++) {
     offsets[i] = offset;
     offset += counter_ptr[i];
     if (i < half_kernel_size) {
       max_count = std::max(max_count, counter_ptr[i]);
     }
+    max_features = std::max(max_features, counter_ptr[i]);
   }
   offsets[kernel_size] = offset;
 
@@ -114,16 +99,22 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
     }
   }
 
-  Gather<T, IntT>(x.values().data<T>(),
-                  rulebook_ptr + rulebook_len,
-                  rulebook_len,
-                  in_channels,
-                  in_features_ptr);
-  Gather<T, IntT>(out_grad.values().data<T>(),
-                  rulebook_ptr + rulebook_len * 2,
-                  rulebook_len,
-                  out_channels,
-                  out_grad_features_ptr);
+  // the features of one kernel offset are buffered at a time
+  DenseTensorMeta in_features_meta(
+      x.dtype(), {max_features, in_channels}, DataLayout::NCHW);
+  DenseTensorMeta d_x_features_meta(
+      x.dtype(), {max_features, in_channels}, DataLayout::NCHW);
+  DenseTensorMeta out_grad_features_meta(
+      x.dtype(), {max_features, out_channels}, DataLayout::NCHW);
+  phi::DenseTensor in_features =
+      phi::Empty(dev_ctx, std::move(in_features_meta));
+  phi::DenseTensor d_x_features =
+      phi::Empty(dev_ctx, std::move(d_x_features_meta));
+  phi::DenseTensor out_grad_features =
+      phi::Empty(dev_ctx, std::move(out_grad_features_meta));
+  T* in_features_ptr = in_features.data<T>();
+  T* d_x_features_ptr = d_x_features.data<T>();
+  T* out_grad_features_ptr = out_grad_features.data<T>();
 
   const T* kernel_ptr = kernel.data<T>();
   for (int i = 0; i < kernel_size; i++) {
@@ -134,11 +125,18 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
     const int M = counter_ptr[i];
     const int K = in_channels;
     const int N = out_channels;
-    T* tmp_in_ptr = in_features_ptr + offsets[i] * in_channels;
-    T* tmp_out_grad_ptr = out_grad_features_ptr + offsets[i] * out_channels;
     const T* tmp_kernel_ptr = kernel_ptr + i * in_channels * out_channels;
-    T* tmp_d_x_ptr = d_x_features_ptr + offsets[i] * in_channels;
     T* tmp_d_kernel_ptr = d_kernel_ptr + i * in_channels * out_channels;
+    Gather<T, IntT>(x.values().data<T>(),
+                    rulebook_ptr + rulebook_len + offsets[i],
+                    M,
+                    in_channels,
+                    in_features_ptr);
+    Gather<T, IntT>(out_grad.values().data<T>(),
+                    rulebook_ptr + rulebook_len * 2 + offsets[i],
+                    M,
+                    out_channels,
+                    out_grad_features_ptr);
 
     // call gemm: d_kernel = transpose(x) * out_grad
     // (in_channels, n) * (n, out_channels)
@@ -148,8 +146,8 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
               N,
               M,
               static_cast<T>(1),
-              tmp_in_ptr,
-              tmp_out_grad_ptr,
+              in_features_ptr,
+              out_grad_features_ptr,
               static_cast<T>(0),
               tmp_d_kernel_ptr);
 
@@ -161,18 +159,18 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
               K,
               N,
               static_cast<T>(1),
-              tmp_out_grad_ptr,
+              out_grad_features_ptr,
               tmp_kernel_ptr,
               static_cast<T>(0),
-              tmp_d_x_ptr);
+              d_x_features_ptr);
+
+    // 4. scatter
+    Scatter<T, IntT>(d_x_features_ptr,
+                     rulebook_ptr + rulebook_len + offsets[i],
+                     M,
+                     in_channels,
+                     x_grad_values_ptr);
   }
-
-  // 4. scatter
-  Scatter<T, IntT>(d_x_features_ptr,
-                   rulebook_ptr + rulebook_len,
-                   rulebook_len,
-                   in_channels,
-                   x_grad_values_ptr);
 }
 
 template <typename T, typename Context>
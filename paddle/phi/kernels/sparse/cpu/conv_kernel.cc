@@ -12,6 +12,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+#include <cstring>
+
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_meta.h"
 #include "paddle/phi/core/tensor_utils.h"
@@ -79,17 +82,29 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   const IntT* rulebook_ptr = nullptr;
   int n = 0;
   bool need_product_rulebook = true;
-  if (subm && !key.empty()) {
+  // subm convs on the same indices with the same kernel geometry share
+  // their rulebook, under an internal key when the user gives none
+  const std::string subm_key =
+      subm && key.empty() ? SubmRulebookKey<IntT>(x, kernel_sizes, dilations)
+                          : key;
+  if (subm && !subm_key.empty()) {
     rulebook_ptr = phi::funcs::sparse::PrepareSubm<T, IntT, CPUContext>(
         dev_ctx,
         x,
-        key,
+        subm_key,
         out_dims,
         out,
         h_counter_ptr,
         h_offsets_ptr,
         &n,
         &need_product_rulebook);
+    if (!need_product_rulebook && key.empty()) {
+      // the backward reads the rulebook and counter outputs
+      const auto* indices_pairs = x.IndicesPairs(subm_key);
+      *rulebook = indices_pairs->first;
+      phi::Copy(
+          dev_ctx, indices_pairs->second, dev_ctx.GetPlace(), false, counter);
+    }
   }
   if (need_product_rulebook) {
     DenseTensor tmp_rulebook;
@@ -111,14 +126,32 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
 
     phi::funcs::sparse::SaveToTable(
         dev_ctx, x, key, tmp_rulebook, h_counter, out, rulebook, counter);
+    // a hit copies the indices of x to out, which is only right when the
+    // rulebook was built on indices that are already sorted and unique
+    if (subm && key.empty() && out->nnz() == x.nnz() &&
+        memcmp(out->indices().data<IntT>(),
+               x.indices().data<IntT>(),
+               sizeof(IntT) * x.indices().numel()) == 0) {
+      out->SaveIndicesPairs(subm_key, std::make_pair(tmp_rulebook, h_counter));
+    }
   }
   // int n = rulebook->dims()[1];
 
-  // 2. gather
+  int offset = 0;
+  int max_count = 0;
+  for (int i = 0; i < kernel_size; i++) {
+    h_offsets_ptr[i] = offset;
+    offset += h_counter_ptr[i];
+    max_count = std::max(max_count, h_counter_ptr[i]);
+  }
+  h_offsets_ptr[kernel_size] = offset;
+
+  // 2. gather, gemm and scatter for every kernel offset, the features of
+  // one offset are buffered at a time
   DenseTensorMeta in_features_meta(
-      x.dtype(), {n, in_channels}, DataLayout::NHWC);
+      x.dtype(), {max_count, in_channels}, DataLayout::NHWC);
   DenseTensorMeta out_features_meta(
-      x.dtype(), {n, out_channels}, DataLayout::NHWC);
+      x.dtype(), {max_count, out_channels}, DataLayout::NHWC);
   phi::DenseTensor in_features =
       phi::Empty(dev_ctx, std::move(in_features_meta));
   phi::DenseTensor out_features =
@@ -126,18 +159,10 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   T* in_features_ptr = in_features.data<T>();
   T* out_features_ptr = out_features.data<T>();
 
-  Gather<T, IntT>(
-      x.values().data<T>(), rulebook_ptr + n, n, in_channels, in_features_ptr);
+  T* out_values_ptr = out->mutable_values()->data<T>();
+  memset(out_values_ptr, 0, sizeof(T) * out->nnz() * out_channels);
 
-  // 3. call gemm for every werght
   auto blas = phi::funcs::GetBlas<CPUContext, T>(dev_ctx);
-  int offset = 0;
-  for (int i = 0; i < kernel_size; i++) {
-    h_offsets_ptr[i] = offset;
-    offset += h_counter_ptr[i];
-  }
-  h_offsets_ptr[kernel_size] = offset;
-
   const T* kernel_ptr = kernel.data<T>();
   for (int i = 0; i < kernel_size; i++) {
     if (h_counter_ptr[i] <= 0) {
@@ -148,26 +173,28 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
     const int M = h_counter_ptr[i];
     const int K = in_channels;   // in_channels
     const int N = out_channels;  // out_channels
-    T* tmp_in_ptr = in_features_ptr + h_offsets_ptr[i] * in_channels;
     const T* tmp_kernel_ptr = kernel_ptr + i * K * N;
-    T* tmp_out_ptr = out_features_ptr + h_offsets_ptr[i] * out_channels;
+    Gather<T, IntT>(x.values().data<T>(),
+                    rulebook_ptr + n + h_offsets_ptr[i],
+                    M,
+                    in_channels,
+                    in_features_ptr);
     blas.GEMM(CblasNoTrans,
               CblasNoTrans,
               M,
               N,
               K,
               static_cast<T>(1),
-              tmp_in_ptr,
+              in_features_ptr,
               tmp_kernel_ptr,
               static_cast<T>(0),
-              tmp_out_ptr);
+              out_features_ptr);
+    Scatter<T, IntT>(out_features_ptr,
+                     rulebook_ptr + n * 2 + h_offsets_ptr[i],
+                     M,
+                     out_channels,
+                     out_values_ptr);
   }
-
-  // 4. scatter
-  T* out_values_ptr = out->mutable_values()->data<T>();
-  memset(out_values_ptr, 0, sizeof(T) * out->nnz() * out_channels);
-  Scatter<T, IntT>(
-      out_features_ptr, rulebook_ptr + n * 2, n, out_channels, out_values_ptr);
 }
 
 template <typename T, typename Context>
@@ -0,0 +1,81 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+namespace phi {
+namespace strings {
+
+// Whether all bytes are ASCII, so every byte is a code point.
+inline bool IsAsciiStr(const char* str, size_t len) {
+  size_t i = 0;
+#ifdef __SSE2__
+  for (; i + 16 <= len; i += 16) {
+    __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+    if (_mm_movemask_epi8(chars) != 0) {
+      return false;
+    }
+  }
+#endif
+  for (; i < len; ++i) {
+    if (static_cast<uint8_t>(str[i]) >= 0x80) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Flip the case of the ASCII letters from `first` to `first` + 25, i.e.
+// 'A' to lower them or 'a' to upper them. Other bytes, including the bytes
+// of multi-byte UTF-8 characters, are copied unchanged. in and out may be
+// the same.
+inline void AsciiConvertCase(const char* in,
+                             size_t len,
+                             char first,
+                             char* out) {
+  size_t i = 0;
+#ifdef __SSE2__
+  // move the letters to [-128, -103] as signed bytes, so a single signed
+  // compare finds them
+  const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - first));
+  const __m128i bound = _mm_set1_epi8(static_cast<char>(0x80 + 26));
+  const __m128i flip = _mm_set1_epi8(0x20);
+  for (; i + 16 <= len; i += 16) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i is_letter = _mm_cmplt_epi8(_mm_add_epi8(chars, bias), bound);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_xor_si128(chars, _mm_and_si128(is_letter, flip)));
+  }
+#endif
+  for (; i < len; ++i) {
+    uint8_t c = static_cast<uint8_t>(in[i]);
+    out[i] = static_cast<uint8_t>(c - first) < 26 ? c ^ 0x20 : c;
+  }
+}
+
+inline bool IsAsciiSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+}  // namespace strings
+}  // namespace phi
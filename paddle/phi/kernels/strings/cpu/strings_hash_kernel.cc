@@ -0,0 +1,63 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/strings/strings_hash_kernel.h"
+
+#include <xxhash.h>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/pstring.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+using pstring = ::phi::dtype::pstring;
+
+namespace phi {
+namespace strings {
+
+template <typename Context>
+void StringHashKernel(const Context& dev_ctx,
+                      const StringTensor& x,
+                      int64_t num_buckets,
+                      int seed,
+                      DenseTensor* out) {
+  PADDLE_ENFORCE_GT(num_buckets,
+                    0,
+                    errors::InvalidArgument(
+                        "The num_buckets of strings_hash should be greater "
+                        "than 0, but got %d.",
+                        num_buckets));
+  const pstring* in = x.data();
+  int64_t num = x.numel();
+  out->Resize(x.dims());
+  int64_t* out_data = dev_ctx.template Alloc<int64_t>(out);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < num; ++i) {
+    out_data[i] = XXH64(in[i].data(), in[i].size(), seed) %
+                  static_cast<uint64_t>(num_buckets);
+  }
+}
+
+}  // namespace strings
+}  // namespace phi
+
+PD_REGISTER_GENERAL_KERNEL(strings_hash,
+                           CPU,
+                           ALL_LAYOUT,
+                           phi::strings::StringHashKernel<phi::CPUContext>,
+                           pstring) {
+  kernel->OutputAt(0).SetDataType(phi::DataType::INT64);
+}
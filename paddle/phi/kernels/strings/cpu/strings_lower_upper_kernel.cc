@@ -14,12 +14,93 @@ limitations under the License. */
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/pstring.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/strings/cpu/ascii_utils.h"
 
 using pstring = ::phi::dtype::pstring;
 
 namespace phi {
 namespace strings {
 
+// The first letter whose case is flipped by a converter.
+template <typename CharConverter>
+struct AsciiCaseFirst;
+
+template <>
+struct AsciiCaseFirst<AsciiToLower> {
+  static constexpr char value = 'A';
+};
+
+template <>
+struct AsciiCaseFirst<AsciiToUpper> {
+  static constexpr char value = 'a';
+};
+
+template <template <typename DeviceContextT> class CharConverter>
+struct UTF8CaseFirst;
+
+template <>
+struct UTF8CaseFirst<UTF8ToLower> {
+  static constexpr char value = 'A';
+};
+
+template <>
+struct UTF8CaseFirst<UTF8ToUpper> {
+  static constexpr char value = 'a';
+};
+
+template <typename CharConverter>
+struct AsciiCaseConverter<phi::CPUContext, CharConverter> {
+  void operator()(const phi::CPUContext& dev_ctx,
+                  const pstring* in,
+                  pstring* out,
+                  size_t num) const {
+    const char first = AsciiCaseFirst<CharConverter>::value;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t i = 0; i < static_cast<int64_t>(num); ++i) {
+      out[i].resize_uninitialized(in[i].size());
+      AsciiConvertCase(in[i].data(), in[i].size(), first, out[i].mdata());
+    }
+  }
+};
+
+template <template <typename DeviceContextT> class CharConverter>
+struct UTF8CaseConverter<phi::CPUContext, CharConverter> {
+  void operator()(const phi::CPUContext& dev_ctx,
+                  const pstring* in,
+                  pstring* out,
+                  size_t num) const {
+    auto unicode_flag_map = GetUniFlagMap();
+    auto cases_map = GetCharcasesMap();
+    const char first = UTF8CaseFirst<CharConverter>::value;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t i = 0; i < static_cast<int64_t>(num); ++i) {
+      // the case of an ASCII string can be converted byte by byte without
+      // decoding it to code points
+      if (IsAsciiStr(in[i].data(), in[i].size())) {
+        out[i].resize_uninitialized(in[i].size());
+        AsciiConvertCase(in[i].data(), in[i].size(), first, out[i].mdata());
+        continue;
+      }
+      uint32_t unicode_len = GetUnicodeStrLen(in[i].data(), in[i].size());
+      std::vector<uint32_t> unicode_in(unicode_len, 0);
+      GetUnicodeStr(in[i].data(), unicode_in.data(), unicode_len);
+      std::transform(
+          unicode_in.begin(),
+          unicode_in.end(),
+          unicode_in.begin(),
+          CharConverter<phi::CPUContext>(unicode_flag_map, cases_map));
+      uint32_t utf8_len = GetUTF8StrLen(unicode_in.data(), unicode_len);
+      std::vector<char> result(utf8_len, 0);
+      GetUTF8Str(unicode_in.data(), result.data(), unicode_len);
+      out[i] = result.data();
+    }
+  }
+};
+
 template <typename ContextT>
 void StringLowerKernel(const ContextT& dev_ctx,
                        const StringTensor& x,
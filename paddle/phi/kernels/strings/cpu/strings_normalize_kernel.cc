@@ -0,0 +1,111 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/strings/strings_normalize_kernel.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/pstring.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/strings/case_utils.h"
+#include "paddle/phi/kernels/strings/cpu/ascii_utils.h"
+#include "paddle/phi/kernels/strings/unicode.h"
+
+using pstring = ::phi::dtype::pstring;
+
+namespace phi {
+namespace strings {
+
+namespace {
+
+void UTF8Lower(const uint8_t* unicode_flag_map,
+               const uint16_t* cases_map,
+               pstring* str) {
+  uint32_t unicode_len = GetUnicodeStrLen(str->data(), str->size());
+  std::vector<uint32_t> unicode(unicode_len, 0);
+  GetUnicodeStr(str->data(), unicode.data(), unicode_len);
+  std::transform(unicode.begin(),
+                 unicode.end(),
+                 unicode.begin(),
+                 UTF8ToLower<phi::CPUContext>(unicode_flag_map, cases_map));
+  std::vector<char> result(GetUTF8StrLen(unicode.data(), unicode_len), 0);
+  GetUTF8Str(unicode.data(), result.data(), unicode_len);
+  *str = result.data();
+}
+
+}  // namespace
+
+template <typename Context>
+void StringNormalizeKernel(const Context& dev_ctx,
+                           const StringTensor& x,
+                           bool lower_case,
+                           bool use_utf8_encoding,
+                           StringTensor* out) {
+  const pstring* in = x.data();
+  int64_t num = x.numel();
+  out->Resize(x.dims());
+  pstring* out_data = dev_ctx.template Alloc<pstring>(out);
+  const uint8_t* unicode_flag_map = nullptr;
+  const uint16_t* cases_map = nullptr;
+  if (lower_case && use_utf8_encoding) {
+    unicode_flag_map = GetUniFlagMap();
+    cases_map = GetCharcasesMap();
+  }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < num; ++i) {
+    const char* src = in[i].data();
+    size_t size = in[i].size();
+    pstring& str = out_data[i];
+    // the result is never longer than the input
+    str.resize_uninitialized(size);
+    char* dst = str.mdata();
+    size_t len = 0;
+    bool pending_space = false;
+    for (size_t j = 0; j < size; ++j) {
+      if (IsAsciiSpace(src[j])) {
+        pending_space = len > 0;
+        continue;
+      }
+      if (pending_space) {
+        dst[len++] = ' ';
+        pending_space = false;
+      }
+      dst[len++] = src[j];
+    }
+    str.resize(len);
+    if (!lower_case) {
+      continue;
+    }
+    if (!use_utf8_encoding || IsAsciiStr(str.data(), len)) {
+      AsciiConvertCase(str.data(), len, 'A', str.mdata());
+    } else {
+      UTF8Lower(unicode_flag_map, cases_map, &str);
+    }
+  }
+}
+
+}  // namespace strings
+}  // namespace phi
+
+PD_REGISTER_GENERAL_KERNEL(
+    strings_normalize,
+    CPU,
+    ALL_LAYOUT,
+    phi::strings::StringNormalizeKernel<phi::CPUContext>,
+    pstring) {}
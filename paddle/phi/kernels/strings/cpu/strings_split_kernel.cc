@@ -0,0 +1,128 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/strings/strings_split_kernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/pstring.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/strings/cpu/ascii_utils.h"
+
+using pstring = ::phi::dtype::pstring;
+
+namespace phi {
+namespace strings {
+
+namespace {
+
+const char* FindDelimiter(const char* begin,
+                          const char* end,
+                          const std::string& delimiter) {
+  if (delimiter.size() == 1) {
+    const void* found = std::memchr(begin, delimiter[0], end - begin);
+    return found ? static_cast<const char*>(found) : end;
+  }
+  return std::search(begin, end, delimiter.begin(), delimiter.end());
+}
+
+// Call func(token, length) on every token of str and return the number of
+// tokens.
+template <typename Func>
+int64_t ForEachToken(const pstring& str,
+                     const std::string& delimiter,
+                     Func&& func) {
+  const char* pos = str.data();
+  const char* end = pos + str.size();
+  int64_t count = 0;
+  if (delimiter.empty()) {
+    while (true) {
+      while (pos < end && IsAsciiSpace(*pos)) {
+        ++pos;
+      }
+      if (pos == end) {
+        break;
+      }
+      const char* token = pos;
+      while (pos < end && !IsAsciiSpace(*pos)) {
+        ++pos;
+      }
+      func(token, pos - token);
+      ++count;
+    }
+    return count;
+  }
+  while (true) {
+    const char* found = FindDelimiter(pos, end, delimiter);
+    func(pos, found - pos);
+    ++count;
+    if (found == end) {
+      break;
+    }
+    pos = found + delimiter.size();
+  }
+  return count;
+}
+
+}  // namespace
+
+template <typename Context>
+void StringSplitKernel(const Context& dev_ctx,
+                       const StringTensor& x,
+                       const std::string& delimiter,
+                       StringTensor* out,
+                       DenseTensor* offsets) {
+  const pstring* in = x.data();
+  int64_t num = x.numel();
+  offsets->Resize({num + 1});
+  int64_t* offsets_data = dev_ctx.template Alloc<int64_t>(offsets);
+
+  // count the tokens first, so every string writes its tokens to its own
+  // range of out in parallel
+  offsets_data[0] = 0;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < num; ++i) {
+    offsets_data[i + 1] =
+        ForEachToken(in[i], delimiter, [](const char*, size_t) {});
+  }
+  std::partial_sum(offsets_data, offsets_data + num + 1, offsets_data);
+
+  out->Resize({offsets_data[num]});
+  pstring* out_data = dev_ctx.template Alloc<pstring>(out);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < num; ++i) {
+    pstring* token_out = out_data + offsets_data[i];
+    ForEachToken(in[i], delimiter, [&token_out](const char* token, size_t len) {
+      *token_out++ = pstring(token, len);
+    });
+  }
+}
+
+}  // namespace strings
+}  // namespace phi
+
+PD_REGISTER_GENERAL_KERNEL(strings_split,
+                           CPU,
+                           ALL_LAYOUT,
+                           phi::strings::StringSplitKernel<phi::CPUContext>,
+                           pstring) {
+  kernel->OutputAt(1).SetDataType(phi::DataType::INT64);
+}
@@ -0,0 +1,33 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/string_tensor.h"
+
+namespace phi {
+namespace strings {
+
+// Hash every string with XXH64 and the seed into an int64 id in
+// [0, num_buckets), e.g. for feature hashing or hashed vocabularies.
+template <typename Context>
+void StringHashKernel(const Context& dev_ctx,
+                      const StringTensor& x,
+                      int64_t num_buckets,
+                      int seed,
+                      DenseTensor* out);
+
+}  // namespace strings
+}  // namespace phi
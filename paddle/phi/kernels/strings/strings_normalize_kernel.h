@@ -0,0 +1,33 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include "paddle/phi/core/string_tensor.h"
+
+namespace phi {
+namespace strings {
+
+// Strip the leading and trailing whitespace of every string and replace
+// every run of whitespace inside by a single space, then lower the case if
+// lower_case is set.
+template <typename Context>
+void StringNormalizeKernel(const Context& dev_ctx,
+                           const StringTensor& x,
+                           bool lower_case,
+                           bool use_utf8_encoding,
+                           StringTensor* out);
+
+}  // namespace strings
+}  // namespace phi
@@ -0,0 +1,38 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/string_tensor.h"
+
+namespace phi {
+namespace strings {
+
+// Split every string of x by the delimiter. The tokens of all strings are
+// written to the 1-D out one string after another, and the tokens of x[i]
+// are out[offsets[i]] to out[offsets[i + 1] - 1]. An empty delimiter splits
+// by runs of ASCII whitespace and drops the empty tokens, as str.split() of
+// Python does.
+template <typename Context>
+void StringSplitKernel(const Context& dev_ctx,
+                       const StringTensor& x,
+                       const std::string& delimiter,
+                       StringTensor* out,
+                       DenseTensor* offsets);
+
+}  // namespace strings
+}  // namespace phi
@@ -22,13 +22,21 @@ KernelSignature SaveCombineOpArgumentMapping(
     return KernelSignature(
         "save_combine_tensor",
         {"X"},
-        {"file_path", "overwrite", "save_as_fp16", "save_to_memory"},
+        {"file_path",
+         "overwrite",
+         "save_as_fp16",
+         "save_to_memory",
+         "aligned_format"},
         {"Y"});
   } else {
     return KernelSignature(
         "save_combine_vocab",
         {"X"},
-        {"file_path", "overwrite", "save_as_fp16", "save_to_memory"},
+        {"file_path",
+         "overwrite",
+         "save_as_fp16",
+         "save_to_memory",
+         "aligned_format"},
         {"Y"});
   }
 }
@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <chrono>  // NOLINT
 #include <iostream>
 #include <sstream>
 
@@ -48,6 +49,65 @@ TEST(KernelFactory, SelectedKernelMap) {
   }
 }
 
+TEST(KernelDispatchCache, SelectKernel) {
+  phi::KernelDispatchCache cache("scale");
+  for (auto dtype : {phi::DataType::FLOAT32, phi::DataType::FLOAT64}) {
+    phi::KernelKey kernel_key(
+        phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, dtype);
+    const auto& kernel =
+        phi::KernelFactory::Instance().SelectKernel("scale", kernel_key);
+    // a miss and a hit return the registered kernel
+    for (int i = 0; i < 2; ++i) {
+      auto kernel_result = cache.SelectKernelOrThrowError(kernel_key);
+      EXPECT_EQ(&kernel_result.kernel, &kernel);
+      EXPECT_FALSE(kernel_result.has_fallback_cpu);
+    }
+  }
+  // a modification of the kernel map drops the memoized kernels
+  phi::KernelKey kernel_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  auto version = phi::KernelFactory::Instance().kernels_version();
+  phi::KernelFactory::Instance().kernels();
+  EXPECT_GT(phi::KernelFactory::Instance().kernels_version(), version);
+  EXPECT_EQ(&cache.SelectKernelOrThrowError(kernel_key).kernel,
+            &phi::KernelFactory::Instance().SelectKernel("scale", kernel_key));
+
+  phi::KernelKey missing_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::PSTRING);
+  EXPECT_ANY_THROW(cache.SelectKernelOrThrowError(missing_key));
+}
+
+TEST(KernelDispatchCache, Benchmark) {
+  const int num_calls = 1000000;
+  phi::KernelKey kernel_key(
+      phi::Backend::CPU, phi::DataLayout::NCHW, phi::DataType::FLOAT32);
+  const phi::Kernel* kernel = nullptr;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_calls; ++i) {
+    // the way the generated API selects a kernel without the cache
+    kernel = &phi::KernelFactory::Instance()
+                  .SelectKernelOrThrowError("scale", kernel_key)
+                  .kernel;
+  }
+  auto factory_ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count() /
+                    num_calls;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_calls; ++i) {
+    static thread_local phi::KernelDispatchCache cache("scale");
+    kernel = &cache.SelectKernelOrThrowError(kernel_key).kernel;
+  }
+  auto cache_ns = std::chrono::duration<double, std::nano>(
+                      std::chrono::steady_clock::now() - start)
+                      .count() /
+                  num_calls;
+  EXPECT_TRUE(kernel->IsValid());
+  std::cout << "kernel selection per op: " << factory_ns << " ns, with "
+            << "dispatch cache: " << cache_ns << " ns" << std::endl;
+}
+
 template <typename T, typename Context>
 void TestKernel(const Context& dev_ctx,
                 const DenseTensor& x,
@@ -115,6 +115,58 @@ TEST(Seq2BatchPadding, CPU) {
   TestSequencePadding<phi::CPUContext, float>(*context, lod2, 128);
 }
 
+TEST(SequencePadding, CPUPadValue) {
+  auto *context = static_cast<phi::CPUContext *>(
+      phi::DeviceContextPool::Instance().Get(phi::CPUPlace()));
+  // an empty sequence, and a sequence as long as the padded length
+  phi::LoD lod;
+  lod.push_back(std::vector<size_t>{0, 2, 2, 5, 6});
+  const int64_t seq_num = 4;
+  const int64_t pad_seq_len = 3;
+  const int64_t width = 2;
+  phi::DenseTensor seq;
+  seq.set_lod(lod);
+  seq.Resize({6, width});
+  float *seq_data = context->template Alloc<float>(&seq);
+  for (int64_t i = 0; i < seq.numel(); ++i) {
+    seq_data[i] = static_cast<float>(i + 1);
+  }
+  // a pad value of a single element and a pad value of a step
+  for (int64_t pad_numel : {1, 2}) {
+    phi::DenseTensor pad_value;
+    pad_value.Resize({pad_numel});
+    float *pad_value_data = context->template Alloc<float>(&pad_value);
+    for (int64_t i = 0; i < pad_numel; ++i) {
+      pad_value_data[i] = -1.0f - i;
+    }
+    for (auto layout :
+         {phi::funcs::kBatchLengthWidth, phi::funcs::kLengthBatchWidth}) {
+      phi::DenseTensor padding;
+      if (layout == phi::funcs::kBatchLengthWidth) {
+        padding.Resize({seq_num, pad_seq_len, width});
+      } else {
+        padding.Resize({pad_seq_len, seq_num, width});
+      }
+      context->template Alloc<float>(&padding);
+      phi::funcs::PaddingLoDTensorFunctor<phi::CPUContext, float>()(
+          *context, seq, &padding, pad_value, -1, 0, false, layout);
+      for (int64_t i = 0; i < seq_num; ++i) {
+        for (int64_t step = 0; step < pad_seq_len; ++step) {
+          int64_t offset = layout == phi::funcs::kBatchLengthWidth
+                               ? (i * pad_seq_len + step) * width
+                               : (step * seq_num + i) * width;
+          bool valid = lod[0][i] + step < lod[0][i + 1];
+          for (int64_t k = 0; k < width; ++k) {
+            float expected = valid ? seq_data[(lod[0][i] + step) * width + k]
+                                   : pad_value_data[k % pad_numel];
+            EXPECT_EQ(padding.data<float>()[offset + k], expected);
+          }
+        }
+      }
+    }
+  }
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 TEST(SequencePadding, CUDA) {
   auto place = phi::GPUPlace(0);
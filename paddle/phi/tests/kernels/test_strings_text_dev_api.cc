@@ -0,0 +1,242 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/common/pstring.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/core/string_tensor.h"
+#include "paddle/phi/kernels/strings/strings_hash_kernel.h"
+#include "paddle/phi/kernels/strings/strings_lower_upper_kernel.h"
+#include "paddle/phi/kernels/strings/strings_normalize_kernel.h"
+#include "paddle/phi/kernels/strings/strings_split_kernel.h"
+
+namespace phi {
+namespace tests {
+
+using pstring = ::phi::dtype::pstring;
+
+namespace {
+
+const phi::CPUContext& GetCPUContext() {
+  phi::DeviceContextPool& pool = phi::DeviceContextPool::Instance();
+  return *static_cast<phi::CPUContext*>(pool.Get(phi::CPUPlace()));
+}
+
+StringTensor MakeStringTensor(const std::vector<std::string>& strs) {
+  StringTensor x;
+  x.Resize({static_cast<int64_t>(strs.size())});
+  pstring* x_data = GetCPUContext().template Alloc<pstring>(&x);
+  for (size_t i = 0; i < strs.size(); ++i) {
+    x_data[i] = strs[i];
+  }
+  return x;
+}
+
+std::string ToString(const pstring& str) {
+  return std::string(str.data(), str.size());
+}
+
+}  // namespace
+
+TEST(DEV_API, strings_split) {
+  auto& dev_ctx = GetCPUContext();
+  StringTensor x = MakeStringTensor(
+      {"a,b,,c", "", "no delimiter", "  many   spaces\there  ", "x,,"});
+
+  StringTensor out;
+  DenseTensor offsets;
+  strings::StringSplitKernel(dev_ctx, x, ",", &out, &offsets);
+  std::vector<int64_t> expected_offsets = {0, 4, 5, 6, 7, 10};
+  std::vector<std::string> expected_tokens = {"a",
+                                              "b",
+                                              "",
+                                              "c",
+                                              "",
+                                              "no delimiter",
+                                              "  many   spaces\there  ",
+                                              "x",
+                                              "",
+                                              ""};
+  ASSERT_EQ(offsets.numel(), 6);
+  ASSERT_EQ(out.numel(), 10);
+  for (int64_t i = 0; i < offsets.numel(); ++i) {
+    EXPECT_EQ(offsets.data<int64_t>()[i], expected_offsets[i]);
+  }
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    EXPECT_EQ(ToString(out.data()[i]), expected_tokens[i]);
+  }
+
+  // split by whitespace
+  strings::StringSplitKernel(dev_ctx, x, "", &out, &offsets);
+  expected_offsets = {0, 1, 1, 3, 6, 7};
+  expected_tokens = {
+      "a,b,,c", "no", "delimiter", "many", "spaces", "here", "x,,"};
+  ASSERT_EQ(out.numel(), 7);
+  for (int64_t i = 0; i < offsets.numel(); ++i) {
+    EXPECT_EQ(offsets.data<int64_t>()[i], expected_offsets[i]);
+  }
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    EXPECT_EQ(ToString(out.data()[i]), expected_tokens[i]);
+  }
+
+  // a delimiter of several chars
+  strings::StringSplitKernel(dev_ctx, x, ",,", &out, &offsets);
+  ASSERT_EQ(out.numel(), 7);
+  EXPECT_EQ(ToString(out.data()[0]), "a,b");
+  EXPECT_EQ(ToString(out.data()[1]), "c");
+  EXPECT_EQ(ToString(out.data()[5]), "x");
+  EXPECT_EQ(ToString(out.data()[6]), "");
+}
+
+TEST(DEV_API, strings_normalize) {
+  auto& dev_ctx = GetCPUContext();
+  StringTensor x = MakeStringTensor({"  Hello \t\n World  ",
+                                     "",
+                                     "   ",
+                                     "ÓsscHlo  ËË",
+                                     "A Large Pstring Whose Length Is Longer"});
+  StringTensor out;
+  strings::StringNormalizeKernel(dev_ctx, x, false, false, &out);
+  EXPECT_EQ(ToString(out.data()[0]), "Hello World");
+  EXPECT_EQ(ToString(out.data()[1]), "");
+  EXPECT_EQ(ToString(out.data()[2]), "");
+  EXPECT_EQ(ToString(out.data()[3]), "ÓsscHlo ËË");
+
+  // the bytes of non-ASCII characters are kept without utf8 encoding
+  strings::StringNormalizeKernel(dev_ctx, x, true, false, &out);
+  EXPECT_EQ(ToString(out.data()[0]), "hello world");
+  EXPECT_EQ(ToString(out.data()[3]), "Ósschlo ËË");
+  EXPECT_EQ(ToString(out.data()[4]), "a large pstring whose length is longer");
+
+  strings::StringNormalizeKernel(dev_ctx, x, true, true, &out);
+  EXPECT_EQ(ToString(out.data()[0]), "hello world");
+  EXPECT_EQ(ToString(out.data()[3]), "ósschlo ëë");
+}
+
+TEST(DEV_API, strings_hash) {
+  auto& dev_ctx = GetCPUContext();
+  StringTensor x = MakeStringTensor({"apple", "banana", "apple", ""});
+  DenseTensor out;
+  strings::StringHashKernel(dev_ctx, x, 1000, 0, &out);
+  ASSERT_EQ(out.numel(), 4);
+  const int64_t* ids = out.data<int64_t>();
+  EXPECT_EQ(ids[0], ids[2]);
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    EXPECT_GE(ids[i], 0);
+    EXPECT_LT(ids[i], 1000);
+  }
+
+  DenseTensor out_seed;
+  strings::StringHashKernel(dev_ctx, x, int64_t{1} << 40, 1, &out_seed);
+  DenseTensor out_no_seed;
+  strings::StringHashKernel(dev_ctx, x, int64_t{1} << 40, 0, &out_no_seed);
+  EXPECT_NE(out_seed.data<int64_t>()[0], out_no_seed.data<int64_t>()[0]);
+}
+
+// lower and upper of ASCII strings longer than the inline buffer of pstring
+TEST(DEV_API, strings_lower_upper_long) {
+  auto& dev_ctx = GetCPUContext();
+  std::string str;
+  for (int i = 0; i < 10; ++i) {
+    str += "Mixed Case ASCII Text, ";
+  }
+  StringTensor x = MakeStringTensor({str, "ÀB"});
+  std::string lower = str;
+  std::string upper = str;
+  for (auto& c : lower) {
+    c = ::tolower(c);
+  }
+  for (auto& c : upper) {
+    c = ::toupper(c);
+  }
+  for (bool use_utf8_encoding : {false, true}) {
+    auto lower_out = strings::StringLower(dev_ctx, x, use_utf8_encoding);
+    auto upper_out = strings::StringUpper(dev_ctx, x, use_utf8_encoding);
+    EXPECT_EQ(ToString(lower_out.data()[0]), lower);
+    EXPECT_EQ(ToString(upper_out.data()[0]), upper);
+  }
+  EXPECT_EQ(ToString(strings::StringLower(dev_ctx, x, true).data()[1]), "àb");
+}
+
+TEST(DEV_API, strings_benchmark) {
+  auto& dev_ctx = GetCPUContext();
+  // 200000 sentences of about 100 bytes, 20MB in total
+  constexpr int kNum = 200000;
+  std::vector<std::string> ascii_strs;
+  std::vector<std::string> utf8_strs;
+  size_t ascii_bytes = 0;
+  size_t utf8_bytes = 0;
+  for (int i = 0; i < kNum; ++i) {
+    std::string str = "The Quick Brown Fox " + std::to_string(i) +
+                      "  Jumps Over\tThe Lazy Dog, Sentence Number " +
+                      std::to_string(i * 7) + " Of The Benchmark";
+    ascii_bytes += str.size();
+    ascii_strs.push_back(str);
+    utf8_strs.push_back(str + " ÓsscHloëË");
+    utf8_bytes += utf8_strs.back().size();
+  }
+  StringTensor ascii_x = MakeStringTensor(ascii_strs);
+  StringTensor utf8_x = MakeStringTensor(utf8_strs);
+
+  auto mb_per_s = [](size_t bytes, std::chrono::steady_clock::duration d) {
+    return bytes / 1e6 / std::chrono::duration<double>(d).count();
+  };
+  auto measure = [](const std::function<void()>& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::steady_clock::now() - start;
+  };
+
+  StringTensor out;
+  out.Resize(ascii_x.dims());
+  DenseTensor dense_out;
+  auto lower_ascii = measure([&] {
+    strings::StringLowerKernel(dev_ctx, ascii_x, false, &out);
+  });
+  auto lower_utf8_on_ascii = measure([&] {
+    strings::StringLowerKernel(dev_ctx, ascii_x, true, &out);
+  });
+  auto lower_utf8 = measure([&] {
+    strings::StringLowerKernel(dev_ctx, utf8_x, true, &out);
+  });
+  auto normalize = measure([&] {
+    strings::StringNormalizeKernel(dev_ctx, ascii_x, true, true, &out);
+  });
+  auto split = measure([&] {
+    strings::StringSplitKernel(dev_ctx, ascii_x, "", &out, &dense_out);
+  });
+  auto hash = measure([&] {
+    strings::StringHashKernel(dev_ctx, ascii_x, 1 << 20, 0, &dense_out);
+  });
+
+  LOG(INFO) << "lower ascii: " << mb_per_s(ascii_bytes, lower_ascii)
+            << " MB/s, lower utf8 of ascii text: "
+            << mb_per_s(ascii_bytes, lower_utf8_on_ascii)
+            << " MB/s, lower utf8: " << mb_per_s(utf8_bytes, lower_utf8)
+            << " MB/s, normalize: " << mb_per_s(ascii_bytes, normalize)
+            << " MB/s, split: " << mb_per_s(ascii_bytes, split)
+            << " MB/s, hash: " << mb_per_s(ascii_bytes, hash) << " MB/s";
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,110 @@
+# Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import multiprocessing
+import socket
+import time
+import unittest
+from contextlib import closing
+
+import numpy as np
+
+import paddle
+from paddle.fluid import core
+
+
+def find_free_port():
+    with closing(socket.socket(socket.AF_INET, socket.SOCK_STREAM)) as s:
+        s.bind(('', 0))
+        return s.getsockname()[1]
+
+
+def check_all_reduce(pg, rank, nranks):
+    for numel in [1, 1000, 300000]:
+        x = np.arange(numel) % 17 + rank
+        tensor = paddle.to_tensor(x.astype('float32'))
+        pg.all_reduce(tensor, core.ReduceOp.SUM, sync_op=True)
+        expect = sum(np.arange(numel) % 17 + r for r in range(nranks))
+        np.testing.assert_allclose(tensor.numpy(), expect)
+
+        tensor = paddle.to_tensor(x.astype('int64'))
+        pg.all_reduce(tensor, core.ReduceOp.MAX, sync_op=True)
+        np.testing.assert_equal(tensor.numpy(), x - rank + nranks - 1)
+
+
+def time_all_reduce(pg, numel, repeat):
+    tensor = paddle.ones([numel], dtype='float32')
+    pg.all_reduce(tensor, core.ReduceOp.SUM, sync_op=True)
+    pg.barrier().wait()
+    start = time.time()
+    for _ in range(repeat):
+        pg.all_reduce(tensor, core.ReduceOp.SUM, sync_op=True)
+    return (time.time() - start) / repeat
+
+
+def hierarchical_func(rank, nranks, ranks_per_node, port, out_dict):
+    try:
+        paddle.device.set_device('cpu')
+        store = core.TCPStore("127.0.0.1", port, rank == 0, nranks, 30)
+        pg = core.ProcessGroupGloo.create(store, rank, nranks)
+        # localhost processes are split into virtual nodes
+        node_key = "node{}".format(rank // ranks_per_node)
+        sizes = [256, 1 << 16, 1 << 22]
+
+        flat = [time_all_reduce(pg, numel, 20) for numel in sizes]
+        check_all_reduce(pg, rank, nranks)
+
+        pg.set_hierarchical_allreduce(
+            True, node_key, chunk_bytes=1 << 18, small_bytes=1 << 12
+        )
+        hierarchical = [time_all_reduce(pg, numel, 20) for numel in sizes]
+        check_all_reduce(pg, rank, nranks)
+
+        pg.set_hierarchical_allreduce(False)
+        check_all_reduce(pg, rank, nranks)
+        out_dict[rank] = list(zip(sizes, flat, hierarchical))
+    except Exception as e:
+        print("rank", rank, "failed:", e)
+        out_dict[rank] = None
+
+
+class CollectiveGlooHierarchicalTest(unittest.TestCase):
+    def test_hierarchical_with_multiprocess(self):
+        nranks = 4
+        ranks_per_node = 2
+        port = find_free_port()
+        manager = multiprocessing.Manager()
+        procs_out_dict = manager.dict()
+        jobs = []
+        for rank in range(nranks):
+            p = multiprocessing.Process(
+                target=hierarchical_func,
+                args=(rank, nranks, ranks_per_node, port, procs_out_dict),
+            )
+            jobs.append(p)
+            p.start()
+        for proc in jobs:
+            proc.join()
+        self.assertEqual(len(procs_out_dict), nranks)
+        for rank, costs in procs_out_dict.items():
+            self.assertIsNotNone(costs)
+            for numel, flat, hierarchical in costs:
+                print(
+                    "rank {}: {} floats, flat {:.6f}s, hierarchical "
+                    "{:.6f}s".format(rank, numel, flat, hierarchical)
+                )
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,119 @@
+# Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import multiprocessing
+import socket
+import time
+import unittest
+from contextlib import closing
+
+import numpy as np
+
+import paddle
+from paddle.fluid import core
+
+
+def find_free_port():
+    with closing(socket.socket(socket.AF_INET, socket.SOCK_STREAM)) as s:
+        s.bind(('', 0))
+        return s.getsockname()[1]
+
+
+def run_buckets(pg, weights, grads, overlap):
+    # Each bucket stands for the backward of a layer followed by the
+    # all-reduce of its gradients. Without overlap every all-reduce is
+    # waited for right away, as the synchronous gloo backend used to do.
+    tasks = []
+    start = time.time()
+    for weight, grad in zip(weights, grads):
+        for _ in range(4):
+            weight = paddle.matmul(weight, weight) * 1e-3
+        task = pg.all_reduce(grad, core.ReduceOp.SUM, sync_op=not overlap)
+        tasks.append(task)
+    for task in tasks:
+        task.wait()
+    return time.time() - start
+
+
+def overlap_func(rank, nranks, port, out_dict):
+    try:
+        paddle.device.set_device('cpu')
+        store = core.TCPStore("127.0.0.1", port, rank == 0, nranks, 30)
+        pg = core.ProcessGroupGloo.create(store, rank, nranks)
+
+        bucket_num = 8
+        bucket_numel = 1 << 20
+        np.random.seed(rank)
+        weights = [
+            paddle.to_tensor(np.random.random((256, 256)).astype('float32'))
+            for _ in range(bucket_num)
+        ]
+        local = [
+            np.full(bucket_numel, rank + i, dtype='float32')
+            for i in range(bucket_num)
+        ]
+        expect = [
+            np.full(bucket_numel, sum(r + i for r in range(nranks)), 'float32')
+            for i in range(bucket_num)
+        ]
+
+        costs = {}
+        for overlap in [False, True, False, True]:
+            grads = [paddle.to_tensor(x) for x in local]
+            cost = run_buckets(pg, weights, grads, overlap)
+            costs[overlap] = min(costs.get(overlap, cost), cost)
+            for grad, value in zip(grads, expect):
+                np.testing.assert_allclose(grad.numpy(), value)
+
+        # an async task is completed once it is waited for
+        task = pg.all_reduce(
+            paddle.to_tensor(local[0]), core.ReduceOp.SUM, sync_op=False
+        )
+        task.wait()
+        assert task.is_completed()
+        pg.barrier().wait()
+        out_dict[rank] = (costs[False], costs[True])
+    except Exception as e:
+        print("rank", rank, "failed:", e)
+        out_dict[rank] = None
+
+
+class CollectiveGlooOverlapTest(unittest.TestCase):
+    def test_overlap_with_multiprocess(self):
+        nranks = 2
+        port = find_free_port()
+        manager = multiprocessing.Manager()
+        procs_out_dict = manager.dict()
+        jobs = []
+        for rank in range(nranks):
+            p = multiprocessing.Process(
+                target=overlap_func,
+                args=(rank, nranks, port, procs_out_dict),
+            )
+            jobs.append(p)
+            p.start()
+        for proc in jobs:
+            proc.join()
+        self.assertEqual(len(procs_out_dict), nranks)
+        for rank, costs in procs_out_dict.items():
+            self.assertIsNotNone(costs)
+            print(
+                "rank {}: sync all-reduce {:.4f}s, overlapped {:.4f}s".format(
+                    rank, costs[0], costs[1]
+                )
+            )
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,82 @@
+#   Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+
+import numpy as np
+from op_test import OpTest
+from test_cvm_op import cvm_compute
+
+
+class TestFusionEmbeddingSeqPoolCVMOp(OpTest):
+    def setUp(self):
+        self.op_type = 'fusion_embedding_seqpool_cvm'
+        self.table_height = 50
+        self.w = 11
+        self.use_cvm = True
+        self.pad_value = 0.0
+        self.lods = [[[2, 3, 5]], [[1, 0, 2]]]
+        self.set_conf()
+        table = np.random.uniform(0.1, 1, [self.table_height, self.w]).astype(
+            'float32'
+        )
+        ids = []
+        outs = []
+        for i, lod in enumerate(self.lods):
+            slot_ids = np.random.randint(
+                0, self.table_height, [sum(lod[0]), 1]
+            ).astype('int64')
+            pooled = np.full((len(lod[0]), self.w), self.pad_value, 'float32')
+            begin = 0
+            for j, seq_len in enumerate(lod[0]):
+                if seq_len > 0:
+                    rows = table[slot_ids[begin : begin + seq_len, 0]]
+                    pooled[j] = rows.sum(axis=0)
+                begin += seq_len
+            ids.append(('ids_{0}'.format(i), (slot_ids, lod)))
+            outs.append(
+                ('out_{0}'.format(i), cvm_compute(pooled, self.w, self.use_cvm))
+            )
+
+        self.inputs = {'W': table, 'Ids': ids}
+        self.outputs = {'Out': outs}
+        self.attrs = {
+            'pad_value': self.pad_value,
+            'use_cvm': self.use_cvm,
+            'cvm_offset': 2,
+        }
+
+    def set_conf(self):
+        pass
+
+    def test_check_output(self):
+        self.check_output()
+
+
+class TestFusionEmbeddingSeqPoolCVMOpNoCVM(TestFusionEmbeddingSeqPoolCVMOp):
+    def set_conf(self):
+        self.use_cvm = False
+        self.pad_value = 0.5
+
+
+class TestFusionEmbeddingSeqPoolCVMOpManySlots(
+    TestFusionEmbeddingSeqPoolCVMOp
+):
+    def set_conf(self):
+        self.lods = [[[2, 13, 4]], [[1, 1, 1]], [[5, 3, 1]], [[9, 10, 3]]]
+        self.w = 16
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -59,6 +59,8 @@ class MemPythonNode:
         current_reserved,
         peak_allocated,
         peak_reserved,
+        op_name='',
+        var_name='',
     ):
         self.timestamp_ns = timestamp_ns
         self.addr = addr
@@ -71,6 +73,8 @@ class MemPythonNode:
         self.current_reserved = current_reserved
         self.peak_allocated = peak_allocated
         self.peak_reserved = peak_reserved
+        self.op_name = op_name
+        self.var_name = var_name
 
 
 class TestProfilerStatistic(unittest.TestCase):
@@ -174,6 +178,8 @@ class TestProfilerStatistic(unittest.TestCase):
                 200,
                 800,
                 800,
+                'conv2d',
+                'conv2d_0.tmp_0',
             )
         )
         conv2d_launchkernel = HostPythonNode(
@@ -436,6 +442,10 @@ class TestProfilerStatistic(unittest.TestCase):
             statistic_data.memory_summary.peak_reserved_values['place(gpu:0)'],
             800,
         )
+        self.assertEqual(
+            statistic_data.memory_summary.peak_breakdown['place(gpu:0)'],
+            [('conv2d', 'conv2d_0.tmp_0', 20)],
+        )
         print(
             profiler.profiler_statistic._build_table(
                 statistic_data,
@@ -12,6 +12,7 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import time
 import unittest
 
 import numpy as np
@@ -161,6 +162,88 @@ class TestSparseConv(unittest.TestCase):
         )
 
 
+def voxelized_point_cloud(grid, num_points, channels):
+    # points on a sphere, as the surface of a lidar scan
+    points = np.random.randn(num_points, 3)
+    points /= np.linalg.norm(points, axis=1, keepdims=True)
+    voxels = ((points + 1) / 2 * (grid - 1)).round().astype('int32')
+    voxels = np.unique(voxels, axis=0)
+    indices = np.concatenate(
+        [np.zeros([len(voxels), 1], dtype='int32'), voxels], axis=1
+    )
+    values = np.random.rand(len(voxels), channels).astype('float32')
+    return sparse.sparse_coo_tensor(
+        paddle.to_tensor(indices.transpose()),
+        paddle.to_tensor(values),
+        [1, grid, grid, grid, channels],
+        stop_gradient=True,
+    )
+
+
+class TestSubmConvRulebookCache(unittest.TestCase):
+    def setUp(self):
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        if paddle.is_compiled_with_cuda():
+            paddle.set_device('gpu')
+
+    def test_cached_rulebook(self):
+        x = voxelized_point_cloud(64, 20000, 16)
+        weight = paddle.randn([3, 3, 3, 16, 16], dtype='float32')
+        layers = 4
+
+        start = time.time()
+        out = sparse.nn.functional.subm_conv3d(x, weight)
+        first_cost = time.time() - start
+        # the next layers find the rulebook of the first one
+        start = time.time()
+        outs = [out]
+        for _ in range(layers - 1):
+            outs.append(sparse.nn.functional.subm_conv3d(outs[-1], weight))
+        cached_cost = (time.time() - start) / (layers - 1)
+        print(
+            "{} voxels, subm_conv3d {:.6f}s, with cached rulebook "
+            "{:.6f}s".format(x.nnz(), first_cost, cached_cost)
+        )
+
+        # tensors without the indices dict build their own rulebook
+        for i in range(1, layers):
+            prev = sparse.sparse_coo_tensor(
+                outs[i - 1].indices(),
+                outs[i - 1].values(),
+                outs[i - 1].shape,
+                stop_gradient=True,
+            )
+            expect = sparse.nn.functional.subm_conv3d(prev, weight)
+            np.testing.assert_array_equal(
+                outs[i].indices().numpy(), expect.indices().numpy()
+            )
+            np.testing.assert_allclose(
+                outs[i].values().numpy(),
+                expect.values().numpy(),
+                rtol=1e-5,
+                atol=1e-5,
+            )
+
+    def test_cached_rulebook_backward(self):
+        x = voxelized_point_cloud(16, 500, 4)
+        weight = paddle.randn([3, 3, 3, 4, 4], dtype='float32')
+        weight.stop_gradient = False
+        out = sparse.nn.functional.subm_conv3d(x, weight)
+        out = sparse.nn.functional.subm_conv3d(out, weight)
+        out.values().sum().backward()
+        cached_grad = weight.grad.numpy()
+
+        weight.clear_gradient()
+        out = sparse.nn.functional.subm_conv3d(x, weight, key='first')
+        out = sparse.nn.functional.subm_conv3d(out, weight, key='second')
+        out.values().sum().backward()
+        np.testing.assert_allclose(
+            cached_grad, weight.grad.numpy(), rtol=1e-4, atol=1e-4
+        )
+
+
 class TestStatic(unittest.TestCase):
     def test(self):
         paddle.enable_static()
@@ -14,6 +14,7 @@
 
 import os
 import re
+import time
 import unittest
 
 import numpy as np
@@ -170,5 +171,106 @@ class TestMaskedMatmul(unittest.TestCase):
         )
 
 
+class TestMatmulCPU(unittest.TestCase):
+    def setUp(self):
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        if paddle.is_compiled_with_cuda():
+            paddle.set_device('gpu')
+        paddle.set_default_dtype('float64')
+
+    def check_result(self, x_shape, y_shape):
+        mask = paddle.randint(0, 2, x_shape[-2:])
+        origin_x = paddle.rand(x_shape) * mask
+        origin_y = paddle.rand(y_shape)
+
+        dense_x = origin_x.detach()
+        dense_x.stop_gradient = False
+        dense_y = origin_y.detach()
+        dense_y.stop_gradient = False
+        dense_out = paddle.matmul(dense_x, dense_y)
+        dense_out.backward()
+
+        sp_x = origin_x.detach().to_sparse_csr()
+        sp_x.stop_gradient = False
+        sp_y = origin_y.detach()
+        sp_y.stop_gradient = False
+        sp_out = paddle.sparse.matmul(sp_x, sp_y)
+        sp_out.backward()
+
+        np.testing.assert_allclose(
+            sp_out.numpy(), dense_out.numpy(), rtol=1e-05
+        )
+        np.testing.assert_allclose(
+            sp_x.grad.to_dense().numpy(),
+            (dense_x.grad * mask).numpy(),
+            rtol=1e-05,
+        )
+        np.testing.assert_allclose(
+            sp_y.grad.numpy(), dense_y.grad.numpy(), rtol=1e-05
+        )
+
+    def check_masked_result(self, x_shape, y_shape):
+        out_shape = x_shape[:-1] + y_shape[-1:]
+        np_mask = np.random.rand(*out_shape) < 0.2
+        np_x = np.random.rand(*x_shape)
+        np_y = np.random.rand(*y_shape)
+        np_out = np.matmul(np_x, np_y) * np_mask
+        # dx = dout * y', dy = x' * dout, where dout is the mask
+        np_x_grad = np.matmul(np_mask, np.swapaxes(np_y, -1, -2))
+        np_y_grad = np.matmul(np.swapaxes(np_x, -1, -2), np_mask)
+
+        x = paddle.to_tensor(np_x, stop_gradient=False)
+        y = paddle.to_tensor(np_y, stop_gradient=False)
+        mask = paddle.to_tensor(np_mask.astype('float64')).to_sparse_csr()
+        out = paddle.sparse.masked_matmul(x, y, mask)
+        out.backward()
+
+        self.assertTrue(out.is_sparse_csr())
+        np.testing.assert_equal(out.crows().numpy(), mask.crows().numpy())
+        np.testing.assert_equal(out.cols().numpy(), mask.cols().numpy())
+        np.testing.assert_allclose(
+            out.to_dense().numpy(), np_out, rtol=1e-05
+        )
+        np.testing.assert_allclose(x.grad.numpy(), np_x_grad, rtol=1e-05)
+        np.testing.assert_allclose(y.grad.numpy(), np_y_grad, rtol=1e-05)
+
+    def test_matmul(self):
+        self.check_result([16, 12], [12, 10])
+        self.check_result([8, 16, 12], [8, 12, 10])
+
+    def test_masked_matmul(self):
+        self.check_masked_result([10, 12], [12, 6])
+        self.check_masked_result([4, 10, 12], [4, 12, 6])
+
+    def test_benchmark(self):
+        paddle.set_default_dtype('float32')
+        m, k, n, repeat = 1024, 1024, 64, 10
+        y = paddle.rand([k, n])
+        for density in [0.001, 0.01, 0.05, 0.2]:
+            mask = (paddle.rand([m, k]) < density).astype('float32')
+            x = paddle.rand([m, k]) * mask
+            sp_x = x.to_sparse_csr()
+            out = paddle.sparse.matmul(sp_x, y)
+            np.testing.assert_allclose(
+                out.numpy(), paddle.matmul(x, y).numpy(), rtol=1e-04
+            )
+
+            start = time.time()
+            for _ in range(repeat):
+                paddle.sparse.matmul(sp_x, y)
+            sparse_cost = (time.time() - start) / repeat
+            start = time.time()
+            for _ in range(repeat):
+                paddle.matmul(x, y)
+            dense_cost = (time.time() - start) / repeat
+            print(
+                "density {}: sparse.matmul {:.6f}s, matmul {:.6f}s".format(
+                    density, sparse_cost, dense_cost
+                )
+            )
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -802,6 +802,8 @@ class MemorySummary:
         )  # for memory summary, device type: event
         self.peak_allocation_values = collections.defaultdict(int)
         self.peak_reserved_values = collections.defaultdict(int)
+        # for peak breakdown, device type: [(op name, var name, size)]
+        self.peak_breakdown = {}
 
     def _analyse_node_memory(self, event_name, node):
         for memnode in node.mem_node:  # self mem node
@@ -852,6 +854,48 @@ class MemorySummary:
                     for child in host_node.children_node:
                         self._analyse_node_memory(host_node.name, child)
                 self._analyse_node_memory(host_node.name, host_node)
+        self._analyse_peak_breakdown(thread2hostnodes)
+
+    def _analyse_peak_breakdown(self, thread2hostnodes):
+        r"""
+        Find which operators and variables own the memory alive at the peak
+        of allocated memory, by replaying the allocations of every place.
+        """
+        records = collections.defaultdict(list)
+        for threadid, host_nodes in thread2hostnodes.items():
+            for host_node in host_nodes:
+                for memnode in host_node.mem_node:
+                    if (
+                        memnode.type == TracerMemEventType.Allocate
+                        or memnode.type == TracerMemEventType.Free
+                    ):
+                        records[memnode.place].append(memnode)
+        for place, memnodes in records.items():
+            memnodes.sort(key=lambda x: x.timestamp_ns)
+            current = 0
+            peak = 0
+            peak_index = -1
+            for index, memnode in enumerate(memnodes):
+                current += memnode.increase_bytes
+                if current > peak:
+                    peak = current
+                    peak_index = index
+            live = {}
+            for memnode in memnodes[: peak_index + 1]:
+                if memnode.type == TracerMemEventType.Allocate:
+                    live[memnode.addr] = memnode
+                else:
+                    live.pop(memnode.addr, None)
+            owners = collections.defaultdict(int)
+            for memnode in live.values():
+                op_name = memnode.op_name if memnode.op_name else 'Unknown'
+                var_name = memnode.var_name if memnode.var_name else '-'
+                owners[(op_name, var_name)] += memnode.increase_bytes
+            self.peak_breakdown[place] = sorted(
+                [(key[0], key[1], size) for key, size in owners.items()],
+                key=lambda x: x[2],
+                reverse=True,
+            )
 
 
 class StatisticData:
@@ -2075,4 +2119,37 @@ def _build_table(
                 append('')
                 append('')
 
+                peak_breakdown = statistic_data.memory_summary.peak_breakdown
+                if not peak_breakdown.get(device_type):
+                    continue
+                headers = ['Operator', 'Variable', 'Size at Peak']
+                row_format_list = [""]
+                header_sep_list = [""]
+                line_length_list = [-SPACING_SIZE]
+                add_column(name_column_width)
+                add_column(name_column_width)
+                add_column(number_column_width)
+                row_format = row_format_list[0]
+                header_sep = header_sep_list[0]
+                line_length = line_length_list[0]
+                append(
+                    add_title(
+                        line_length,
+                        "Memory Peak Breakdown - {}".format(device_type),
+                    )
+                )
+                append(header_sep)
+                append(row_format.format(*headers))
+                append(header_sep)
+                for op_name, var_name, size in peak_breakdown[device_type][
+                    :row_limit
+                ]:
+                    if len(op_name) > name_column_width:
+                        op_name = op_name[: name_column_width - 3] + '...'
+                    if len(var_name) > name_column_width:
+                        var_name = var_name[: name_column_width - 3] + '...'
+                    append(row_format.format(op_name, var_name, size))
+                append('')
+                append('')
+
     return ''.join(result)